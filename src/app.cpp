@@ -51,9 +51,12 @@
 #include "sound/audio.h"
 #include "utils/ccrc32.h"
 #include "utils/file.h"
+#include "utils/assetcache.h"
+#include "surfacecache.h"
 #include "utils/log.h"
 #include "utils/configfile.h"
 #include "utils/portablefile.h"
+#include "utils/profiler.h"
 #include "agent.h"
 #include "menus/gamemenufactory.h"
 #include "menus/gamemenuid.h"
@@ -74,6 +77,7 @@ App::App(bool disable_sound):
     menus_(new GameMenuFactory(), &game_sounds_)    
 {
     running_ = true;
+    startupOk_ = true;
 #ifdef _DEBUG
     debug_breakpoint_trigger_ = 0;
 #endif
@@ -172,6 +176,14 @@ bool App::readConfiguration() {
         context_->setFullScreen(conf.read("fullscreen", false));
         context_->setPlayIntro(conf.read("play_intro", true));
         context_->setTimeForClick(conf.read("time_for_click", 80));
+        context_->setPathFinder(conf.read("path_finder", 0) == 1 ?
+            AppContext::PATHFINDER_ASTAR : AppContext::PATHFINDER_FLOOD);
+        context_->setPathWorkers(conf.read("path_workers", 0));
+        context_->setStartupWorkers(conf.read("startup_workers", 2));
+        context_->setSimRate(conf.read("sim_rate", 30));
+        AssetCache::setEnabled(conf.read("asset_cache", true));
+        SurfaceCache::setMode((SurfaceCache::EMode) conf.read("surface_cache", 2));
+        maps_.setMemoryBudget((size_t) conf.read("map_cache_kb", 16384) * 1024);
         bool origDataDirFound = conf.readInto(origDataDir, "data_dir");
         bool ourDataDirFound = conf.readInto(ourDataDir, "freesynd_data_dir");
 
@@ -351,38 +363,92 @@ bool App::initialize(const std::string& iniPath) {
         return false;
     }
 
-    LOG(Log::k_FLG_INFO, "App", "initialize", ("initializing menus..."))
-    if (!menus_.initialize(context_->isPlayIntro())) {
+    // menu sprites, fonts and sounds are needed by the first menu, game
+    // sprites and tiles can continue loading while the intro is playing
+    LOG(Log::k_FLG_INFO, "App", "initialize", ("loading data..."))
+    int menuSprites = loader_.addTask("menu sprites", loadMenuSprites, this, false);
+    int fonts = loader_.addTask("fonts", loadFonts, this, false);
+    loader_.addDependency(fonts, menuSprites);
+    if (context_->isPlayIntro()) {
+        int introSprites = loader_.addTask("intro font sprites", loadIntroFontSprites, this, false);
+        loader_.addDependency(fonts, introSprites);
+    }
+    loader_.addTask("game sprites", loadGameSprites, this, false);
+    loader_.addTask("game tileset", loadTiles, this, false);
+    // SDL_mixer is not thread safe so sounds are loaded by the main thread
+    int introSounds = -1;
+    if (context_->isPlayIntro()) {
+        introSounds = loader_.addTask("intro sounds", loadIntroSounds, this, true);
+    }
+    int gameSounds = loader_.addTask("game sounds", loadGameSounds, this, true);
+    int music = loader_.addTask("music", loadMusic, this, true);
+    loader_.start(context_->getStartupWorkers());
+
+    // main thread loads sounds while workers load sprites
+    if ((introSounds != -1 && !loader_.waitFor(introSounds)) ||
+        !loader_.waitFor(gameSounds) || !loader_.waitFor(music) ||
+        !loader_.waitFor(fonts)) {
+        waitForStartup();
         return false;
     }
 
-    LOG(Log::k_FLG_INFO, "App", "initialize", ("loading game sprites..."))
-    if (!gameSprites().loaded())
-        gameSprites().load();
+    LOG(Log::k_FLG_INFO, "App", "initialize", ("Loading game data..."))
+    g_gameCtrl.agents().loadAgents();
+    return reset();
+}
 
-    LOG(Log::k_FLG_INFO, "App", "initialize", ("loading game tileset..."))
-    if (!maps().initialize()) {
-        return false;
+/*!
+ * Blocks until all the data started loading in initialize() is loaded.
+ * Does nothing once all data has been loaded.
+ * \return false if some data could not be loaded.
+ */
+bool App::waitForStartup() {
+    if (!loader_.isRunning()) {
+        return startupOk_;
     }
 
-    if (context_->isPlayIntro()) {
-        LOG(Log::k_FLG_INFO, "App", "initialize", ("Loading intro sounds..."))
-        if (!intro_sounds_.loadSounds(SoundManager::SAMPLES_INTRO)) {
-            return false;
-        }
+    startupOk_ = loader_.waitForAll();
+    if (context_->isStartupReport()) {
+        loader_.printTimeline();
     }
+    return startupOk_;
+}
 
-    LOG(Log::k_FLG_INFO, "App", "initialize", ("Loading game sounds..."))
-    if (!game_sounds_.loadSounds(SoundManager::SAMPLES_GAME)) {
-        return false;
+bool App::loadMenuSprites(void *pCtxt) {
+    return static_cast<App *>(pCtxt)->menus().loadMenuSprites();
+}
+
+bool App::loadIntroFontSprites(void *pCtxt) {
+    return static_cast<App *>(pCtxt)->menus().loadIntroFontSprites();
+}
+
+bool App::loadFonts(void *pCtxt) {
+    return static_cast<App *>(pCtxt)->menus().loadFonts();
+}
+
+bool App::loadGameSprites(void *pCtxt) {
+    GameSpriteManager &sprites = static_cast<App *>(pCtxt)->gameSprites();
+    if (!sprites.loaded()) {
+        sprites.load();
     }
+    return sprites.loaded();
+}
 
-    LOG(Log::k_FLG_INFO, "App", "initialize", ("Loading music..."))
-    music_.loadMusic();
+bool App::loadTiles(void *pCtxt) {
+    return static_cast<App *>(pCtxt)->maps().initialize();
+}
 
-    LOG(Log::k_FLG_INFO, "App", "initialize", ("Loading game data..."))
-    g_gameCtrl.agents().loadAgents();
-    return reset();
+bool App::loadIntroSounds(void *pCtxt) {
+    return static_cast<App *>(pCtxt)->introSounds().loadSounds(SoundManager::SAMPLES_INTRO);
+}
+
+bool App::loadGameSounds(void *pCtxt) {
+    return static_cast<App *>(pCtxt)->gameSounds().loadSounds(SoundManager::SAMPLES_GAME);
+}
+
+bool App::loadMusic(void *pCtxt) {
+    static_cast<App *>(pCtxt)->music().loadMusic();
+    return true;
 }
 
 /*!
@@ -554,8 +620,12 @@ bool App::reset() {
  * Destroy the application.
  */
 void App::destroy() {
+    // threads may still be loading if game is left during the intro
+    waitForStartup();
     game_ctlr_->clearAllListeners();
     menus_.destroy();
+    // the mission releases its map so it must go before the maps
+    g_Session.setMission(NULL);
 
     game_ctlr_->destroy();
 }
@@ -637,10 +707,15 @@ void App::run(int start_mission) {
             SDL_Delay(30 - diff_ticks);
             continue;
         }
-        menus_.handleTick(diff_ticks);
-        menus_.renderMenu();
-        lasttick = curtick;
-        system_->updateScreen();
+        {
+            PROFILE_ZONE("App::run");
+            menus_.handleTick(diff_ticks);
+            menus_.renderMenu();
+            lasttick = curtick;
+            PROFILE_ZONE("System::updateScreen");
+            system_->updateScreen();
+        }
+        Profiler::endFrame();
     }
 
 #ifdef GP2X
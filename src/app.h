@@ -51,6 +51,7 @@
 #include "appcontext.h"
 #include "core/gamesession.h"
 #include "core/gamecontroller.h"
+#include "core/startuploader.h"
 
 /*!
  * Application class.
@@ -90,6 +91,9 @@ class App : public Singleton < App > {
         return music_;
     }
 
+    //! Waits for the data still loading after initialization
+    bool waitForStartup();
+
     //! Main application method
     void run(int start_mission);
     //! Reset the application data
@@ -130,6 +134,16 @@ private:
     //! Sets the intro flag to false in the config file
     void updateIntroFlag();
 
+    // Startup loading tasks, context is the application
+    static bool loadMenuSprites(void *pCtxt);
+    static bool loadIntroFontSprites(void *pCtxt);
+    static bool loadFonts(void *pCtxt);
+    static bool loadGameSprites(void *pCtxt);
+    static bool loadTiles(void *pCtxt);
+    static bool loadIntroSounds(void *pCtxt);
+    static bool loadGameSounds(void *pCtxt);
+    static bool loadMusic(void *pCtxt);
+
     void cheatFunds() {
         g_Session.setMoney(100000000);
     }
@@ -146,6 +160,8 @@ private:
 
 private:
     bool running_;
+    /*! False if some data could not be loaded at startup.*/
+    bool startupOk_;
     /*! A structure to hold general application informations.*/
     std::unique_ptr<AppContext> context_;
     /*! A structure to hold player informations.*/
@@ -163,6 +179,8 @@ private:
     SoundManager game_sounds_;
     MusicManager music_;
     MenuManager menus_;
+    /*! Loads the data at startup.*/
+    StartupLoader loader_;
 };
 
 #define g_App   App::singleton()
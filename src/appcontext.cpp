@@ -31,6 +31,11 @@ AppContext::AppContext() {
     time_for_click_ = 80; 
     fullscreen_ = false;
     playIntro_ = true;
+    path_finder_ = PATHFINDER_FLOOD;
+    path_workers_ = 0;
+    startup_workers_ = 0;
+    startup_report_ = false;
+    sim_rate_ = 30;
     language_ = NULL;
 }
 
@@ -28,6 +28,8 @@
 #ifndef CORE_APPCONTEXT_H_
 #define CORE_APPCONTEXT_H_
 
+#include <string>
+
 #include "common.h"
 #include "utils/configfile.h"
 
@@ -46,6 +48,16 @@ public:
         GERMAN = 3
     };
 
+    /*!
+     * Algorithms available for ped path finding.
+     */
+    enum FS_PathFinder {
+        //! Original bidirectional flood
+        PATHFINDER_FLOOD = 0,
+        //! A* over the same directions map
+        PATHFINDER_ASTAR = 1
+    };
+
     AppContext();
     ~AppContext();
 
@@ -58,6 +70,31 @@ public:
     void setTimeForClick(int32 time) { time_for_click_ = time; }
     int32 getTimeForClick() { return time_for_click_; }
 
+    void setPathFinder(FS_PathFinder finder) { path_finder_ = finder; }
+    FS_PathFinder getPathFinder() { return path_finder_; }
+
+    void setPathWorkers(int nb) { path_workers_ = nb; }
+    int getPathWorkers() { return path_workers_; }
+
+    void setStartupWorkers(int nb) { startup_workers_ = nb; }
+    int getStartupWorkers() { return startup_workers_; }
+
+    //! Prints the startup timeline on standard output if true
+    void setStartupReport(bool report) { startup_report_ = report; }
+    bool isStartupReport() { return startup_report_; }
+
+    //! Sets the number of simulation steps per second, kept between 10 and 100
+    void setSimRate(int rate) { sim_rate_ = rate < 10 ? 10 : (rate > 100 ? 100 : rate); }
+    int getSimRate() { return sim_rate_; }
+
+    //! Sets the file where player commands are recorded during missions
+    void setRecordFile(const std::string &path) { record_file_ = path; }
+    const std::string & getRecordFile() { return record_file_; }
+
+    //! Sets the file from which player commands are replayed during missions
+    void setReplayFile(const std::string &path) { replay_file_ = path; }
+    const std::string & getReplayFile() { return replay_file_; }
+
     void setLanguage(FS_Lang lang);
     FS_Lang currLanguage(void) {return curr_language_; }
     std::string getMessage(const std::string & id);
@@ -72,6 +109,20 @@ private:
      * if it will be longer it will be treated as dragging
     */
     int32 time_for_click_;
+    /*! Algorithm used by peds to find their path.*/
+    FS_PathFinder path_finder_;
+    /*! Number of threads searching paths for peds, 0 means main thread.*/
+    int path_workers_;
+    /*! Number of threads loading data at startup, 0 means main thread.*/
+    int startup_workers_;
+    /*! True to print how long each startup task took.*/
+    bool startup_report_;
+    /*! Number of simulation steps per second during a mission.*/
+    int sim_rate_;
+    /*! If not empty, missions are recorded in this file.*/
+    std::string record_file_;
+    /*! If not empty, missions are replayed from this file.*/
+    std::string replay_file_;
     /*! Language file. */
     ConfigFile  *language_;
     FS_Lang curr_language_;
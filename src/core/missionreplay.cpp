@@ -0,0 +1,250 @@
+/************************************************************************
+ *                                                                      *
+ *  FreeSynd - a remake of the classic Bullfrog game "Syndicate".       *
+ *                                                                      *
+ *   Copyright (C) 2016  Benoit Blancard <benblan@users.sourceforge.net>*
+ *                                                                      *
+ *    This program is free software;  you can redistribute it and / or  *
+ *  modify it  under the  terms of the  GNU General  Public License as  *
+ *  published by the Free Software Foundation; either version 2 of the  *
+ *  License, or (at your option) any later version.                     *
+ *                                                                      *
+ *    This program is  distributed in the hope that it will be useful,  *
+ *  but WITHOUT  ANY WARRANTY;  without even  the implied  warranty of  *
+ *  MERCHANTABILITY  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU  *
+ *  General Public License for more details.                            *
+ *                                                                      *
+ *    You can view the GNU  General Public License, online, at the GNU  *
+ *  project's  web  site;  see <http://www.gnu.org/licenses/gpl.html>.  *
+ *  The full text of the license is also included in the file COPYING.  *
+ *                                                                      *
+ ************************************************************************/
+
+#include <sstream>
+
+#include "core/missionreplay.h"
+#include "utils/log.h"
+
+/*!
+ * Version of the file format. Increase it when the meaning of
+ * commands changes.
+ */
+static const int kReplayVersion = 1;
+
+const char *MissionReplay::kCommandNames[PlayerCommand::kNbCommands] = {
+    "select_agent", "select_all", "set_ipa", "select_weapon",
+    "putdown_weapon", "pickup_weapon", "follow_ped", "enter_vehicle",
+    "move_to", "shoot_at", "update_shooting_target", "stop_shooting",
+    "suicide"
+};
+
+const int MissionReplay::kCommandNbArgs[PlayerCommand::kNbCommands] = {
+    2, 1, 3, 2, 2, 2, 2, 2, 7, 3, 3, 0, 0
+};
+
+PlayerCommand::PlayerCommand(EType aType) {
+    step = 0;
+    type = aType;
+    for (int i = 0; i < kMaxArgs; i++) {
+        args[i] = 0;
+    }
+}
+
+MissionReplay::MissionReplay() {
+    mode_ = kModeOff;
+    nextCmd_ = 0;
+    endStep_ = 0;
+    endChecksum_ = 0;
+    endChecked_ = false;
+}
+
+MissionReplay::~MissionReplay() {
+    if (out_.is_open()) {
+        out_.close();
+    }
+}
+
+/*!
+ * Creates the replay file and writes the header.
+ * \param path Path of the file
+ * \param header Mission parameters
+ * \return False if file could not be created
+ */
+bool MissionReplay::startRecording(const std::string &path, const ReplayHeader &header) {
+    out_.open(path.c_str(), std::ios::out | std::ios::trunc);
+    if (!out_.is_open()) {
+        FSERR(Log::k_FLG_IO, "MissionReplay", "startRecording", ("Cannot create replay file %s\n", path.c_str()))
+        return false;
+    }
+
+    out_ << "FSREPLAY " << kReplayVersion << "\n";
+    out_ << "header " << header.missionId << " " << header.seed << " "
+        << header.simStep << " " << (header.pathWorkers ? 1 : 0) << " "
+        << header.startChecksum << "\n";
+    mode_ = kModeRecord;
+    LOG(Log::k_FLG_GAME, "MissionReplay", "startRecording", ("Recording mission %d in %s",
+        header.missionId, path.c_str()))
+    return true;
+}
+
+void MissionReplay::record(uint32 step, const PlayerCommand &cmd) {
+    if (mode_ != kModeRecord) {
+        return;
+    }
+
+    out_ << step << " " << kCommandNames[cmd.type];
+    for (int i = 0; i < kCommandNbArgs[cmd.type]; i++) {
+        out_ << " " << cmd.args[i];
+    }
+    out_ << "\n";
+}
+
+/*!
+ * Writes the number of steps and the state of the mission at the end of
+ * the recording so that the replay can tell if it went the same way.
+ */
+void MissionReplay::stopRecording(uint32 step, uint32 checksum) {
+    if (mode_ != kModeRecord) {
+        return;
+    }
+
+    out_ << "end " << step << " " << checksum << "\n";
+    out_.close();
+    mode_ = kModeOff;
+}
+
+/*!
+ * Reads the replay file.
+ * \param path Path of the file
+ * \param pHeader Receives mission parameters
+ * \return False if file could not be read
+ */
+bool MissionReplay::startPlaying(const std::string &path, ReplayHeader *pHeader) {
+    std::ifstream in(path.c_str());
+    if (!in.is_open()) {
+        FSERR(Log::k_FLG_IO, "MissionReplay", "startPlaying", ("Cannot open replay file %s\n", path.c_str()))
+        return false;
+    }
+
+    std::string line;
+    std::string tag;
+    int version = 0;
+    std::getline(in, line);
+    std::istringstream magic(line);
+    magic >> tag >> version;
+    if (tag != "FSREPLAY" || version != kReplayVersion) {
+        FSERR(Log::k_FLG_IO, "MissionReplay", "startPlaying", ("%s is not a replay file of version %d\n",
+            path.c_str(), kReplayVersion))
+        return false;
+    }
+
+    int workers = 0;
+    std::getline(in, line);
+    std::istringstream head(line);
+    head >> tag >> pHeader->missionId >> pHeader->seed >> pHeader->simStep
+        >> workers >> pHeader->startChecksum;
+    if (tag != "header" || head.fail()) {
+        FSERR(Log::k_FLG_IO, "MissionReplay", "startPlaying", ("Bad header in replay file %s\n", path.c_str()))
+        return false;
+    }
+    pHeader->pathWorkers = workers != 0;
+
+    commands_.clear();
+    endStep_ = 0;
+    endChecksum_ = 0;
+    bool hasEnd = false;
+    int lineNum = 2;
+    while (std::getline(in, line)) {
+        lineNum++;
+        if (line.empty()) {
+            continue;
+        }
+
+        std::istringstream is(line);
+        if (line.compare(0, 4, "end ") == 0) {
+            is >> tag >> endStep_ >> endChecksum_;
+            hasEnd = !is.fail();
+            break;
+        }
+
+        PlayerCommand cmd;
+        std::string name;
+        is >> cmd.step >> name;
+        int type = 0;
+        while (type < PlayerCommand::kNbCommands && name != kCommandNames[type]) {
+            type++;
+        }
+        if (is.fail() || type == PlayerCommand::kNbCommands) {
+            FSERR(Log::k_FLG_IO, "MissionReplay", "startPlaying", ("Bad command at line %d in replay file %s\n",
+                lineNum, path.c_str()))
+            return false;
+        }
+        cmd.type = (PlayerCommand::EType) type;
+        for (int i = 0; i < kCommandNbArgs[type]; i++) {
+            is >> cmd.args[i];
+        }
+        commands_.push_back(cmd);
+    }
+
+    if (!hasEnd) {
+        // the game probably stopped while recording
+        LOG(Log::k_FLG_IO, "MissionReplay", "startPlaying", ("Replay file %s has no end, state will not be checked",
+            path.c_str()))
+    }
+
+    nextCmd_ = 0;
+    endChecked_ = !hasEnd;
+    mode_ = kModePlay;
+    LOG(Log::k_FLG_GAME, "MissionReplay", "startPlaying", ("Playing %d commands for mission %d",
+        (int) commands_.size(), pHeader->missionId))
+    return true;
+}
+
+/*!
+ * Returns one by one the commands that were given before the given step.
+ * \param step Number of simulation steps already run
+ * \param pCmd Receives the command
+ * \return False if there's no more command for this step
+ */
+bool MissionReplay::nextCommand(uint32 step, PlayerCommand *pCmd) {
+    if (mode_ != kModePlay || nextCmd_ >= commands_.size() ||
+        commands_[nextCmd_].step > step) {
+        return false;
+    }
+
+    *pCmd = commands_[nextCmd_];
+    nextCmd_++;
+    return true;
+}
+
+/*!
+ * Returns true when the replay has just run as many steps as the
+ * recording and the state has not been checked yet.
+ */
+bool MissionReplay::isEndStep(uint32 step) {
+    return mode_ == kModePlay && !endChecked_ && step == endStep_;
+}
+
+/*!
+ * Compares the state of the mission at the end step with the one
+ * that was recorded.
+ * \param checksum Checksum of the current state
+ * \return False if the replay went differently
+ */
+bool MissionReplay::checkEnd(uint32 checksum) {
+    endChecked_ = true;
+    if (checksum != endChecksum_) {
+        FSERR(Log::k_FLG_GAME, "MissionReplay", "checkEnd", ("Replay diverged : state at step %u is %u instead of %u\n",
+            endStep_, checksum, endChecksum_))
+        return false;
+    }
+
+    LOG(Log::k_FLG_GAME, "MissionReplay", "checkEnd", ("Replay reached step %u with the recorded state", endStep_))
+    return true;
+}
+
+void MissionReplay::stopPlaying() {
+    commands_.clear();
+    nextCmd_ = 0;
+    mode_ = kModeOff;
+}
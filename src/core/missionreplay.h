@@ -0,0 +1,160 @@
+/************************************************************************
+ *                                                                      *
+ *  FreeSynd - a remake of the classic Bullfrog game "Syndicate".       *
+ *                                                                      *
+ *   Copyright (C) 2016  Benoit Blancard <benblan@users.sourceforge.net>*
+ *                                                                      *
+ *    This program is free software;  you can redistribute it and / or  *
+ *  modify it  under the  terms of the  GNU General  Public License as  *
+ *  published by the Free Software Foundation; either version 2 of the  *
+ *  License, or (at your option) any later version.                     *
+ *                                                                      *
+ *    This program is  distributed in the hope that it will be useful,  *
+ *  but WITHOUT  ANY WARRANTY;  without even  the implied  warranty of  *
+ *  MERCHANTABILITY  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU  *
+ *  General Public License for more details.                            *
+ *                                                                      *
+ *    You can view the GNU  General Public License, online, at the GNU  *
+ *  project's  web  site;  see <http://www.gnu.org/licenses/gpl.html>.  *
+ *  The full text of the license is also included in the file COPYING.  *
+ *                                                                      *
+ ************************************************************************/
+
+#ifndef CORE_MISSIONREPLAY_H_
+#define CORE_MISSIONREPLAY_H_
+
+#include <string>
+#include <vector>
+#include <fstream>
+
+#include "common.h"
+
+/*!
+ * An order given by the player during a mission.
+ * Commands are stamped with the number of simulation steps run before
+ * they were given so they can be replayed at the same moment.
+ */
+struct PlayerCommand {
+    /*!
+     * Type of command and its arguments.
+     */
+    enum EType {
+        //! args : agent slot, add to group
+        kCmdSelectAgent = 0,
+        //! args : new state of the select all button
+        kCmdSelectAll,
+        //! args : agent slot, IPA type, percentage
+        kCmdSetIpa,
+        //! args : weapon index in leader inventory, apply to all
+        kCmdSelectWeapon,
+        //! args : weapon index in leader inventory, append action
+        kCmdPutdownWeapon,
+        //! args : weapon index in weapons on ground, append action
+        kCmdPickupWeapon,
+        //! args : ped index in mission, append action
+        kCmdFollowPed,
+        //! args : vehicle index in mission, append action
+        kCmdEnterVehicle,
+        //! args : tx, ty, tz, ox, oy, oz, append action
+        kCmdMoveTo,
+        //! args : world x, y, z
+        kCmdShootAt,
+        //! args : world x, y, z
+        kCmdUpdateShootingTarget,
+        //! no args
+        kCmdStopShooting,
+        //! no args
+        kCmdSuicide,
+        kNbCommands
+    };
+
+    static const int kMaxArgs = 7;
+
+    PlayerCommand(EType aType = kCmdStopShooting);
+
+    /*! Number of simulation steps run before the command.*/
+    uint32 step;
+    /*! What the command does.*/
+    EType type;
+    /*! Arguments, meaning depends on type.*/
+    int args[kMaxArgs];
+};
+
+/*!
+ * What must be the same between the recording and the replay of a mission.
+ */
+struct ReplayHeader {
+    /*! Id of the mission.*/
+    int missionId;
+    /*! Seed given to the random generator before mission starts.*/
+    uint32 seed;
+    /*! Duration of a simulation step in ms.*/
+    int simStep;
+    /*! True if paths were searched by worker threads.*/
+    bool pathWorkers;
+    /*! Checksum of mission state after start (squad equipment, ...).*/
+    uint32 startChecksum;
+};
+
+/*!
+ * Records the commands of the player in a text file or plays them back.
+ * With the same seed and the same commands given at the same simulation
+ * steps, a mission runs exactly the same way, so a replay can be used
+ * to compare the performances of different builds.
+ */
+class MissionReplay {
+public:
+    /*!
+     * What is done with the replay.
+     */
+    enum EMode {
+        kModeOff = 0,
+        kModeRecord = 1,
+        kModePlay = 2
+    };
+
+    MissionReplay();
+    ~MissionReplay();
+
+    EMode mode() { return mode_; }
+    bool isRecording() { return mode_ == kModeRecord; }
+    bool isPlaying() { return mode_ == kModePlay; }
+
+    //! Opens the file and writes the header
+    bool startRecording(const std::string &path, const ReplayHeader &header);
+    //! Adds the command to the recording
+    void record(uint32 step, const PlayerCommand &cmd);
+    //! Writes the end of the recording and closes file
+    void stopRecording(uint32 step, uint32 checksum);
+
+    //! Loads all commands from the file
+    bool startPlaying(const std::string &path, ReplayHeader *pHeader);
+    //! Returns the next command to play at the given step
+    bool nextCommand(uint32 step, PlayerCommand *pCmd);
+    //! Returns true if the state must be checked after the given step
+    bool isEndStep(uint32 step);
+    //! Compares the state at the end of the replay with the recorded one
+    bool checkEnd(uint32 checksum);
+    //! Stops playing
+    void stopPlaying();
+
+protected:
+    static const char *kCommandNames[PlayerCommand::kNbCommands];
+    static const int kCommandNbArgs[PlayerCommand::kNbCommands];
+
+    EMode mode_;
+    /*! File written during recording.*/
+    std::ofstream out_;
+    /*! Commands read from file for playing.*/
+    std::vector<PlayerCommand> commands_;
+    /*! Index of next command to play.*/
+    size_t nextCmd_;
+    /*! Step at which the recording ended.*/
+    uint32 endStep_;
+    /*! Checksum of mission at the end of recording.*/
+    uint32 endChecksum_;
+    /*! True if the end has been checked.*/
+    bool endChecked_;
+};
+
+#endif  // CORE_MISSIONREPLAY_H_
@@ -0,0 +1,283 @@
+/************************************************************************
+ *                                                                      *
+ *  FreeSynd - a remake of the classic Bullfrog game "Syndicate".       *
+ *                                                                      *
+ *   Copyright (C) 2016  Benoit Blancard <benblan@users.sourceforge.net>*
+ *                                                                      *
+ *    This program is free software;  you can redistribute it and / or  *
+ *  modify it  under the  terms of the  GNU General  Public License as  *
+ *  published by the Free Software Foundation; either version 2 of the  *
+ *  License, or (at your option) any later version.                     *
+ *                                                                      *
+ *    This program is  distributed in the hope that it will be useful,  *
+ *  but WITHOUT  ANY WARRANTY;  without even  the implied  warranty of  *
+ *  MERCHANTABILITY  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU  *
+ *  General Public License for more details.                            *
+ *                                                                      *
+ *    You can view the GNU  General Public License, online, at the GNU  *
+ *  project's  web  site;  see <http://www.gnu.org/licenses/gpl.html>.  *
+ *  The full text of the license is also included in the file COPYING.  *
+ *                                                                      *
+ ************************************************************************/
+
+#include <cstdio>
+
+#include "SDL.h"
+
+#include "core/startuploader.h"
+#include "utils/log.h"
+#include "utils/profiler.h"
+#include "utils/timer.h"
+
+StartupLoader::StartupLoader() {
+    nbWorkers_ = 0;
+    running_ = false;
+    startTime_ = 0;
+    endTime_ = 0;
+    pMutex_ = SDL_CreateMutex();
+    pTaskCond_ = SDL_CreateCond();
+}
+
+StartupLoader::~StartupLoader() {
+    if (running_) {
+        waitForAll();
+    }
+    SDL_DestroyCond(pTaskCond_);
+    SDL_DestroyMutex(pMutex_);
+}
+
+/*!
+ * \param name Name of the task in the timeline
+ * \param func Function that does the loading
+ * \param pCtxt Argument given to the function
+ * \param mainThread True if the task must be run by the main thread
+ * \return id of the task.
+ */
+int StartupLoader::addTask(const char *name, LoadFunction func, void *pCtxt, bool mainThread) {
+    Task task;
+    task.name = name;
+    task.func = func;
+    task.pCtxt = pCtxt;
+    task.mainThread = mainThread;
+    task.status = kPending;
+    task.thread = 0;
+    task.startTime = 0;
+    task.endTime = 0;
+    tasks_.push_back(task);
+    return tasks_.size() - 1;
+}
+
+void StartupLoader::addDependency(int task, int required) {
+    tasks_[task].required.push_back(required);
+}
+
+/*!
+ * Workers run tasks as soon as they are ready. With no worker, all tasks
+ * are run by the main thread when it waits for them.
+ * \param nbWorkers Number of threads
+ */
+void StartupLoader::start(int nbWorkers) {
+    startTime_ = fs_utils::microTime();
+    running_ = true;
+
+    for (int i = 0; i < nbWorkers; i++) {
+        Worker *pWorker = new Worker();
+        pWorker->pOwner = this;
+        pWorker->num = i + 1;
+        pWorker->pThread = SDL_CreateThread(workerLoop, pWorker);
+        if (pWorker->pThread == NULL) {
+            FSERR(Log::k_FLG_INFO, "StartupLoader", "start", ("Unable to create thread : %s\n", SDL_GetError()));
+            delete pWorker;
+            break;
+        }
+        workers_.push_back(pWorker);
+    }
+    nbWorkers_ = workers_.size();
+
+    LOG(Log::k_FLG_INFO, "StartupLoader", "start", ("%d tasks, %d loading threads started",
+        (int)tasks_.size(), (int)workers_.size()));
+}
+
+/*!
+ * While the task is not over, the main thread runs the tasks it needs
+ * that are ready, or sleeps until a worker finishes a task.
+ * \param task Id of the task
+ * \return false if the task or a task it needs failed.
+ */
+bool StartupLoader::waitFor(int task) {
+    SDL_LockMutex(pMutex_);
+    while (tasks_[task].status == kPending || tasks_[task].status == kRunning) {
+        int next = findTaskFor(task);
+        if (next != -1) {
+            runTask(next, 0);
+        } else {
+            SDL_CondWait(pTaskCond_, pMutex_);
+        }
+    }
+    bool res = tasks_[task].status == kDone;
+    SDL_UnlockMutex(pMutex_);
+    return res;
+}
+
+bool StartupLoader::waitForAll() {
+    bool res = true;
+    for (size_t i = 0; i < tasks_.size(); i++) {
+        if (!waitFor(i)) {
+            res = false;
+        }
+    }
+
+    // workers stop by themselves once there's no task left for them
+    for (size_t i = 0; i < workers_.size(); i++) {
+        SDL_WaitThread(workers_[i]->pThread, NULL);
+        delete workers_[i];
+    }
+    workers_.clear();
+
+    endTime_ = fs_utils::microTime() - startTime_;
+    running_ = false;
+    LOG(Log::k_FLG_INFO, "StartupLoader", "waitForAll", ("All tasks over in %.1f ms", endTime_ / 1000.0));
+    return res;
+}
+
+void StartupLoader::printTimeline() {
+    printf("Startup timeline (ms) :\n");
+    printf("  %-20s %6s %9s %9s %9s\n", "task", "thread", "start", "end", "duration");
+    for (size_t i = 0; i < tasks_.size(); i++) {
+        const Task &task = tasks_[i];
+        printf("  %-20s %6d %9.1f %9.1f %9.1f%s\n", task.name.c_str(), task.thread,
+            task.startTime / 1000.0, task.endTime / 1000.0,
+            (task.endTime - task.startTime) / 1000.0,
+            task.status == kDone ? "" : " FAILED");
+    }
+    printf("  total %.1f ms with %d loading threads\n", endTime_ / 1000.0, nbWorkers_);
+    fflush(stdout);
+}
+
+int StartupLoader::workerLoop(void *pData) {
+    Worker *pWorker = static_cast<Worker *>(pData);
+    Profiler::setThreadName("startup worker");
+    pWorker->pOwner->processTasks(pWorker);
+    return 0;
+}
+
+/*!
+ * Runs ready tasks until no task is left for workers.
+ * \param pWorker The worker running this loop
+ */
+void StartupLoader::processTasks(Worker *pWorker) {
+    SDL_LockMutex(pMutex_);
+    while (hasWorkerTasks()) {
+        int next = findWorkerTask();
+        if (next != -1) {
+            runTask(next, pWorker->num);
+        } else {
+            SDL_CondWait(pTaskCond_, pMutex_);
+        }
+    }
+    SDL_UnlockMutex(pMutex_);
+}
+
+bool StartupLoader::isReady(int task) {
+    const std::vector<int> &required = tasks_[task].required;
+    for (size_t i = 0; i < required.size(); i++) {
+        if (tasks_[required[i]].status != kDone) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool StartupLoader::isNeededBy(int task, int target) {
+    if (task == target) {
+        return true;
+    }
+    const std::vector<int> &required = tasks_[target].required;
+    for (size_t i = 0; i < required.size(); i++) {
+        if (isNeededBy(task, required[i])) {
+            return true;
+        }
+    }
+    return false;
+}
+
+int StartupLoader::findWorkerTask() {
+    for (size_t i = 0; i < tasks_.size(); i++) {
+        if (tasks_[i].status == kPending && !tasks_[i].mainThread && isReady(i)) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+int StartupLoader::findTaskFor(int target) {
+    for (size_t i = 0; i < tasks_.size(); i++) {
+        if (tasks_[i].status == kPending && isReady(i) && isNeededBy(i, target)) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+bool StartupLoader::hasWorkerTasks() {
+    for (size_t i = 0; i < tasks_.size(); i++) {
+        if (tasks_[i].status == kPending && !tasks_[i].mainThread) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/*!
+ * Must be called with the lock held : it is released while the
+ * task is running.
+ * \param task Id of the task
+ * \param thread Number of the thread running the task
+ */
+void StartupLoader::runTask(int task, int thread) {
+    Task &t = tasks_[task];
+    t.status = kRunning;
+    t.thread = thread;
+    t.startTime = fs_utils::microTime() - startTime_;
+    LoadFunction func = t.func;
+    void *pCtxt = t.pCtxt;
+    SDL_UnlockMutex(pMutex_);
+
+    bool res;
+    {
+        // tasks_ is not resized once started so the name stays valid
+        PROFILE_ZONE(t.name.c_str());
+        res = func(pCtxt);
+    }
+
+    SDL_LockMutex(pMutex_);
+    // tasks_ is not resized once started so the reference is still valid
+    t.endTime = fs_utils::microTime() - startTime_;
+    t.status = res ? kDone : kFailed;
+    if (!res) {
+        FSERR(Log::k_FLG_INFO, "StartupLoader", "runTask", ("Loading task %s failed\n", t.name.c_str()));
+        propagateFailure();
+    }
+    SDL_CondBroadcast(pTaskCond_);
+}
+
+void StartupLoader::propagateFailure() {
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (size_t i = 0; i < tasks_.size(); i++) {
+            if (tasks_[i].status != kPending) {
+                continue;
+            }
+            const std::vector<int> &required = tasks_[i].required;
+            for (size_t j = 0; j < required.size(); j++) {
+                if (tasks_[required[j]].status == kFailed) {
+                    tasks_[i].status = kFailed;
+                    tasks_[i].startTime = tasks_[i].endTime = tasks_[required[j]].endTime;
+                    changed = true;
+                    break;
+                }
+            }
+        }
+    }
+}
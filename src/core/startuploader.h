@@ -0,0 +1,136 @@
+/************************************************************************
+ *                                                                      *
+ *  FreeSynd - a remake of the classic Bullfrog game "Syndicate".       *
+ *                                                                      *
+ *   Copyright (C) 2016  Benoit Blancard <benblan@users.sourceforge.net>*
+ *                                                                      *
+ *    This program is free software;  you can redistribute it and / or  *
+ *  modify it  under the  terms of the  GNU General  Public License as  *
+ *  published by the Free Software Foundation; either version 2 of the  *
+ *  License, or (at your option) any later version.                     *
+ *                                                                      *
+ *    This program is  distributed in the hope that it will be useful,  *
+ *  but WITHOUT  ANY WARRANTY;  without even  the implied  warranty of  *
+ *  MERCHANTABILITY  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU  *
+ *  General Public License for more details.                            *
+ *                                                                      *
+ *    You can view the GNU  General Public License, online, at the GNU  *
+ *  project's  web  site;  see <http://www.gnu.org/licenses/gpl.html>.  *
+ *  The full text of the license is also included in the file COPYING.  *
+ *                                                                      *
+ ************************************************************************/
+
+#ifndef CORE_STARTUPLOADER_H_
+#define CORE_STARTUPLOADER_H_
+
+#include <string>
+#include <vector>
+
+#include "common.h"
+
+struct SDL_Thread;
+struct SDL_mutex;
+struct SDL_cond;
+
+/*!
+ * Runs the loading tasks of the application startup on a pool of threads.
+ * Each task can require other tasks to be done before it starts (fonts
+ * need the menu sprites for example). Tasks that must run on the main
+ * thread (because the library they use is not thread safe) are only run
+ * when the main thread waits for them or for a task that needs them.
+ * Waiting for a task is the way to get its result : once waitFor() returns
+ * true, all data written by the task can be used by the main thread.
+ * If a task fails, all the tasks that need it fail too.
+ * Tasks must all be added before start() is called.
+ */
+class StartupLoader {
+public:
+    //! A loading function : returns false if loading failed
+    typedef bool (*LoadFunction)(void *pCtxt);
+
+    StartupLoader();
+    ~StartupLoader();
+
+    //! Adds a task and returns its id
+    int addTask(const char *name, LoadFunction func, void *pCtxt, bool mainThread);
+    //! The task will not start before the required task is done
+    void addDependency(int task, int required);
+
+    //! Starts the given number of threads
+    void start(int nbWorkers);
+    //! Blocks until the task is over. Returns true if task succeeded
+    bool waitFor(int task);
+    //! Runs all remaining tasks and stops the threads. Returns true if all tasks succeeded
+    bool waitForAll();
+    //! Returns true if tasks were started and not all waited for
+    bool isRunning() { return running_; }
+
+    //! Prints the start and duration of each task on standard output
+    void printTimeline();
+
+protected:
+    //! State of a task
+    enum EStatus {
+        kPending,
+        kRunning,
+        kDone,
+        kFailed
+    };
+
+    //! A loading task
+    struct Task {
+        std::string name;
+        LoadFunction func;
+        void *pCtxt;
+        bool mainThread;
+        /*! Ids of tasks that must be done before this one.*/
+        std::vector<int> required;
+        EStatus status;
+        /*! Thread that ran the task : 0 is the main thread.*/
+        int thread;
+        /*! Start and end of the task in microseconds since start().*/
+        uint64 startTime;
+        uint64 endTime;
+    };
+
+    //! A thread of the pool
+    struct Worker {
+        StartupLoader *pOwner;
+        SDL_Thread *pThread;
+        int num;
+    };
+
+    static int workerLoop(void *pData);
+    void processTasks(Worker *pWorker);
+
+    //! Returns true if all required tasks are done
+    bool isReady(int task);
+    //! Returns true if target cannot be done without task
+    bool isNeededBy(int task, int target);
+    //! Returns the id of a ready task that can run in a worker, -1 if none
+    int findWorkerTask();
+    //! Returns the id of a ready task needed by target, -1 if none
+    int findTaskFor(int target);
+    //! Returns true if there are tasks that workers can still run
+    bool hasWorkerTasks();
+    //! Runs the task without holding the lock
+    void runTask(int task, int thread);
+    //! Fails all tasks that need a failed task
+    void propagateFailure();
+
+protected:
+    std::vector<Task> tasks_;
+    std::vector<Worker *> workers_;
+    /*! Number of threads that were started.*/
+    int nbWorkers_;
+    bool running_;
+    /*! Time when start() was called.*/
+    uint64 startTime_;
+    /*! Time when all tasks were over.*/
+    uint64 endTime_;
+    SDL_mutex *pMutex_;
+    /*! Signaled each time a task is over.*/
+    SDL_cond *pTaskCond_;
+};
+
+#endif  // CORE_STARTUPLOADER_H_
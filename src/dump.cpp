@@ -495,8 +495,19 @@ void Screen::scale2x(int x, int y, int width, int height,
 
 #include "common.h"
 #include "editor/editorapp.h"
+#include "editor/missionbenchmark.h"
+#include "editor/blitbenchmark.h"
+#include "editor/roadbenchmark.h"
+#include "editor/assetbenchmark.h"
+#include "editor/surfacebenchmark.h"
+#include "editor/searchbenchmark.h"
+#include "editor/voxelbenchmark.h"
+#include "editor/mapcachebenchmark.h"
+#include "editor/pathbenchmark.h"
+#include "editor/linebenchmark.h"
 #include "utils/file.h"
 #include "utils/log.h"
+#include "utils/profiler.h"
 #include "default_ini.h"
 
 #ifdef _WIN32
@@ -522,6 +533,30 @@ void print_usage() {
     printf("    -h, --help            display this help and exit.\n");
     printf("    -i, --ini <path>      specify the location of the FreeSynd config file.\n");
     printf("    --nosound             disable all sound.\n");
+    printf("    --bench <mission>     run the mission without display and print timings.\n");
+    printf("    --bench-seconds <n>   simulated time of the benchmark (default: 60).\n");
+    printf("    --bench-seed <n>      seed for the random generator (default: 1).\n");
+    printf("    --bench-no-orders     do not give random walk orders to agents.\n");
+    printf("    --bench-no-perception-cache cast a ray for each visibility query.\n");
+    printf("    --bench-crowd <n>     add n civilians walking to random places to the benchmarked mission.\n");
+    printf("    --bench-blit <mission> draw the mission map with each blit kernel and print timings.\n");
+    printf("    --bench-frames <n>    number of frames drawn by the blit benchmark (default: 200).\n");
+    printf("    --bench-roads <mission> build the road graph of the mission map and time routes.\n");
+    printf("    --bench-routes <n>    number of routes searched by the road benchmark (default: 10000).\n");
+    printf("    --check-roads         compare routes of the road graph with a search over the tiles on all maps.\n");
+    printf("    --check-route-heap    check the open list of the vehicle route search in --bench-routes random searches.\n");
+    printf("    --bench-assets <mission> time loading of data files with and without the asset cache.\n");
+    printf("    --bench-surfaces      time the walkable surfaces of all missions with and without the surface cache.\n");
+    printf("    --bench-search        time the search of missions with and without the mission index.\n");
+    printf("    --bench-voxels        compare memory and traversal time of the map cells of all missions.\n");
+    printf("    --bench-voxel-rounds <n> number of traversals of each map (default: 20).\n");
+    printf("    --bench-map-cache     load all missions in a row with and without prefetch of maps.\n");
+    printf("    --bench-map-budget <kb> memory budget of the map cache (default: the one of the ini file).\n");
+    printf("    --bench-paths         time flood and A* ped paths between random tiles of all maps, fail if A* paths are longer than allowed.\n");
+    printf("    --bench-path-count <n> number of paths searched on each map (default: 1000).\n");
+    printf("    --bench-lines         compare checkBlockedByTile with its former sampling on random lines of all maps.\n");
+    printf("    --bench-line-count <n> number of lines checked on each map (default: 100000).\n");
+    printf("    --profile <file>      write a Chrome trace to the file, first 1048576 zones of each thread.\n");
 
 #ifdef _WIN32
     printf(" (default: freesynd.ini in the same folder as freesynd.exe)\n");
@@ -544,6 +579,43 @@ int main(int argc, char *argv[]) {
     std::string iniPath;
 
     bool disable_sound = true;
+    // Benchmark parameters : no benchmark if mission is 0
+    int benchMission = 0;
+    int benchSeconds = 60;
+    unsigned int benchSeed = 1;
+    bool benchOrders = true;
+    bool benchPerceptionCache = true;
+    int benchCrowd = 0;
+    // Blit benchmark parameters : no benchmark if mission is 0
+    int blitMission = 0;
+    int blitFrames = 200;
+    // Road benchmark parameters : no benchmark if mission is 0
+    int roadMission = 0;
+    int roadRoutes = 10000;
+    // True to check the routes of the road graph on all maps
+    bool checkRoads = false;
+    // True to check the open list of the vehicle route search
+    bool checkRouteHeap = false;
+    // Asset benchmark parameters : no benchmark if mission is 0
+    int assetMission = 0;
+    // True to run the surface cache benchmark
+    bool benchSurfaces = false;
+    // True to run the mission search benchmark
+    bool benchSearch = false;
+    // True to run the map storage benchmark
+    bool benchVoxels = false;
+    int voxelRounds = 20;
+    // True to run the map cache benchmark
+    bool benchMapCache = false;
+    int mapCacheBudget = -1;
+    // True to run the ped path benchmark
+    bool benchPaths = false;
+    int pathCount = 1000;
+    // True to run the tile blocking benchmark
+    bool benchLines = false;
+    int lineCount = 100000;
+    // File receiving the profiler trace
+    std::string profilePath;
 
     for (int i = 1; i < argc; ++i) {
 
@@ -556,6 +628,127 @@ int main(int argc, char *argv[]) {
             i++;
             iniPath = argv[i];
         }
+
+        if (0 == strcmp("--bench", argv[i]) && i + 1 < argc) {
+            i++;
+            benchMission = atoi(argv[i]);
+        }
+
+        if (0 == strcmp("--bench-seconds", argv[i]) && i + 1 < argc) {
+            i++;
+            benchSeconds = atoi(argv[i]);
+        }
+
+        if (0 == strcmp("--bench-seed", argv[i]) && i + 1 < argc) {
+            i++;
+            benchSeed = (unsigned int) atoi(argv[i]);
+        }
+
+        if (0 == strcmp("--bench-no-orders", argv[i])) {
+            benchOrders = false;
+        }
+
+        if (0 == strcmp("--bench-no-perception-cache", argv[i])) {
+            benchPerceptionCache = false;
+        }
+
+        if (0 == strcmp("--bench-crowd", argv[i]) && i + 1 < argc) {
+            i++;
+            benchCrowd = atoi(argv[i]);
+        }
+
+        if (0 == strcmp("--bench-blit", argv[i]) && i + 1 < argc) {
+            i++;
+            blitMission = atoi(argv[i]);
+        }
+
+        if (0 == strcmp("--bench-frames", argv[i]) && i + 1 < argc) {
+            i++;
+            blitFrames = atoi(argv[i]);
+        }
+
+        if (0 == strcmp("--bench-roads", argv[i]) && i + 1 < argc) {
+            i++;
+            roadMission = atoi(argv[i]);
+        }
+
+        if (0 == strcmp("--bench-routes", argv[i]) && i + 1 < argc) {
+            i++;
+            roadRoutes = atoi(argv[i]);
+        }
+
+        if (0 == strcmp("--check-roads", argv[i])) {
+            checkRoads = true;
+        }
+
+        if (0 == strcmp("--check-route-heap", argv[i])) {
+            checkRouteHeap = true;
+        }
+
+        if (0 == strcmp("--bench-assets", argv[i]) && i + 1 < argc) {
+            i++;
+            assetMission = atoi(argv[i]);
+        }
+
+        if (0 == strcmp("--bench-surfaces", argv[i])) {
+            benchSurfaces = true;
+        }
+
+        if (0 == strcmp("--bench-search", argv[i])) {
+            benchSearch = true;
+        }
+
+        if (0 == strcmp("--bench-voxels", argv[i])) {
+            benchVoxels = true;
+        }
+
+        if (0 == strcmp("--bench-voxel-rounds", argv[i]) && i + 1 < argc) {
+            i++;
+            voxelRounds = atoi(argv[i]);
+        }
+
+        if (0 == strcmp("--bench-map-cache", argv[i])) {
+            benchMapCache = true;
+        }
+
+        if (0 == strcmp("--bench-map-budget", argv[i]) && i + 1 < argc) {
+            i++;
+            mapCacheBudget = atoi(argv[i]);
+        }
+
+        if (0 == strcmp("--bench-paths", argv[i])) {
+            benchPaths = true;
+        }
+
+        if (0 == strcmp("--bench-path-count", argv[i]) && i + 1 < argc) {
+            i++;
+            pathCount = atoi(argv[i]);
+        }
+
+        if (0 == strcmp("--bench-lines", argv[i])) {
+            benchLines = true;
+        }
+
+        if (0 == strcmp("--bench-line-count", argv[i]) && i + 1 < argc) {
+            i++;
+            lineCount = atoi(argv[i]);
+        }
+
+        if (0 == strcmp("--profile", argv[i]) && i + 1 < argc) {
+            i++;
+            profilePath = argv[i];
+        }
+    }
+
+    if (benchMission != 0 || blitMission != 0 || roadMission != 0 || assetMission != 0 ||
+        benchSurfaces || benchSearch || benchVoxels || benchMapCache || benchPaths || benchLines ||
+        checkRoads || checkRouteHeap) {
+        // No window is needed to run the benchmark
+#ifdef _WIN32
+        _putenv("SDL_VIDEODRIVER=dummy");
+#else
+        setenv("SDL_VIDEODRIVER", "dummy", 1);
+#endif
     }
 
 #ifdef _DEBUG
@@ -583,13 +776,95 @@ int main(int argc, char *argv[]) {
         }
     }
 
+    Profiler::initialize();
+    if (!profilePath.empty()) {
+        Profiler::startCapture();
+    }
+
     LOG(Log::k_FLG_INFO, "Main", "main", ("----- Initializing application..."))
     std::unique_ptr<EditorApp> app(new EditorApp(disable_sound));
 
+    int res = 0;
     if (app->initialize(iniPath)) {
         LOG(Log::k_FLG_INFO, "Main", "main", ("----- Initializing application completed"))
-        LOG(Log::k_FLG_INFO, "Main", "main", ("----- Starting game loop"))
-        app->run();
+        if (benchMission != 0) {
+            LOG(Log::k_FLG_INFO, "Main", "main", ("----- Starting benchmark"))
+            MissionBenchmark bench(benchMission, benchSeconds, benchSeed, benchOrders);
+            bench.setPerceptionCache(benchPerceptionCache);
+            bench.setCrowd(benchCrowd);
+            if (!bench.run()) {
+                res = -1;
+            }
+        } else if (blitMission != 0) {
+            LOG(Log::k_FLG_INFO, "Main", "main", ("----- Starting blit benchmark"))
+            BlitBenchmark bench(blitMission, blitFrames);
+            if (!bench.run()) {
+                res = -1;
+            }
+        } else if (roadMission != 0) {
+            LOG(Log::k_FLG_INFO, "Main", "main", ("----- Starting road benchmark"))
+            RoadBenchmark bench(roadMission, roadRoutes, benchSeed);
+            if (!bench.run()) {
+                res = -1;
+            }
+        } else if (checkRoads) {
+            LOG(Log::k_FLG_INFO, "Main", "main", ("----- Starting road check"))
+            RoadBenchmark bench(0, roadRoutes, benchSeed);
+            if (!bench.runRouteCheck()) {
+                res = -1;
+            }
+        } else if (checkRouteHeap) {
+            LOG(Log::k_FLG_INFO, "Main", "main", ("----- Starting route heap check"))
+            RoadBenchmark bench(0, roadRoutes, benchSeed);
+            if (!bench.runHeapCheck()) {
+                res = -1;
+            }
+        } else if (assetMission != 0) {
+            LOG(Log::k_FLG_INFO, "Main", "main", ("----- Starting asset benchmark"))
+            AssetBenchmark bench(assetMission);
+            if (!bench.run()) {
+                res = -1;
+            }
+        } else if (benchSurfaces) {
+            LOG(Log::k_FLG_INFO, "Main", "main", ("----- Starting surface benchmark"))
+            SurfaceBenchmark bench;
+            if (!bench.run()) {
+                res = -1;
+            }
+        } else if (benchSearch) {
+            LOG(Log::k_FLG_INFO, "Main", "main", ("----- Starting search benchmark"))
+            SearchBenchmark bench;
+            if (!bench.run()) {
+                res = -1;
+            }
+        } else if (benchVoxels) {
+            LOG(Log::k_FLG_INFO, "Main", "main", ("----- Starting voxel benchmark"))
+            VoxelBenchmark bench(voxelRounds);
+            if (!bench.run()) {
+                res = -1;
+            }
+        } else if (benchMapCache) {
+            LOG(Log::k_FLG_INFO, "Main", "main", ("----- Starting map cache benchmark"))
+            MapCacheBenchmark bench(mapCacheBudget);
+            if (!bench.run()) {
+                res = -1;
+            }
+        } else if (benchPaths) {
+            LOG(Log::k_FLG_INFO, "Main", "main", ("----- Starting path benchmark"))
+            PathBenchmark bench(pathCount, benchSeed);
+            if (!bench.run()) {
+                res = -1;
+            }
+        } else if (benchLines) {
+            LOG(Log::k_FLG_INFO, "Main", "main", ("----- Starting line benchmark"))
+            LineBenchmark bench(lineCount, benchSeed);
+            if (!bench.run()) {
+                res = -1;
+            }
+        } else {
+            LOG(Log::k_FLG_INFO, "Main", "main", ("----- Starting game loop"))
+            app->run();
+        }
     } else {
         LOG(Log::k_FLG_INFO, "Main", "main", ("----- Initializing application failed"))
     }
@@ -598,10 +873,15 @@ int main(int argc, char *argv[]) {
     LOG(Log::k_FLG_INFO, "Main", "main", ("----- End of game loop. Destroy application"))
     app->destroy();
 
+    if (!profilePath.empty() && !Profiler::stopCapture(profilePath)) {
+        res = -1;
+    }
+    Profiler::destroy();
+
 #ifdef _DEBUG
     // Close log
     Log::close();
 #endif
 
-    return 0;
+    return res;
 }
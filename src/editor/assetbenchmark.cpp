@@ -0,0 +1,127 @@
+/************************************************************************
+ *                                                                      *
+ *  FreeSynd - a remake of the classic Bullfrog game "Syndicate".       *
+ *                                                                      *
+ *   Copyright (C) 2016  Benoit Blancard <benblan@users.sourceforge.net>*
+ *                                                                      *
+ *    This program is free software;  you can redistribute it and / or  *
+ *  modify it  under the  terms of the  GNU General  Public License as  *
+ *  published by the Free Software Foundation; either version 2 of the  *
+ *  License, or (at your option) any later version.                     *
+ *                                                                      *
+ *    This program is  distributed in the hope that it will be useful,  *
+ *  but WITHOUT  ANY WARRANTY;  without even  the implied  warranty of  *
+ *  MERCHANTABILITY  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU  *
+ *  General Public License for more details.                            *
+ *                                                                      *
+ *    You can view the GNU  General Public License, online, at the GNU  *
+ *  project's  web  site;  see <http://www.gnu.org/licenses/gpl.html>.  *
+ *  The full text of the license is also included in the file COPYING.  *
+ *                                                                      *
+ ************************************************************************/
+
+#include <cstdio>
+
+#include "editor/assetbenchmark.h"
+#include "editor/editorapp.h"
+#include "missionmanager.h"
+#include "mission.h"
+#include "resources.h"
+#include "utils/assetcache.h"
+#include "utils/file.h"
+#include "utils/log.h"
+#include "utils/timer.h"
+
+AssetBenchmark::AssetBenchmark(int missionId) {
+    missionId_ = missionId;
+}
+
+/*!
+ * Every byte of a file is read so that mapped pages are really loaded.
+ * \param files Names of original files
+ * \param pSum Receives the sum of all bytes, which must be the same for all passes
+ * \return Time spent
+ */
+uint64 AssetBenchmark::loadFiles(const std::vector<std::string> &files, uint32 *pSum) {
+    uint64 startTime = fs_utils::microTime();
+    for (size_t i = 0; i < files.size(); i++) {
+        FileData data;
+        if (File::loadOriginalData(files[i], &data)) {
+            const uint8 *pData = data.data();
+            for (int j = 0; j < data.size(); j++) {
+                *pSum += pData[j];
+            }
+        }
+    }
+    return fs_utils::microTime() - startTime;
+}
+
+/*!
+ * Loads the mission once to know its map, then loads the files of each
+ * group once per pass.
+ * \return False if the mission could not be loaded or if a pass did not
+ * give the same content as the others.
+ */
+bool AssetBenchmark::run() {
+    Mission *pMission = g_gameCtrl.missions().loadMission(missionId_);
+    if (pMission == NULL) {
+        FSERR(Log::k_FLG_GAME, "AssetBenchmark", "run", ("Cannot load mission %d\n", missionId_))
+        return false;
+    }
+    int mapId = pMission->mapId();
+    delete pMission;
+
+    char tmp[100];
+    std::vector<std::string> startupFiles;
+    startupFiles.push_back(TILE_TYPES);
+    startupFiles.push_back(TILE_SET);
+    startupFiles.push_back("hspr-0.tab");
+    startupFiles.push_back("hspr-0.dat");
+    std::vector<std::string> missionFiles;
+    sprintf(tmp, "map%02d.dat", mapId);
+    missionFiles.push_back(tmp);
+    sprintf(tmp, GAME_PATTERN, missionId_);
+    missionFiles.push_back(tmp);
+
+    bool wasEnabled = AssetCache::isEnabled();
+    uint64 startupTime[kNbPasses];
+    uint64 missionTime[kNbPasses];
+    uint32 sums[kNbPasses];
+    AssetCache::Stats cacheStats[kNbPasses];
+    for (int pass = 0; pass < kNbPasses; pass++) {
+        AssetCache::setEnabled(pass != kPassNoCache);
+        if (pass == kPassCold) {
+            for (size_t i = 0; i < startupFiles.size(); i++) {
+                AssetCache::remove(startupFiles[i]);
+            }
+            for (size_t i = 0; i < missionFiles.size(); i++) {
+                AssetCache::remove(missionFiles[i]);
+            }
+        }
+        AssetCache::resetStats();
+        sums[pass] = 0;
+        startupTime[pass] = loadFiles(startupFiles, &sums[pass]);
+        missionTime[pass] = loadFiles(missionFiles, &sums[pass]);
+        cacheStats[pass] = AssetCache::stats();
+    }
+    AssetCache::setEnabled(wasEnabled);
+
+    const char *passNames[kNbPasses] = { "no_cache", "cold", "warm" };
+    printf("{\n");
+    printf("  \"mission\": %d,\n", missionId_);
+    printf("  \"map\": %d,\n", mapId);
+    for (int pass = 0; pass < kNbPasses; pass++) {
+        printf("  \"%s\": {\n", passNames[pass]);
+        printf("    \"startup_ms\": %.3f,\n", startupTime[pass] / 1000.0);
+        printf("    \"mission_ms\": %.3f,\n", missionTime[pass] / 1000.0);
+        printf("    \"cache_hits\": %u,\n", cacheStats[pass].hits);
+        printf("    \"cache_misses\": %u,\n", cacheStats[pass].misses);
+        printf("    \"cache_written\": %u\n", cacheStats[pass].written);
+        printf("  },\n");
+    }
+    bool same = sums[kPassCold] == sums[kPassNoCache] && sums[kPassWarm] == sums[kPassNoCache];
+    printf("  \"same_content\": %s\n", same ? "true" : "false");
+    printf("}\n");
+    fflush(stdout);
+    return same;
+}
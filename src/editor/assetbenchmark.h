@@ -0,0 +1,66 @@
+#ifndef EDITOR_ASSETBENCHMARK_H_
+#define EDITOR_ASSETBENCHMARK_H_
+
+/************************************************************************
+ *                                                                      *
+ *  FreeSynd - a remake of the classic Bullfrog game "Syndicate".       *
+ *                                                                      *
+ *   Copyright (C) 2016  Benoit Blancard <benblan@users.sourceforge.net>*
+ *                                                                      *
+ *    This program is free software;  you can redistribute it and / or  *
+ *  modify it  under the  terms of the  GNU General  Public License as  *
+ *  published by the Free Software Foundation; either version 2 of the  *
+ *  License, or (at your option) any later version.                     *
+ *                                                                      *
+ *    This program is  distributed in the hope that it will be useful,  *
+ *  but WITHOUT  ANY WARRANTY;  without even  the implied  warranty of  *
+ *  MERCHANTABILITY  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU  *
+ *  General Public License for more details.                            *
+ *                                                                      *
+ *    You can view the GNU  General Public License, online, at the GNU  *
+ *  project's  web  site;  see <http://www.gnu.org/licenses/gpl.html>.  *
+ *  The full text of the license is also included in the file COPYING.  *
+ *                                                                      *
+ ************************************************************************/
+
+#include <string>
+#include <vector>
+
+#include "common.h"
+
+/*!
+ * Measures how long it takes to load the data files read at startup
+ * (tiles and sprites) and the ones read for a mission (map and level data)
+ * without the asset cache, with an empty cache and with a filled cache.
+ * Timings are printed as a JSON object on standard output.
+ */
+class AssetBenchmark {
+public:
+    AssetBenchmark(int missionId);
+
+    //! Runs the benchmark and prints the report
+    bool run();
+
+protected:
+    /*!
+     * How files are loaded during a pass.
+     */
+    enum EPass {
+        //! Cache is disabled
+        kPassNoCache = 0,
+        //! Cache entries are removed before loading
+        kPassCold,
+        //! Cache entries have been written by the previous pass
+        kPassWarm,
+        kNbPasses
+    };
+
+    //! Loads the files and returns the time in microseconds
+    uint64 loadFiles(const std::vector<std::string> &files, uint32 *pSum);
+
+protected:
+    /*! Id of the mission whose files are loaded.*/
+    int missionId_;
+};
+
+#endif  // EDITOR_ASSETBENCHMARK_H_
@@ -0,0 +1,428 @@
+/************************************************************************
+ *                                                                      *
+ *  FreeSynd - a remake of the classic Bullfrog game "Syndicate".       *
+ *                                                                      *
+ *   Copyright (C) 2016  Benoit Blancard <benblan@users.sourceforge.net>*
+ *                                                                      *
+ *    This program is free software;  you can redistribute it and / or  *
+ *  modify it  under the  terms of the  GNU General  Public License as  *
+ *  published by the Free Software Foundation; either version 2 of the  *
+ *  License, or (at your option) any later version.                     *
+ *                                                                      *
+ *    This program is  distributed in the hope that it will be useful,  *
+ *  but WITHOUT  ANY WARRANTY;  without even  the implied  warranty of  *
+ *  MERCHANTABILITY  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU  *
+ *  General Public License for more details.                            *
+ *                                                                      *
+ *    You can view the GNU  General Public License, online, at the GNU  *
+ *  project's  web  site;  see <http://www.gnu.org/licenses/gpl.html>.  *
+ *  The full text of the license is also included in the file COPYING.  *
+ *                                                                      *
+ ************************************************************************/
+
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <set>
+#include <vector>
+
+#include "editor/blitbenchmark.h"
+#include "editor/editorapp.h"
+#include "gfx/blitkernels.h"
+#include "gfx/sprite.h"
+#include "gfx/tile.h"
+#include "map.h"
+#include "menus/maprenderer.h"
+#include "menus/squadselection.h"
+#include "missionmanager.h"
+#include "mission.h"
+#include "ped.h"
+#include "appcontext.h"
+#include "core/gamesession.h"
+#include "utils/log.h"
+#include "utils/timer.h"
+
+/*! Number of memory allocations counted so far.*/
+static long gNbAllocations = 0;
+/*! True when allocations made by the current thread are counted.*/
+static thread_local bool tCountAllocations = false;
+
+// the dump tool replaces the global allocation functions to count
+// the allocations made while rendering
+void * operator new(size_t size) {
+    if (tCountAllocations) {
+        gNbAllocations++;
+    }
+    void *p = malloc(size > 0 ? size : 1);
+    if (p == NULL) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void * operator new[](size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void *p) noexcept {
+    free(p);
+}
+
+void operator delete[](void *p) noexcept {
+    free(p);
+}
+
+BlitBenchmark::BlitBenchmark(int missionId, int frames) {
+    missionId_ = missionId;
+    frames_ = frames;
+}
+
+/*!
+ * Loads the mission and draws the viewport centered on the squad leader
+ * with each kernel.
+ * \return False if the mission could not be loaded or if a kernel
+ * did not draw the same pixels as the scalar one.
+ */
+bool BlitBenchmark::run() {
+    bool kernelsOk = checkKernels();
+
+    Mission *pMission = g_gameCtrl.missions().loadMission(missionId_);
+    if (pMission == NULL) {
+        FSERR(Log::k_FLG_GAME, "BlitBenchmark", "run", ("Cannot load mission %d\n", missionId_))
+        return false;
+    }
+    g_Session.setMission(pMission);
+    pMission->start();
+
+    SquadSelection selection;
+    selection.setSquad(pMission->getSquad());
+    MapRenderer renderer;
+    renderer.init(pMission, &selection);
+
+    // same viewport as the gameplay menu at the start of the mission
+    Point2D viewport;
+    PedInstance *pLeader = selection.leader();
+    pMission->get_map()->tileToScreenPoint(pLeader->tileX(), pLeader->tileY(),
+        pMission->mmax_z_ + 1, 0, 0, &viewport);
+    viewport.x -= (Screen::kScreenWidth - Screen::kScreenPanelWidth) / 2;
+    viewport.y -= Screen::kScreenHeight / 2;
+    if (viewport.x < 0)
+        viewport.x = 0;
+    if (viewport.y < 0)
+        viewport.y = 0;
+
+    fs_blit::EKernel bestKernel = fs_blit::currentKernel();
+    std::vector<uint8> reference;
+    bool sameFrames = true;
+
+    printf("{\n");
+    printf("  \"mission\": %d,\n", missionId_);
+    printf("  \"frames\": %d,\n", frames_);
+    printf("  \"rows_check\": %s,\n", kernelsOk ? "true" : "false");
+    printf("  \"kernels\": {\n");
+    bool first = true;
+    for (int k = fs_blit::kKernelScalar; k < fs_blit::kNbKernels; k++) {
+        fs_blit::EKernel kernel = (fs_blit::EKernel) k;
+        if (!fs_blit::useKernel(kernel)) {
+            continue;
+        }
+
+        g_Screen.clear(0);
+        uint64 startTime = fs_utils::microTime();
+        for (int i = 0; i < frames_; i++) {
+            // draw the whole viewport each time
+            renderer.invalidate();
+            renderer.render(viewport);
+        }
+        uint64 runTime = fs_utils::microTime() - startTime;
+
+        const uint8 *pixels = g_Screen.pixels();
+        size_t size = Screen::kScreenWidth * Screen::kScreenHeight;
+        bool same = true;
+        if (reference.empty()) {
+            reference.assign(pixels, pixels + size);
+        } else {
+            same = memcmp(&reference[0], pixels, size) == 0;
+            sameFrames &= same;
+        }
+
+        printf("%s    \"%s\": { \"us_per_frame\": %.1f, \"same_pixels\": %s }",
+            first ? "" : ",\n", fs_blit::kernelName(kernel),
+            frames_ > 0 ? (double) runTime / frames_ : 0.0, same ? "true" : "false");
+        first = false;
+    }
+    printf("\n  },\n");
+
+    renderer.invalidate();
+    renderer.render(viewport);
+    const MapRenderer::RenderStats &stats = renderer.stats();
+    printf("  \"tiles_per_frame\": {\n");
+    printf("    \"map_cells\": %d,\n",
+        pMission->get_map()->maxX() * pMission->get_map()->maxY() * pMission->get_map()->maxZ());
+    printf("    \"map_opaque_tiles\": %d,\n", pMission->get_map()->drawList().size());
+    printf("    \"sweep_cells\": %d,\n", countSweepCells(pMission->get_map(), viewport));
+    printf("    \"visited\": %d,\n", stats.tilesVisited);
+    printf("    \"drawn\": %d,\n", stats.tilesDrawn);
+    printf("    \"object_cells\": %d,\n", stats.objectCells);
+    printf("    \"objects\": %d\n", stats.objects);
+    printf("  },\n");
+
+    // the mission runs between frames so objects move, appear and disappear
+    int simStep = 1000 / g_Ctx.getSimRate();
+    for (int i = 0; i < 10; i++) {
+        pMission->simulateStep(simStep);
+        renderer.render(viewport);
+    }
+    long allocations = 0;
+    long maxAllocations = 0;
+    for (int i = 0; i < frames_; i++) {
+        pMission->simulateStep(simStep);
+        long before = gNbAllocations;
+        tCountAllocations = true;
+        renderer.render(viewport);
+        tCountAllocations = false;
+        long frameAllocations = gNbAllocations - before;
+        allocations += frameAllocations;
+        maxAllocations = frameAllocations > maxAllocations ? frameAllocations : maxAllocations;
+    }
+    printf("  \"render_allocations\": { \"per_frame\": %.2f, \"max_in_frame\": %ld },\n",
+        frames_ > 0 ? (double) allocations / frames_ : 0.0, maxAllocations);
+
+    fs_blit::useKernel(bestKernel);
+    bool sameSprites = benchSpriteSets(pMission->get_map());
+    printf("}\n");
+    fflush(stdout);
+
+    pMission->end();
+    g_Session.setMission(NULL);
+    return kernelsOk && sameFrames && sameSprites;
+}
+
+/*!
+ * Copies random rows with all widths and alignments with each kernel,
+ * flipped and not, and compares the result with the scalar kernel.
+ */
+bool BlitBenchmark::checkKernels() {
+    const int kMaxWidth = 100;
+    uint8 src[kMaxWidth + 32];
+    uint8 expected[kMaxWidth + 32];
+    uint8 dst[kMaxWidth + 32];
+    bool ok = true;
+    fs_blit::EKernel current = fs_blit::currentKernel();
+
+    for (int k = fs_blit::kKernelScalar + 1; k < fs_blit::kNbKernels; k++) {
+        fs_blit::EKernel kernel = (fs_blit::EKernel) k;
+        if (!fs_blit::isSupported(kernel)) {
+            continue;
+        }
+
+        for (int width = 1; width <= kMaxWidth; width++) {
+            for (int offset = 0; offset < 32; offset++) {
+                for (size_t i = 0; i < sizeof(src); i++) {
+                    // a quarter of pixels are transparent
+                    src[i] = rand() % 4 == 0 ? fs_blit::kTransparentColor : rand() % 255;
+                    expected[i] = dst[i] = rand() % 256;
+                }
+
+                for (int flipped = 0; flipped < 2; flipped++) {
+                    const uint8 *pSrc = flipped ? src + offset + width - 1 : src + offset;
+                    fs_blit::useKernel(fs_blit::kKernelScalar);
+                    if (flipped) {
+                        fs_blit::copyRowFlipped(expected + offset, pSrc, width);
+                    } else {
+                        fs_blit::copyRow(expected + offset, pSrc, width);
+                    }
+                    fs_blit::useKernel(kernel);
+                    if (flipped) {
+                        fs_blit::copyRowFlipped(dst + offset, pSrc, width);
+                    } else {
+                        fs_blit::copyRow(dst + offset, pSrc, width);
+                    }
+
+                    if (memcmp(expected, dst, sizeof(dst)) != 0) {
+                        FSERR(Log::k_FLG_GFX, "BlitBenchmark", "checkKernels",
+                            ("Kernel %s differs from scalar for width %d offset %d flipped %d\n",
+                            fs_blit::kernelName(kernel), width, offset, flipped))
+                        ok = false;
+                    }
+                }
+            }
+        }
+    }
+
+    fs_blit::useKernel(current);
+    return ok;
+}
+
+/*!
+ * Counts the cells a diagonal sweep over all the cells that may be on
+ * screen looks at, as the renderer did before it used the draw list
+ * of the map : each of these cells was read to find if it had a tile
+ * to draw.
+ */
+int BlitBenchmark::countSweepCells(Map *pMap, const Point2D &viewport) {
+    TilePoint mtp = pMap->screenToTilePoint(viewport.x, viewport.y);
+    int chk = Screen::kScreenWidth / (TILE_WIDTH / 2) + 2
+        + Screen::kScreenHeight / (TILE_HEIGHT / 3) + pMap->maxZ() * 2;
+    int sh = mtp.ty - 8;
+    int shm = sh + chk;
+    int cmw = viewport.x + Screen::kScreenWidth - Screen::kScreenPanelWidth + 128;
+    int cmh = viewport.y + Screen::kScreenHeight + 128;
+    int chky = sh < 0 ? 0 : sh;
+    int nbCells = 0;
+
+    for (int inc = 0; inc < shm + pMap->maxZ() + 1; ++inc) {
+        int ye = sh + inc;
+        int tile_z = pMap->maxZ() + 1;
+        for (int yb = ye - pMap->maxZ() - 2; yb < ye; ++yb, --tile_z) {
+            if (yb < 0 || yb < sh || yb >= shm || tile_z >= pMap->maxZ()) {
+                continue;
+            }
+            int tile_y = yb;
+            for (int tile_x = mtp.tx; tile_y >= chky && tile_x < pMap->maxX(); ++tile_x, --tile_y) {
+                if (tile_x < 0 || tile_y >= pMap->maxY()) {
+                    continue;
+                }
+                int screen_w = (pMap->maxX() + (tile_x - tile_y)) * (TILE_WIDTH / 2);
+                int coord_h = ((pMap->maxZ() + tile_x + tile_y) - (tile_z - 1)) * (TILE_HEIGHT / 3);
+                if (screen_w >= viewport.x - TILE_WIDTH * 2 && screen_w + TILE_WIDTH * 2 < cmw
+                    && coord_h >= viewport.y - TILE_HEIGHT * 2 && coord_h + TILE_HEIGHT * 2 < cmh) {
+                    nbCells++;
+                }
+            }
+        }
+    }
+    return nbCells;
+}
+
+/*!
+ * Collects the game sprites and the tiles used by the map and prints
+ * the results of each set.
+ * \return False if a sprite was not drawn the same way with spans
+ */
+bool BlitBenchmark::benchSpriteSets(Map *pMap) {
+    std::vector<SpanImage> sprites;
+    GameSpriteManager &spriteMgr = g_App.gameSprites();
+    for (int i = 0; i < spriteMgr.spriteCount(); i++) {
+        Sprite *pSprite = spriteMgr.sprite(i);
+        if (pSprite->spans().isBuilt()) {
+            SpanImage image = { pSprite->pixels(), pSprite->width(),
+                pSprite->height(), pSprite->stride(), &pSprite->spans() };
+            sprites.push_back(image);
+        }
+    }
+
+    std::set<Tile *> mapTiles;
+    for (int z = 0; z < pMap->maxZ(); z++) {
+        for (int y = 0; y < pMap->maxY(); y++) {
+            for (int x = 0; x < pMap->maxX(); x++) {
+                mapTiles.insert(pMap->getTileAt(x, y, z));
+            }
+        }
+    }
+    std::vector<SpanImage> tiles;
+    for (std::set<Tile *>::iterator it = mapTiles.begin(); it != mapTiles.end(); it++) {
+        SpanImage image = { (*it)->pixels() + (TILE_HEIGHT - 1) * TILE_WIDTH,
+            TILE_WIDTH, TILE_HEIGHT, -TILE_WIDTH, &(*it)->spans() };
+        tiles.push_back(image);
+    }
+
+    printf("  \"sprite_sets\": {\n");
+    bool same = benchSpriteSet("game_sprites", sprites);
+    printf(",\n");
+    same &= benchSpriteSet("map_tiles", tiles);
+    printf("\n  }\n");
+    return same;
+}
+
+/*!
+ * Prints how many transparent bytes the span lists skip at each draw
+ * of the whole set and the time to draw a sprite with and without them.
+ */
+bool BlitBenchmark::benchSpriteSet(const char *name, const std::vector<SpanImage> &images) {
+    long pixels = 0;
+    long opaque = 0;
+    long spans = 0;
+    long spanBytes = 0;
+    bool same = true;
+    g_Screen.resetClipRect();
+    for (size_t i = 0; i < images.size(); i++) {
+        const SpanImage &image = images[i];
+        pixels += image.width * image.height;
+        opaque += image.pSpans->numOpaquePixels();
+        spans += image.pSpans->numSpans();
+        spanBytes += (long) image.pSpans->memorySize();
+
+        // inside the screen, flipped and partly out of the screen
+        same &= sameSpanBlit(image, 20, 20, false);
+        same &= sameSpanBlit(image, 20, 20, true);
+        same &= sameSpanBlit(image, -image.width / 2, -image.height / 2, true);
+        same &= sameSpanBlit(image, -image.width / 2, -image.height / 2, false);
+    }
+
+    int rounds = frames_ / 10 > 0 ? frames_ / 10 : 1;
+    uint64 startTime = fs_utils::microTime();
+    for (int r = 0; r < rounds; r++) {
+        for (size_t i = 0; i < images.size(); i++) {
+            const SpanImage &image = images[i];
+            g_Screen.blit(200, 100, image.width, image.height, image.pixels,
+                (r & 1) != 0, image.stride);
+        }
+    }
+    uint64 blitTime = fs_utils::microTime() - startTime;
+
+    startTime = fs_utils::microTime();
+    for (int r = 0; r < rounds; r++) {
+        for (size_t i = 0; i < images.size(); i++) {
+            const SpanImage &image = images[i];
+            g_Screen.blitSpans(200, 100, image.width, image.height, image.pixels,
+                image.stride, *image.pSpans, (r & 1) != 0);
+        }
+    }
+    uint64 spansTime = fs_utils::microTime() - startTime;
+
+    double nbDraws = (double) rounds * images.size();
+    printf("    \"%s\": {\n", name);
+    printf("      \"images\": %d,\n", (int) images.size());
+    printf("      \"pixels\": %ld,\n", pixels);
+    printf("      \"opaque_pixels\": %ld,\n", opaque);
+    printf("      \"spans\": %ld,\n", spans);
+    printf("      \"span_bytes\": %ld,\n", spanBytes);
+    printf("      \"skipped_bytes_per_set_draw\": %ld,\n", pixels - opaque);
+    printf("      \"us_per_sprite_blit\": %.3f,\n", nbDraws > 0 ? blitTime / nbDraws : 0.0);
+    printf("      \"us_per_sprite_spans\": %.3f,\n", nbDraws > 0 ? spansTime / nbDraws : 0.0);
+    printf("      \"same_pixels\": %s\n", same ? "true" : "false");
+    printf("    }");
+    return same;
+}
+
+/*!
+ * Draws the image on a cleared part of the screen with blit() then with
+ * blitSpans() and compares both results.
+ */
+bool BlitBenchmark::sameSpanBlit(const SpanImage &image, int x, int y, bool flipped) {
+    int w = image.width + 40 < Screen::kScreenWidth ? image.width + 40 : Screen::kScreenWidth;
+    int h = image.height + 40 < Screen::kScreenHeight ? image.height + 40 : Screen::kScreenHeight;
+    std::vector<uint8> expected(w * h);
+
+    g_Screen.drawRect(0, 0, w, h, 0);
+    g_Screen.blit(x, y, image.width, image.height, image.pixels, flipped, image.stride);
+    for (int j = 0; j < h; j++) {
+        memcpy(&expected[j * w], g_Screen.pixels() + j * Screen::kScreenWidth, w);
+    }
+
+    g_Screen.drawRect(0, 0, w, h, 0);
+    g_Screen.blitSpans(x, y, image.width, image.height, image.pixels, image.stride,
+        *image.pSpans, flipped);
+    for (int j = 0; j < h; j++) {
+        if (memcmp(&expected[j * w], g_Screen.pixels() + j * Screen::kScreenWidth, w) != 0) {
+            FSERR(Log::k_FLG_GFX, "BlitBenchmark", "sameSpanBlit",
+                ("Spans differ from blit for image %dx%d at %d,%d flipped %d\n",
+                image.width, image.height, x, y, flipped))
+            return false;
+        }
+    }
+    return true;
+}
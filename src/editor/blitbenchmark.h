@@ -0,0 +1,83 @@
+#ifndef EDITOR_BLITBENCHMARK_H_
+#define EDITOR_BLITBENCHMARK_H_
+
+/************************************************************************
+ *                                                                      *
+ *  FreeSynd - a remake of the classic Bullfrog game "Syndicate".       *
+ *                                                                      *
+ *   Copyright (C) 2016  Benoit Blancard <benblan@users.sourceforge.net>*
+ *                                                                      *
+ *    This program is free software;  you can redistribute it and / or  *
+ *  modify it  under the  terms of the  GNU General  Public License as  *
+ *  published by the Free Software Foundation; either version 2 of the  *
+ *  License, or (at your option) any later version.                     *
+ *                                                                      *
+ *    This program is  distributed in the hope that it will be useful,  *
+ *  but WITHOUT  ANY WARRANTY;  without even  the implied  warranty of  *
+ *  MERCHANTABILITY  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU  *
+ *  General Public License for more details.                            *
+ *                                                                      *
+ *    You can view the GNU  General Public License, online, at the GNU  *
+ *  project's  web  site;  see <http://www.gnu.org/licenses/gpl.html>.  *
+ *  The full text of the license is also included in the file COPYING.  *
+ *                                                                      *
+ ************************************************************************/
+
+
+#include <vector>
+
+#include "common.h"
+#include "gfx/spanlist.h"
+#include "model/position.h"
+
+class Map;
+
+/*!
+ * Measures the blit kernels : the whole map viewport of a mission is drawn
+ * a number of times with each kernel the CPU supports and the time is
+ * printed as a JSON object on standard output. Every kernel must give
+ * the same pixels as the scalar one.
+ * Then the game sprites and the tiles of the map are drawn with and
+ * without their span lists to show what skipping transparent runs saves.
+ * It also tells how many tiles the renderer looks at to draw a frame
+ * compared to the cells a sweep over the whole screen would look at,
+ * and how many memory allocations a render makes while the mission runs.
+ */
+class BlitBenchmark {
+public:
+    BlitBenchmark(int missionId, int frames);
+
+    //! Runs the benchmark and prints the report
+    bool run();
+
+protected:
+    /*!
+     * Pixels of a sprite or a tile with their runs of opaque pixels.
+     */
+    struct SpanImage {
+        const uint8 *pixels;
+        int width;
+        int height;
+        int stride;
+        const SpanList *pSpans;
+    };
+
+    //! Compares each kernel with the scalar one on random rows
+    bool checkKernels();
+    //! Prints the results for the game sprites and the tiles of the map
+    bool benchSpriteSets(Map *pMap);
+    //! Draws every image with and without spans and prints the results
+    bool benchSpriteSet(const char *name, const std::vector<SpanImage> &images);
+    //! Returns the number of cells looked at by a sweep over the screen
+    static int countSweepCells(Map *pMap, const Point2D &viewport);
+    //! Returns true if the image is drawn the same way with and without spans
+    bool sameSpanBlit(const SpanImage &image, int x, int y, bool flipped);
+
+protected:
+    /*! Id of the mission to draw.*/
+    int missionId_;
+    /*! Number of times the viewport is drawn.*/
+    int frames_;
+};
+
+#endif  // EDITOR_BLITBENCHMARK_H_
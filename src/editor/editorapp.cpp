@@ -51,6 +51,8 @@
 #include "sound/audio.h"
 #include "utils/ccrc32.h"
 #include "utils/file.h"
+#include "utils/assetcache.h"
+#include "surfacecache.h"
 #include "utils/log.h"
 #include "utils/configfile.h"
 #include "utils/portablefile.h"
@@ -176,6 +178,13 @@ bool EditorApp::readConfiguration() {
         string ourDataDir;
         context_->setFullScreen(conf.read("fullscreen", false));
         context_->setTimeForClick(conf.read("time_for_click", 80));
+        context_->setPathFinder(conf.read("path_finder", 0) == 1 ?
+            AppContext::PATHFINDER_ASTAR : AppContext::PATHFINDER_FLOOD);
+        context_->setPathWorkers(conf.read("path_workers", 0));
+        context_->setSimRate(conf.read("sim_rate", 30));
+        AssetCache::setEnabled(conf.read("asset_cache", true));
+        SurfaceCache::setMode((SurfaceCache::EMode) conf.read("surface_cache", 2));
+        maps_.setMemoryBudget((size_t) conf.read("map_cache_kb", 16384) * 1024);
         bool origDataDirFound = conf.readInto(origDataDir, "data_dir");
         bool ourDataDirFound = conf.readInto(ourDataDir, "freesynd_data_dir");
 
@@ -42,6 +42,7 @@
 #include "sound/musicmanager.h"
 #include "appcontext.h"
 #include "core/gamecontroller.h"
+#include "editor/missionindex.h"
 
 /*!
  * Editor Application class.
@@ -97,6 +98,8 @@ class EditorApp : public Singleton < EditorApp > {
     static std::string defaultIniFolder();
     //! Return the list of missions found in the search menu
     std::list<int> & getMissionResultList() { return searchResLst_;}
+    //! Return the index used to search missions
+    MissionIndex & missionIndex() { return missionIndex_; }
 
 #ifdef _DEBUG
 public:
@@ -135,6 +138,8 @@ private:
      * Use to store id of missions that are found in the search menu.
      */
     std::list<int> searchResLst_;
+    /*! What is known of each mission, built on first search.*/
+    MissionIndex missionIndex_;
 };
 
 #define g_App   EditorApp::singleton()
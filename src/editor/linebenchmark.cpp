@@ -0,0 +1,159 @@
+/************************************************************************
+ *                                                                      *
+ *  FreeSynd - a remake of the classic Bullfrog game "Syndicate".       *
+ *                                                                      *
+ *   Copyright (C) 2016  Benoit Blancard <benblan@users.sourceforge.net>*
+ *                                                                      *
+ *    This program is free software;  you can redistribute it and / or  *
+ *  modify it  under the  terms of the  GNU General  Public License as  *
+ *  published by the Free Software Foundation; either version 2 of the  *
+ *  License, or (at your option) any later version.                     *
+ *                                                                      *
+ *    This program is  distributed in the hope that it will be useful,  *
+ *  but WITHOUT  ANY WARRANTY;  without even  the implied  warranty of  *
+ *  MERCHANTABILITY  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU  *
+ *  General Public License for more details.                            *
+ *                                                                      *
+ *    You can view the GNU  General Public License, online, at the GNU  *
+ *  project's  web  site;  see <http://www.gnu.org/licenses/gpl.html>.  *
+ *  The full text of the license is also included in the file COPYING.  *
+ *                                                                      *
+ ************************************************************************/
+
+#include <cstdio>
+#include <cstdlib>
+#include <set>
+#include <vector>
+
+#include "editor/linebenchmark.h"
+#include "editor/editorapp.h"
+#include "missionmanager.h"
+#include "mission.h"
+#include "utils/log.h"
+#include "utils/timer.h"
+
+const int LineBenchmark::kNbMissions = 50;
+const int LineBenchmark::kHitTolerance = 16;
+
+LineBenchmark::LineBenchmark(int nbLines, unsigned int seed) {
+    nbLines_ = nbLines > 0 ? nbLines : 1;
+    seed_ = seed;
+}
+
+/*!
+ * Each map is checked once, with the first mission that uses it.
+ * Both implementations are not expected to agree on every line : the
+ * sampling misses tiles whose corner is crossed by less than 8 units.
+ * \return False if no map could be loaded.
+ */
+bool LineBenchmark::run() {
+    std::set<int> mapIds;
+
+    printf("{\n");
+    printf("  \"seed\": %u,\n", seed_);
+    printf("  \"lines\": %d,\n", nbLines_);
+    printf("  \"hit_tolerance\": %d,\n", kHitTolerance);
+    printf("  \"maps\": [\n");
+    for (int missionId = 1; missionId <= kNbMissions; missionId++) {
+        Mission *pMission = g_gameCtrl.missions().loadMission(missionId);
+        if (pMission == NULL) {
+            FSERR(Log::k_FLG_GAME, "LineBenchmark", "run", ("Cannot load mission %d\n", missionId))
+            continue;
+        }
+
+        if (mapIds.find(pMission->mapId()) == mapIds.end()) {
+            printf("%s", mapIds.empty() ? "" : ",\n");
+            mapIds.insert(pMission->mapId());
+            benchMap(pMission);
+        }
+        delete pMission;
+    }
+    printf("\n  ]\n");
+    printf("}\n");
+    fflush(stdout);
+
+    return !mapIds.empty();
+}
+
+/*!
+ * Lines start anywhere in the map, go up to 1500 units away on the ground
+ * and 300 units up or down, and may be cut by a maximum distance, as shots
+ * of the different weapons.
+ */
+void LineBenchmark::benchMap(Mission *pMission) {
+    srand(seed_);
+    int maxX = pMission->mmax_x_ * 256;
+    int maxY = pMission->mmax_y_ * 256;
+    int maxZ = (pMission->mmax_z_ - 1) * 128;
+
+    std::vector<WorldPoint> origins;
+    std::vector<WorldPoint> targets;
+    std::vector<double> ranges;
+    while ((int) origins.size() < nbLines_) {
+        WorldPoint origin;
+        origin.x = rand() % maxX;
+        origin.y = rand() % maxY;
+        origin.z = rand() % maxZ;
+        WorldPoint target;
+        target.x = origin.x + rand() % 3000 - 1500;
+        target.y = origin.y + rand() % 3000 - 1500;
+        target.z = origin.z + rand() % 600 - 300;
+        if (target.x < 0 || target.y < 0 || target.z < 0 || target.x >= maxX
+            || target.y >= maxY || target.z > maxZ) {
+            continue;
+        }
+        origins.push_back(origin);
+        targets.push_back(target);
+        ranges.push_back(500 + rand() % 3000);
+    }
+
+    std::vector<WorldPoint> hits(targets);
+    std::vector<uint8> masks(nbLines_);
+    uint64 startTime = fs_utils::microTime();
+    for (int i = 0; i < nbLines_; i++) {
+        masks[i] = pMission->checkBlockedByTile(origins[i], &hits[i], true, ranges[i]);
+    }
+    uint64 traversalTime = fs_utils::microTime() - startTime;
+
+    std::vector<WorldPoint> sampledHits(targets);
+    std::vector<uint8> sampledMasks(nbLines_);
+    startTime = fs_utils::microTime();
+    for (int i = 0; i < nbLines_; i++) {
+        sampledMasks[i] = pMission->checkBlockedByTileSampled(origins[i], &sampledHits[i], ranges[i]);
+    }
+    uint64 sampledTime = fs_utils::microTime() - startTime;
+
+    int nbBlocked = 0;
+    int nbSampledOnly = 0;
+    int nbTraversalOnly = 0;
+    int nbHitDiffs = 0;
+    for (int i = 0; i < nbLines_; i++) {
+        bool blocked = (masks[i] & 16) != 0;
+        bool sampledBlocked = (sampledMasks[i] & 16) != 0;
+        if (blocked) {
+            nbBlocked++;
+        }
+        if (blocked && !sampledBlocked) {
+            nbTraversalOnly++;
+        } else if (!blocked && sampledBlocked) {
+            nbSampledOnly++;
+        } else if (blocked) {
+            int ex = hits[i].x - sampledHits[i].x;
+            int ey = hits[i].y - sampledHits[i].y;
+            int ez = hits[i].z - sampledHits[i].z;
+            if (ex * ex + ey * ey + ez * ez > kHitTolerance * kHitTolerance) {
+                nbHitDiffs++;
+            }
+        }
+    }
+
+    printf("    { \"map\": %d, \"blocked\": %d,", pMission->mapId(), nbBlocked);
+    printf(" \"blocked_by_traversal_only\": %d, \"blocked_by_sampling_only\": %d,",
+        nbTraversalOnly, nbSampledOnly);
+    printf(" \"hit_point_diffs\": %d,", nbHitDiffs);
+    printf(" \"verdict_diff_percent\": %.2f,",
+        100.0 * (nbTraversalOnly + nbSampledOnly) / nbLines_);
+    printf(" \"lines_per_second\": { \"sampling\": %.0f, \"traversal\": %.0f } }",
+        sampledTime > 0 ? nbLines_ * 1000000.0 / sampledTime : 0.0,
+        traversalTime > 0 ? nbLines_ * 1000000.0 / traversalTime : 0.0);
+}
@@ -0,0 +1,60 @@
+#ifndef EDITOR_LINEBENCHMARK_H_
+#define EDITOR_LINEBENCHMARK_H_
+
+/************************************************************************
+ *                                                                      *
+ *  FreeSynd - a remake of the classic Bullfrog game "Syndicate".       *
+ *                                                                      *
+ *   Copyright (C) 2016  Benoit Blancard <benblan@users.sourceforge.net>*
+ *                                                                      *
+ *    This program is free software;  you can redistribute it and / or  *
+ *  modify it  under the  terms of the  GNU General  Public License as  *
+ *  published by the Free Software Foundation; either version 2 of the  *
+ *  License, or (at your option) any later version.                     *
+ *                                                                      *
+ *    This program is  distributed in the hope that it will be useful,  *
+ *  but WITHOUT  ANY WARRANTY;  without even  the implied  warranty of  *
+ *  MERCHANTABILITY  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU  *
+ *  General Public License for more details.                            *
+ *                                                                      *
+ *    You can view the GNU  General Public License, online, at the GNU  *
+ *  project's  web  site;  see <http://www.gnu.org/licenses/gpl.html>.  *
+ *  The full text of the license is also included in the file COPYING.  *
+ *                                                                      *
+ ************************************************************************/
+
+#include "common.h"
+
+class Mission;
+
+/*!
+ * Compares, for each map used by a mission, Mission::checkBlockedByTile()
+ * with its former implementation that sampled the line every 8 units.
+ * Random lines are checked by both and the number of lines where they
+ * disagree is printed with their timings as a JSON object on standard
+ * output.
+ */
+class LineBenchmark {
+public:
+    LineBenchmark(int nbLines, unsigned int seed);
+
+    //! Runs the benchmark and prints the report
+    bool run();
+
+protected:
+    //! Checks the lines on the map of the mission and prints the results
+    void benchMap(Mission *pMission);
+
+protected:
+    /*! Number of missions in the game.*/
+    static const int kNbMissions;
+    /*! Hit points farther than this distance are counted as different.*/
+    static const int kHitTolerance;
+
+    /*! Number of lines checked on each map.*/
+    int nbLines_;
+    /*! Seed for random generator.*/
+    unsigned int seed_;
+};
+
+#endif  // EDITOR_LINEBENCHMARK_H_
@@ -0,0 +1,119 @@
+/************************************************************************
+ *                                                                      *
+ *  FreeSynd - a remake of the classic Bullfrog game "Syndicate".       *
+ *                                                                      *
+ *   Copyright (C) 2016  Benoit Blancard <benblan@users.sourceforge.net>*
+ *                                                                      *
+ *    This program is free software;  you can redistribute it and / or  *
+ *  modify it  under the  terms of the  GNU General  Public License as  *
+ *  published by the Free Software Foundation; either version 2 of the  *
+ *  License, or (at your option) any later version.                     *
+ *                                                                      *
+ *    This program is  distributed in the hope that it will be useful,  *
+ *  but WITHOUT  ANY WARRANTY;  without even  the implied  warranty of  *
+ *  MERCHANTABILITY  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU  *
+ *  General Public License for more details.                            *
+ *                                                                      *
+ *    You can view the GNU  General Public License, online, at the GNU  *
+ *  project's  web  site;  see <http://www.gnu.org/licenses/gpl.html>.  *
+ *  The full text of the license is also included in the file COPYING.  *
+ *                                                                      *
+ ************************************************************************/
+
+#include <cstdio>
+
+#include "SDL.h"
+
+#include "editor/mapcachebenchmark.h"
+#include "editor/editorapp.h"
+#include "missionmanager.h"
+#include "mission.h"
+#include "mapmanager.h"
+#include "utils/log.h"
+#include "utils/timer.h"
+
+const int MapCacheBenchmark::kNbMissions = 50;
+const int MapCacheBenchmark::kSelectDelay = 100;
+
+MapCacheBenchmark::MapCacheBenchmark(int budgetKb) {
+    budgetKb_ = budgetKb;
+}
+
+/*!
+ * \return False if no mission could be loaded
+ */
+bool MapCacheBenchmark::run() {
+    MapManager &maps = g_App.maps();
+    size_t oldBudget = maps.memoryBudget();
+    if (budgetKb_ >= 0) {
+        maps.setMemoryBudget((size_t) budgetKb_ * 1024);
+    }
+
+    printf("{\n");
+    printf("  \"budget_kb\": %d,\n", (int) (maps.memoryBudget() / 1024));
+    printf("  \"select_delay_ms\": %d,\n", kSelectDelay);
+    printf("  \"passes\": [\n");
+    bool ok = runPass(false);
+    printf(",\n");
+    ok = runPass(true) && ok;
+    printf("\n  ]\n");
+    printf("}\n");
+    fflush(stdout);
+
+    maps.setMemoryBudget(oldBudget);
+    return ok;
+}
+
+/*!
+ * The cache is emptied before the pass. Each mission is loaded, its map
+ * lists are built as when the mission is played, then it is deleted.
+ * With prefetch, the map is asked before a delay that stands for the
+ * time the player spends in the briefing.
+ * \param prefetch True to prefetch the map of each mission
+ * \return False if no mission could be loaded
+ */
+bool MapCacheBenchmark::runPass(bool prefetch) {
+    MapManager &maps = g_App.maps();
+    maps.clearCache();
+    maps.resetStats();
+
+    uint64 loadTime = 0;
+    uint64 maxLoadTime = 0;
+    size_t peakBytes = 0;
+    int nbMissions = 0;
+    for (int missionId = 1; missionId <= kNbMissions; missionId++) {
+        if (prefetch) {
+            g_gameCtrl.missions().prefetchMap(missionId);
+        }
+        SDL_Delay(kSelectDelay);
+
+        uint64 startTime = fs_utils::microTime();
+        Mission *pMission = g_gameCtrl.missions().loadMission(missionId);
+        uint64 time = fs_utils::microTime() - startTime;
+        if (pMission == NULL) {
+            FSERR(Log::k_FLG_GAME, "MapCacheBenchmark", "runPass", ("Cannot load mission %d\n", missionId))
+            continue;
+        }
+        loadTime += time;
+        if (time > maxLoadTime) {
+            maxLoadTime = time;
+        }
+
+        pMission->get_map()->drawList();
+        pMission->get_map()->roadGraph();
+        if (maps.residentBytes() > peakBytes) {
+            peakBytes = maps.residentBytes();
+        }
+        nbMissions++;
+        delete pMission;
+    }
+
+    const MapManager::Stats &stats = maps.stats();
+    printf("    { \"prefetch\": %s, \"missions\": %d,", prefetch ? "true" : "false", nbMissions);
+    printf(" \"load_ms\": %.3f, \"max_load_ms\": %.3f,", loadTime / 1000.0, maxLoadTime / 1000.0);
+    printf(" \"hits\": %u, \"misses\": %u, \"prefetches\": %u, \"evictions\": %u,",
+        stats.hits, stats.misses, stats.prefetches, stats.evictions);
+    printf(" \"peak_resident_kb\": %d, \"resident_kb\": %d, \"maps\": %d }",
+        (int) (peakBytes / 1024), (int) (maps.residentBytes() / 1024), (int) maps.nbMaps());
+    return nbMissions > 0;
+}
@@ -0,0 +1,55 @@
+#ifndef EDITOR_MAPCACHEBENCHMARK_H_
+#define EDITOR_MAPCACHEBENCHMARK_H_
+
+/************************************************************************
+ *                                                                      *
+ *  FreeSynd - a remake of the classic Bullfrog game "Syndicate".       *
+ *                                                                      *
+ *   Copyright (C) 2016  Benoit Blancard <benblan@users.sourceforge.net>*
+ *                                                                      *
+ *    This program is free software;  you can redistribute it and / or  *
+ *  modify it  under the  terms of the  GNU General  Public License as  *
+ *  published by the Free Software Foundation; either version 2 of the  *
+ *  License, or (at your option) any later version.                     *
+ *                                                                      *
+ *    This program is  distributed in the hope that it will be useful,  *
+ *  but WITHOUT  ANY WARRANTY;  without even  the implied  warranty of  *
+ *  MERCHANTABILITY  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU  *
+ *  General Public License for more details.                            *
+ *                                                                      *
+ *    You can view the GNU  General Public License, online, at the GNU  *
+ *  project's  web  site;  see <http://www.gnu.org/licenses/gpl.html>.  *
+ *  The full text of the license is also included in the file COPYING.  *
+ *                                                                      *
+ ************************************************************************/
+
+#include "common.h"
+
+/*!
+ * Plays the missions one after the other as in a campaign, without and
+ * with the prefetch of maps, and prints how long missions waited for
+ * their map and how much memory the map cache used, as a JSON object on
+ * standard output.
+ */
+class MapCacheBenchmark {
+public:
+    MapCacheBenchmark(int budgetKb);
+
+    //! Runs the benchmark and prints the report
+    bool run();
+
+protected:
+    //! Loads each mission once and prints the results of the pass
+    bool runPass(bool prefetch);
+
+protected:
+    /*! Number of missions in the game.*/
+    static const int kNbMissions;
+    /*! Time in ms between the prefetch and the start of the mission.*/
+    static const int kSelectDelay;
+
+    /*! Memory budget of the cache in KB, -1 to keep the one of the configuration.*/
+    int budgetKb_;
+};
+
+#endif  // EDITOR_MAPCACHEBENCHMARK_H_
@@ -0,0 +1,355 @@
+/************************************************************************
+ *                                                                      *
+ *  FreeSynd - a remake of the classic Bullfrog game "Syndicate".       *
+ *                                                                      *
+ *   Copyright (C) 2015  Benoit Blancard <benblan@users.sourceforge.net>*
+ *                                                                      *
+ *    This program is free software;  you can redistribute it and / or  *
+ *  modify it  under the  terms of the  GNU General  Public License as  *
+ *  published by the Free Software Foundation; either version 2 of the  *
+ *  License, or (at your option) any later version.                     *
+ *                                                                      *
+ *    This program is  distributed in the hope that it will be useful,  *
+ *  but WITHOUT  ANY WARRANTY;  without even  the implied  warranty of  *
+ *  MERCHANTABILITY  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU  *
+ *  General Public License for more details.                            *
+ *                                                                      *
+ *    You can view the GNU  General Public License, online, at the GNU  *
+ *  project's  web  site;  see <http://www.gnu.org/licenses/gpl.html>.  *
+ *  The full text of the license is also included in the file COPYING.  *
+ *                                                                      *
+ ************************************************************************/
+
+#include <cstdio>
+#include <cstdlib>
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+#include "editor/missionbenchmark.h"
+#include "editor/editorapp.h"
+#include "appcontext.h"
+#include "agentmanager.h"
+#include "missionmanager.h"
+#include "ped.h"
+#include "pedmanager.h"
+#include "pathsurfaces.h"
+#include "model/squad.h"
+#include "model/vehicle.h"
+#include "core/gamesession.h"
+#include "utils/log.h"
+#include "utils/timer.h"
+
+const int MissionBenchmark::kOrderPeriod = 5000;
+const int MissionBenchmark::kNbRangeQueries = 10000;
+const int MissionBenchmark::kQueryRange = 1024;
+
+MissionBenchmark::MissionBenchmark(int missionId, int seconds, unsigned int seed, bool randomOrders) {
+    missionId_ = missionId;
+    seconds_ = seconds;
+    seed_ = seed;
+    randomOrders_ = randomOrders;
+    perceptionCache_ = true;
+    nbOrders_ = 0;
+    nbCrowdPeds_ = 0;
+    gridQueryTime_ = 0;
+    scanQueryTime_ = 0;
+    nbObjectsInRange_ = 0;
+}
+
+/*!
+ * Loads the mission and runs it by fixed steps, as the gameplay menu does,
+ * until the simulated time is reached.
+ * \return False if the mission could not be loaded or if the grid did not
+ * find the same objects as the scan
+ */
+bool MissionBenchmark::run() {
+    srand(seed_);
+
+    uint64 startTime = fs_utils::microTime();
+    Mission *pMission = g_gameCtrl.missions().loadMission(missionId_);
+    if (pMission == NULL) {
+        FSERR(Log::k_FLG_GAME, "MissionBenchmark", "run", ("Cannot load mission %d\n", missionId_))
+        return false;
+    }
+    if (nbCrowdPeds_ > 0) {
+        spawnCrowd(pMission);
+    }
+    // some objects get the current mission from the session
+    g_Session.setMission(pMission);
+    pMission->start();
+    pMission->perception().setCacheEnabled(perceptionCache_);
+    uint64 loadTime = fs_utils::microTime() - startTime;
+
+    int simStep = 1000 / g_Ctx.getSimRate();
+    int nbSteps = (seconds_ * 1000) / simStep;
+    int orderTimer = 0;
+
+    LOG(Log::k_FLG_GAME, "MissionBenchmark", "run", ("Running mission %d for %d steps of %d ms",
+        missionId_, nbSteps, simStep))
+
+    profile_.reset();
+    startTime = fs_utils::microTime();
+    for (int i = 0; i < nbSteps; i++) {
+        if (randomOrders_) {
+            orderTimer -= simStep;
+            if (orderTimer <= 0) {
+                giveRandomOrders(pMission);
+                orderTimer = kOrderPeriod;
+            }
+        }
+        pMission->simulateStep(simStep, &profile_);
+    }
+    uint64 runTime = fs_utils::microTime() - startTime;
+
+    bool sameObjects = true;
+    if (!crowd_.empty()) {
+        sameObjects = benchRangeQueries(pMission);
+    }
+
+    printReport(pMission, nbSteps, simStep, loadTime, runTime);
+
+    pMission->end();
+    // session owns the mission since setMission(pMission) : it deletes it here
+    g_Session.setMission(NULL);
+    crowd_.clear();
+    return sameObjects;
+}
+
+/*!
+ * Every living agent who is not doing anything and is not in a vehicle
+ * receives the order to walk to a random walkable tile.
+ */
+void MissionBenchmark::giveRandomOrders(Mission *pMission) {
+    for (size_t i = AgentManager::kSlot1; i < AgentManager::kMaxSlot; i++) {
+        PedInstance *pAgent = pMission->getSquad()->member(i);
+        if (pAgent != NULL) {
+            giveRandomOrder(pMission, pAgent);
+        }
+    }
+
+    for (size_t i = 0; i < crowd_.size(); i++) {
+        giveRandomOrder(pMission, crowd_[i]);
+    }
+}
+
+void MissionBenchmark::giveRandomOrder(Mission *pMission, PedInstance *pPed) {
+    if (!pPed->isAlive() || pPed->inVehicle() != NULL || pPed->currentAction() != NULL) {
+        return;
+    }
+
+    // a few tries to find a tile where a ped can stand
+    for (int tries = 0; tries < 16; tries++) {
+        TilePoint destPosT(rand() % pMission->mmax_x_, rand() % pMission->mmax_y_,
+            pPed->tileZ(), 128, 128);
+        if (pMission->getWalkableClosestByZ(destPosT)) {
+            pPed->addActionWalk(destPosT, false);
+            nbOrders_++;
+            break;
+        }
+    }
+}
+
+/*!
+ * Civilians are copies of the first civilian of the mission file, placed
+ * on random tiles that are walkable and off the roads. They are created
+ * by the PedManager as the peds of the mission so they have the same
+ * behaviour.
+ */
+void MissionBenchmark::spawnCrowd(Mission *pMission) {
+    LevelData::LevelDataAll levelData;
+    if (!g_gameCtrl.missions().load_level_data(missionId_, levelData)) {
+        FSERR(Log::k_FLG_GAME, "MissionBenchmark", "spawnCrowd", ("Cannot read data of mission %d\n", missionId_))
+        return;
+    }
+
+    // first 8 peds are reserved for agents
+    const LevelData::People *pModel = NULL;
+    for (int i = 8; i < 256 && pModel == NULL; i++) {
+        const LevelData::People &people = levelData.people[i];
+        if (people.type_ped == PedInstance::kPedTypeCivilian &&
+            people.location == LevelData::kPeopleLocOnMap &&
+            people.state != LevelData::kPeopleStateDead) {
+            pModel = &people;
+        }
+    }
+    if (pModel == NULL) {
+        FSERR(Log::k_FLG_GAME, "MissionBenchmark", "spawnCrowd", ("No civilian in mission %d\n", missionId_))
+        return;
+    }
+
+    const uint8 safeWalk = m_fdWalkable | m_fdSafeWalk;
+    int nbNodes = pMission->mmax_m_xy * pMission->mmax_z_;
+    std::vector<int> walkables;
+    for (int i = 0; i < nbNodes; i++) {
+        if ((pMission->mdpoints_[i].bfNodeDesc & safeWalk) == safeWalk) {
+            walkables.push_back(i);
+        }
+    }
+    if (walkables.empty()) {
+        return;
+    }
+
+    PedManager peds;
+    for (int i = 0; i < nbCrowdPeds_; i++) {
+        int node = walkables[rand() % walkables.size()];
+        LevelData::People people = *pModel;
+        people.mapposx[1] = node % pMission->mmax_x_;
+        people.mapposx[0] = 128;
+        people.mapposy[1] = (node % pMission->mmax_m_xy) / pMission->mmax_x_;
+        people.mapposy[0] = 128;
+        uint16 z = (node / pMission->mmax_m_xy) * 128;
+        people.mapposz[0] = z & 0xFF;
+        people.mapposz[1] = z >> 8;
+        people.state = 0;
+
+        // ids follow the ones of the mission file
+        PedInstance *pPed = peds.loadInstance(people, 256 + i, pMission->mapId(),
+            PedInstance::kPlayerGroupId);
+        if (pPed != NULL) {
+            pMission->addPed(pPed);
+            crowd_.push_back(pPed);
+        }
+    }
+}
+
+/*!
+ * Queries are centered on random peds, as explosions are often around
+ * them. Objects returned by the grid are filtered by distance, as the
+ * callers of the grid do, and compared with a scan of all objects.
+ * \return False if the grid and the scan did not find the same number of objects
+ */
+bool MissionBenchmark::benchRangeQueries(Mission *pMission) {
+    const int natures = MapObject::kNaturePed | MapObject::kNatureStatic
+        | MapObject::kNatureVehicle | MapObject::kNatureWeapon;
+    std::vector<WorldPoint> centers(kNbRangeQueries);
+    for (int i = 0; i < kNbRangeQueries; i++) {
+        centers[i] = WorldPoint(pMission->ped(rand() % pMission->numPeds())->position());
+    }
+
+    std::vector<MapObject *> candidates;
+    int nbGridFound = 0;
+    uint64 startTime = fs_utils::microTime();
+    for (int i = 0; i < kNbRangeQueries; i++) {
+        candidates.clear();
+        pMission->objectsGrid().findInRange(centers[i], kQueryRange, natures, candidates);
+        for (size_t j = 0; j < candidates.size(); j++) {
+            if (candidates[j]->isCloseTo(centers[i], kQueryRange)) {
+                nbGridFound++;
+            }
+        }
+    }
+    gridQueryTime_ = fs_utils::microTime() - startTime;
+
+    int nbScanFound = 0;
+    startTime = fs_utils::microTime();
+    for (int i = 0; i < kNbRangeQueries; i++) {
+        for (size_t j = 0; j < pMission->numPeds(); j++) {
+            if (pMission->ped(j)->isCloseTo(centers[i], kQueryRange)) {
+                nbScanFound++;
+            }
+        }
+        for (size_t j = 0; j < pMission->numVehicles(); j++) {
+            if (pMission->vehicle(j)->isCloseTo(centers[i], kQueryRange)) {
+                nbScanFound++;
+            }
+        }
+        for (size_t j = 0; j < pMission->numStatics(); j++) {
+            if (pMission->statics(j)->isCloseTo(centers[i], kQueryRange)) {
+                nbScanFound++;
+            }
+        }
+        for (size_t j = 0; j < pMission->numWeaponsOnGround(); j++) {
+            if (pMission->weaponOnGround(j)->isCloseTo(centers[i], kQueryRange)) {
+                nbScanFound++;
+            }
+        }
+    }
+    scanQueryTime_ = fs_utils::microTime() - startTime;
+
+    nbObjectsInRange_ = nbScanFound;
+    if (nbGridFound != nbScanFound) {
+        FSERR(Log::k_FLG_GAME, "MissionBenchmark", "benchRangeQueries", ("Grid found %d objects instead of %d\n",
+            nbGridFound, nbScanFound))
+        return false;
+    }
+    return true;
+}
+
+void MissionBenchmark::printReport(Mission *pMission, int nbSteps, int simStep, uint64 loadTime, uint64 runTime) {
+    const char *status = "running";
+    if (pMission->completed()) {
+        status = "completed";
+    } else if (pMission->failed()) {
+        status = "failed";
+    }
+
+    double runSec = runTime / 1000000.0;
+
+    printf("{\n");
+    printf("  \"mission\": %d,\n", missionId_);
+    printf("  \"map\": %d,\n", pMission->mapId());
+    printf("  \"seed\": %u,\n", seed_);
+    printf("  \"random_orders\": %s,\n", randomOrders_ ? "true" : "false");
+    printf("  \"orders\": %d,\n", nbOrders_);
+    printf("  \"crowd\": %d,\n", (int) crowd_.size());
+    printf("  \"peds\": %d,\n", (int) pMission->numPeds());
+    printf("  \"vehicles\": %d,\n", (int) pMission->numVehicles());
+    printf("  \"statics\": %d,\n", (int) pMission->numStatics());
+    printf("  \"status\": \"%s\",\n", status);
+    printf("  \"step_ms\": %d,\n", simStep);
+    printf("  \"steps\": %d,\n", nbSteps);
+    printf("  \"simulated_seconds\": %.3f,\n", nbSteps * simStep / 1000.0);
+    printf("  \"load_ms\": %.3f,\n", loadTime / 1000.0);
+    printf("  \"run_ms\": %.3f,\n", runTime / 1000.0);
+    printf("  \"steps_per_second\": %.1f,\n", runSec > 0 ? nbSteps / runSec : 0.0);
+    printf("  \"us_per_step\": %.2f,\n",
+        nbSteps > 0 ? (double) profile_.totalTime / nbSteps : 0.0);
+    printf("  \"parts_us\": {\n");
+    for (int i = 0; i < SimProfile::kNbParts; i++) {
+        printf("    \"%s\": %llu%s\n", SimProfile::partName(i),
+            (unsigned long long) profile_.partTime[i],
+            i + 1 < SimProfile::kNbParts ? "," : "");
+    }
+    printf("  },\n");
+    const Perception::Stats &sight = pMission->perception().stats();
+    double simSec = nbSteps * simStep / 1000.0;
+    printf("  \"perception\": {\n");
+    printf("    \"cache\": %s,\n", perceptionCache_ ? "true" : "false");
+    printf("    \"queries\": %u,\n", sight.queries);
+    printf("    \"hits\": %u,\n", sight.hits);
+    printf("    \"culled\": %u,\n", sight.culled);
+    printf("    \"rays\": %u,\n", sight.rays);
+    printf("    \"rays_per_second\": %.1f\n", simSec > 0 ? sight.rays / simSec : 0.0);
+    printf("  },\n");
+    if (!crowd_.empty()) {
+        printf("  \"range_queries\": {\n");
+        printf("    \"queries\": %d,\n", kNbRangeQueries);
+        printf("    \"range\": %d,\n", kQueryRange);
+        printf("    \"mean_objects_in_range\": %.1f,\n", (double) nbObjectsInRange_ / kNbRangeQueries);
+        printf("    \"grid_us\": %llu,\n", (unsigned long long) gridQueryTime_);
+        printf("    \"scan_us\": %llu\n", (unsigned long long) scanQueryTime_);
+        printf("  },\n");
+    }
+    printf("  \"peak_memory_kb\": %ld\n", peakMemoryKb());
+    printf("}\n");
+    fflush(stdout);
+}
+
+long MissionBenchmark::peakMemoryKb() {
+#ifdef _WIN32
+    return -1;
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return -1;
+    }
+#ifdef __APPLE__
+    // ru_maxrss is in bytes on OS X
+    return usage.ru_maxrss / 1024;
+#else
+    return usage.ru_maxrss;
+#endif
+#endif
+}
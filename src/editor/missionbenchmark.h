@@ -0,0 +1,97 @@
+#ifndef EDITOR_MISSIONBENCHMARK_H_
+#define EDITOR_MISSIONBENCHMARK_H_
+
+/************************************************************************
+ *                                                                      *
+ *  FreeSynd - a remake of the classic Bullfrog game "Syndicate".       *
+ *                                                                      *
+ *   Copyright (C) 2015  Benoit Blancard <benblan@users.sourceforge.net>*
+ *                                                                      *
+ *    This program is free software;  you can redistribute it and / or  *
+ *  modify it  under the  terms of the  GNU General  Public License as  *
+ *  published by the Free Software Foundation; either version 2 of the  *
+ *  License, or (at your option) any later version.                     *
+ *                                                                      *
+ *    This program is  distributed in the hope that it will be useful,  *
+ *  but WITHOUT  ANY WARRANTY;  without even  the implied  warranty of  *
+ *  MERCHANTABILITY  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU  *
+ *  General Public License for more details.                            *
+ *                                                                      *
+ *    You can view the GNU  General Public License, online, at the GNU  *
+ *  project's  web  site;  see <http://www.gnu.org/licenses/gpl.html>.  *
+ *  The full text of the license is also included in the file COPYING.  *
+ *                                                                      *
+ ************************************************************************/
+
+#include <vector>
+
+#include "common.h"
+#include "mission.h"
+
+/*!
+ * Runs a mission without rendering for a given simulated time and
+ * prints how fast the simulation went as a JSON object on standard output.
+ * Agents can receive random walk orders so that pathfinding is used.
+ * A crowd of civilians walking to random places can be added to the
+ * mission to stress pathfinding and queries on mission objects.
+ */
+class MissionBenchmark {
+public:
+    MissionBenchmark(int missionId, int seconds, unsigned int seed, bool randomOrders);
+
+    //! Enables or disables the cache of the mission perception
+    void setPerceptionCache(bool enabled) { perceptionCache_ = enabled; }
+    //! Sets the number of civilians added to the mission
+    void setCrowd(int nbPeds) { nbCrowdPeds_ = nbPeds; }
+
+    //! Runs the benchmark and prints the report
+    bool run();
+
+protected:
+    //! Gives a random destination to every idle agent and crowd ped
+    void giveRandomOrders(Mission *pMission);
+    //! Gives a random destination to the ped if it is idle
+    void giveRandomOrder(Mission *pMission, PedInstance *pPed);
+    //! Adds civilians at random walkable places of the map
+    void spawnCrowd(Mission *pMission);
+    //! Times range queries with the objects grid and with a scan of all objects
+    bool benchRangeQueries(Mission *pMission);
+    //! Prints the results on standard output
+    void printReport(Mission *pMission, int nbSteps, int simStep, uint64 loadTime, uint64 runTime);
+    //! Returns the peak memory used by the process in KB or -1 if unknown
+    static long peakMemoryKb();
+
+protected:
+    /*! Period between two orders in milliseconds.*/
+    static const int kOrderPeriod;
+    /*! Number of range queries timed when a crowd is added.*/
+    static const int kNbRangeQueries;
+    /*! Range of the queries, as a big explosion.*/
+    static const int kQueryRange;
+
+    /*! Id of the mission to run.*/
+    int missionId_;
+    /*! Simulated time in seconds.*/
+    int seconds_;
+    /*! Seed for random generator.*/
+    unsigned int seed_;
+    /*! True to give random walk orders to agents.*/
+    bool randomOrders_;
+    /*! False to cast a ray for each visibility query.*/
+    bool perceptionCache_;
+    /*! Number of orders given to agents and crowd peds.*/
+    int nbOrders_;
+    /*! Number of civilians to add to the mission.*/
+    int nbCrowdPeds_;
+    /*! Civilians added to the mission.*/
+    std::vector<PedInstance *> crowd_;
+    /*! Time of range queries with the grid and with a scan in microseconds.*/
+    uint64 gridQueryTime_;
+    uint64 scanQueryTime_;
+    /*! Number of objects found in range by the queries.*/
+    int nbObjectsInRange_;
+    /*! Time spent by each part of the simulation.*/
+    SimProfile profile_;
+};
+
+#endif  // EDITOR_MISSIONBENCHMARK_H_
@@ -0,0 +1,359 @@
+/************************************************************************
+ *                                                                      *
+ *  FreeSynd - a remake of the classic Bullfrog game "Syndicate".       *
+ *                                                                      *
+ *   Copyright (C) 2016  Benoit Blancard <benblan@users.sourceforge.net>*
+ *                                                                      *
+ *    This program is free software;  you can redistribute it and / or  *
+ *  modify it  under the  terms of the  GNU General  Public License as  *
+ *  published by the Free Software Foundation; either version 2 of the  *
+ *  License, or (at your option) any later version.                     *
+ *                                                                      *
+ *    This program is  distributed in the hope that it will be useful,  *
+ *  but WITHOUT  ANY WARRANTY;  without even  the implied  warranty of  *
+ *  MERCHANTABILITY  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU  *
+ *  General Public License for more details.                            *
+ *                                                                      *
+ *    You can view the GNU  General Public License, online, at the GNU  *
+ *  project's  web  site;  see <http://www.gnu.org/licenses/gpl.html>.  *
+ *  The full text of the license is also included in the file COPYING.  *
+ *                                                                      *
+ ************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include "SDL.h"
+
+#include "editor/missionindex.h"
+#include "missionmanager.h"
+#include "resources.h"
+#include "model/leveldata.h"
+#include "utils/ccrc32.h"
+#include "utils/file.h"
+#include "utils/log.h"
+#include "utils/timer.h"
+
+/*!
+ * Header of the index file. The file is only read on the computer that
+ * wrote it so the header and the infos are written as is.
+ */
+struct MissionIndexHeader {
+    char magic[4];
+    uint32 version;
+    uint32 nbMissions;
+    //! CRC of the infos that follow the header
+    uint32 dataCrc;
+};
+
+/*! Increase it when MissionInfo or the way it's filled changes.*/
+static const uint32 kIndexVersion = 1;
+
+int MissionInfo::nbPedsOfType(int pedType) const {
+    for (int i = 0; i < kNbPedTypes; i++) {
+        if (pedType == (1 << i)) {
+            return nbPeds[i];
+        }
+    }
+    return 0;
+}
+
+bool MissionInfo::hasVehicleType(uint8 vehicleType) const {
+    return (vehicleTypes[vehicleType >> 5] & (1 << (vehicleType & 0x1F))) != 0;
+}
+
+bool MissionInfo::hasObjectiveType(uint8 objectiveType) const {
+    for (int i = 0; i < nbObjectives; i++) {
+        if (objectiveTypes[i] == objectiveType) {
+            return true;
+        }
+    }
+    return false;
+}
+
+MissionIndex::Query::Query() {
+    pedType = kAny;
+    vehicleType = kAny;
+    weaponType = kAny;
+    objectiveType = kAny;
+    mapId = kAny;
+}
+
+MissionIndex::MissionIndex() {
+    built_ = false;
+    buildTime_ = 0;
+}
+
+/*!
+ * Missions whose file has not changed since the index was saved are not
+ * read again. The others are read in parallel.
+ * \return False if no mission could be read.
+ */
+bool MissionIndex::build() {
+    uint64 startTime = fs_utils::microTime();
+    bool loaded = loadFile();
+
+    ScanContext ctxt;
+    ctxt.pIndex = this;
+    ctxt.next = 0;
+    infos_.resize(kNbMissions);
+    for (int id = 1; id <= kNbMissions; id++) {
+        MissionInfo &info = infos_[id - 1];
+        uint32 size = 0, time = 0;
+        bool exists = sourceInfo(id, &size, &time);
+        if (!loaded || info.missionId != id || info.valid != exists ||
+            (exists && (info.sourceSize != size || info.sourceTime != time))) {
+            ctxt.missions.push_back(id);
+        }
+    }
+
+    if (!ctxt.missions.empty()) {
+        ctxt.pMutex = SDL_CreateMutex();
+        std::vector<SDL_Thread *> threads;
+        for (int i = 0; i < kNbScanThreads && (size_t) i < ctxt.missions.size(); i++) {
+            SDL_Thread *pThread = SDL_CreateThread(scanLoop, &ctxt);
+            if (pThread == NULL) {
+                FSERR(Log::k_FLG_IO, "MissionIndex", "build", ("Unable to create thread : %s\n", SDL_GetError()));
+                break;
+            }
+            threads.push_back(pThread);
+        }
+        // the current thread also reads files, so missions are read even
+        // if no thread could be created
+        scanLoop(&ctxt);
+        for (size_t i = 0; i < threads.size(); i++) {
+            SDL_WaitThread(threads[i], NULL);
+        }
+        SDL_DestroyMutex(ctxt.pMutex);
+        saveFile();
+    }
+
+    int nbValid = 0;
+    for (size_t i = 0; i < infos_.size(); i++) {
+        if (infos_[i].valid) {
+            nbValid++;
+        }
+    }
+    built_ = nbValid > 0;
+    buildTime_ = fs_utils::microTime() - startTime;
+    LOG(Log::k_FLG_IO, "MissionIndex", "build", ("Index of %d missions built in %.1f ms, %d missions read",
+        nbValid, buildTime_ / 1000.0, (int) ctxt.missions.size()))
+    return built_;
+}
+
+void MissionIndex::search(const Query &query, std::list<int> &results) const {
+    for (size_t i = 0; i < infos_.size(); i++) {
+        const MissionInfo &info = infos_[i];
+        if (!info.valid) {
+            continue;
+        }
+        if (query.pedType != Query::kAny && info.nbPedsOfType(query.pedType) == 0) {
+            continue;
+        }
+        if (query.vehicleType != Query::kAny && !info.hasVehicleType(query.vehicleType)) {
+            continue;
+        }
+        if (query.weaponType != Query::kAny && (query.weaponType >= MissionInfo::kNbWeaponTypes ||
+            info.nbWeapons[query.weaponType] == 0)) {
+            continue;
+        }
+        if (query.objectiveType != Query::kAny && !info.hasObjectiveType(query.objectiveType)) {
+            continue;
+        }
+        if (query.mapId != Query::kAny && info.mapId != query.mapId) {
+            continue;
+        }
+        results.push_back(info.missionId);
+    }
+}
+
+const MissionInfo * MissionIndex::info(int missionId) const {
+    if (missionId < 1 || missionId > (int) infos_.size() || !infos_[missionId - 1].valid) {
+        return NULL;
+    }
+    return &infos_[missionId - 1];
+}
+
+/*!
+ * Reads missions one by one until all are read. Game files are loaded with
+ * File::loadOriginalData() which can be called by several threads.
+ */
+int MissionIndex::scanLoop(void *pData) {
+    ScanContext *pCtxt = static_cast<ScanContext *>(pData);
+    while (true) {
+        SDL_LockMutex(pCtxt->pMutex);
+        if (pCtxt->next == pCtxt->missions.size()) {
+            SDL_UnlockMutex(pCtxt->pMutex);
+            break;
+        }
+        int missionId = pCtxt->missions[pCtxt->next++];
+        SDL_UnlockMutex(pCtxt->pMutex);
+
+        // each thread reads a different mission, so there's no need to lock infos
+        scanMission(missionId, &(pCtxt->pIndex->infos_[missionId - 1]));
+    }
+    return 0;
+}
+
+/*!
+ * Peds, vehicles and weapons are counted as MissionManager would create them,
+ * except that agents are counted whatever the squad.
+ */
+void MissionIndex::scanMission(int missionId, MissionInfo *pInfo) {
+    memset(pInfo, 0, sizeof(MissionInfo));
+    pInfo->missionId = missionId;
+    if (!sourceInfo(missionId, &pInfo->sourceSize, &pInfo->sourceTime)) {
+        return;
+    }
+
+    // level data is too big for the stack of a thread
+    LevelData::LevelDataAll *pData = new LevelData::LevelDataAll();
+    MissionManager missions;
+    if (!missions.load_level_data(missionId, *pData)) {
+        delete pData;
+        return;
+    }
+
+    pInfo->valid = true;
+    pInfo->mapId = READ_LE_UINT16(pData->mapinfos.map);
+    pInfo->minX = READ_LE_UINT16(pData->mapinfos.min_x) / 2;
+    pInfo->minY = READ_LE_UINT16(pData->mapinfos.min_y) / 2;
+    pInfo->maxX = READ_LE_UINT16(pData->mapinfos.max_x) / 2;
+    pInfo->maxY = READ_LE_UINT16(pData->mapinfos.max_y) / 2;
+
+    for (int i = 0; i < 256; i++) {
+        const LevelData::People &ped = pData->people[i];
+        if (ped.type == 0x0 || ped.location == LevelData::kPeopleLocNotVisible ||
+            ped.location == LevelData::kPeopleLocAboveWalkSurf || (i >= 4 && i < 8)) {
+            continue;
+        }
+        for (int type = 0; type < MissionInfo::kNbPedTypes; type++) {
+            if (ped.type_ped == (1 << type)) {
+                pInfo->nbPeds[type]++;
+            }
+        }
+    }
+
+    for (int i = 0; i < 64; i++) {
+        const LevelData::Cars &car = pData->cars[i];
+        if (car.type == 0x0) {
+            continue;
+        }
+        pInfo->nbVehicles++;
+        pInfo->vehicleTypes[car.sub_type >> 5] |= 1 << (car.sub_type & 0x1F);
+    }
+
+    for (int i = 0; i < 512; i++) {
+        const LevelData::Weapons &weapon = pData->weapons[i];
+        if (weapon.desc == 0) {
+            continue;
+        }
+        Weapon::WeaponType type = MissionManager::weaponTypeFromValue(weapon.sub_type);
+        if (type != Weapon::Unknown) {
+            pInfo->nbWeapons[type]++;
+        }
+    }
+
+    for (int i = 0; i < MissionInfo::kMaxObjectives; i++) {
+        uint16 type = READ_LE_UINT16(pData->objectives[i].type);
+        if (type != 0) {
+            pInfo->objectiveTypes[pInfo->nbObjectives++] = (uint8) type;
+        }
+    }
+
+    delete pData;
+}
+
+bool MissionIndex::sourceInfo(int missionId, uint32 *pSize, uint32 *pTime) {
+    char name[20];
+    sprintf(name, GAME_PATTERN, missionId);
+    std::string path;
+    struct stat st;
+    if (!File::originalFilePath(name, &path) || stat(path.c_str(), &st) != 0) {
+        return false;
+    }
+    *pSize = (uint32) st.st_size;
+    *pTime = (uint32) st.st_mtime;
+    return true;
+}
+
+std::string MissionIndex::filePath() {
+    return File::homeFullPath("cache/missions.idx");
+}
+
+void MissionIndex::removeFile() {
+    remove(filePath().c_str());
+}
+
+/*!
+ * \return False if there's no saved index or if it can't be used.
+ */
+bool MissionIndex::loadFile() {
+    std::string path = filePath();
+    FILE *fp = fopen(path.c_str(), "rb");
+    if (fp == NULL) {
+        return false;
+    }
+
+    MissionIndexHeader header;
+    std::vector<MissionInfo> infos(kNbMissions);
+    bool valid = fread(&header, sizeof(header), 1, fp) == 1 &&
+        memcmp(header.magic, "FSMI", 4) == 0 && header.version == kIndexVersion &&
+        header.nbMissions == (uint32) kNbMissions &&
+        fread(&infos[0], sizeof(MissionInfo), kNbMissions, fp) == (size_t) kNbMissions;
+    fclose(fp);
+    if (valid) {
+        CCRC32 crc;
+        valid = crc.FullCRC((const unsigned char *) &infos[0],
+            kNbMissions * sizeof(MissionInfo)) == header.dataCrc;
+    }
+    if (!valid) {
+        LOG(Log::k_FLG_IO, "MissionIndex", "loadFile", ("Index file %s is outdated", path.c_str()))
+        return false;
+    }
+
+    infos_.swap(infos);
+    return true;
+}
+
+/*!
+ * The index is written in a temporary file which is renamed at the end.
+ */
+void MissionIndex::saveFile() {
+    MissionIndexHeader header;
+    memcpy(header.magic, "FSMI", 4);
+    header.version = kIndexVersion;
+    header.nbMissions = infos_.size();
+    CCRC32 crc;
+    header.dataCrc = crc.FullCRC((const unsigned char *) &infos_[0],
+        infos_.size() * sizeof(MissionInfo));
+
+    std::string cacheDir = File::homeFullPath("cache");
+#ifdef _WIN32
+    CreateDirectory(cacheDir.c_str(), NULL);
+#else
+    mkdir(cacheDir.c_str(), 0755);
+#endif
+    std::string path = filePath();
+    std::string tmpPath = path + ".tmp";
+    FILE *fp = fopen(tmpPath.c_str(), "wb");
+    if (fp == NULL) {
+        FSERR(Log::k_FLG_IO, "MissionIndex", "saveFile", ("Cannot create index file %s\n", tmpPath.c_str()))
+        return;
+    }
+    bool written = fwrite(&header, sizeof(header), 1, fp) == 1 &&
+        fwrite(&infos_[0], sizeof(MissionInfo), infos_.size(), fp) == infos_.size();
+    written = fclose(fp) == 0 && written;
+    // rename() does not replace an existing file on Windows
+    remove(path.c_str());
+    if (!written || rename(tmpPath.c_str(), path.c_str()) != 0) {
+        FSERR(Log::k_FLG_IO, "MissionIndex", "saveFile", ("Cannot write index file %s\n", path.c_str()))
+        remove(tmpPath.c_str());
+    }
+}
@@ -0,0 +1,152 @@
+#ifndef EDITOR_MISSIONINDEX_H_
+#define EDITOR_MISSIONINDEX_H_
+
+/************************************************************************
+ *                                                                      *
+ *  FreeSynd - a remake of the classic Bullfrog game "Syndicate".       *
+ *                                                                      *
+ *   Copyright (C) 2016  Benoit Blancard <benblan@users.sourceforge.net>*
+ *                                                                      *
+ *    This program is free software;  you can redistribute it and / or  *
+ *  modify it  under the  terms of the  GNU General  Public License as  *
+ *  published by the Free Software Foundation; either version 2 of the  *
+ *  License, or (at your option) any later version.                     *
+ *                                                                      *
+ *    This program is  distributed in the hope that it will be useful,  *
+ *  but WITHOUT  ANY WARRANTY;  without even  the implied  warranty of  *
+ *  MERCHANTABILITY  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU  *
+ *  General Public License for more details.                            *
+ *                                                                      *
+ *    You can view the GNU  General Public License, online, at the GNU  *
+ *  project's  web  site;  see <http://www.gnu.org/licenses/gpl.html>.  *
+ *  The full text of the license is also included in the file COPYING.  *
+ *                                                                      *
+ ************************************************************************/
+
+#include <list>
+#include <string>
+#include <vector>
+
+#include "common.h"
+
+struct SDL_mutex;
+
+/*!
+ * What the editor knows about a mission without creating it : all is
+ * read from the mission file.
+ */
+struct MissionInfo {
+    //! Number of ped types, see PedInstance::PedType
+    static const int kNbPedTypes = 5;
+    //! Number of weapon types, see Weapon::WeaponType
+    static const int kNbWeaponTypes = 15;
+    //! Number of objectives read in a mission file
+    static const int kMaxObjectives = 6;
+
+    int missionId;
+    //! False if the mission file could not be read
+    bool valid;
+    //! Size of the mission file
+    uint32 sourceSize;
+    //! Modification time of the mission file
+    uint32 sourceTime;
+    int mapId;
+    int minX;
+    int minY;
+    int maxX;
+    int maxY;
+    //! Number of peds of each type, index is the bit set in the type
+    uint16 nbPeds[kNbPedTypes];
+    uint16 nbVehicles;
+    //! One bit for each type of vehicle in the mission
+    uint32 vehicleTypes[8];
+    //! Number of weapons of each type, on the ground or carried by peds
+    uint16 nbWeapons[kNbWeaponTypes];
+    int nbObjectives;
+    //! Type of objectives as in the game data
+    uint8 objectiveTypes[kMaxObjectives];
+
+    //! Returns the number of peds of the given PedInstance::PedType
+    int nbPedsOfType(int pedType) const;
+    //! Returns true if mission has a vehicle of the given type
+    bool hasVehicleType(uint8 vehicleType) const;
+    //! Returns true if mission has an objective of the given type
+    bool hasObjectiveType(uint8 objectiveType) const;
+};
+
+/*!
+ * An index of all missions used by the editor to search missions.
+ * Missions files are read by a few threads, without creating the missions
+ * nor loading their maps, and the index is saved in the cache directory of
+ * the home path. Next time, only the missions whose file has changed are
+ * read again.
+ */
+class MissionIndex {
+public:
+    //! Criterias of a search : a criteria set to kAny is not checked
+    struct Query {
+        static const int kAny = -1;
+
+        Query();
+
+        //! A PedInstance::PedType
+        int pedType;
+        //! A Vehicle type
+        int vehicleType;
+        //! A Weapon::WeaponType
+        int weaponType;
+        //! An objective type as in game data
+        int objectiveType;
+        int mapId;
+    };
+
+    //! Number of missions in the game
+    static const int kNbMissions = 50;
+    //! Number of threads reading mission files
+    static const int kNbScanThreads = 4;
+
+    MissionIndex();
+
+    //! Reads the saved index and the mission files that changed
+    bool build();
+    bool isBuilt() const { return built_; }
+    //! Returns how long the last build took in microseconds
+    uint64 buildTime() const { return buildTime_; }
+    //! Returns the ids of the missions that match the query
+    void search(const Query &query, std::list<int> &results) const;
+    //! Returns what is known of the mission or NULL
+    const MissionInfo * info(int missionId) const;
+    //! Removes the saved index
+    static void removeFile();
+
+protected:
+    //! Shared by threads reading mission files
+    struct ScanContext {
+        MissionIndex *pIndex;
+        SDL_mutex *pMutex;
+        //! Ids of missions to read
+        std::vector<int> missions;
+        //! Index of the next mission to read in missions
+        size_t next;
+    };
+
+    static int scanLoop(void *pData);
+    //! Reads the mission file and fills the info
+    static void scanMission(int missionId, MissionInfo *pInfo);
+    //! Reads size and modification time of the mission file
+    static bool sourceInfo(int missionId, uint32 *pSize, uint32 *pTime);
+    //! Returns the path of the saved index
+    static std::string filePath();
+    //! Reads the saved index
+    bool loadFile();
+    //! Saves the index
+    void saveFile();
+
+protected:
+    /*! Info of each mission, index is the mission id - 1.*/
+    std::vector<MissionInfo> infos_;
+    bool built_;
+    uint64 buildTime_;
+};
+
+#endif  // EDITOR_MISSIONINDEX_H_
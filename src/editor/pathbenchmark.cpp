@@ -0,0 +1,228 @@
+/************************************************************************
+ *                                                                      *
+ *  FreeSynd - a remake of the classic Bullfrog game "Syndicate".       *
+ *                                                                      *
+ *   Copyright (C) 2016  Benoit Blancard <benblan@users.sourceforge.net>*
+ *                                                                      *
+ *    This program is free software;  you can redistribute it and / or  *
+ *  modify it  under the  terms of the  GNU General  Public License as  *
+ *  published by the Free Software Foundation; either version 2 of the  *
+ *  License, or (at your option) any later version.                     *
+ *                                                                      *
+ *    This program is  distributed in the hope that it will be useful,  *
+ *  but WITHOUT  ANY WARRANTY;  without even  the implied  warranty of  *
+ *  MERCHANTABILITY  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU  *
+ *  General Public License for more details.                            *
+ *                                                                      *
+ *    You can view the GNU  General Public License, online, at the GNU  *
+ *  project's  web  site;  see <http://www.gnu.org/licenses/gpl.html>.  *
+ *  The full text of the license is also included in the file COPYING.  *
+ *                                                                      *
+ ************************************************************************/
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <set>
+#include <string>
+
+#include "editor/pathbenchmark.h"
+#include "editor/editorapp.h"
+#include "appcontext.h"
+#include "missionmanager.h"
+#include "mission.h"
+#include "ped.h"
+#include "pathregions.h"
+#include "pathsurfaces.h"
+#include "utils/log.h"
+#include "utils/timer.h"
+
+const int PathBenchmark::kNbMissions = 50;
+const int PathBenchmark::kMaxCorridorExcess = 25;
+
+PathBenchmark::PathBenchmark(int nbPaths, unsigned int seed) {
+    nbPaths_ = nbPaths > 0 ? nbPaths : 1;
+    seed_ = seed;
+}
+
+/*!
+ * Each map is benched once, with the first mission that uses it.
+ * Path finders are selected by the benchmark whatever the configuration says.
+ * \return False if no map could be loaded or if path finders disagreed.
+ */
+bool PathBenchmark::run() {
+    AppContext::FS_PathFinder finder = g_Ctx.getPathFinder();
+    g_Ctx.setPathFinder(AppContext::PATHFINDER_FLOOD);
+    std::set<int> mapIds;
+    bool allSame = true;
+
+    printf("{\n");
+    printf("  \"seed\": %u,\n", seed_);
+    printf("  \"paths\": %d,\n", nbPaths_);
+    printf("  \"maps\": [\n");
+    for (int missionId = 1; missionId <= kNbMissions; missionId++) {
+        Mission *pMission = g_gameCtrl.missions().loadMission(missionId);
+        if (pMission == NULL) {
+            FSERR(Log::k_FLG_GAME, "PathBenchmark", "run", ("Cannot load mission %d\n", missionId))
+            continue;
+        }
+
+        if (mapIds.find(pMission->mapId()) == mapIds.end()) {
+            printf("%s", mapIds.empty() ? "" : ",\n");
+            mapIds.insert(pMission->mapId());
+            allSame = benchMap(pMission) && allSame;
+        }
+        delete pMission;
+    }
+    printf("\n  ],\n");
+    printf("  \"same_lengths\": %s\n", allSame ? "true" : "false");
+    printf("}\n");
+    fflush(stdout);
+
+    g_Ctx.setPathFinder(finder);
+    return !mapIds.empty() && allSame;
+}
+
+/*!
+ * Searches the same paths twice : once restoring only the touched nodes
+ * after each search, as the path finder does, and once copying the whole
+ * directions map in the mirror before each search, as it was done before.
+ * Then A* searches them and its paths are compared with the flood ones.
+ * \return False if a path was found by only one path finder, if paths
+ * had not the same number of tiles or, for paths searched in a corridor,
+ * if A* path was shorter or too much longer.
+ */
+bool PathBenchmark::benchMap(Mission *pMission) {
+    pickPaths(pMission);
+    g_Ctx.setPathFinder(AppContext::PATHFINDER_FLOOD);
+
+    pathSearchDesc &search = pMission->mdsearch_;
+    size_t mapSize = pMission->mmax_x_ * pMission->mmax_y_ * pMission->mmax_z_
+        * sizeof(floodPointDesc);
+    std::vector<TilePoint> path;
+    path.reserve(256);
+
+    // length of each flood path, -1 if not found
+    std::vector<int> floodLengths(queries_.size(), -1);
+    int nbFound = 0;
+    size_t totalLength = 0;
+    uint64 startTime = fs_utils::microTime();
+    for (size_t i = 0; i < queries_.size(); i++) {
+        path.clear();
+        if (PedInstance::findPath(pMission, queries_[i].from, queries_[i].to, &search, path)) {
+            nbFound++;
+            totalLength += path.size();
+            floodLengths[i] = path.size();
+        }
+    }
+    uint64 touchedTime = fs_utils::microTime() - startTime;
+
+    startTime = fs_utils::microTime();
+    for (size_t i = 0; i < queries_.size(); i++) {
+        path.clear();
+        memcpy((void *)search.flood.nodes, (void *)pMission->mdpoints_, mapSize);
+        PedInstance::findPath(pMission, queries_[i].from, queries_[i].to, &search, path);
+    }
+    uint64 copyTime = fs_utils::microTime() - startTime;
+
+    g_Ctx.setPathFinder(AppContext::PATHFINDER_ASTAR);
+    std::vector<int> astarLengths(queries_.size(), -1);
+    startTime = fs_utils::microTime();
+    for (size_t i = 0; i < queries_.size(); i++) {
+        path.clear();
+        if (PedInstance::findPath(pMission, queries_[i].from, queries_[i].to, &search, path)) {
+            astarLengths[i] = path.size();
+        }
+    }
+    uint64 astarTime = fs_utils::microTime() - startTime;
+
+    int nbMismatches = 0;
+    int nbCorridorPaths = 0;
+    int nbLongerPaths = 0;
+    int maxExcess = 0;
+    for (size_t i = 0; i < queries_.size(); i++) {
+        int flood = floodLengths[i];
+        int astar = astarLengths[i];
+        bool same = flood == astar;
+        if (queries_[i].inCorridor && flood != -1 && astar != -1) {
+            // corridor path can't be shorter than flood which is the shortest
+            nbCorridorPaths++;
+            int excess = flood > 0 ? (astar - flood) * 100 / flood : 0;
+            same = astar >= flood && excess <= kMaxCorridorExcess;
+            if (astar > flood) {
+                nbLongerPaths++;
+                maxExcess = excess > maxExcess ? excess : maxExcess;
+            }
+        }
+        if (!same) {
+            if (nbMismatches == 0) {
+                std::string fromStr, toStr;
+                queries_[i].from.toString(&fromStr);
+                queries_[i].to.toString(&toStr);
+                FSERR(Log::k_FLG_GAME, "PathBenchmark", "benchMap", ("Map %d : from %s to %s, flood %d steps, A* %d steps%s\n",
+                    pMission->mapId(), fromStr.c_str(), toStr.c_str(), flood, astar,
+                    queries_[i].inCorridor ? " in corridor" : ""))
+            }
+            nbMismatches++;
+        }
+    }
+
+    int nbQueries = queries_.size();
+    printf("    { \"map\": %d, \"size\": [%d, %d, %d], \"map_kb\": %d,", pMission->mapId(),
+        pMission->mmax_x_, pMission->mmax_y_, pMission->mmax_z_, (int) (mapSize / 1024));
+    printf(" \"searched\": %d, \"found\": %d, \"mean_length\": %.1f,", nbQueries, nbFound,
+        nbFound > 0 ? (double) totalLength / nbFound : 0.0);
+    printf(" \"paths_per_second\": { \"copy_map\": %.0f, \"restore_touched\": %.0f, \"astar\": %.0f },",
+        copyTime > 0 ? nbQueries * 1000000.0 / copyTime : 0.0,
+        touchedTime > 0 ? nbQueries * 1000000.0 / touchedTime : 0.0,
+        astarTime > 0 ? nbQueries * 1000000.0 / astarTime : 0.0);
+    printf(" \"corridor\": { \"paths\": %d, \"longer\": %d, \"max_excess_percent\": %d },",
+        nbCorridorPaths, nbLongerPaths, maxExcess);
+    printf(" \"mismatches\": %d }", nbMismatches);
+    return nbMismatches == 0;
+}
+
+/*!
+ * When the walkable regions are built, only tiles of the same component
+ * are paired, as the path finder is not called for the others.
+ */
+void PathBenchmark::pickPaths(Mission *pMission) {
+    srand(seed_);
+    queries_.clear();
+
+    int maxX = pMission->mmax_x_;
+    int maxXY = pMission->mmax_m_xy;
+    int nbNodes = maxXY * pMission->mmax_z_;
+    std::vector<int> walkables;
+    for (int i = 0; i < nbNodes; i++) {
+        if ((pMission->mdpoints_[i].bfNodeDesc & m_fdWalkable) != 0) {
+            walkables.push_back(i);
+        }
+    }
+    if (walkables.size() < 2) {
+        return;
+    }
+
+    PathRegions &regions = pMission->mdregions_;
+    for (int i = 0; i < nbPaths_; i++) {
+        // a few tries to find two tiles that can be linked
+        for (int tries = 0; tries < 16; tries++) {
+            int from = walkables[rand() % walkables.size()];
+            int to = walkables[rand() % walkables.size()];
+            if (from == to || (regions.isBuilt() && !regions.isReachable(from, to))) {
+                continue;
+            }
+
+            Query query;
+            query.from = TilePoint(from % maxX, (from % maxXY) / maxX, from / maxXY, 128, 128);
+            query.to = TilePoint(to % maxX, (to % maxXY) / maxX, to / maxXY, 128, 128);
+            // same test as PedInstance::findPathAStar()
+            int dist = std::max(abs(query.to.tx - query.from.tx),
+                std::max(abs(query.to.ty - query.from.ty), abs(query.to.tz - query.from.tz)));
+            query.inCorridor = regions.isBuilt() && dist >= PathRegions::kMinCorridorDistance;
+            queries_.push_back(query);
+            break;
+        }
+    }
+}
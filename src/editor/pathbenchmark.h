@@ -0,0 +1,81 @@
+#ifndef EDITOR_PATHBENCHMARK_H_
+#define EDITOR_PATHBENCHMARK_H_
+
+/************************************************************************
+ *                                                                      *
+ *  FreeSynd - a remake of the classic Bullfrog game "Syndicate".       *
+ *                                                                      *
+ *   Copyright (C) 2016  Benoit Blancard <benblan@users.sourceforge.net>*
+ *                                                                      *
+ *    This program is free software;  you can redistribute it and / or  *
+ *  modify it  under the  terms of the  GNU General  Public License as  *
+ *  published by the Free Software Foundation; either version 2 of the  *
+ *  License, or (at your option) any later version.                     *
+ *                                                                      *
+ *    This program is  distributed in the hope that it will be useful,  *
+ *  but WITHOUT  ANY WARRANTY;  without even  the implied  warranty of  *
+ *  MERCHANTABILITY  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU  *
+ *  General Public License for more details.                            *
+ *                                                                      *
+ *    You can view the GNU  General Public License, online, at the GNU  *
+ *  project's  web  site;  see <http://www.gnu.org/licenses/gpl.html>.  *
+ *  The full text of the license is also included in the file COPYING.  *
+ *                                                                      *
+ ************************************************************************/
+
+#include <vector>
+
+#include "common.h"
+#include "model/position.h"
+
+class Mission;
+
+/*!
+ * Times ped path searches between random walkable tiles for each map
+ * used by a mission and prints the number of paths per second as a JSON
+ * object on standard output. Flood searches are timed as they are done
+ * now, restoring only the nodes touched by the search, and as they were
+ * done before, copying the whole directions map before each search.
+ * The same paths are searched with A* to check both path finders give
+ * paths of same length. When A* searches in the corridor of a coarse
+ * route, its path is only the shortest one in the corridor, so it is
+ * only checked not to be more than kMaxCorridorExcess percent longer.
+ */
+class PathBenchmark {
+public:
+    PathBenchmark(int nbPaths, unsigned int seed);
+
+    //! Runs the benchmark and prints the report
+    bool run();
+
+protected:
+    //! Times the searches for the map of the mission and prints the results
+    bool benchMap(Mission *pMission);
+    //! Picks random pairs of walkable tiles that can be linked
+    void pickPaths(Mission *pMission);
+
+protected:
+    /*!
+     * A path to search.
+     */
+    struct Query {
+        TilePoint from;
+        TilePoint to;
+        /*! True if A* first searches in a corridor for this path.*/
+        bool inCorridor;
+    };
+
+    /*! Number of missions in the game.*/
+    static const int kNbMissions;
+    /*! Percentage by which a path found in a corridor can be longer.*/
+    static const int kMaxCorridorExcess;
+
+    /*! Number of paths searched on each map.*/
+    int nbPaths_;
+    /*! Seed for random generator.*/
+    unsigned int seed_;
+    /*! Paths to search.*/
+    std::vector<Query> queries_;
+};
+
+#endif  // EDITOR_PATHBENCHMARK_H_
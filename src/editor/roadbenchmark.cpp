@@ -0,0 +1,338 @@
+/************************************************************************
+ *                                                                      *
+ *  FreeSynd - a remake of the classic Bullfrog game "Syndicate".       *
+ *                                                                      *
+ *   Copyright (C) 2016  Benoit Blancard <benblan@users.sourceforge.net>*
+ *                                                                      *
+ *    This program is free software;  you can redistribute it and / or  *
+ *  modify it  under the  terms of the  GNU General  Public License as  *
+ *  published by the Free Software Foundation; either version 2 of the  *
+ *  License, or (at your option) any later version.                     *
+ *                                                                      *
+ *    This program is  distributed in the hope that it will be useful,  *
+ *  but WITHOUT  ANY WARRANTY;  without even  the implied  warranty of  *
+ *  MERCHANTABILITY  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU  *
+ *  General Public License for more details.                            *
+ *                                                                      *
+ *    You can view the GNU  General Public License, online, at the GNU  *
+ *  project's  web  site;  see <http://www.gnu.org/licenses/gpl.html>.  *
+ *  The full text of the license is also included in the file COPYING.  *
+ *                                                                      *
+ ************************************************************************/
+
+#include <cstdio>
+#include <cstdlib>
+#include <set>
+
+#include "editor/roadbenchmark.h"
+#include "editor/editorapp.h"
+#include "map.h"
+#include "missionmanager.h"
+#include "mission.h"
+#include "roadgraph.h"
+#include "core/gamesession.h"
+#include "utils/log.h"
+#include "utils/timer.h"
+
+const int RoadBenchmark::kNbMissions = 50;
+
+RoadBenchmark::RoadBenchmark(int missionId, int nbRoutes, unsigned int seed) {
+    missionId_ = missionId;
+    nbRoutes_ = nbRoutes;
+    seed_ = seed;
+}
+
+/*!
+ * Loads the mission, builds the road graph of its map and searches the
+ * routes with the graph twice, first while next-hop tables are built and
+ * then once they are in cache, and once over the tiles.
+ * \return False if the mission could not be loaded or if a route of the
+ * graph is not as short as the one found over the tiles.
+ */
+bool RoadBenchmark::run() {
+    Mission *pMission = g_gameCtrl.missions().loadMission(missionId_);
+    if (pMission == NULL) {
+        FSERR(Log::k_FLG_GAME, "RoadBenchmark", "run", ("Cannot load mission %d\n", missionId_))
+        return false;
+    }
+    g_Session.setMission(pMission);
+    pMission->start();
+
+    Map *pMap = pMission->get_map();
+    RoadGraph &graph = pMap->roadGraph();
+    // built again to measure it alone
+    graph.build(pMap);
+    pickRoutes(graph);
+
+    std::vector<TilePoint> route;
+    uint64 graphTime[2];
+    size_t graphLength = 0;
+    int nbFound = 0;
+    for (int pass = 0; pass < 2; pass++) {
+        uint64 startTime = fs_utils::microTime();
+        for (size_t i = 0; i < queries_.size(); i++) {
+            const Query &query = queries_[i];
+            if (graph.findRoute(query.from.tx, query.from.ty, query.from.tz, query.move,
+                query.to.tx, query.to.ty, &route) && pass == 0) {
+                graphLength += route.size();
+                nbFound++;
+            }
+        }
+        graphTime[pass] = fs_utils::microTime() - startTime;
+    }
+
+    carSearchDesc search;
+    std::vector<TilePoint> graphRoute;
+    int nbMismatches = 0;
+    uint64 searchTime = 0;
+    for (size_t i = 0; i < queries_.size(); i++) {
+        const Query &query = queries_[i];
+        uint64 startTime = fs_utils::microTime();
+        bool found = RoadGraph::searchRoute(pMap, &search, query.from.tx, query.from.ty,
+            query.from.tz, query.move, query.to.tx, query.to.ty, &route);
+        searchTime += fs_utils::microTime() - startTime;
+
+        bool graphFound = graph.findRoute(query.from.tx, query.from.ty, query.from.tz,
+            query.move, query.to.tx, query.to.ty, &graphRoute);
+        if (found != graphFound || route.size() != graphRoute.size() ||
+            (graphFound && !isRouteAllowed(pMap, query, graphRoute))) {
+            nbMismatches++;
+        }
+    }
+    search.release();
+
+    int nbQueries = queries_.size();
+    printf("{\n");
+    printf("  \"mission\": %d,\n", missionId_);
+    printf("  \"map\": %d,\n", pMission->mapId());
+    printf("  \"road_tiles\": %d,\n", (int) graph.nbTiles());
+    printf("  \"nodes\": %d,\n", (int) graph.nbNodes());
+    printf("  \"edges\": %d,\n", (int) graph.nbEdges());
+    printf("  \"build_ms\": %.3f,\n", graph.buildTime() / 1000.0);
+    printf("  \"routes\": %d,\n", nbQueries);
+    printf("  \"found\": %d,\n", nbFound);
+    printf("  \"mean_length\": %.1f,\n", nbFound > 0 ? (double) graphLength / nbFound : 0.0);
+    printf("  \"next_hop_tables\": %d,\n", (int) graph.nbTables());
+    printf("  \"memory_kb\": %d,\n", (int) (graph.memorySize() / 1024));
+    printf("  \"routes_per_second\": {\n");
+    printf("    \"graph_first\": %.0f,\n",
+        graphTime[0] > 0 ? nbQueries * 1000000.0 / graphTime[0] : 0.0);
+    printf("    \"graph_cached\": %.0f,\n",
+        graphTime[1] > 0 ? nbQueries * 1000000.0 / graphTime[1] : 0.0);
+    printf("    \"tile_search\": %.0f\n",
+        searchTime > 0 ? nbQueries * 1000000.0 / searchTime : 0.0);
+    printf("  },\n");
+    printf("  \"mismatches\": %d\n", nbMismatches);
+    printf("}\n");
+    fflush(stdout);
+
+    pMission->end();
+    g_Session.setMission(NULL);
+    return nbMismatches == 0;
+}
+
+/*!
+ * Each map is checked once, with the first mission that uses it : routes
+ * are searched with the graph and over the tiles by RoadGraph::searchRoute().
+ * \return False if no map could be loaded or if a route of the graph was
+ * not found over the tiles, had not the same length or had a move that
+ * is not allowed.
+ */
+bool RoadBenchmark::runRouteCheck() {
+    std::set<int> mapIds;
+    int nbMismatches = 0;
+
+    printf("{\n");
+    printf("  \"seed\": %u,\n", seed_);
+    printf("  \"routes\": %d,\n", nbRoutes_);
+    printf("  \"maps\": [\n");
+    for (int missionId = 1; missionId <= kNbMissions; missionId++) {
+        Mission *pMission = g_gameCtrl.missions().loadMission(missionId);
+        if (pMission == NULL) {
+            FSERR(Log::k_FLG_GAME, "RoadBenchmark", "runRouteCheck", ("Cannot load mission %d\n", missionId))
+            continue;
+        }
+
+        if (mapIds.find(pMission->mapId()) == mapIds.end()) {
+            Map *pMap = pMission->get_map();
+            RoadGraph &graph = pMap->roadGraph();
+            if (!graph.isBuilt()) {
+                graph.build(pMap);
+            }
+            pickRoutes(graph);
+            int nbMapMismatches = checkRoutes(pMap, graph);
+            nbMismatches += nbMapMismatches;
+
+            printf("%s", mapIds.empty() ? "" : ",\n");
+            printf("    { \"map\": %d, \"road_tiles\": %d, \"routes\": %d, \"mismatches\": %d }",
+                pMission->mapId(), (int) graph.nbTiles(), (int) queries_.size(), nbMapMismatches);
+            mapIds.insert(pMission->mapId());
+        }
+        delete pMission;
+    }
+    printf("\n  ],\n");
+    printf("  \"mismatches\": %d\n", nbMismatches);
+    printf("}\n");
+    fflush(stdout);
+
+    return !mapIds.empty() && nbMismatches == 0;
+}
+
+/*!
+ * Searches the routes with the graph and over the tiles.
+ * \return The number of routes that differ, the first one is logged.
+ */
+int RoadBenchmark::checkRoutes(Map *pMap, RoadGraph &graph) {
+    carSearchDesc search;
+    std::vector<TilePoint> route;
+    std::vector<TilePoint> graphRoute;
+    int nbMismatches = 0;
+    for (size_t i = 0; i < queries_.size(); i++) {
+        const Query &query = queries_[i];
+        bool found = RoadGraph::searchRoute(pMap, &search, query.from.tx, query.from.ty,
+            query.from.tz, query.move, query.to.tx, query.to.ty, &route);
+        bool graphFound = graph.findRoute(query.from.tx, query.from.ty, query.from.tz,
+            query.move, query.to.tx, query.to.ty, &graphRoute);
+        if (found != graphFound || route.size() != graphRoute.size() ||
+            (graphFound && !isRouteAllowed(pMap, query, graphRoute))) {
+            if (nbMismatches == 0) {
+                FSERR(Log::k_FLG_GAME, "RoadBenchmark", "checkRoutes",
+                    ("Routes differ from (%d, %d, %d) move %d to (%d, %d) : %d tiles / %d tiles with graph\n",
+                    query.from.tx, query.from.ty, query.from.tz, query.move, query.to.tx,
+                    query.to.ty, found ? (int) route.size() : -1,
+                    graphFound ? (int) graphRoute.size() : -1))
+            }
+            nbMismatches++;
+        }
+    }
+    search.release();
+    return nbMismatches;
+}
+
+/*!
+ * The route must start on the start tile, end on the target tile and
+ * each tile must be reached from the previous one with a move given by
+ * RoadGraph::nextMoves().
+ */
+bool RoadBenchmark::isRouteAllowed(Map *pMap, const Query &query,
+    const std::vector<TilePoint> &route) const {
+    if (route.empty() || route.front().tx != query.from.tx ||
+        route.front().ty != query.from.ty || route.back().tx != query.to.tx ||
+        route.back().ty != query.to.ty) {
+        return false;
+    }
+
+    int move = query.move;
+    for (size_t i = 1; i < route.size(); i++) {
+        const TilePoint &prev = route[i - 1];
+        if (route[i].tz != query.from.tz) {
+            return false;
+        }
+        int moves[RoadGraph::kNbMoves];
+        int nb = RoadGraph::nextMoves(pMap, prev.tx, prev.ty, prev.tz, move, moves);
+        int next = -1;
+        for (int m = 0; m < nb; m++) {
+            if (prev.tx + RoadGraph::kMoveX[moves[m]] == route[i].tx &&
+                prev.ty + RoadGraph::kMoveY[moves[m]] == route[i].ty) {
+                next = moves[m];
+            }
+        }
+        if (next == -1) {
+            return false;
+        }
+        move = next;
+    }
+    return true;
+}
+
+/*!
+ * Fills the open list of carSearchDesc with random nodes, lowers the cost
+ * of some of them and pops nodes. Before each pop, the whole open list is
+ * browsed to check the position of each node and that the node on top has
+ * the lowest cost. Uses nbRoutes searches with the seed of the benchmark.
+ * \return False if the open list was wrong once.
+ */
+bool RoadBenchmark::runHeapCheck() {
+    const uint32 nbNodes = 1024;
+    carSearchDesc search;
+    if (!search.allocate(nbNodes)) {
+        FSERR(Log::k_FLG_GAME, "RoadBenchmark", "runHeapCheck", ("Memory allocation error\n"))
+        return false;
+    }
+
+    srand(seed_);
+    int nbPushes = 0;
+    int nbDecreases = 0;
+    int nbPops = 0;
+    int nbErrors = 0;
+    for (int i = 0; i < nbRoutes_; i++) {
+        search.newSearch();
+        for (int step = 0; step < 256; step++) {
+            uint32 node = rand() % nbNodes;
+            if (search.stamps[node] != search.generation) {
+                search.reach(node);
+                search.costs[node] = rand() % 100;
+                search.estimates[node] = rand() % 50;
+                search.push(node);
+                nbPushes++;
+            } else if (search.heapPos[node] != carSearchDesc::kNotInOpen &&
+                search.costs[node] > 0) {
+                search.costs[node] -= rand() % (search.costs[node] + 1);
+                search.push(node);
+                nbDecreases++;
+            }
+
+            if (rand() % 4 == 0 && !search.open.empty()) {
+                uint32 best = search.open[0];
+                for (size_t pos = 0; pos < search.open.size(); pos++) {
+                    uint32 other = search.open[pos];
+                    uint32 fOther = search.costs[other] + search.estimates[other];
+                    uint32 fBest = search.costs[best] + search.estimates[best];
+                    if (search.heapPos[other] != pos || fOther < fBest ||
+                        (fOther == fBest && search.estimates[other] < search.estimates[best])) {
+                        nbErrors++;
+                    }
+                }
+                if (search.pop() != best || search.heapPos[best] != carSearchDesc::kNotInOpen) {
+                    nbErrors++;
+                }
+                nbPops++;
+            }
+        }
+    }
+    search.release();
+
+    printf("{\n");
+    printf("  \"seed\": %u,\n", seed_);
+    printf("  \"searches\": %d,\n", nbRoutes_);
+    printf("  \"pushes\": %d,\n", nbPushes);
+    printf("  \"decreases\": %d,\n", nbDecreases);
+    printf("  \"pops\": %d,\n", nbPops);
+    printf("  \"errors\": %d\n", nbErrors);
+    printf("}\n");
+    fflush(stdout);
+
+    return nbErrors == 0;
+}
+
+void RoadBenchmark::pickRoutes(const RoadGraph &graph) {
+    srand(seed_);
+    queries_.clear();
+    if (graph.nbTiles() == 0) {
+        return;
+    }
+
+    for (int i = 0; i < nbRoutes_; i++) {
+        // a few tries to find two tiles on the same level
+        for (int tries = 0; tries < 16; tries++) {
+            Query query;
+            query.from = graph.tile(rand() % graph.nbTiles());
+            query.to = graph.tile(rand() % graph.nbTiles());
+            query.move = rand() % RoadGraph::kNbMoves;
+            if (query.from.tz == query.to.tz) {
+                queries_.push_back(query);
+                break;
+            }
+        }
+    }
+}
@@ -0,0 +1,83 @@
+#ifndef EDITOR_ROADBENCHMARK_H_
+#define EDITOR_ROADBENCHMARK_H_
+
+/************************************************************************
+ *                                                                      *
+ *  FreeSynd - a remake of the classic Bullfrog game "Syndicate".       *
+ *                                                                      *
+ *   Copyright (C) 2016  Benoit Blancard <benblan@users.sourceforge.net>*
+ *                                                                      *
+ *    This program is free software;  you can redistribute it and / or  *
+ *  modify it  under the  terms of the  GNU General  Public License as  *
+ *  published by the Free Software Foundation; either version 2 of the  *
+ *  License, or (at your option) any later version.                     *
+ *                                                                      *
+ *    This program is  distributed in the hope that it will be useful,  *
+ *  but WITHOUT  ANY WARRANTY;  without even  the implied  warranty of  *
+ *  MERCHANTABILITY  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU  *
+ *  General Public License for more details.                            *
+ *                                                                      *
+ *    You can view the GNU  General Public License, online, at the GNU  *
+ *  project's  web  site;  see <http://www.gnu.org/licenses/gpl.html>.  *
+ *  The full text of the license is also included in the file COPYING.  *
+ *                                                                      *
+ ************************************************************************/
+
+#include <vector>
+
+#include "common.h"
+#include "model/position.h"
+
+class Map;
+class RoadGraph;
+
+/*!
+ * Measures the road graph of the map of a mission : the graph is built
+ * again and its size is printed with the time of routes between random
+ * road tiles as a JSON object on standard output. The same routes are
+ * searched over the tiles to check the graph gives routes of same length
+ * made of allowed moves. The check alone can be run on all maps.
+ */
+class RoadBenchmark {
+public:
+    RoadBenchmark(int missionId, int nbRoutes, unsigned int seed);
+
+    //! Runs the benchmark and prints the report
+    bool run();
+    //! Checks the routes of the graph on the maps of all missions
+    bool runRouteCheck();
+    //! Checks the open list of the tile search against a brute-force minimum
+    bool runHeapCheck();
+
+protected:
+    /*!
+     * A route to search.
+     */
+    struct Query {
+        TilePoint from;
+        int move;
+        TilePoint to;
+    };
+
+    //! Picks random pairs of road tiles on the same level
+    void pickRoutes(const RoadGraph &graph);
+    //! Compares the routes of the graph with the ones of the tile search
+    int checkRoutes(Map *pMap, RoadGraph &graph);
+    //! Returns true if the route goes from start to target with allowed moves
+    bool isRouteAllowed(Map *pMap, const Query &query,
+        const std::vector<TilePoint> &route) const;
+
+protected:
+    static const int kNbMissions;
+
+    /*! Id of the mission whose map is used.*/
+    int missionId_;
+    /*! Number of routes to search.*/
+    int nbRoutes_;
+    /*! Seed for random generator.*/
+    unsigned int seed_;
+    /*! Routes to search.*/
+    std::vector<Query> queries_;
+};
+
+#endif  // EDITOR_ROADBENCHMARK_H_
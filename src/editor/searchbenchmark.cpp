@@ -0,0 +1,108 @@
+/************************************************************************
+ *                                                                      *
+ *  FreeSynd - a remake of the classic Bullfrog game "Syndicate".       *
+ *                                                                      *
+ *   Copyright (C) 2016  Benoit Blancard <benblan@users.sourceforge.net>*
+ *                                                                      *
+ *    This program is free software;  you can redistribute it and / or  *
+ *  modify it  under the  terms of the  GNU General  Public License as  *
+ *  published by the Free Software Foundation; either version 2 of the  *
+ *  License, or (at your option) any later version.                     *
+ *                                                                      *
+ *    This program is  distributed in the hope that it will be useful,  *
+ *  but WITHOUT  ANY WARRANTY;  without even  the implied  warranty of  *
+ *  MERCHANTABILITY  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU  *
+ *  General Public License for more details.                            *
+ *                                                                      *
+ *    You can view the GNU  General Public License, online, at the GNU  *
+ *  project's  web  site;  see <http://www.gnu.org/licenses/gpl.html>.  *
+ *  The full text of the license is also included in the file COPYING.  *
+ *                                                                      *
+ ************************************************************************/
+
+#include <cstdio>
+
+#include "editor/searchbenchmark.h"
+#include "editor/editorapp.h"
+#include "missionmanager.h"
+#include "mission.h"
+#include "ped.h"
+#include "model/vehicle.h"
+#include "utils/timer.h"
+
+SearchBenchmark::SearchBenchmark() {
+}
+
+void SearchBenchmark::initQueries(MissionIndex::Query *pQueries) {
+    pQueries[0].pedType = PedInstance::kPedTypeCivilian;
+    pQueries[1].pedType = PedInstance::kPedTypePolice;
+    pQueries[2].pedType = PedInstance::kPedTypeGuard;
+    pQueries[3].pedType = PedInstance::kPedTypeCriminal;
+    pQueries[4].vehicleType = Vehicle::kVehicleTypeTrainHead;
+}
+
+/*!
+ * Each mission is loaded once and checked against all queries.
+ * \return Time spent
+ */
+uint64 SearchBenchmark::searchByLoading(const MissionIndex::Query *pQueries, std::list<int> *pResults) {
+    MissionManager missionMgr;
+    uint64 startTime = fs_utils::microTime();
+    for (int misId = 1; misId <= MissionIndex::kNbMissions; misId++) {
+        Mission *pMission = missionMgr.loadMission(misId);
+        if (pMission == NULL) {
+            continue;
+        }
+
+        for (int q = 0; q < kNbQueries; q++) {
+            bool found = false;
+            for (size_t i = 0; i < pMission->numPeds() && !found; i++) {
+                found = pMission->ped(i)->type() == pQueries[q].pedType;
+            }
+            for (size_t i = 0; i < pMission->numVehicles() && !found; i++) {
+                found = pMission->vehicle(i)->getType() == pQueries[q].vehicleType;
+            }
+            if (found) {
+                pResults[q].push_back(misId);
+            }
+        }
+        delete pMission;
+    }
+    return fs_utils::microTime() - startTime;
+}
+
+bool SearchBenchmark::run() {
+    MissionIndex::Query queries[kNbQueries];
+    initQueries(queries);
+
+    std::list<int> loadResults[kNbQueries];
+    uint64 loadTime = searchByLoading(queries, loadResults);
+
+    MissionIndex::removeFile();
+    MissionIndex coldIndex;
+    coldIndex.build();
+    MissionIndex warmIndex;
+    warmIndex.build();
+
+    bool same = true;
+    uint64 startTime = fs_utils::microTime();
+    std::list<int> indexResults[kNbQueries];
+    for (int q = 0; q < kNbQueries; q++) {
+        warmIndex.search(queries[q], indexResults[q]);
+    }
+    uint64 searchTime = fs_utils::microTime() - startTime;
+    for (int q = 0; q < kNbQueries; q++) {
+        same = same && indexResults[q] == loadResults[q];
+    }
+
+    printf("{\n");
+    printf("  \"queries\": %d,\n", kNbQueries);
+    printf("  \"load_missions_ms\": %.3f,\n", loadTime / 1000.0);
+    printf("  \"index_cold_ms\": %.3f,\n", coldIndex.buildTime() / 1000.0);
+    printf("  \"index_warm_ms\": %.3f,\n", warmIndex.buildTime() / 1000.0);
+    printf("  \"index_search_us\": %llu,\n", (unsigned long long) searchTime);
+    printf("  \"same_results\": %s\n", same ? "true" : "false");
+    printf("}\n");
+    fflush(stdout);
+    return same;
+}
@@ -0,0 +1,56 @@
+#ifndef EDITOR_SEARCHBENCHMARK_H_
+#define EDITOR_SEARCHBENCHMARK_H_
+
+/************************************************************************
+ *                                                                      *
+ *  FreeSynd - a remake of the classic Bullfrog game "Syndicate".       *
+ *                                                                      *
+ *   Copyright (C) 2016  Benoit Blancard <benblan@users.sourceforge.net>*
+ *                                                                      *
+ *    This program is free software;  you can redistribute it and / or  *
+ *  modify it  under the  terms of the  GNU General  Public License as  *
+ *  published by the Free Software Foundation; either version 2 of the  *
+ *  License, or (at your option) any later version.                     *
+ *                                                                      *
+ *    This program is  distributed in the hope that it will be useful,  *
+ *  but WITHOUT  ANY WARRANTY;  without even  the implied  warranty of  *
+ *  MERCHANTABILITY  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU  *
+ *  General Public License for more details.                            *
+ *                                                                      *
+ *    You can view the GNU  General Public License, online, at the GNU  *
+ *  project's  web  site;  see <http://www.gnu.org/licenses/gpl.html>.  *
+ *  The full text of the license is also included in the file COPYING.  *
+ *                                                                      *
+ ************************************************************************/
+
+#include <list>
+
+#include "common.h"
+#include "editor/missionindex.h"
+
+/*!
+ * Compares the search of missions by loading every mission, as the search
+ * menu used to do, with the search in the mission index built without
+ * saved index, with a saved index and once built. Checks that both ways
+ * find the same missions for all types of ped but agents (agents created
+ * depend on the squad) and for trains. Timings are printed as a JSON
+ * object on standard output.
+ */
+class SearchBenchmark {
+public:
+    SearchBenchmark();
+
+    //! Runs the benchmark and prints the report
+    bool run();
+
+protected:
+    //! Number of queries compared between both ways
+    static const int kNbQueries = 5;
+
+    //! Fills the queries compared between both ways
+    static void initQueries(MissionIndex::Query *pQueries);
+    //! Searches by loading all missions
+    uint64 searchByLoading(const MissionIndex::Query *pQueries, std::list<int> *pResults);
+};
+
+#endif  // EDITOR_SEARCHBENCHMARK_H_
@@ -30,8 +30,6 @@
 #include "editor/editormenuid.h"
 #include "gfx/screen.h"
 #include "system.h"
-#include "missionmanager.h"
-#include "mission.h"
 #include "model/vehicle.h"
 
 std::string PedTypeAdapter::getName() {
@@ -121,60 +119,24 @@ void SearchMissionMenu::handleLeave() {
     g_System.hideCursor();
 }
 
-bool SearchMissionMenu::matchMissionWithPedType(Mission *pMission) {
-    if (searchOnPedType_) {
-        for (size_t pedId = 0; pedId < pMission->numPeds(); pedId++) {
-            PedInstance *pPed = pMission->ped(pedId);
-
-            if (pPed->type() == pedTypeCriteria_) {
-                return true;
-            }
+void SearchMissionMenu::handleAction(const int actionId, void *ctx, const int modKeys) {
+    if (actionId == searchButId_) {
+        MissionIndex &index = g_App.missionIndex();
+        if (!index.isBuilt()) {
+            index.build();
         }
-        return false;
-    }
-
-    return true;
-}
-
-bool SearchMissionMenu::matchMissionWithVehicleType(Mission *pMission) {
-    if (searchOnVehicleType_) {
-        for (size_t vId = 0; vId < pMission->numVehicles(); vId++) {
-            Vehicle *pVehicle = pMission->vehicle(vId);
 
-            if (pVehicle->getType() == vehicleTypeCriteria_) {
-                return true;
-            }
+        MissionIndex::Query query;
+        if (searchOnPedType_) {
+            query.pedType = pedTypeCriteria_;
+        }
+        if (searchOnVehicleType_) {
+            query.vehicleType = vehicleTypeCriteria_;
         }
-        return false;
-    }
-
-    return true;
-}
-
-void SearchMissionMenu::handleAction(const int actionId, void *ctx, const int modKeys) {
-    if (actionId == searchButId_) {
-        MissionManager missionMgr;
 
         // first clear result list
         g_App.getMissionResultList().clear();
-
-        for (int misId = 1; misId <= 50; misId++) {
-            Mission *pMission = missionMgr.loadMission(misId);
-
-            if (pMission) {
-                bool keepMission = matchMissionWithPedType(pMission);
-
-                if (keepMission) {
-                    keepMission = matchMissionWithVehicleType(pMission);
-                }
-
-                if (keepMission) {
-                    g_App.getMissionResultList().push_back(misId);
-                }
-
-                delete pMission;
-            }
-        }
+        index.search(query, g_App.getMissionResultList());
 
         menu_manager_->gotoMenu(fs_edit_menus::kMenuIdListMis);
     } else if (actionId == pPedTypeListBox_->getId()) {
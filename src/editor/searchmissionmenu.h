@@ -29,8 +29,6 @@
 #include "utils/seqmodel.h"
 #include "ped.h"
 
-class Mission;
-
 class PedTypeAdapter {
 public:
     PedTypeAdapter(PedInstance::PedType type) {
@@ -74,9 +72,6 @@ protected:
     void initSearchCriterias();
     void initVehicleTypeListAndWidget();
 
-    bool matchMissionWithPedType(Mission *pMission);
-    bool matchMissionWithVehicleType(Mission *pMission);
-
 protected:
     int searchButId_;
     ListBox *pPedTypeListBox_;
@@ -0,0 +1,115 @@
+/************************************************************************
+ *                                                                      *
+ *  FreeSynd - a remake of the classic Bullfrog game "Syndicate".       *
+ *                                                                      *
+ *   Copyright (C) 2016  Benoit Blancard <benblan@users.sourceforge.net>*
+ *                                                                      *
+ *    This program is free software;  you can redistribute it and / or  *
+ *  modify it  under the  terms of the  GNU General  Public License as  *
+ *  published by the Free Software Foundation; either version 2 of the  *
+ *  License, or (at your option) any later version.                     *
+ *                                                                      *
+ *    This program is  distributed in the hope that it will be useful,  *
+ *  but WITHOUT  ANY WARRANTY;  without even  the implied  warranty of  *
+ *  MERCHANTABILITY  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU  *
+ *  General Public License for more details.                            *
+ *                                                                      *
+ *    You can view the GNU  General Public License, online, at the GNU  *
+ *  project's  web  site;  see <http://www.gnu.org/licenses/gpl.html>.  *
+ *  The full text of the license is also included in the file COPYING.  *
+ *                                                                      *
+ ************************************************************************/
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "editor/surfacebenchmark.h"
+#include "editor/editorapp.h"
+#include "missionmanager.h"
+#include "mission.h"
+#include "surfacecache.h"
+#include "utils/log.h"
+#include "utils/timer.h"
+
+const int SurfaceBenchmark::kNbMissions = 50;
+
+SurfaceBenchmark::SurfaceBenchmark() {
+}
+
+uint64 SurfaceBenchmark::timeSetSurfaces(Mission *pMission) {
+    uint64 startTime = fs_utils::microTime();
+    pMission->setSurfaces();
+    return fs_utils::microTime() - startTime;
+}
+
+/*!
+ * Each mission is loaded once, then its surfaces are set once per pass.
+ * \return False if no mission could be loaded or if a pass did not
+ * give the same directions map as without cache.
+ */
+bool SurfaceBenchmark::run() {
+    SurfaceCache::EMode oldMode = SurfaceCache::mode();
+    const char *passNames[kNbPasses] = { "no_cache_ms", "cold_ms", "disk_ms", "memory_ms" };
+    uint64 totalTime[kNbPasses] = { 0, 0, 0, 0 };
+    bool allSame = true;
+    int nbMissions = 0;
+
+    printf("{\n");
+    printf("  \"missions\": [\n");
+    for (int missionId = 1; missionId <= kNbMissions; missionId++) {
+        Mission *pMission = g_gameCtrl.missions().loadMission(missionId);
+        if (pMission == NULL) {
+            FSERR(Log::k_FLG_GAME, "SurfaceBenchmark", "run", ("Cannot load mission %d\n", missionId))
+            continue;
+        }
+
+        uint64 passTime[kNbPasses];
+        bool same = true;
+        std::vector<floodPointDesc> reference;
+        for (int pass = 0; pass < kNbPasses; pass++) {
+            if (pass == kPassNoCache) {
+                SurfaceCache::setMode(SurfaceCache::kModeOff);
+            } else if (pass == kPassCold) {
+                SurfaceCache::setMode(SurfaceCache::kModeDisk);
+                SurfaceCache::remove(pMission->surfaceKey());
+            } else if (pass == kPassDisk) {
+                SurfaceCache::clear();
+            }
+            passTime[pass] = timeSetSurfaces(pMission);
+            totalTime[pass] += passTime[pass];
+
+            const floodPointDesc *pPoints = pMission->mdpoints_;
+            size_t nbNodes = pMission->mmax_x_ * pMission->mmax_y_ * pMission->mmax_z_;
+            if (pPoints == NULL) {
+                same = false;
+            } else if (pass == kPassNoCache) {
+                reference.assign(pPoints, pPoints + nbNodes);
+            } else if (memcmp(&reference[0], pPoints, nbNodes * sizeof(floodPointDesc)) != 0) {
+                same = false;
+            }
+        }
+        allSame = allSame && same;
+
+        printf("%s    { \"mission\": %d, \"map\": %d", nbMissions > 0 ? ",\n" : "",
+            missionId, pMission->mapId());
+        for (int pass = 0; pass < kNbPasses; pass++) {
+            printf(", \"%s\": %.3f", passNames[pass], passTime[pass] / 1000.0);
+        }
+        printf(", \"same\": %s }", same ? "true" : "false");
+        nbMissions++;
+        delete pMission;
+    }
+    printf("\n  ],\n");
+    printf("  \"total\": {");
+    for (int pass = 0; pass < kNbPasses; pass++) {
+        printf("%s \"%s\": %.3f", pass > 0 ? "," : "", passNames[pass], totalTime[pass] / 1000.0);
+    }
+    printf(" },\n");
+    printf("  \"same_directions\": %s\n", allSame ? "true" : "false");
+    printf("}\n");
+    fflush(stdout);
+
+    SurfaceCache::setMode(oldMode);
+    return nbMissions > 0 && allSame;
+}
@@ -0,0 +1,67 @@
+#ifndef EDITOR_SURFACEBENCHMARK_H_
+#define EDITOR_SURFACEBENCHMARK_H_
+
+/************************************************************************
+ *                                                                      *
+ *  FreeSynd - a remake of the classic Bullfrog game "Syndicate".       *
+ *                                                                      *
+ *   Copyright (C) 2016  Benoit Blancard <benblan@users.sourceforge.net>*
+ *                                                                      *
+ *    This program is free software;  you can redistribute it and / or  *
+ *  modify it  under the  terms of the  GNU General  Public License as  *
+ *  published by the Free Software Foundation; either version 2 of the  *
+ *  License, or (at your option) any later version.                     *
+ *                                                                      *
+ *    This program is  distributed in the hope that it will be useful,  *
+ *  but WITHOUT  ANY WARRANTY;  without even  the implied  warranty of  *
+ *  MERCHANTABILITY  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU  *
+ *  General Public License for more details.                            *
+ *                                                                      *
+ *    You can view the GNU  General Public License, online, at the GNU  *
+ *  project's  web  site;  see <http://www.gnu.org/licenses/gpl.html>.  *
+ *  The full text of the license is also included in the file COPYING.  *
+ *                                                                      *
+ ************************************************************************/
+
+#include "common.h"
+
+class Mission;
+
+/*!
+ * Measures how long Mission::setSurfaces() takes for each mission
+ * without the surface cache, with an empty cache, with the entry saved on
+ * disk and with the entry in memory. Each pass must give the same
+ * directions map. Timings are printed as a JSON object on standard output.
+ */
+class SurfaceBenchmark {
+public:
+    SurfaceBenchmark();
+
+    //! Runs the benchmark and prints the report
+    bool run();
+
+protected:
+    /*!
+     * How the surface cache is used during a pass.
+     */
+    enum EPass {
+        //! Cache is disabled
+        kPassNoCache = 0,
+        //! Entry is removed before computing
+        kPassCold,
+        //! Entry is only in the file written by the previous pass
+        kPassDisk,
+        //! Entry is in memory
+        kPassMemory,
+        kNbPasses
+    };
+
+    //! Calls setSurfaces() and returns the time in microseconds
+    uint64 timeSetSurfaces(Mission *pMission);
+
+protected:
+    /*! Number of missions in the game.*/
+    static const int kNbMissions;
+};
+
+#endif  // EDITOR_SURFACEBENCHMARK_H_
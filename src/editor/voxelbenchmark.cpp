@@ -0,0 +1,165 @@
+/************************************************************************
+ *                                                                      *
+ *  FreeSynd - a remake of the classic Bullfrog game "Syndicate".       *
+ *                                                                      *
+ *   Copyright (C) 2016  Benoit Blancard <benblan@users.sourceforge.net>*
+ *                                                                      *
+ *    This program is free software;  you can redistribute it and / or  *
+ *  modify it  under the  terms of the  GNU General  Public License as  *
+ *  published by the Free Software Foundation; either version 2 of the  *
+ *  License, or (at your option) any later version.                     *
+ *                                                                      *
+ *    This program is  distributed in the hope that it will be useful,  *
+ *  but WITHOUT  ANY WARRANTY;  without even  the implied  warranty of  *
+ *  MERCHANTABILITY  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU  *
+ *  General Public License for more details.                            *
+ *                                                                      *
+ *    You can view the GNU  General Public License, online, at the GNU  *
+ *  project's  web  site;  see <http://www.gnu.org/licenses/gpl.html>.  *
+ *  The full text of the license is also included in the file COPYING.  *
+ *                                                                      *
+ ************************************************************************/
+
+#include <cstdio>
+#include <cstdlib>
+#include <set>
+#include <vector>
+
+#include "editor/voxelbenchmark.h"
+#include "editor/editorapp.h"
+#include "missionmanager.h"
+#include "mission.h"
+#include "map.h"
+#include "gfx/tile.h"
+#include "gfx/tilemanager.h"
+#include "utils/log.h"
+#include "utils/timer.h"
+
+const int VoxelBenchmark::kNbMissions = 50;
+const int VoxelBenchmark::kNbRandomCells = 1000000;
+
+VoxelBenchmark::VoxelBenchmark(int nbRounds) {
+    nbRounds_ = nbRounds > 0 ? nbRounds : 1;
+}
+
+/*!
+ * Each map is benched once, with the first mission that uses it.
+ * \return False if no map could be loaded or if both storages did not
+ * give the same walk data.
+ */
+bool VoxelBenchmark::run() {
+    std::set<int> mapIds;
+    bool allSame = true;
+
+    printf("{\n");
+    printf("  \"rounds\": %d,\n", nbRounds_);
+    printf("  \"random_cells\": %d,\n", kNbRandomCells);
+    printf("  \"maps\": [\n");
+    for (int missionId = 1; missionId <= kNbMissions; missionId++) {
+        Mission *pMission = g_gameCtrl.missions().loadMission(missionId);
+        if (pMission == NULL) {
+            FSERR(Log::k_FLG_GAME, "VoxelBenchmark", "run", ("Cannot load mission %d\n", missionId))
+            continue;
+        }
+
+        if (mapIds.find(pMission->mapId()) == mapIds.end()) {
+            printf("%s", mapIds.empty() ? "" : ",\n");
+            mapIds.insert(pMission->mapId());
+            allSame = benchMap(pMission->get_map()) && allSame;
+        }
+        delete pMission;
+    }
+    printf("\n  ],\n");
+    printf("  \"same_walk_data\": %s\n", allSame ? "true" : "false");
+    printf("}\n");
+    fflush(stdout);
+
+    return !mapIds.empty() && allSame;
+}
+
+/*!
+ * The former storage is rebuilt from the map so that both storages are
+ * timed on the same cells. Two traversals are timed : all cells in the
+ * order of Mission::setSurfaces() and cells at random positions, as read
+ * by the line of sight and the pathfinder.
+ * \return False if both storages did not give the same walk data
+ */
+bool VoxelBenchmark::benchMap(Map *pMap) {
+    const int maxX = pMap->maxX();
+    const int maxY = pMap->maxY();
+    const int maxZ = pMap->maxZ();
+    const int nbCells = maxX * maxY * maxZ;
+    TileManager *pTileMgr = pMap->tileManager();
+    const uint8 *tileIds = pMap->tileIds();
+
+    // one Tile pointer per cell, cells of a column are contiguous
+    std::vector<Tile *> columns(nbCells);
+    for (int z = 0; z < maxZ; z++) {
+        for (int y = 0; y < maxY; y++) {
+            for (int x = 0; x < maxX; x++) {
+                columns[(y * maxX + x) * maxZ + z] = pMap->getTileAt(x, y, z);
+            }
+        }
+    }
+
+    srand(1);
+    std::vector<int> randomX(kNbRandomCells);
+    std::vector<int> randomY(kNbRandomCells);
+    std::vector<int> randomZ(kNbRandomCells);
+    for (int i = 0; i < kNbRandomCells; i++) {
+        randomX[i] = rand() % maxX;
+        randomY[i] = rand() % maxY;
+        randomZ[i] = rand() % maxZ;
+    }
+
+    uint32 sumPointers = 0;
+    uint64 startTime = fs_utils::microTime();
+    for (int round = 0; round < nbRounds_; round++) {
+        for (int z = 0; z < maxZ; z++) {
+            for (int y = 0; y < maxY; y++) {
+                for (int x = 0; x < maxX; x++) {
+                    sumPointers += columns[(y * maxX + x) * maxZ + z]->getWalkData();
+                }
+            }
+        }
+    }
+    uint64 surfacesPointersTime = fs_utils::microTime() - startTime;
+
+    uint32 sumIds = 0;
+    startTime = fs_utils::microTime();
+    for (int round = 0; round < nbRounds_; round++) {
+        for (int i = 0; i < nbCells; i++) {
+            sumIds += pTileMgr->walkData(tileIds[i]);
+        }
+    }
+    uint64 surfacesIdsTime = fs_utils::microTime() - startTime;
+    bool same = sumPointers == sumIds;
+
+    sumPointers = 0;
+    startTime = fs_utils::microTime();
+    for (int round = 0; round < nbRounds_; round++) {
+        for (int i = 0; i < kNbRandomCells; i++) {
+            sumPointers += columns[(randomY[i] * maxX + randomX[i]) * maxZ + randomZ[i]]->getWalkData();
+        }
+    }
+    uint64 randomPointersTime = fs_utils::microTime() - startTime;
+
+    sumIds = 0;
+    startTime = fs_utils::microTime();
+    for (int round = 0; round < nbRounds_; round++) {
+        for (int i = 0; i < kNbRandomCells; i++) {
+            sumIds += pTileMgr->walkData(tileIds[pMap->cellIndex(randomX[i], randomY[i], randomZ[i])]);
+        }
+    }
+    uint64 randomIdsTime = fs_utils::microTime() - startTime;
+    same = same && sumPointers == sumIds;
+
+    printf("    { \"map\": %d, \"size\": [%d, %d, %d], \"cells\": %d,", pMap->id(), maxX, maxY, maxZ, nbCells);
+    printf(" \"pointer_bytes\": %d, \"id_bytes\": %d,", (int) (nbCells * sizeof(Tile *)), pMap->cellsMemory());
+    printf(" \"surfaces_pointers_ms\": %.3f, \"surfaces_ids_ms\": %.3f,",
+        surfacesPointersTime / 1000.0, surfacesIdsTime / 1000.0);
+    printf(" \"random_pointers_ms\": %.3f, \"random_ids_ms\": %.3f,",
+        randomPointersTime / 1000.0, randomIdsTime / 1000.0);
+    printf(" \"same\": %s }", same ? "true" : "false");
+    return same;
+}
@@ -0,0 +1,57 @@
+#ifndef EDITOR_VOXELBENCHMARK_H_
+#define EDITOR_VOXELBENCHMARK_H_
+
+/************************************************************************
+ *                                                                      *
+ *  FreeSynd - a remake of the classic Bullfrog game "Syndicate".       *
+ *                                                                      *
+ *   Copyright (C) 2016  Benoit Blancard <benblan@users.sourceforge.net>*
+ *                                                                      *
+ *    This program is free software;  you can redistribute it and / or  *
+ *  modify it  under the  terms of the  GNU General  Public License as  *
+ *  published by the Free Software Foundation; either version 2 of the  *
+ *  License, or (at your option) any later version.                     *
+ *                                                                      *
+ *    This program is  distributed in the hope that it will be useful,  *
+ *  but WITHOUT  ANY WARRANTY;  without even  the implied  warranty of  *
+ *  MERCHANTABILITY  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU  *
+ *  General Public License for more details.                            *
+ *                                                                      *
+ *    You can view the GNU  General Public License, online, at the GNU  *
+ *  project's  web  site;  see <http://www.gnu.org/licenses/gpl.html>.  *
+ *  The full text of the license is also included in the file COPYING.  *
+ *                                                                      *
+ ************************************************************************/
+
+#include "common.h"
+
+class Map;
+
+/*!
+ * Compares, for each map used by a mission, the memory and the traversal
+ * time of the map cells stored as tile ids with the former storage of one
+ * Tile pointer per cell in columns. Timings are printed as a JSON object
+ * on standard output.
+ */
+class VoxelBenchmark {
+public:
+    VoxelBenchmark(int nbRounds);
+
+    //! Runs the benchmark and prints the report
+    bool run();
+
+protected:
+    //! Times both storages for the map and prints the results
+    bool benchMap(Map *pMap);
+
+protected:
+    /*! Number of missions in the game.*/
+    static const int kNbMissions;
+    /*! Number of random cells read in each round.*/
+    static const int kNbRandomCells;
+
+    /*! How many times each traversal is done.*/
+    int nbRounds_;
+};
+
+#endif  // EDITOR_VOXELBENCHMARK_H_
@@ -32,6 +32,7 @@
 #include "utils/file.h"
 #include "app.h"
 #include "utils/log.h"
+#include "utils/profiler.h"
 #include "default_ini.h"
 
 #ifdef _WIN32
@@ -126,6 +127,10 @@ void print_usage() {
     printf("    -h, --help            display this help and exit.\n");
     printf("    -i, --ini <path>      specify the location of the FreeSynd config file.\n");
     printf("    --nosound             disable all sound.\n");
+    printf("    --record <file>       record player commands of the next mission.\n");
+    printf("    --replay <file>       replay player commands when playing the recorded mission.\n");
+    printf("    --startup-report      print how long each data took to load at startup.\n");
+    printf("    --profile <file>      write a Chrome trace to the file, first 1048576 zones of each thread.\n");
 
 #ifdef _WIN32
     printf(" (default: freesynd.ini in the same folder as freesynd.exe)\n");
@@ -166,6 +171,12 @@ int main(int argc, char *argv[]) {
     std::string iniPath;
 
     bool disable_sound = false;
+    // Files to record or replay missions
+    std::string recordPath;
+    std::string replayPath;
+    bool startupReport = false;
+    // File receiving the profiler trace
+    std::string profilePath;
 
     for (int i = 1; i < argc; ++i) {
 #ifdef _DEBUG
@@ -201,6 +212,21 @@ int main(int argc, char *argv[]) {
         if (0 == strcmp("--nosound", argv[i])) {
             disable_sound = true;
         }
+        if (0 == strcmp("--record", argv[i]) && i + 1 < argc) {
+            i++;
+            recordPath = argv[i];
+        }
+        if (0 == strcmp("--replay", argv[i]) && i + 1 < argc) {
+            i++;
+            replayPath = argv[i];
+        }
+        if (0 == strcmp("--startup-report", argv[i])) {
+            startupReport = true;
+        }
+        if (0 == strcmp("--profile", argv[i]) && i + 1 < argc) {
+            i++;
+            profilePath = argv[i];
+        }
     }
 
 #ifdef _DEBUG
@@ -228,8 +254,15 @@ int main(int argc, char *argv[]) {
         }
     }
 
+    Profiler::initialize();
+    if (!profilePath.empty()) {
+        // capture starts now so that loading of data is in the trace
+        Profiler::startCapture();
+    }
+
     LOG(Log::k_FLG_INFO, "Main", "main", ("----- Initializing application..."))
     std::unique_ptr<App> app(new App(disable_sound));
+    g_Ctx.setStartupReport(startupReport);
 
     if (app->initialize(iniPath)) {
         // setting the cheat codes
@@ -244,6 +277,9 @@ int main(int argc, char *argv[]) {
             }
         }
 
+        g_Ctx.setRecordFile(recordPath);
+        g_Ctx.setReplayFile(replayPath);
+
         LOG(Log::k_FLG_INFO, "Main", "main", ("----- Initializing application completed"))
         LOG(Log::k_FLG_INFO, "Main", "main", ("----- Starting game loop"))
         app->run(start_mission);
@@ -255,6 +291,11 @@ int main(int argc, char *argv[]) {
     LOG(Log::k_FLG_INFO, "Main", "main", ("----- End of game loop. Destroy application"))
     app->destroy();
 
+    if (!profilePath.empty()) {
+        Profiler::stopCapture(profilePath);
+    }
+    Profiler::destroy();
+
 #ifdef _DEBUG
     // Close log
     Log::close();
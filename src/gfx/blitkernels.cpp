@@ -0,0 +1,224 @@
+/************************************************************************
+ *                                                                      *
+ *  FreeSynd - a remake of the classic Bullfrog game "Syndicate".       *
+ *                                                                      *
+ *   Copyright (C) 2016  Benoit Blancard <benblan@users.sourceforge.net>*
+ *                                                                      *
+ *    This program is free software;  you can redistribute it and / or  *
+ *  modify it  under the  terms of the  GNU General  Public License as  *
+ *  published by the Free Software Foundation; either version 2 of the  *
+ *  License, or (at your option) any later version.                     *
+ *                                                                      *
+ *    This program is  distributed in the hope that it will be useful,  *
+ *  but WITHOUT  ANY WARRANTY;  without even  the implied  warranty of  *
+ *  MERCHANTABILITY  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU  *
+ *  General Public License for more details.                            *
+ *                                                                      *
+ *    You can view the GNU  General Public License, online, at the GNU  *
+ *  project's  web  site;  see <http://www.gnu.org/licenses/gpl.html>.  *
+ *  The full text of the license is also included in the file COPYING.  *
+ *                                                                      *
+ ************************************************************************/
+
+
+#include "gfx/blitkernels.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define FS_BLIT_SSE2
+#include <emmintrin.h>
+#endif
+
+#if defined(FS_BLIT_SSE2) && defined(__GNUC__)
+// AVX2 code is compiled only for the functions that use it and
+// those functions are called only if the CPU has AVX2
+#define FS_BLIT_AVX2
+#define FS_BLIT_AVX2_TARGET __attribute__((target("avx2")))
+#include <immintrin.h>
+#elif defined(FS_BLIT_SSE2) && defined(__AVX2__)
+#define FS_BLIT_AVX2
+#define FS_BLIT_AVX2_TARGET
+#include <immintrin.h>
+#endif
+
+namespace fs_blit {
+
+static void copyRowScalar(uint8 *pDst, const uint8 *pSrc, int width) {
+    for (int i = 0; i < width; ++i) {
+        uint8 c = pSrc[i];
+        if (c != kTransparentColor)
+            pDst[i] = c;
+    }
+}
+
+static void copyRowFlippedScalar(uint8 *pDst, const uint8 *pSrc, int width) {
+    for (int i = 0; i < width; ++i) {
+        uint8 c = pSrc[-i];
+        if (c != kTransparentColor)
+            pDst[i] = c;
+    }
+}
+
+#ifdef FS_BLIT_SSE2
+/*!
+ * Writes the 16 source pixels on the destination except transparent ones.
+ */
+static inline void blend16(uint8 *pDst, __m128i src, __m128i key) {
+    __m128i transp = _mm_cmpeq_epi8(src, key);
+    int mask = _mm_movemask_epi8(transp);
+    if (mask == 0xFFFF) {
+        // nothing to draw
+        return;
+    }
+    if (mask != 0) {
+        __m128i dst = _mm_loadu_si128((const __m128i *) pDst);
+        src = _mm_or_si128(_mm_and_si128(transp, dst), _mm_andnot_si128(transp, src));
+    }
+    _mm_storeu_si128((__m128i *) pDst, src);
+}
+
+/*!
+ * Reverses the order of the 16 bytes.
+ */
+static inline __m128i reverse16(__m128i x) {
+    x = _mm_shuffle_epi32(x, _MM_SHUFFLE(0, 1, 2, 3));
+    x = _mm_shufflelo_epi16(x, _MM_SHUFFLE(2, 3, 0, 1));
+    x = _mm_shufflehi_epi16(x, _MM_SHUFFLE(2, 3, 0, 1));
+    return _mm_or_si128(_mm_slli_epi16(x, 8), _mm_srli_epi16(x, 8));
+}
+
+static void copyRowSse2(uint8 *pDst, const uint8 *pSrc, int width) {
+    const __m128i key = _mm_set1_epi8((char) kTransparentColor);
+    int i = 0;
+    for (; i + 16 <= width; i += 16) {
+        blend16(pDst + i, _mm_loadu_si128((const __m128i *) (pSrc + i)), key);
+    }
+    copyRowScalar(pDst + i, pSrc + i, width - i);
+}
+
+static void copyRowFlippedSse2(uint8 *pDst, const uint8 *pSrc, int width) {
+    const __m128i key = _mm_set1_epi8((char) kTransparentColor);
+    int i = 0;
+    for (; i + 16 <= width; i += 16) {
+        // the 16 pixels before pSrc - i are loaded and put back in order
+        __m128i src = _mm_loadu_si128((const __m128i *) (pSrc - i - 15));
+        blend16(pDst + i, reverse16(src), key);
+    }
+    copyRowFlippedScalar(pDst + i, pSrc - i, width - i);
+}
+#endif
+
+#ifdef FS_BLIT_AVX2
+FS_BLIT_AVX2_TARGET
+static inline void blend32(uint8 *pDst, __m256i src, __m256i key) {
+    __m256i transp = _mm256_cmpeq_epi8(src, key);
+    int mask = _mm256_movemask_epi8(transp);
+    if (mask == -1) {
+        return;
+    }
+    if (mask != 0) {
+        __m256i dst = _mm256_loadu_si256((const __m256i *) pDst);
+        src = _mm256_blendv_epi8(src, dst, transp);
+    }
+    _mm256_storeu_si256((__m256i *) pDst, src);
+}
+
+FS_BLIT_AVX2_TARGET
+static void copyRowAvx2(uint8 *pDst, const uint8 *pSrc, int width) {
+    const __m256i key = _mm256_set1_epi8((char) kTransparentColor);
+    int i = 0;
+    for (; i + 32 <= width; i += 32) {
+        blend32(pDst + i, _mm256_loadu_si256((const __m256i *) (pSrc + i)), key);
+    }
+    copyRowSse2(pDst + i, pSrc + i, width - i);
+}
+
+FS_BLIT_AVX2_TARGET
+static void copyRowFlippedAvx2(uint8 *pDst, const uint8 *pSrc, int width) {
+    const __m256i key = _mm256_set1_epi8((char) kTransparentColor);
+    // reverses bytes inside each half, halves are swapped by the permute
+    const __m256i reverse = _mm256_setr_epi8(
+        15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0,
+        15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0);
+    int i = 0;
+    for (; i + 32 <= width; i += 32) {
+        __m256i src = _mm256_loadu_si256((const __m256i *) (pSrc - i - 31));
+        src = _mm256_permute2x128_si256(src, src, 1);
+        blend32(pDst + i, _mm256_shuffle_epi8(src, reverse), key);
+    }
+    copyRowFlippedSse2(pDst + i, pSrc - i, width - i);
+}
+#endif
+
+CopyRowFunc copyRow = copyRowScalar;
+CopyRowFunc copyRowFlipped = copyRowFlippedScalar;
+
+static EKernel currentKernel_ = kKernelScalar;
+
+bool isSupported(EKernel kernel) {
+    switch (kernel) {
+    case kKernelScalar:
+        return true;
+#ifdef FS_BLIT_SSE2
+    case kKernelSse2:
+        return true;
+#endif
+#ifdef FS_BLIT_AVX2
+    case kKernelAvx2:
+#ifdef __GNUC__
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2") != 0;
+#else
+        return true;
+#endif
+#endif
+    default:
+        return false;
+    }
+}
+
+bool useKernel(EKernel kernel) {
+    if (!isSupported(kernel)) {
+        return false;
+    }
+
+    switch (kernel) {
+#ifdef FS_BLIT_SSE2
+    case kKernelSse2:
+        copyRow = copyRowSse2;
+        copyRowFlipped = copyRowFlippedSse2;
+        break;
+#endif
+#ifdef FS_BLIT_AVX2
+    case kKernelAvx2:
+        copyRow = copyRowAvx2;
+        copyRowFlipped = copyRowFlippedAvx2;
+        break;
+#endif
+    default:
+        copyRow = copyRowScalar;
+        copyRowFlipped = copyRowFlippedScalar;
+        break;
+    }
+    currentKernel_ = kernel;
+    return true;
+}
+
+EKernel currentKernel() {
+    return currentKernel_;
+}
+
+EKernel bestKernel() {
+    for (int kernel = kNbKernels - 1; kernel > kKernelScalar; kernel--) {
+        if (isSupported((EKernel) kernel)) {
+            return (EKernel) kernel;
+        }
+    }
+    return kKernelScalar;
+}
+
+const char *kernelName(EKernel kernel) {
+    static const char *names[kNbKernels] = { "scalar", "sse2", "avx2" };
+    return kernel < kNbKernels ? names[kernel] : "unknown";
+}
+
+}
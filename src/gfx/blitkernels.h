@@ -0,0 +1,76 @@
+/************************************************************************
+ *                                                                      *
+ *  FreeSynd - a remake of the classic Bullfrog game "Syndicate".       *
+ *                                                                      *
+ *   Copyright (C) 2016  Benoit Blancard <benblan@users.sourceforge.net>*
+ *                                                                      *
+ *    This program is free software;  you can redistribute it and / or  *
+ *  modify it  under the  terms of the  GNU General  Public License as  *
+ *  published by the Free Software Foundation; either version 2 of the  *
+ *  License, or (at your option) any later version.                     *
+ *                                                                      *
+ *    This program is  distributed in the hope that it will be useful,  *
+ *  but WITHOUT  ANY WARRANTY;  without even  the implied  warranty of  *
+ *  MERCHANTABILITY  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU  *
+ *  General Public License for more details.                            *
+ *                                                                      *
+ *    You can view the GNU  General Public License, online, at the GNU  *
+ *  project's  web  site;  see <http://www.gnu.org/licenses/gpl.html>.  *
+ *  The full text of the license is also included in the file COPYING.  *
+ *                                                                      *
+ ************************************************************************/
+
+
+#ifndef GFX_BLITKERNELS_H_
+#define GFX_BLITKERNELS_H_
+
+#include "common.h"
+
+/*!
+ * Functions that copy a row of 8 bits pixels to the screen, skipping
+ * transparent pixels (color 255). They are used by all blits so
+ * the fastest version the CPU supports is chosen at startup.
+ */
+namespace fs_blit {
+
+/*! Value of a transparent pixel.*/
+const uint8 kTransparentColor = 255;
+
+/*!
+ * Implementations of the copy functions.
+ */
+enum EKernel {
+    //! Pixel by pixel
+    kKernelScalar = 0,
+    //! 16 pixels at a time
+    kKernelSse2,
+    //! 32 pixels at a time
+    kKernelAvx2,
+    kNbKernels
+};
+
+/*!
+ * Copies width pixels from pSrc to pDst except transparent ones.
+ * When flipped, pixels are read backward : pDst[i] = pSrc[-i].
+ */
+typedef void (*CopyRowFunc)(uint8 *pDst, const uint8 *pSrc, int width);
+
+/*! Function used to copy a row.*/
+extern CopyRowFunc copyRow;
+/*! Function used to copy a row read backward.*/
+extern CopyRowFunc copyRowFlipped;
+
+//! Returns true if the CPU can run the given kernel
+bool isSupported(EKernel kernel);
+//! Uses the given kernel for all blits, returns false if not supported
+bool useKernel(EKernel kernel);
+//! Returns the kernel currently used
+EKernel currentKernel();
+//! Returns the fastest kernel supported by the CPU
+EKernel bestKernel();
+//! Returns a name for the kernel
+const char *kernelName(EKernel kernel);
+
+}
+
+#endif  // GFX_BLITKERNELS_H_
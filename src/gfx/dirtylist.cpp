@@ -160,3 +160,73 @@ bool DirtyList::intersectsList(int x, int y, int width, int height)
        
     return false;
 }
+
+void DirtyArea::merge(DirtyRect &r1, const DirtyRect &r2) {
+    int right = r1.x + r1.width > r2.x + r2.width ? r1.x + r1.width : r2.x + r2.width;
+    int bottom = r1.y + r1.height > r2.y + r2.height ? r1.y + r1.height : r2.y + r2.height;
+    r1.x = r1.x < r2.x ? r1.x : r2.x;
+    r1.y = r1.y < r2.y ? r1.y : r2.y;
+    r1.width = right - r1.x;
+    r1.height = bottom - r1.y;
+}
+
+void DirtyArea::add(int x, int y, int width, int height) {
+    if (width <= 0 || height <= 0) {
+        return;
+    }
+
+    DirtyRect newRect = {x, y, width, height};
+    for (int i = 0; i < size_; i++) {
+        const DirtyRect &r = rects_[i];
+        if (r.x <= x && r.y <= y && r.x + r.width >= x + width &&
+            r.y + r.height >= y + height) {
+            // already covered
+            return;
+        }
+    }
+
+    // merge with every overlapping rect, the result may overlap other rects
+    bool merged = true;
+    while (merged) {
+        merged = false;
+        for (int i = 0; i < size_; i++) {
+            if (intersect(rects_[i], newRect)) {
+                merge(newRect, rects_[i]);
+                remove(i);
+                merged = true;
+                break;
+            }
+        }
+    }
+
+    if (size_ == kMaxRects) {
+        // no more room : merge with the rect that grows the least
+        int best = 0;
+        int bestGrowth = 0;
+        for (int i = 0; i < size_; i++) {
+            DirtyRect u = rects_[i];
+            merge(u, newRect);
+            int growth = u.width * u.height - rects_[i].width * rects_[i].height;
+            if (i == 0 || growth < bestGrowth) {
+                best = i;
+                bestGrowth = growth;
+            }
+        }
+        merge(newRect, rects_[best]);
+        remove(best);
+        add(newRect.x, newRect.y, newRect.width, newRect.height);
+        return;
+    }
+
+    rects_[size_++] = newRect;
+}
+
+bool DirtyArea::intersects(int x, int y, int width, int height) const {
+    DirtyRect r = {x, y, width, height};
+    for (int i = 0; i < size_; i++) {
+        if (intersect(rects_[i], r)) {
+            return true;
+        }
+    }
+    return false;
+}
@@ -62,4 +62,44 @@ private:
     int screenHeight_;
     Link    *pHead_;
 };
+
+/*!
+ * A small set of rectangles that must be redrawn or sent to the display.
+ * Overlapping rectangles are merged and when the set is full, the new
+ * rectangle is merged with the one that grows the least, so the set never
+ * allocates memory.
+ */
+class DirtyArea {
+public:
+    /*! Maximum number of rectangles in the set.*/
+    static const int kMaxRects = 16;
+
+    DirtyArea() { size_ = 0; }
+
+    bool isEmpty() const { return size_ == 0; }
+    int size() const { return size_; }
+    const DirtyRect & rectAt(int pos) const { return rects_[pos]; }
+
+    //! Adds the rectangle to the set
+    void add(int x, int y, int width, int height);
+    //! Empties the set
+    void clear() { size_ = 0; }
+    //! Returns true if the given rect intersects with any rect in the set
+    bool intersects(int x, int y, int width, int height) const;
+
+    //! Returns true if both rectangles have pixels in common
+    static bool intersect(const DirtyRect &r1, const DirtyRect &r2) {
+        return r1.x < r2.x + r2.width && r2.x < r1.x + r1.width &&
+            r1.y < r2.y + r2.height && r2.y < r1.y + r1.height;
+    }
+    //! Makes r1 the smallest rectangle containing r1 and r2
+    static void merge(DirtyRect &r1, const DirtyRect &r2);
+
+private:
+    void remove(int pos) { rects_[pos] = rects_[--size_]; }
+
+private:
+    DirtyRect rects_[kMaxRects];
+    int size_;
+};
 #endif // DIRTYLIST_H
@@ -26,7 +26,9 @@
 
 #include "common.h"
 #include "screen.h"
+#include "gfx/blitkernels.h"
 #include "utils/file.h"
+#include "utils/log.h"
 
 const int Screen::kScreenWidth = 640;
 const int Screen::kScreenHeight = 400;
@@ -36,7 +38,7 @@ Screen::Screen(int width, int height)
 :width_(width)
 , height_(height)
 , pixels_(NULL)
-, dirty_(false)
+, tracking_(false)
 , data_logo_(NULL), data_logo_copy_(NULL)
 , data_mini_logo_(NULL), data_mini_logo_copy_(NULL)
 {
@@ -44,6 +46,15 @@ Screen::Screen(int width, int height)
     assert(height_ > 0);
 
     pixels_ = new uint8[width_ * height_];
+    resetClipRect();
+    // all blits use the fastest row copy the CPU can run
+    fs_blit::useKernel(fs_blit::bestKernel());
+    LOG(Log::k_FLG_GFX, "Screen", "Screen", ("Using %s blit kernel",
+        fs_blit::kernelName(fs_blit::currentKernel())))
+    trackedArea_.x = trackedArea_.y = 0;
+    trackedArea_.width = trackedArea_.height = 0;
+    // nothing has been sent to the display yet
+    dirtyArea_.add(0, 0, width_, height_);
 }
 
 Screen::~Screen()
@@ -62,8 +73,97 @@ Screen::~Screen()
 void Screen::clear(uint8 color)
 {
     memset(pixels_, color, width_ * height_);
-    dirty_ = true;
+    dirtyArea_.add(0, 0, width_, height_);
 }
+
+/*!
+ * Sets the part of the screen that drawing operations can change.
+ * The rect is reduced to the screen size.
+ */
+void Screen::setClipRect(int x, int y, int width, int height)
+{
+    clipX_ = x < 0 ? 0 : x;
+    clipY_ = y < 0 ? 0 : y;
+    clipRight_ = x + width > width_ ? width_ : x + width;
+    clipBottom_ = y + height > height_ ? height_ : y + height;
+}
+
+/*!
+ * While tracking, every drawing operation extends the tracked area with
+ * the rect it covers, even the parts outside the clip rect. With an empty
+ * clip rect, this gives the size of something without drawing it.
+ */
+void Screen::startTracking()
+{
+    tracking_ = true;
+    trackedArea_.x = trackedArea_.y = 0;
+    trackedArea_.width = trackedArea_.height = 0;
+}
+
+DirtyRect Screen::stopTracking()
+{
+    tracking_ = false;
+    return trackedArea_;
+}
+
+void Screen::track(int x, int y, int width, int height)
+{
+    if (width <= 0 || height <= 0)
+        return;
+
+    DirtyRect r = {x, y, width, height};
+    if (trackedArea_.width == 0) {
+        trackedArea_ = r;
+    } else {
+        DirtyArea::merge(trackedArea_, r);
+    }
+}
+
+void Screen::addDrawnRect(int x, int y, int width, int height)
+{
+    int xlow = x < clipX_ ? clipX_ : x;
+    int ylow = y < clipY_ ? clipY_ : y;
+    int xhigh = x + width > clipRight_ ? clipRight_ : x + width;
+    int yhigh = y + height > clipBottom_ ? clipBottom_ : y + height;
+
+    dirtyArea_.add(xlow, ylow, xhigh - xlow, yhigh - ylow);
+}
+
+/*!
+ * Moves the content of a part of the screen. Pixels that leave the rect
+ * are lost and pixels uncovered by the move keep their old value.
+ * \param x Origin of the rect
+ * \param y Origin of the rect
+ * \param width Width of the rect
+ * \param height Height of the rect
+ * \param dx Move on x axis
+ * \param dy Move on y axis
+ */
+void Screen::shiftArea(int x, int y, int width, int height, int dx, int dy)
+{
+    assert(x >= 0 && y >= 0 && x + width <= width_ && y + height <= height_);
+
+    int w = width - (dx < 0 ? -dx : dx);
+    int h = height - (dy < 0 ? -dy : dy);
+    if (w <= 0 || h <= 0)
+        return;
+
+    int src_x = dx < 0 ? x - dx : x;
+    int dst_x = dx < 0 ? x : x + dx;
+    if (dy > 0) {
+        // rows are moved down so start from the bottom
+        for (int j = h - 1; j >= 0; --j)
+            memmove(pixels_ + (y + dy + j) * width_ + dst_x,
+                pixels_ + (y + j) * width_ + src_x, w);
+    } else {
+        for (int j = 0; j < h; ++j)
+            memmove(pixels_ + (y + j) * width_ + dst_x,
+                pixels_ + (y - dy + j) * width_ + src_x, w);
+    }
+
+    dirtyArea_.add(x, y, width, height);
+}
+
 /*!
  * Blits data to screen
  * @param x position by x coord
@@ -72,127 +172,158 @@ void Screen::clear(uint8 color)
  * @param height data's height
  * @param pixeldata pointer to data to be blitted
  * @param flipped draw flipped
- * @param stride actual data width (Sprite class related)
+ * @param stride actual data width (Sprite class related), negative
+ *  if rows are stored from bottom to top
  * @sa sprite.h
  */
 void Screen::blit(int x, int y, int width, int height,
                   const uint8 * pixeldata, bool flipped, int stride)
 {
-    if (x + width < 0 || y + height < 0 || x >= width_ || y >= height_)
+    if (tracking_)
+        track(x, y, width, height);
+
+    int xlow = x < clipX_ ? clipX_ : x;
+    int ylow = y < clipY_ ? clipY_ : y;
+    int xhigh = x + width > clipRight_ ? clipRight_ : x + width;
+    int yhigh = y + height > clipBottom_ ? clipBottom_ : y + height;
+    if (xlow >= xhigh || ylow >= yhigh)
         return;
 
-    int clipped_x = x < 0 ? 0 : x;
-    int clipped_y = y < 0 ? 0 : y;
-
-    int sx = x < 0 ? -x : 0;
-    int sy = y < 0 ? -y : 0;
-
-    int w = x < 0 ? x + width : x + width > width_ ? width_ - x : width;
-    int h = y < 0
-        ? y + height : y + height > height_ ? height_ - y : height;
+    int sx = xlow - x;
+    int sy = ylow - y;
+    int w = xhigh - xlow;
+    int h = yhigh - ylow;
 
     stride = (stride == 0 ? width : stride);
-    int ofs = (flipped ? w - 1 : 0) + clipped_x;
-    uint8 *d = pixels_ + clipped_y * width_ + ofs;
+    uint8 *d = pixels_ + ylow * width_ + xlow;
 
     if (flipped) {
-        const uint8 *s = pixeldata + sy * stride + sx + (width - w);
+        // column x + i of the screen shows column width - 1 - i of the data.
+        // This also holds when the sprite is cut by the left side : data
+        // used to be read from column -2 * x there, drawing wrong pixels
+        const uint8 *s = pixeldata + sy * stride + (width - 1 - sx);
         for (int j = 0; j < h; ++j) {
 
-            const uint8 *cp_s = s;
+            fs_blit::copyRowFlipped(d, s, w);
             s += stride;
-            uint8 *cp_d = d;
             d += width_;
-            for (int i = 0; i < w; ++i) {
-                uint8 c = *cp_s++;
-
-                if (c != 255)
-                    *cp_d = c;
-                cp_d--;
-            }
         }
     } else {
         const uint8 *s = pixeldata + sy * stride + sx;
         for (int j = 0; j < h; ++j) {
 
-            const uint8 *cp_s = s;
+            fs_blit::copyRow(d, s, w);
             s += stride;
-            uint8 *cp_d = d;
             d += width_;
-            for (int i = 0; i < w; ++i) {
-                uint8 c = *cp_s++;
+        }
+    }
 
-                if (c != 255)
-                    *cp_d = c;
-                cp_d++;
+    dirtyArea_.add(xlow, ylow, w, h);
+}
+
+/*!
+ * Same as blit() but copies only the runs of opaque pixels listed
+ * in spans, so transparent pixels are neither read nor tested.
+ * \param spans Runs of opaque pixels built from pixeldata
+ */
+void Screen::blitSpans(int x, int y, int width, int height,
+                  const uint8 * pixeldata, int stride, const SpanList &spans,
+                  bool flipped)
+{
+    if (tracking_)
+        track(x, y, width, height);
+
+    int xlow = x < clipX_ ? clipX_ : x;
+    int ylow = y < clipY_ ? clipY_ : y;
+    int xhigh = x + width > clipRight_ ? clipRight_ : x + width;
+    int yhigh = y + height > clipBottom_ ? clipBottom_ : y + height;
+    if (xlow >= xhigh || ylow >= yhigh)
+        return;
+
+    stride = (stride == 0 ? width : stride);
+
+    for (int row = ylow - y; row < yhigh - y; ++row) {
+        const uint8 *s = pixeldata + row * stride;
+        uint8 *d = pixels_ + (y + row) * width_;
+        for (int i = spans.rowBegin(row); i < spans.rowEnd(row); ++i) {
+            const SpanList::Span &span = spans.span(i);
+            // flipped : data column c is drawn at x + width - 1 - c
+            int left = flipped ? x + width - span.start - span.length :
+                x + span.start;
+            int right = left + span.length;
+            if (left < xlow)
+                left = xlow;
+            if (right > xhigh)
+                right = xhigh;
+            if (left >= right)
+                continue;
+
+            if (flipped) {
+                fs_blit::copyRowFlipped(d + left,
+                    s + width - 1 - (left - x), right - left);
+            } else {
+                memcpy(d + left, s + (left - x), right - left);
             }
         }
     }
 
-    dirty_ = true;
+    dirtyArea_.add(xlow, ylow, xhigh - xlow, yhigh - ylow);
 }
 
 /*!
  * Blits a portion of the source data to the screen a given position.
+ * The source has the size of the screen and the portion is taken at
+ * the same position.
  */
 void Screen::blitRect(int x, int y, int width, int height,
                   const uint8 * pixeldata, bool flipped, int stride)
 {
-    if (x + width < 0 || y + height < 0 || x >= width_ || y >= height_)
+    if (tracking_)
+        track(x, y, width, height);
+
+    int xlow = x < clipX_ ? clipX_ : x;
+    int ylow = y < clipY_ ? clipY_ : y;
+    int xhigh = x + width > clipRight_ ? clipRight_ : x + width;
+    int yhigh = y + height > clipBottom_ ? clipBottom_ : y + height;
+    if (xlow >= xhigh || ylow >= yhigh)
         return;
 
-    int dest_x = x < 0 ? 0 : x;
-    int dest_y = y < 0 ? 0 : y;
-
-    int clipped_w = x < 0 ? x + width : x + width > width_ ? width_ - x : width;
-    int clipped_h = y < 0
-        ? y + height : y + height > height_ ? height_ - y : height;
+    int clipped_w = xhigh - xlow;
+    int clipped_h = yhigh - ylow;
 
     stride = (stride == 0 ? width : stride);
-    int ofs = (flipped ? clipped_w - 1 : 0) + dest_x;
-    uint8 *d = pixels_ + dest_y * width_ + ofs;
+    uint8 *d = pixels_ + ylow * width_ + xlow;
 
     if (flipped) {
-        const uint8 *s = pixeldata + y * stride + x + (width - clipped_w);
+        const uint8 *s = pixeldata + ylow * stride + x + width - 1 - (xlow - x);
         for (int j = 0; j < clipped_h; ++j) {
 
-            const uint8 *cp_s = s;
+            fs_blit::copyRowFlipped(d, s, clipped_w);
             s += stride;
-            uint8 *cp_d = d;
             d += width_;
-            for (int i = 0; i < clipped_w; ++i) {
-                uint8 c = *cp_s++;
-
-                if (c != 255)
-                    *cp_d = c;
-                cp_d--;
-            }
         }
     } else {
-        const uint8 *s = pixeldata + y * stride + x;
+        const uint8 *s = pixeldata + ylow * stride + xlow;
         for (int j = 0; j < clipped_h; ++j) {
 
-            const uint8 *cp_s = s;
+            fs_blit::copyRow(d, s, clipped_w);
             s += stride;
-            uint8 *cp_d = d;
             d += width_;
-            for (int i = 0; i < clipped_w; ++i) {
-                uint8 c = *cp_s++;
-
-                if (c != 255)
-                    *cp_d = c;
-                cp_d++;
-            }
         }
     }
 
-    dirty_ = true;
+    dirtyArea_.add(xlow, ylow, clipped_w, clipped_h);
 }
 
 void Screen::scale2x(int x, int y, int width, int height,
                      const uint8 * pixeldata, int stride, bool transp)
 {
+    if (tracking_)
+        track(x, y, width * 2, height * 2);
+
     stride = (stride == 0 ? width : stride);
+    bool inside = x >= clipX_ && y >= clipY_ &&
+        x + width * 2 <= clipRight_ && y + height * 2 <= clipBottom_;
 
     for (int j = 0; j < height; ++j) {
         uint8 *d = pixels_ + (y + j * 2) * width_ + x;
@@ -200,59 +331,73 @@ void Screen::scale2x(int x, int y, int width, int height,
         for (int i = 0; i < width; ++i, d += 2) {
             uint8 c = *(pixeldata + i);
             if (c != 255 || !transp) {
-                *(d + 0) = c;
-                *(d + 1) = c;
-                *(d + 0 + width_) = c;
-                *(d + 1 + width_) = c;
+                if (inside) {
+                    *(d + 0) = c;
+                    *(d + 1) = c;
+                    *(d + 0 + width_) = c;
+                    *(d + 1 + width_) = c;
+                } else {
+                    for (int k = 0; k < 4; k++) {
+                        int px = x + i * 2 + (k & 1);
+                        int py = y + j * 2 + (k >> 1);
+                        if (px >= clipX_ && px < clipRight_ &&
+                            py >= clipY_ && py < clipBottom_)
+                            pixels_[py * width_ + px] = c;
+                    }
+                }
             }
         }
 
         pixeldata += stride;
     }
 
-    dirty_ = true;
+    addDrawnRect(x, y, width * 2, height * 2);
 }
 
 void Screen::drawVLine(int x, int y, int length, uint8 color)
 {
-    if (x < 0 || x >= width_ || y + length < 0 || y >= height_)
+    if (tracking_)
+        track(x, y, 1, length);
+
+    if (x < clipX_ || x >= clipRight_ || y + length <= clipY_ || y >= clipBottom_)
         return;
 
-    length = y + length >= height_ ? height_ - y : length;
-    if (y < 0) {
-        length += y;
-        y = 0;
+    length = y + length >= clipBottom_ ? clipBottom_ - y : length;
+    if (y < clipY_) {
+        length -= clipY_ - y;
+        y = clipY_;
     }
     if (length < 1)
         return;
 
+    dirtyArea_.add(x, y, 1, length);
     uint8 *pixel = pixels_ + y * width_ + x;
     while (length--) {
         *pixel = color;
         pixel += width_;
     }
-
-    dirty_ = true;
 }
 
 void Screen::drawHLine(int x, int y, int length, uint8 color)
 {
-    if ((x + length) < 0 || x >= width_ || y < 0 || y >= height_)
+    if (tracking_)
+        track(x, y, length, 1);
+
+    if ((x + length) <= clipX_ || x >= clipRight_ || y < clipY_ || y >= clipBottom_)
         return;
 
-    length = x + length >= width_ ? width_ - x : length;
-    if (x < 0) {
-        length += x;
-        x = 0;
+    length = x + length >= clipRight_ ? clipRight_ - x : length;
+    if (x < clipX_) {
+        length -= clipX_ - x;
+        x = clipX_;
     }
     if (length < 1)
         return;
 
+    dirtyArea_.add(x, y, length, 1);
     uint8 *pixel_ptr = pixels_ + y * width_ + x;
     while (length--)
         *pixel_ptr++ = color;
-
-    dirty_ = true;
 }
 
 int Screen::numLogos()
@@ -285,8 +430,6 @@ void Screen::drawLogo(int x, int y, int logo, int colour, bool mini)
         scale2x(x, y, 16, 16, data_mini_logo_copy_ + logo * 16 * 16, 16);
     else
         scale2x(x, y, 32, 32, data_logo_copy_ + logo * 32 * 32, 32);
-
-    dirty_ = true;
 }
 
 // Taken from SDL_gfx
@@ -301,6 +444,13 @@ void Screen::drawLine(int x1, int y1, int x2, int y2, uint8 color,
     int swaptmp;
     uint8 *pixel;
 
+    int left = x1 < x2 ? x1 : x2;
+    int top = y1 < y2 ? y1 : y2;
+    int right = x1 < x2 ? x2 : x1;
+    int bottom = y1 < y2 ? y2 : y1;
+    if (tracking_)
+        track(left, top, right - left + 1, bottom - top + 1);
+
     /*
      * Variable setup
      */
@@ -323,6 +473,10 @@ void Screen::drawLine(int x1, int y1, int x2, int y2, uint8 color,
     pixel = pixels_ + pixx * (int) x1 + pixy * (int) y1;
     pixx *= sx;
     pixy *= sy;
+    // coordinates of the pixel follow the same steps to be clipped
+    int px = x1, py = y1;
+    int stepx_x = sx, stepx_y = 0;
+    int stepy_x = 0, stepy_y = sy;
     if (dx < dy) {
         swaptmp = dx;
         dx = dy;
@@ -330,6 +484,10 @@ void Screen::drawLine(int x1, int y1, int x2, int y2, uint8 color,
         swaptmp = pixx;
         pixx = pixy;
         pixy = swaptmp;
+        stepx_x = 0;
+        stepx_y = sy;
+        stepy_x = sx;
+        stepy_y = 0;
     }
 
     /*
@@ -338,26 +496,30 @@ void Screen::drawLine(int x1, int y1, int x2, int y2, uint8 color,
     x = 0;
     y = 0;
     int count = 0;
-    for (; x < dx; x++, pixel += pixx) {
+    for (; x < dx; x++, pixel += pixx, px += stepx_x, py += stepx_y) {
         if (skip == 0 || !(((off + count++) / skip) & 1))
-            if (pixel >= pixels_ && pixel < pixels_ + width_ * height_)
+            if (px >= clipX_ && px < clipRight_ && py >= clipY_ && py < clipBottom_)
                 *pixel = color;
         y += dy;
         if (y >= dx) {
             y -= dx;
             pixel += pixy;
+            px += stepy_x;
+            py += stepy_y;
         }
     }
 
-    dirty_ = true;
+    addDrawnRect(left, top, right - left + 1, bottom - top + 1);
 }
 
 void Screen::setPixel(int x, int y, uint8 color)
 {
-    if (x < 0 || y < 0 || x >= width_ || y >= height_)
+    if (tracking_)
+        track(x, y, 1, 1);
+    if (x < clipX_ || y < clipY_ || x >= clipRight_ || y >= clipBottom_)
         return;
     pixels_[y * width_ + x] = color;
-    dirty_ = true;
+    dirtyArea_.add(x, y, 1, 1);
 }
 
 
@@ -367,14 +529,19 @@ void Screen::drawRect(int x, int y, int width, int height, uint8 color)
         || (y + height) > height_ || width <= 0 || height <= 0)
         return;
     // NOTE: we don't handle properly clipping by (x,y), do we need it?
+    if (tracking_)
+        track(x, y, width, height);
+
+    int xlow = x < clipX_ ? clipX_ : x;
+    int ylow = y < clipY_ ? clipY_ : y;
+    int xhigh = x + width > clipRight_ ? clipRight_ : x + width;
+    int yhigh = y + height > clipBottom_ ? clipBottom_ : y + height;
+    if (xlow >= xhigh || ylow >= yhigh)
+        return;
 
-
-    for (int i = 0; i < height; i++) {
-        uint8 *p_pixels = pixels_ + x + width_ * (y + i);
-        for (int w = 0; w != width; w++)
-            *p_pixels++ = color;
-    }
-    dirty_ = true;
+    for (int j = ylow; j < yhigh; j++)
+        memset(pixels_ + xlow + width_ * j, color, xhigh - xlow);
+    dirtyArea_.add(xlow, ylow, xhigh - xlow, yhigh - ylow);
 }
 
 int Screen::gameScreenHeight()
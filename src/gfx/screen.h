@@ -26,6 +26,8 @@
 #define SCREEN_H
 
 #include "common.h"
+#include "gfx/dirtylist.h"
+#include "gfx/spanlist.h"
 
 /*!
  * Screen class.
@@ -45,11 +47,31 @@ public:
     void clear(uint8 color = 0);
 
     const uint8 *pixels() const { return pixels_; }
-    bool dirty() { return dirty_; }
-    void clearDirty() { dirty_ = false; }
+    bool dirty() { return !dirtyArea_.isEmpty(); }
+    void clearDirty() { dirtyArea_.clear(); }
+    //! Marks the whole screen as changed so it is entirely sent to the display
+    void setAllDirty() { dirtyArea_.add(0, 0, width_, height_); }
+    //! Returns the parts of the screen that changed since last clearDirty()
+    const DirtyArea & dirtyArea() const { return dirtyArea_; }
+
+    //! Drawing will only change pixels inside the given rect
+    void setClipRect(int x, int y, int width, int height);
+    //! Drawing can change any pixel of the screen
+    void resetClipRect() { setClipRect(0, 0, width_, height_); }
+
+    //! Starts recording the area covered by drawing operations
+    void startTracking();
+    //! Stops recording and returns the area covered since startTracking()
+    DirtyRect stopTracking();
+
+    //! Moves the pixels inside the given rect by dx, dy
+    void shiftArea(int x, int y, int width, int height, int dx, int dy);
 
     void blit(int x, int y, int width, int height, const uint8 *pixeldata,
             bool flipped = false, int stride = 0);
+    //! Blits only the opaque runs of the given pixels
+    void blitSpans(int x, int y, int width, int height, const uint8 *pixeldata,
+            int stride, const SpanList &spans, bool flipped = false);
     void blitRect(int x, int y, int width, int height,
                   const uint8 * pixeldata, bool flipped = false, int stride = 0);
     void scale2x(int x, int y, int width, int height, const uint8 *pixeldata,
@@ -70,11 +92,24 @@ public:
     int gameScreenWidth();
     int gameScreenLeftMargin();
 
+protected:
+    //! Adds the part of the given rect that is inside the clip rect to the dirty area
+    void addDrawnRect(int x, int y, int width, int height);
+    //! Extends the tracked area with the given rect
+    void track(int x, int y, int width, int height);
+
 protected:
     int width_;
     int height_;
     uint8 *pixels_;
-    bool dirty_;
+    /*! Parts of the screen that have been changed.*/
+    DirtyArea dirtyArea_;
+    /*! Limits of the clip rect : right and bottom are excluded.*/
+    int clipX_, clipY_, clipRight_, clipBottom_;
+    /*! True when the area covered by drawing is recorded.*/
+    bool tracking_;
+    /*! Area covered by drawing since tracking started.*/
+    DirtyRect trackedArea_;
     int size_logo_;
     uint8 *data_logo_, *data_logo_copy_;
     int size_mini_logo_;
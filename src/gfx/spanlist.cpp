@@ -0,0 +1,66 @@
+/************************************************************************
+ *                                                                      *
+ *  FreeSynd - a remake of the classic Bullfrog game "Syndicate".       *
+ *                                                                      *
+ *   Copyright (C) 2016  Benoit Blancard <benblan@users.sourceforge.net>*
+ *                                                                      *
+ *    This program is free software;  you can redistribute it and / or  *
+ *  modify it  under the  terms of the  GNU General  Public License as  *
+ *  published by the Free Software Foundation; either version 2 of the  *
+ *  License, or (at your option) any later version.                     *
+ *                                                                      *
+ *    This program is  distributed in the hope that it will be useful,  *
+ *  but WITHOUT  ANY WARRANTY;  without even  the implied  warranty of  *
+ *  MERCHANTABILITY  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU  *
+ *  General Public License for more details.                            *
+ *                                                                      *
+ *    You can view the GNU  General Public License, online, at the GNU  *
+ *  project's  web  site;  see <http://www.gnu.org/licenses/gpl.html>.  *
+ *  The full text of the license is also included in the file COPYING.  *
+ *                                                                      *
+ ************************************************************************/
+
+#include "gfx/spanlist.h"
+#include "gfx/blitkernels.h"
+
+/*!
+ * Finds the runs of opaque pixels.
+ * \param pixels First row of the image
+ * \param width Width of the image
+ * \param height Height of the image
+ * \param stride Distance between two rows, negative when rows are
+ *  stored from bottom to top
+ */
+void SpanList::build(const uint8 *pixels, int width, int height, int stride) {
+    // columns are stored on 16 bits
+    assert(width <= 65535);
+    spans_.clear();
+    rowStart_.clear();
+    rowStart_.reserve(height + 1);
+
+    for (int j = 0; j < height; ++j) {
+        rowStart_.push_back((uint32) spans_.size());
+        const uint8 *row = pixels + j * stride;
+        int i = 0;
+        while (i < width) {
+            while (i < width && row[i] == fs_blit::kTransparentColor)
+                ++i;
+            int start = i;
+            while (i < width && row[i] != fs_blit::kTransparentColor)
+                ++i;
+            if (i > start) {
+                Span span = { (uint16) start, (uint16) (i - start) };
+                spans_.push_back(span);
+            }
+        }
+    }
+    rowStart_.push_back((uint32) spans_.size());
+}
+
+int SpanList::numOpaquePixels() const {
+    int total = 0;
+    for (size_t i = 0; i < spans_.size(); i++) {
+        total += spans_[i].length;
+    }
+    return total;
+}
@@ -0,0 +1,74 @@
+/************************************************************************
+ *                                                                      *
+ *  FreeSynd - a remake of the classic Bullfrog game "Syndicate".       *
+ *                                                                      *
+ *   Copyright (C) 2016  Benoit Blancard <benblan@users.sourceforge.net>*
+ *                                                                      *
+ *    This program is free software;  you can redistribute it and / or  *
+ *  modify it  under the  terms of the  GNU General  Public License as  *
+ *  published by the Free Software Foundation; either version 2 of the  *
+ *  License, or (at your option) any later version.                     *
+ *                                                                      *
+ *    This program is  distributed in the hope that it will be useful,  *
+ *  but WITHOUT  ANY WARRANTY;  without even  the implied  warranty of  *
+ *  MERCHANTABILITY  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU  *
+ *  General Public License for more details.                            *
+ *                                                                      *
+ *    You can view the GNU  General Public License, online, at the GNU  *
+ *  project's  web  site;  see <http://www.gnu.org/licenses/gpl.html>.  *
+ *  The full text of the license is also included in the file COPYING.  *
+ *                                                                      *
+ ************************************************************************/
+
+#ifndef GFX_SPANLIST_H_
+#define GFX_SPANLIST_H_
+
+#include <vector>
+
+#include "common.h"
+
+/*!
+ * Lists the runs of opaque pixels in each row of an image. It is built
+ * when the image is loaded so that blits copy the runs and never read
+ * the transparent pixels between them.
+ */
+class SpanList {
+public:
+    /*!
+     * A run of opaque pixels in a row.
+     */
+    struct Span {
+        /*! Column of the first pixel.*/
+        uint16 start;
+        /*! Number of pixels.*/
+        uint16 length;
+    };
+
+    //! Builds the list for the given pixels
+    void build(const uint8 *pixels, int width, int height, int stride);
+
+    //! Returns true if the list has been built
+    bool isBuilt() const { return !rowStart_.empty(); }
+    //! Index of the first span of the row
+    int rowBegin(int row) const { return rowStart_[row]; }
+    //! Index after the last span of the row
+    int rowEnd(int row) const { return rowStart_[row + 1]; }
+    const Span & span(int index) const { return spans_[index]; }
+
+    //! Returns the number of spans
+    int numSpans() const { return (int) spans_.size(); }
+    //! Returns the number of opaque pixels
+    int numOpaquePixels() const;
+    //! Returns the memory used by the list in bytes
+    size_t memorySize() const {
+        return spans_.size() * sizeof(Span) + rowStart_.size() * sizeof(uint32);
+    }
+
+private:
+    std::vector<Span> spans_;
+    /*! For each row, index of its first span. One more for the end.
+     * Big images can have more than 65535 spans.*/
+    std::vector<uint32> rowStart_;
+};
+
+#endif  // GFX_SPANLIST_H_
@@ -133,6 +133,7 @@ void Sprite::loadSpriteFromPNG(const char *filename)
         stride_ = w;
         for (unsigned int i = 0; i < h; i++)
             memcpy(sprite_data_ + i * stride_, row_pointers[i], w);
+        spans_.build(sprite_data_, width_, height_, stride_);
     }
 
     png_destroy_read_struct(&png_ptr, &info_ptr, 0);
@@ -223,6 +224,7 @@ bool Sprite::loadSprite(uint8 * tabData, uint8 * spriteData, uint32 offset,
         }
     }
 
+    spans_.build(sprite_data_, width_, height_, stride_);
     return true;
 }
 
@@ -230,6 +232,9 @@ void Sprite::draw(int x, int y, int z, bool flipped, bool x2)
 {
     if (x2)
         g_Screen.scale2x(x, y, width_, height_, sprite_data_, stride_);
+    else if (spans_.isBuilt())
+        g_Screen.blitSpans(x, y, width_, height_, sprite_data_, stride_,
+                      spans_, flipped);
     else
         g_Screen.blit(x, y, width_, height_, sprite_data_, flipped,
                       stride_);
@@ -27,6 +27,7 @@
 #define SPRITE_H
 
 #include "common.h"
+#include "gfx/spanlist.h"
 
 const int TABENTRY_SIZE = 6;
 
@@ -43,6 +44,8 @@ class Sprite {
      */
     int stride_;
     uint8 *sprite_data_;
+    /*! Runs of opaque pixels in sprite_data_.*/
+    SpanList spans_;
 
 public:
     /*! Id of sprite agent selector 1 in the menu sprite list.*/
@@ -93,6 +96,9 @@ public:
 
     int width() const { return width_; }
     int height() const { return height_; }
+    int stride() const { return stride_; }
+    const uint8 * pixels() const { return sprite_data_; }
+    const SpanList & spans() const { return spans_; }
 
     void data(uint8 *spr_data) const;
 };
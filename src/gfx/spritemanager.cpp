@@ -27,6 +27,7 @@
 
 #include "gfx/spritemanager.h"
 #include "utils/file.h"
+#include "utils/assetcache.h"
 
 SpriteManager::SpriteManager():sprites_(NULL), sprite_count_(0)
 {
@@ -101,20 +102,21 @@ GameSpriteManager::~GameSpriteManager()
 
 void GameSpriteManager::load()
 {
-    int tabSize, size;
-    uint8 *tabData, *data;
+    int size;
+    uint8 *data;
+    FileData sprTab, sprData;
 #if 1
-    tabData = File::loadOriginalFile("hspr-0.tab", tabSize);
-    data = File::loadOriginalFile("hspr-0.dat", size);
-    printf("Loaded %d sprites from hspr-0.dat\n", tabSize / 6);
+    File::loadOriginalData("hspr-0.tab", &sprTab);
+    File::loadOriginalData("hspr-0.dat", &sprData);
+    printf("Loaded %d sprites from hspr-0.dat\n", sprTab.size() / 6);
 #else
-    tabData = File::loadOriginalFile("hspr-0-d.tab", tabSize);
-    data = File::loadOriginalFile("hspr-0-d.dat", size);
-    printf("Loading %d sprites from hspr-0-d.dat\n", tabSize / 6);
+    File::loadOriginalData("hspr-0-d.tab", &sprTab);
+    File::loadOriginalData("hspr-0-d.dat", &sprData);
+    printf("Loading %d sprites from hspr-0-d.dat\n", sprTab.size() / 6);
 #endif
-    loadSprites(tabData, tabSize, data);
-    delete[] tabData;
-    delete[] data;
+    loadSprites(sprTab.data(), sprTab.size(), sprData.data());
+    sprTab.release();
+    sprData.release();
 
     FILE *fp = File::openOriginalFile("HELE-0.TXT");
     if (fp) {
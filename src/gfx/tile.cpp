@@ -28,6 +28,7 @@
 
 #include "tile.h"
 #include "gfx/screen.h"
+#include "gfx/blitkernels.h"
 
 
 Tile::Tile(uint8 id_set, uint8 *tile_Data, bool not_alpha, EType type_set)
@@ -37,6 +38,8 @@ Tile::Tile(uint8 id_set, uint8 *tile_Data, bool not_alpha, EType type_set)
     a_pixels_ = new uint8[TILE_WIDTH * TILE_HEIGHT];
     memcpy(a_pixels_, tile_Data, TILE_WIDTH * TILE_HEIGHT);
     not_alpha_ = not_alpha;
+    spans_.build(a_pixels_ + (TILE_HEIGHT - 1) * TILE_WIDTH, TILE_WIDTH,
+        TILE_HEIGHT, -TILE_WIDTH);
 }
 
 Tile::~Tile()
@@ -63,23 +66,30 @@ bool Tile::drawTo(uint8 * screen, int swidth, int sheight, int x, int y)
     uint8 *ptr_screen = screen + ylow * swidth + xlow;
     for (int j = ylow; j < yhigh; ++j)
     {
-        uint8 *cp_ptr_a_pixels = ptr_a_pixels;
+        fs_blit::copyRow(ptr_screen, ptr_a_pixels, xhigh - xlow);
         ptr_a_pixels -= TILE_WIDTH;
-        uint8 *cp_ptr_screen = ptr_screen;
         ptr_screen += swidth;
-        for (int i = xlow; i < xhigh; ++i) {
-            uint8 c = *cp_ptr_a_pixels++;
-            if (c != 255)
-                *cp_ptr_screen = c;
-            ++cp_ptr_screen;
-        }
     }
     return true;
 }
 
+/*!
+ * Draws the tile on the screen. Rows of tile are stored from bottom to top
+ * so they are blitted with a negative stride. Only the opaque runs are
+ * copied and the blit follows the clip rect of the screen.
+ * \return False if the tile is outside the screen
+ */
 bool Tile::drawToScreen(int x, int y)
 {
-    return drawTo((uint8*) g_Screen.pixels(), g_Screen.gameScreenWidth(), g_Screen.gameScreenHeight(), x, y);
+    if (x + TILE_WIDTH < 0 || y + TILE_HEIGHT < 0
+        || x >= g_Screen.gameScreenWidth() || y >= g_Screen.gameScreenHeight())
+    {
+        return false;
+    }
+
+    g_Screen.blitSpans(x, y, TILE_WIDTH, TILE_HEIGHT,
+        a_pixels_ + (TILE_HEIGHT - 1) * TILE_WIDTH, -TILE_WIDTH, spans_);
+    return true;
 }
 
 uint8 Tile::getWalkData() {
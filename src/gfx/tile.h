@@ -26,6 +26,7 @@
 #define TILE_H
 
 #include "common.h"
+#include "gfx/spanlist.h"
 
 // TODO: Convert these to const int's -- we are using C++, yes? :-)
 #define TILE_WIDTH              64
@@ -100,6 +101,11 @@ public:
 
     inline bool notTransparent() { return not_alpha_; }
 
+    //! Returns the pixels, rows are stored from bottom to top
+    const uint8 * pixels() const { return a_pixels_; }
+    //! Returns the runs of opaque pixels, first row is the top one
+    const SpanList & spans() const { return spans_; }
+
 protected:
     /*! Each tile has a unique id.*/
     uint8 i_id_;
@@ -107,6 +113,8 @@ protected:
     uint8 *a_pixels_;
     /*! A quick flag to tell that all pixel are transparent.*/
     bool not_alpha_;
+    /*! Runs of opaque pixels.*/
+    SpanList spans_;
     /*! The tile type. */
     EType e_type_;
 };
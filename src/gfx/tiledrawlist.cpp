@@ -0,0 +1,93 @@
+/************************************************************************
+ *                                                                      *
+ *  FreeSynd - a remake of the classic Bullfrog game "Syndicate".       *
+ *                                                                      *
+ *   Copyright (C) 2016  Benoit Blancard <benblan@users.sourceforge.net>*
+ *                                                                      *
+ *    This program is free software;  you can redistribute it and / or  *
+ *  modify it  under the  terms of the  GNU General  Public License as  *
+ *  published by the Free Software Foundation; either version 2 of the  *
+ *  License, or (at your option) any later version.                     *
+ *                                                                      *
+ *    This program is  distributed in the hope that it will be useful,  *
+ *  but WITHOUT  ANY WARRANTY;  without even  the implied  warranty of  *
+ *  MERCHANTABILITY  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU  *
+ *  General Public License for more details.                            *
+ *                                                                      *
+ *    You can view the GNU  General Public License, online, at the GNU  *
+ *  project's  web  site;  see <http://www.gnu.org/licenses/gpl.html>.  *
+ *  The full text of the license is also included in the file COPYING.  *
+ *                                                                      *
+ ************************************************************************/
+
+#include <algorithm>
+
+#include "gfx/tiledrawlist.h"
+#include "gfx/tile.h"
+#include "gfx/tilemanager.h"
+#include "map.h"
+#include "utils/log.h"
+
+/*!
+ * Stores each opaque tile in the block that contains the top left corner
+ * of the tile on the map and sorts each block by drawing order.
+ */
+void TileDrawList::build(Map *pMap) {
+    const int maxX = pMap->maxX();
+    const int maxY = pMap->maxY();
+    const int maxZ = pMap->maxZ();
+
+    // a tile is drawn at ((maxX + x - y) * 32, (maxZ + x + y - z + 1) * 16)
+    originX_ = (maxX - maxY + 1) * (TILE_WIDTH / 2);
+    nbCols_ = colAt((2 * maxX - 1) * (TILE_WIDTH / 2)) + 1;
+    nbRows_ = rowAt((maxZ + maxX + maxY - 1) * (TILE_HEIGHT / 3)) + 1;
+
+    std::vector<int> blocks;
+    std::vector<int> counts(nbCols_ * nbRows_, 0);
+    entries_.clear();
+    // cells are read in the order the map stores them
+    const uint8 *tileIds = pMap->tileIds();
+    TileManager *pTileMgr = pMap->tileManager();
+    for (int z = 0; z < maxZ; z++) {
+        for (int y = 0; y < maxY; y++) {
+            for (int x = 0; x < maxX; x++) {
+                uint8 tileId = *tileIds++;
+                if (!pTileMgr->isOpaque(tileId)) {
+                    continue;
+                }
+                Tile *pTile = pTileMgr->getTile(tileId);
+                int block = rowAt((maxZ + x + y - z + 1) * (TILE_HEIGHT / 3)) * nbCols_ +
+                    colAt((maxX + x - y) * (TILE_WIDTH / 2));
+                Entry entry = { cellKey(x, y, z), pTile };
+                entries_.push_back(entry);
+                blocks.push_back(block);
+                counts[block]++;
+            }
+        }
+    }
+
+    blockStart_.assign(nbCols_ * nbRows_ + 1, 0);
+    for (int i = 0; i < nbCols_ * nbRows_; i++) {
+        blockStart_[i + 1] = blockStart_[i] + counts[i];
+    }
+
+    std::vector<Entry> sorted(entries_.size());
+    std::vector<int> next(blockStart_.begin(), blockStart_.end() - 1);
+    for (size_t i = 0; i < entries_.size(); i++) {
+        sorted[next[blocks[i]]++] = entries_[i];
+    }
+    entries_.swap(sorted);
+    for (int i = 0; i < nbCols_ * nbRows_; i++) {
+        std::sort(entries_.begin() + blockStart_[i], entries_.begin() + blockStart_[i + 1],
+            isBefore);
+    }
+
+    LOG(Log::k_FLG_GFX, "TileDrawList", "build", ("%d opaque tiles out of %d in %dx%d blocks",
+        size(), maxX * maxY * maxZ, nbCols_, nbRows_))
+}
+
+void TileDrawList::clear() {
+    entries_.clear();
+    blockStart_.clear();
+    nbCols_ = nbRows_ = 0;
+}
@@ -0,0 +1,109 @@
+/************************************************************************
+ *                                                                      *
+ *  FreeSynd - a remake of the classic Bullfrog game "Syndicate".       *
+ *                                                                      *
+ *   Copyright (C) 2016  Benoit Blancard <benblan@users.sourceforge.net>*
+ *                                                                      *
+ *    This program is free software;  you can redistribute it and / or  *
+ *  modify it  under the  terms of the  GNU General  Public License as  *
+ *  published by the Free Software Foundation; either version 2 of the  *
+ *  License, or (at your option) any later version.                     *
+ *                                                                      *
+ *    This program is  distributed in the hope that it will be useful,  *
+ *  but WITHOUT  ANY WARRANTY;  without even  the implied  warranty of  *
+ *  MERCHANTABILITY  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU  *
+ *  General Public License for more details.                            *
+ *                                                                      *
+ *    You can view the GNU  General Public License, online, at the GNU  *
+ *  project's  web  site;  see <http://www.gnu.org/licenses/gpl.html>.  *
+ *  The full text of the license is also included in the file COPYING.  *
+ *                                                                      *
+ ************************************************************************/
+
+#ifndef GFX_TILEDRAWLIST_H_
+#define GFX_TILEDRAWLIST_H_
+
+#include <vector>
+
+#include "common.h"
+
+class Map;
+class Tile;
+
+/*!
+ * The opaque tiles of a map sorted in the order they must be drawn.
+ * Most cells of a map are empty air, so instead of browsing all the cells
+ * that may be on screen, the renderer only looks at the tiles of this list
+ * that are in the blocks of the map covered by the screen.
+ *
+ * Tiles are drawn from back to front : cells are sorted by x + y + z, then
+ * by x + y and then by x. This order is encoded in the key of each cell so
+ * objects can be inserted between tiles by comparing keys.
+ */
+class TileDrawList {
+public:
+    /*!
+     * A tile and its position in the map.
+     */
+    struct Entry {
+        /*! Position of the cell, see cellKey().*/
+        uint32 key;
+        Tile *pTile;
+    };
+
+    /*! Width in pixels of the blocks in which tiles are stored.*/
+    static const int kBlockWidth = 256;
+    /*! Height in pixels of the blocks in which tiles are stored.*/
+    static const int kBlockHeight = 256;
+
+    TileDrawList() : nbCols_(0), nbRows_(0), originX_(0) {}
+
+    //! Lists the opaque tiles of the map
+    void build(Map *pMap);
+    //! Forgets the tiles so the list must be built again
+    void clear();
+    bool isBuilt() const { return !blockStart_.empty(); }
+
+    //! Returns the number of tiles in the list
+    int size() const { return (int) entries_.size(); }
+    //! Returns the memory used by the list in bytes
+    size_t memorySize() const {
+        return entries_.capacity() * sizeof(Entry) + blockStart_.capacity() * sizeof(int);
+    }
+    int nbCols() const { return nbCols_; }
+    int nbRows() const { return nbRows_; }
+    //! Returns the column of blocks at the given map x coordinate in pixels (-1 if before first)
+    int colAt(int x) const { return x < originX_ ? -1 : (x - originX_) / kBlockWidth; }
+    //! Returns the row of blocks at the given map y coordinate in pixels (-1 if before first)
+    int rowAt(int y) const { return y < 0 ? -1 : y / kBlockHeight; }
+    //! Returns the first tile of the block
+    const Entry * blockBegin(int col, int row) const {
+        return entries_.data() + blockStart_[row * nbCols_ + col];
+    }
+    //! Returns the end of the tiles of the block
+    const Entry * blockEnd(int col, int row) const {
+        return entries_.data() + blockStart_[row * nbCols_ + col + 1];
+    }
+
+    //! Returns a key that gives the drawing order of the cell
+    static uint32 cellKey(int x, int y, int z) {
+        return ((uint32) (x + y + z) << 20) | ((uint32) (x + y) << 10) | (uint32) x;
+    }
+    //! Returns true if the first entry must be drawn before the second
+    static bool isBefore(const Entry &e1, const Entry &e2) { return e1.key < e2.key; }
+    static int keyX(uint32 key) { return key & 0x3FF; }
+    static int keyY(uint32 key) { return ((key >> 10) & 0x3FF) - (key & 0x3FF); }
+    static int keyZ(uint32 key) { return (key >> 20) - ((key >> 10) & 0x3FF); }
+
+private:
+    /*! Tiles grouped by block, each block being sorted by key.*/
+    std::vector<Entry> entries_;
+    /*! Index of the first tile of each block. One more for the end.*/
+    std::vector<int> blockStart_;
+    int nbCols_;
+    int nbRows_;
+    /*! Map x coordinate of the first column of blocks.*/
+    int originX_;
+};
+
+#endif  // GFX_TILEDRAWLIST_H_
@@ -29,6 +29,7 @@
 #include "resources.h"
 #include "utils/log.h"
 #include "utils/file.h"
+#include "utils/assetcache.h"
 
 /*!
  *
@@ -81,6 +82,10 @@ TileManager::TileManager()
 {
     a_tiles_ = new Tile*[kNumOfTiles];
     memset(a_tiles_, 0, sizeof(Tile*) * kNumOfTiles);
+    a_walkData_ = new uint8[kNumOfTiles];
+    memset(a_walkData_, 0, kNumOfTiles);
+    a_opaque_ = new uint8[kNumOfTiles];
+    memset(a_opaque_, 0, kNumOfTiles);
 }
 
 /*!
@@ -92,6 +97,8 @@ TileManager::~TileManager()
         delete a_tiles_[i];
     }
     delete [] a_tiles_;
+    delete [] a_walkData_;
+    delete [] a_opaque_;
 }
 
 /*!
@@ -185,31 +192,26 @@ Tile::EType TileManager::toTileType(uint8 data)
  */
 bool TileManager::loadTiles()
 {
-    int size;
-    uint8 *type_data;
-
+    FileData typeData;
     // first reads types
-    type_data = File::loadOriginalFile(TILE_TYPES, size);
-    if (!type_data) {
+    if (!File::loadOriginalData(TILE_TYPES, &typeData)) {
         return false;
     }
 
     // then reads tiles
-    uint8 *tileData = File::loadOriginalFile(TILE_SET, size);
-  
-    if (!tileData) {
+    FileData tileData;
+    if (!File::loadOriginalData(TILE_SET, &tileData)) {
         FSERR(Log::k_FLG_IO, "TileManager", "loadTiles", ("Failed to load tiles data\n"));
-        delete[] type_data;
         return false;
     }
 
     // Loads all tiles
     for (int i = 0; i < kNumOfTiles; ++i) {
-        a_tiles_[i] = loadTile(tileData, i, toTileType(type_data[i]));
+        a_tiles_[i] = loadTile(tileData.data(), i, toTileType(typeData.data()[i]));
+        a_walkData_[i] = a_tiles_[i]->getWalkData();
+        a_opaque_[i] = a_tiles_[i]->notTransparent() ? 1 : 0;
     }
 
-    delete[] type_data;
-    delete[] tileData;
     return true;
 }
 
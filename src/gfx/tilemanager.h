@@ -43,6 +43,10 @@ public:
 
     //! Returns tile with the given index
     Tile * getTile(uint8 index);
+    //! Returns the walk data of the tile with the given index
+    uint8 walkData(uint8 index) { return a_walkData_[index]; }
+    //! Returns true if the tile with the given index has opaque pixels
+    bool isOpaque(uint8 index) { return a_opaque_[index] != 0; }
 
 protected:
     //! Load a given tile
@@ -53,6 +57,10 @@ protected:
 protected:
     //! All the tiles in the game
     Tile **a_tiles_;
+    /*! Walk data of each tile, so maps can read it from a tile id.*/
+    uint8 *a_walkData_;
+    /*! 1 for each tile that is not fully transparent.*/
+    uint8 *a_opaque_;
 };
 
 #endif
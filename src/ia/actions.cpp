@@ -236,7 +236,7 @@ bool WalkAction::suspend(PedInstance *pPed) {
 
 void WalkAction::doStart(Mission *pMission, PedInstance *pPed) {
     // Go to given location at given speed
-    if (!pPed->initMovementToDestination(pMission, destLocT_, newSpeed_)) {
+    if (!pPed->requestMovementToDestination(pMission, destLocT_, newSpeed_)) {
         setFailed();
         return;
     }
@@ -252,6 +252,14 @@ void WalkAction::doStart(Mission *pMission, PedInstance *pPed) {
  * \param pPed The ped executing the action.
  */
 bool WalkAction::doExecute(int elapsed, Mission *pMission, PedInstance *pPed) {
+    if (pPed->isWaitingForPath()) {
+        // path workers have not found the path yet
+        return false;
+    } else if (pPed->hasPathRequestFailed()) {
+        setFailed();
+        return false;
+    }
+
     bool updated = pPed->doMove(elapsed, pMission);
     if (!pPed->hasDestination()) {
         // Ped has arrived at destination
@@ -495,21 +503,26 @@ bool FollowToShootAction::doExecute(int elapsed, Mission *pMission, PedInstance
         if (!pTarget_->isCloseTo(targetLastPosW_, 128)) {
             // resetting target position
             targetLastPosW_.convertFromTilePoint(pTarget_->position());
-            if (!pPed->initMovementToDestination(pMission, pTarget_->position())) {
+            if (!pPed->requestMovementToDestination(pMission, pTarget_->position())) {
                 setFailed();
                 return true;
             }
         }
 
-        WorldPoint pedPosW(pPed->position());
+        if (pPed->hasPathRequestFailed()) {
+            setFailed();
+            return true;
+        }
+
         // Ped stops walking if the target is in range of fire (ie close enough and not
-        // hiding behing something)
+        // hiding behing something).
+        WorldPoint pedPosW(pPed->position());
         if (pPed->isCloseTo(pTarget_, followDistance_) &&
-            pMission->checkBlockedByTile(pedPosW, &targetLastPosW_, true, followDistance_) == 1) {
+            pMission->perception().checkLine(pMission, pPed, pedPosW, &targetLastPosW_, followDistance_) == 1) {
             // We reached the target so stop moving
             setSucceeded();
             pPed->clearDestination();
-        } else {
+        } else if (!pPed->isWaitingForPath()) {
             updated = pPed->doMove(elapsed, pMission);
         }
 
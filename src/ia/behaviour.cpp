@@ -31,15 +31,15 @@
 #include "model/squad.h"
 #include "core/gamesession.h"
 #include "core/gamecontroller.h"
+#include "utils/profiler.h"
 
 //*************************************
 // Constant definition
 //*************************************
 const int CommonAgentBehaviourComponent::kRegeratesHealthStep = 1;
-const int PanicComponent::kScoutDistance = 1500;
 const int PanicComponent::kDistanceToRun = 500;
 const double PersuadedBehaviourComponent::kMaxRangeForSearchingWeapon = 500.0;
-const int PoliceBehaviourComponent::kPoliceScoutDistance = 1500;
+const int PoliceBehaviourComponent::kPoliceScoutDistance = ThreatMap::kArmedPedRange;
 const int PoliceBehaviourComponent::kPolicePendingTime = 1500;
 const int PlayerHostileBehaviourComponent::kEnemyScoutDistance = 1500;
 
@@ -81,6 +81,7 @@ void Behaviour::replaceAllcomponentsBy(BehaviourComponent *pComp) {
  * \param pMission Mission data
  */
 void Behaviour::execute(int elapsed, Mission *pMission) {
+    PROFILE_ZONE("Behaviour::execute");
     if (pThisPed_->isDead()) {
         return;
     }
@@ -135,10 +136,13 @@ PersuaderBehaviourComponent::PersuaderBehaviourComponent():
 void PersuaderBehaviourComponent::execute(int elapsed, Mission *pMission, PedInstance *pPed) {
     // Check if Agent has selected his Persuadotron
     if (doUsePersuadotron_) {
-        // iterate through all peds except our agents
-        for (size_t i = pMission->getSquad()->size(); i < pMission->numPeds(); i++) {
-            PedInstance *pOtherPed = pMission->ped(i);
-            if (pPed->canPersuade(pOtherPed, persuadotronRange_)) {
+        // iterate through all peds near the agent except our agents
+        WorldPoint agentPosW(pPed->position());
+        pMission->objectsGrid().findInRange(agentPosW, persuadotronRange_,
+            MapObject::kNaturePed, pedsAround_);
+        for (size_t i = 0; i < pedsAround_.size(); i++) {
+            PedInstance *pOtherPed = static_cast<PedInstance *>(pedsAround_[i]);
+            if (!pOtherPed->isOurAgent() && pPed->canPersuade(pOtherPed, persuadotronRange_)) {
                 fs_dmg::DamageToInflict dmg;
                 dmg.dtype = fs_dmg::kDmgTypePersuasion;
                 dmg.d_owner = pPed;
@@ -303,9 +307,8 @@ void PanicComponent::execute(int elapsed, Mission *pMission, PedInstance *pCivil
     }
 
     if (status_ == kPanicStatusAlert && scoutTimer_.update(elapsed)) {
-        pArmedPed_ = findNearbyArmedPed(pMission, pCivil);
-        if (pArmedPed_) {
-            runAway(pCivil);
+        if (pMission->threats().isDangerous(pCivil->tileX(), pCivil->tileY())) {
+            runAway(pMission, pCivil);
             status_ = kPanicStatusInPanic;
         } else if (backFromPanic_) {
             backFromPanic_ = false;
@@ -343,9 +346,8 @@ void PanicComponent::handleBehaviourEvent(PedInstance *pCivil, Behaviour::Behavi
         }
         break;
     case Behaviour::kBehvEvtActionEnded:
-        if (!pCivil->isCloseTo(pArmedPed_, kScoutDistance)) {
-            // Ped is far from armed guy,
-            pArmedPed_ = NULL;
+        if (!g_Session.getMission()->threats().isDangerous(pCivil->tileX(), pCivil->tileY())) {
+            // Ped is far from danger,
             // so next time check if there another enemy around
             status_ = kPanicStatusAlert;
             scoutTimer_.setToMax();
@@ -358,32 +360,16 @@ void PanicComponent::handleBehaviourEvent(PedInstance *pCivil, Behaviour::Behavi
 }
 
 /*!
- * Return the first armed ped that is close to the given ped.
- * \param pMission
- * \param pPed
- * \return NULL if no ped is found
- */
-PedInstance * PanicComponent::findNearbyArmedPed(Mission *pMission, PedInstance *pPed) {
-    for (size_t i = 0; i < pMission->numArmedPeds(); i++) {
-        PedInstance *pOtherPed = pMission->armedPedAtIndex(i);
-        if (pPed->isCloseTo(pOtherPed, kScoutDistance)) {
-            return pOtherPed;
-        }
-    }
-    return NULL;
-}
-
-/*!
- * Makes the ped runs in the opposite way of the armed ped.
+ * Makes the ped run toward the least dangerous neighbour tile.
+ * \param pMission Mission data
  * \param pPed The panicking ped
  */
-void  PanicComponent::runAway(PedInstance *pPed) {
-    // setting opposite direction for movement
-    WorldPoint thisPedLocW(pPed->position());
-    WorldPoint otherLocW(pArmedPed_->position());
-
-    pPed->setDirection(otherLocW.x - thisPedLocW.x,
-        otherLocW.y - thisPedLocW.y);
+void  PanicComponent::runAway(Mission *pMission, PedInstance *pPed) {
+    int dx = 0;
+    int dy = 0;
+    if (pMission->threats().fleeDirection(pPed->tileX(), pPed->tileY(), &dx, &dy)) {
+        pPed->setDirection(dx, dy);
+    }
     if (pPed->altAction() == NULL) {
         // Adds the action of running away
         WalkToDirectionAction *pAction =
@@ -492,8 +478,14 @@ bool PoliceBehaviourComponent::findAndEngageNewTarget(Mission *pMission, PedInst
 
 /*!
  * Return a ped that has his weapon out and is not a police man and is close to this policeman.
+ * No sight test here : the police man goes to the target until
+ * FollowToShootAction finds no tile between them.
  */
 PedInstance * PoliceBehaviourComponent::findArmedPedNotPolice(Mission *pMission, PedInstance *pPed) {
+    if (!pMission->threats().hasArmedPedInRange(pPed->tileX(), pPed->tileY())) {
+        // no need to look at every armed ped
+        return NULL;
+    }
     for (size_t i = 0; i < pMission->numArmedPeds(); i++) {
         PedInstance *pOtherPed = pMission->armedPedAtIndex(i);
         if (pPed != pOtherPed && pOtherPed->type() != PedInstance::kPedTypePolice && pPed->isCloseTo(pOtherPed, kPoliceScoutDistance)) {
@@ -590,6 +582,11 @@ void PlayerHostileBehaviourComponent::handleBehaviourEvent(PedInstance *pPed, Be
     }
 }
 
+/*!
+ * Return the first living agent close to the ped.
+ * No sight test here : the ped goes to the agent until FollowToShootAction
+ * finds no tile between them.
+ */
 PedInstance * PlayerHostileBehaviourComponent::findPlayerAgent(Mission *pMission, PedInstance *pPed) {
     for (size_t i = 0; i < pMission->getSquad()->size(); i++) {
         PedInstance *pAgent = pMission->getSquad()->member(i);
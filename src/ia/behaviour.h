@@ -25,6 +25,7 @@
 #define IA_BEHAVIOUR_H_
 
 #include <list>
+#include <vector>
 
 #include "utils/timer.h"
 #include "ia/actions.h"
@@ -33,6 +34,7 @@ class Mission;
 class PedInstance;
 class BehaviourComponent;
 class WeaponInstance;
+class MapObject;
 
 /*!
  * A Behaviour drives the ped's reactions.
@@ -141,6 +143,8 @@ private:
     /*! Flag to indicate an agent can use his persuadotron.*/
     bool doUsePersuadotron_;
     int persuadotronRange_;
+    /*! Peds near the agent, filled at each execution.*/
+    std::vector<MapObject *> pedsAround_;
 };
 
 /*!
@@ -193,8 +197,6 @@ private:
  */
 class PanicComponent : public BehaviourComponent {
 public:
-    //! Range for looking for armed ped
-    static const int kScoutDistance;
     //! The distance a panicking ped walks before calming down
     static const int kDistanceToRun;
 
@@ -204,10 +206,8 @@ public:
 
     void handleBehaviourEvent(PedInstance *pPed, Behaviour::BehaviourEvent evtType, void *pCtxt);
 private:
-    //! Checks whether there is an armed ped next to the ped : returns that ped
-    PedInstance * findNearbyArmedPed(Mission *pMission, PedInstance *pPed);
-    //! Makes the ped runs in the opposite direction from the armed ped
-    void  runAway(PedInstance *pPed);
+    //! Makes the ped run away from danger
+    void  runAway(Mission *pMission, PedInstance *pPed);
 private:
     /*!
      * Status of police behaviour.
@@ -225,8 +225,6 @@ private:
     fs_utils::Timer scoutTimer_;
     /*! Use to detect if ped is getting from panic to not panic.*/
     bool backFromPanic_;
-    /*! The ped that frightened this civilian.*/
-    PedInstance *pArmedPed_;
 };
 
 class PoliceBehaviourComponent : public BehaviourComponent {
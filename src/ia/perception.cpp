@@ -0,0 +1,153 @@
+/************************************************************************
+ *                                                                      *
+ *  FreeSynd - a remake of the classic Bullfrog game "Syndicate".       *
+ *                                                                      *
+ *   Copyright (C) 2016  Benoit Blancard <benblan@users.sourceforge.net>*
+ *                                                                      *
+ *    This program is free software;  you can redistribute it and / or  *
+ *  modify it  under the  terms of the  GNU General  Public License as  *
+ *  published by the Free Software Foundation; either version 2 of the  *
+ *  License, or (at your option) any later version.                     *
+ *                                                                      *
+ *    This program is  distributed in the hope that it will be useful,  *
+ *  but WITHOUT  ANY WARRANTY;  without even  the implied  warranty of  *
+ *  MERCHANTABILITY  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU  *
+ *  General Public License for more details.                            *
+ *                                                                      *
+ *    You can view the GNU  General Public License, online, at the GNU  *
+ *  project's  web  site;  see <http://www.gnu.org/licenses/gpl.html>.  *
+ *  The full text of the license is also included in the file COPYING.  *
+ *                                                                      *
+ ************************************************************************/
+
+#include <string.h>
+
+#include "ia/perception.h"
+#include "ped.h"
+#include "mission.h"
+#include "utils/log.h"
+
+const int Perception::kTickPeriod = 200;
+const int Perception::kSightDistance = 6144;
+
+Perception::Perception() : tickTimer_(kTickPeriod) {
+    cacheEnabled_ = true;
+    reset();
+}
+
+void Perception::reset() {
+    tickTimer_.reset();
+    tick_ = 1;
+    pairs_.clear();
+    lines_.clear();
+    memset(&stats_, 0, sizeof(Stats));
+}
+
+/*!
+ * All answers become invalid at the beginning of a tick.
+ * \param elapsed Time since last call
+ */
+void Perception::update(int elapsed) {
+    if (tickTimer_.update(elapsed)) {
+        tick_++;
+        stats_.ticks++;
+    }
+}
+
+/*!
+ * \param pMission The mission
+ * \param pPedA A ped
+ * \param pPedB Another ped
+ * \return true if peds are close enough and no tile is between them.
+ */
+bool Perception::canSee(Mission *pMission, PedInstance *pPedA, PedInstance *pPedB) {
+    stats_.queries++;
+    if (pPedA == pPedB) {
+        return true;
+    }
+    if (!pPedA->isCloseTo(pPedB, kSightDistance)) {
+        stats_.culled++;
+        return false;
+    }
+    if (!cacheEnabled_ || pPedA->id() >= kMaxPeds || pPedB->id() >= kMaxPeds) {
+        return castRay(pMission, pPedA, pPedB);
+    }
+
+    if (pairs_.empty()) {
+        pairs_.assign(kMaxPeds * (kMaxPeds - 1) / 2, 0);
+    }
+    uint32 low = pPedA->id() < pPedB->id() ? pPedA->id() : pPedB->id();
+    uint32 high = pPedA->id() < pPedB->id() ? pPedB->id() : pPedA->id();
+    uint32 &answer = pairs_[high * (high - 1) / 2 + low];
+    if ((answer >> 1) == tick_) {
+        stats_.hits++;
+        return (answer & 1) != 0;
+    }
+
+    bool visible = castRay(pMission, pPedA, pPedB);
+    answer = (tick_ << 1) | (visible ? 1 : 0);
+    return visible;
+}
+
+/*!
+ * The line is cast with updateLoc set, as tiles don't change during a mission
+ * the same points always give the same answer and updated target.
+ * \param pMission The mission
+ * \param pPed The ped casting the line
+ * \param fromW Origin of the line
+ * \param pToW Target of the line, updated when a tile is in the way
+ * \param distanceMax Length of the line
+ * \return the mask returned by Mission::checkBlockedByTile().
+ */
+uint8 Perception::checkLine(Mission *pMission, PedInstance *pPed, const WorldPoint &fromW,
+                            WorldPoint *pToW, double distanceMax) {
+    stats_.queries++;
+    if (!cacheEnabled_ || pPed->id() >= kMaxPeds) {
+        stats_.rays++;
+        return pMission->checkBlockedByTile(fromW, pToW, true, distanceMax);
+    }
+
+    if (lines_.empty()) {
+        Line empty;
+        empty.tick = 0;
+        lines_.assign(kMaxPeds, empty);
+    }
+    Line &line = lines_[pPed->id()];
+    if (line.tick == tick_ && line.distanceMax == distanceMax &&
+            line.fromW.equals(fromW) && line.toW.equals(*pToW)) {
+        stats_.hits++;
+        *pToW = line.resultW;
+        return line.result;
+    }
+
+    stats_.rays++;
+    line.tick = tick_;
+    line.fromW = fromW;
+    line.toW = *pToW;
+    line.distanceMax = distanceMax;
+    line.result = pMission->checkBlockedByTile(fromW, pToW, true, distanceMax);
+    line.resultW = *pToW;
+    return line.result;
+}
+
+bool Perception::castRay(Mission *pMission, PedInstance *pPedA, PedInstance *pPedB) {
+    stats_.rays++;
+    // always cast from the lowest id so both peds get the same answer
+    if (pPedB->id() < pPedA->id()) {
+        PedInstance *pTmp = pPedA;
+        pPedA = pPedB;
+        pPedB = pTmp;
+    }
+    WorldPoint fromW(pPedA->position());
+    fromW.z += pPedA->sizeZ() >> 1;
+    WorldPoint toW(pPedB->position());
+    toW.z += pPedB->sizeZ() >> 1;
+    return pMission->checkBlockedByTile(fromW, &toW, false, kSightDistance) == 1;
+}
+
+void Perception::logStats() const {
+    LOG(Log::k_FLG_GAME, "Perception", "logStats",
+        ("ticks %u, queries %u, cache hits %u, culled %u, rays %u%s", stats_.ticks,
+        stats_.queries, stats_.hits, stats_.culled, stats_.rays,
+        cacheEnabled_ ? "" : " (cache disabled)"))
+}
@@ -0,0 +1,120 @@
+/************************************************************************
+ *                                                                      *
+ *  FreeSynd - a remake of the classic Bullfrog game "Syndicate".       *
+ *                                                                      *
+ *   Copyright (C) 2016  Benoit Blancard <benblan@users.sourceforge.net>*
+ *                                                                      *
+ *    This program is free software;  you can redistribute it and / or  *
+ *  modify it  under the  terms of the  GNU General  Public License as  *
+ *  published by the Free Software Foundation; either version 2 of the  *
+ *  License, or (at your option) any later version.                     *
+ *                                                                      *
+ *    This program is  distributed in the hope that it will be useful,  *
+ *  but WITHOUT  ANY WARRANTY;  without even  the implied  warranty of  *
+ *  MERCHANTABILITY  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU  *
+ *  General Public License for more details.                            *
+ *                                                                      *
+ *    You can view the GNU  General Public License, online, at the GNU  *
+ *  project's  web  site;  see <http://www.gnu.org/licenses/gpl.html>.  *
+ *  The full text of the license is also included in the file COPYING.  *
+ *                                                                      *
+ ************************************************************************/
+
+#ifndef IA_PERCEPTION_H_
+#define IA_PERCEPTION_H_
+
+#include <vector>
+
+#include "common.h"
+#include "model/position.h"
+#include "utils/timer.h"
+
+class Mission;
+class PedInstance;
+
+/*!
+ * Tells behaviours and actions which peds can see each other.
+ * Seeing is symmetric, so a ray is cast for a pair of peds at most once per
+ * perception tick and the answer is kept until the next tick, whatever the
+ * number of peds asking. Peds farther than kSightDistance never see each
+ * other and no ray is cast for them.
+ * Callers that need a ray between given points use checkLine() : the last
+ * line of each ped is kept for the tick and reused only when asked again
+ * with the same points, so the answer is the one of
+ * Mission::checkBlockedByTile().
+ * The cache can be disabled to measure how many rays it saves.
+ */
+class Perception {
+public:
+    //! Counters of visibility queries
+    struct Stats {
+        //! Number of perception ticks
+        uint32 ticks;
+        //! Number of visibility queries
+        uint32 queries;
+        //! Number of queries answered from the cache
+        uint32 hits;
+        //! Number of queries rejected by distance
+        uint32 culled;
+        //! Number of rays cast
+        uint32 rays;
+    };
+
+    //! Peds are identified by their id, which is lower than this
+    static const int kMaxPeds = 256;
+    //! Time in ms during which an answer is kept
+    static const int kTickPeriod;
+    //! Distance beyond which peds can't see each other
+    static const int kSightDistance;
+
+    Perception();
+
+    //! Forgets all answers and clears counters
+    void reset();
+    //! Enables or disables the cache of answers
+    void setCacheEnabled(bool enabled) { cacheEnabled_ = enabled; }
+    bool isCacheEnabled() const { return cacheEnabled_; }
+    //! Starts a new tick when its time has come
+    void update(int elapsed);
+    //! Returns true if nothing blocks the sight between the two peds
+    bool canSee(Mission *pMission, PedInstance *pPedA, PedInstance *pPedB);
+    //! Returns Mission::checkBlockedByTile() for a line cast by a ped
+    uint8 checkLine(Mission *pMission, PedInstance *pPed, const WorldPoint &fromW,
+                    WorldPoint *pToW, double distanceMax);
+
+    const Stats & stats() const { return stats_; }
+    //! Writes counters to the log
+    void logStats() const;
+
+protected:
+    //! Casts a ray between the middle of the two peds
+    bool castRay(Mission *pMission, PedInstance *pPedA, PedInstance *pPedB);
+
+protected:
+    //! Last line cast by a ped
+    struct Line {
+        /*! Tick of the answer, 0 if none.*/
+        uint32 tick;
+        WorldPoint fromW;
+        /*! Target point given by the caller.*/
+        WorldPoint toW;
+        double distanceMax;
+        /*! Target point updated by checkBlockedByTile().*/
+        WorldPoint resultW;
+        uint8 result;
+    };
+
+    /*! Counts the time of the current tick.*/
+    fs_utils::Timer tickTimer_;
+    /*! Current tick, starts at 1.*/
+    uint32 tick_;
+    /*! For each pair of ped ids : tick of the answer << 1 | answer.*/
+    std::vector<uint32> pairs_;
+    /*! For each ped id : last line cast by this ped.*/
+    std::vector<Line> lines_;
+    /*! False to cast a ray for each query.*/
+    bool cacheEnabled_;
+    Stats stats_;
+};
+
+#endif  // IA_PERCEPTION_H_
@@ -0,0 +1,214 @@
+/************************************************************************
+ *                                                                      *
+ *  FreeSynd - a remake of the classic Bullfrog game "Syndicate".       *
+ *                                                                      *
+ *   Copyright (C) 2016  Benoit Blancard <benblan@users.sourceforge.net>*
+ *                                                                      *
+ *    This program is free software;  you can redistribute it and / or  *
+ *  modify it  under the  terms of the  GNU General  Public License as  *
+ *  published by the Free Software Foundation; either version 2 of the  *
+ *  License, or (at your option) any later version.                     *
+ *                                                                      *
+ *    This program is  distributed in the hope that it will be useful,  *
+ *  but WITHOUT  ANY WARRANTY;  without even  the implied  warranty of  *
+ *  MERCHANTABILITY  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU  *
+ *  General Public License for more details.                            *
+ *                                                                      *
+ *    You can view the GNU  General Public License, online, at the GNU  *
+ *  project's  web  site;  see <http://www.gnu.org/licenses/gpl.html>.  *
+ *  The full text of the license is also included in the file COPYING.  *
+ *                                                                      *
+ ************************************************************************/
+
+#include <math.h>
+
+#include "ia/threatmap.h"
+#include "ped.h"
+
+const int ThreatMap::kShotRange = 2048;
+const int ThreatMap::kArmedPedLevel = 64;
+const int ThreatMap::kShotLevel = 128;
+const int ThreatMap::kDecayPeriod = 500;
+
+ThreatMap::ThreatMap() : decayTimer_(kDecayPeriod) {
+    width_ = 0;
+    height_ = 0;
+    nbNoisyTiles_ = 0;
+    armedRadius_ = buildStamp(kArmedPedRange, kArmedPedLevel, &armedStamp_);
+    shotRadius_ = buildStamp(kShotRange, kShotLevel, &shotStamp_);
+}
+
+/*!
+ * A tile is in the stamp if one of its points is in range of a point
+ * of the center tile, so every ped in range of another ped is on a tile
+ * of his footprint. Danger decreases from the center to the border, where
+ * it is 1.
+ * \param range Distance in world coords
+ * \param level Danger at the center
+ * \param pStamp Receives the danger for each tile around the center
+ * \return The number of tiles on each side of the center
+ */
+int ThreatMap::buildStamp(int range, int level, std::vector<uint8> *pStamp) {
+    int radius = range / 256 + 1;
+    int size = 2 * radius + 1;
+    pStamp->assign(size * size, 0);
+    for (int dy = -radius; dy <= radius; dy++) {
+        for (int dx = -radius; dx <= radius; dx++) {
+            int gapX = (dx < 0 ? -dx : dx) - 1;
+            int gapY = (dy < 0 ? -dy : dy) - 1;
+            gapX = gapX < 0 ? 0 : gapX * 256;
+            gapY = gapY < 0 ? 0 : gapY * 256;
+            int dist = (int) sqrt((double) (gapX * gapX + gapY * gapY));
+            if (dist < range) {
+                (*pStamp)[(dy + radius) * size + dx + radius] =
+                    (uint8) (1 + (level - 1) * (range - dist) / range);
+            }
+        }
+    }
+    return radius;
+}
+
+/*!
+ * \param width Number of tiles along X
+ * \param height Number of tiles along Y
+ */
+void ThreatMap::init(int width, int height) {
+    width_ = width;
+    height_ = height;
+    armed_.assign(width * height, 0);
+    noise_.assign(width * height, 0);
+    nbNoisyTiles_ = 0;
+    sources_.clear();
+    decayTimer_.reset();
+}
+
+void ThreatMap::addArmedPed(PedInstance *pPed) {
+    Source src;
+    src.pPed = pPed;
+    src.tx = pPed->tileX();
+    src.ty = pPed->tileY();
+    sources_.push_back(src);
+    stampArmedPed(src.tx, src.ty, true);
+}
+
+void ThreatMap::removeArmedPed(PedInstance *pPed) {
+    for (size_t i = 0; i < sources_.size(); i++) {
+        if (sources_[i].pPed == pPed) {
+            stampArmedPed(sources_[i].tx, sources_[i].ty, false);
+            sources_.erase(sources_.begin() + i);
+            break;
+        }
+    }
+}
+
+void ThreatMap::stampArmedPed(int tx, int ty, bool add) {
+    int size = 2 * armedRadius_ + 1;
+    for (int dy = -armedRadius_; dy <= armedRadius_; dy++) {
+        int y = ty + dy;
+        if (y < 0 || y >= height_) {
+            continue;
+        }
+        const uint8 *pStamp = &armedStamp_[(dy + armedRadius_) * size + armedRadius_];
+        for (int dx = -armedRadius_; dx <= armedRadius_; dx++) {
+            int x = tx + dx;
+            if (x < 0 || x >= width_) {
+                continue;
+            }
+            if (add) {
+                armed_[y * width_ + x] += pStamp[dx];
+            } else {
+                armed_[y * width_ + x] -= pStamp[dx];
+            }
+        }
+    }
+}
+
+/*!
+ * Noise is not added to existing noise : a tile keeps the loudest.
+ * \param originW Where the shot comes from
+ */
+void ThreatMap::addShot(const WorldPoint &originW) {
+    int tx = originW.x / 256;
+    int ty = originW.y / 256;
+    int size = 2 * shotRadius_ + 1;
+    for (int dy = -shotRadius_; dy <= shotRadius_; dy++) {
+        int y = ty + dy;
+        if (y < 0 || y >= height_) {
+            continue;
+        }
+        const uint8 *pStamp = &shotStamp_[(dy + shotRadius_) * size + shotRadius_];
+        for (int dx = -shotRadius_; dx <= shotRadius_; dx++) {
+            int x = tx + dx;
+            if (x < 0 || x >= width_) {
+                continue;
+            }
+            uint8 &noise = noise_[y * width_ + x];
+            if (pStamp[dx] > noise) {
+                if (noise == 0) {
+                    nbNoisyTiles_++;
+                }
+                noise = pStamp[dx];
+            }
+        }
+    }
+}
+
+/*!
+ * Moves the footprint of armed peds who changed tile and halves
+ * noise when its period has come.
+ * \param elapsed Time since last update
+ */
+void ThreatMap::update(int elapsed) {
+    for (size_t i = 0; i < sources_.size(); i++) {
+        Source &src = sources_[i];
+        int tx = src.pPed->tileX();
+        int ty = src.pPed->tileY();
+        if (tx != src.tx || ty != src.ty) {
+            stampArmedPed(src.tx, src.ty, false);
+            src.tx = tx;
+            src.ty = ty;
+            stampArmedPed(tx, ty, true);
+        }
+    }
+
+    if (decayTimer_.update(elapsed) && nbNoisyTiles_ > 0) {
+        for (size_t i = 0; i < noise_.size(); i++) {
+            if (noise_[i] != 0) {
+                noise_[i] >>= 1;
+                if (noise_[i] == 0) {
+                    nbNoisyTiles_--;
+                }
+            }
+        }
+    }
+}
+
+/*!
+ * Tiles outside the map are not considered.
+ * \param tx Current tile
+ * \param ty Current tile
+ * \param pDx Receives the direction to take along X (-1, 0 or 1)
+ * \param pDy Receives the direction to take along Y (-1, 0 or 1)
+ * \return False if no neighbour is less dangerous than the current tile
+ */
+bool ThreatMap::fleeDirection(int tx, int ty, int *pDx, int *pDy) const {
+    int lowest = danger(tx, ty);
+    bool found = false;
+    for (int dy = -1; dy <= 1; dy++) {
+        for (int dx = -1; dx <= 1; dx++) {
+            int x = tx + dx;
+            int y = ty + dy;
+            if ((dx == 0 && dy == 0) || x < 0 || x >= width_ || y < 0 || y >= height_) {
+                continue;
+            }
+            int d = danger(x, y);
+            if (d < lowest) {
+                lowest = d;
+                *pDx = dx;
+                *pDy = dy;
+                found = true;
+            }
+        }
+    }
+    return found;
+}
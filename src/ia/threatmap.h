@@ -0,0 +1,126 @@
+/************************************************************************
+ *                                                                      *
+ *  FreeSynd - a remake of the classic Bullfrog game "Syndicate".       *
+ *                                                                      *
+ *   Copyright (C) 2016  Benoit Blancard <benblan@users.sourceforge.net>*
+ *                                                                      *
+ *    This program is free software;  you can redistribute it and / or  *
+ *  modify it  under the  terms of the  GNU General  Public License as  *
+ *  published by the Free Software Foundation; either version 2 of the  *
+ *  License, or (at your option) any later version.                     *
+ *                                                                      *
+ *    This program is  distributed in the hope that it will be useful,  *
+ *  but WITHOUT  ANY WARRANTY;  without even  the implied  warranty of  *
+ *  MERCHANTABILITY  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU  *
+ *  General Public License for more details.                            *
+ *                                                                      *
+ *    You can view the GNU  General Public License, online, at the GNU  *
+ *  project's  web  site;  see <http://www.gnu.org/licenses/gpl.html>.  *
+ *  The full text of the license is also included in the file COPYING.  *
+ *                                                                      *
+ ************************************************************************/
+
+#ifndef IA_THREATMAP_H_
+#define IA_THREATMAP_H_
+
+#include <vector>
+
+#include "common.h"
+#include "utils/timer.h"
+
+class PedInstance;
+class WorldPoint;
+
+/*!
+ * A coarse map of danger with one value per tile (height is ignored).
+ * Each armed ped adds a footprint around him which is moved only when he
+ * changes tile, and shots add noise that fades over time. So behaviours
+ * know if there's danger around a ped by reading a single tile instead of
+ * scanning all armed peds, and can tell where danger is lower.
+ */
+class ThreatMap {
+public:
+    //! Distance at which an armed ped is seen as a threat
+    static const int kArmedPedRange = 1500;
+    //! Distance at which a shot is heard
+    static const int kShotRange;
+    //! Danger at the tile of an armed ped
+    static const int kArmedPedLevel;
+    //! Danger at the origin of a shot
+    static const int kShotLevel;
+    //! Noise is halved with this period in ms
+    static const int kDecayPeriod;
+
+    ThreatMap();
+
+    //! Clears the map and sets its size in tiles
+    void init(int width, int height);
+    //! Adds the footprint of an armed ped
+    void addArmedPed(PedInstance *pPed);
+    //! Removes the footprint of a ped that is no longer armed
+    void removeArmedPed(PedInstance *pPed);
+    //! Adds noise around the origin of a shot
+    void addShot(const WorldPoint &originW);
+    //! Follows armed peds and lowers noise
+    void update(int elapsed);
+
+    int width() const { return width_; }
+    int height() const { return height_; }
+    //! Returns the danger at the given tile : 0 if there's none
+    int danger(int tx, int ty) const {
+        if (tx < 0 || tx >= width_ || ty < 0 || ty >= height_) {
+            return 0;
+        }
+        int i = ty * width_ + tx;
+        return armed_[i] + noise_[i];
+    }
+    //! Returns true if an armed ped may be in range of the given tile
+    bool hasArmedPedInRange(int tx, int ty) const {
+        return tx >= 0 && tx < width_ && ty >= 0 && ty < height_ &&
+            armed_[ty * width_ + tx] != 0;
+    }
+    //! Returns true if there's danger at the given tile
+    bool isDangerous(int tx, int ty) const { return danger(tx, ty) != 0; }
+    //! Finds the neighbour tile with the lowest danger
+    bool fleeDirection(int tx, int ty, int *pDx, int *pDy) const;
+
+protected:
+    /*!
+     * An armed ped and the tile where his footprint is.
+     */
+    struct Source {
+        PedInstance *pPed;
+        int tx;
+        int ty;
+    };
+
+    //! Adds or removes the footprint of an armed ped
+    void stampArmedPed(int tx, int ty, bool add);
+    //! Computes danger around a tile for the given range and level
+    static int buildStamp(int range, int level, std::vector<uint8> *pStamp);
+
+protected:
+    /*! Map size in tiles.*/
+    int width_;
+    int height_;
+    /*! Sum of footprints of armed peds for each tile.*/
+    std::vector<uint16> armed_;
+    /*! Noise of shots for each tile.*/
+    std::vector<uint8> noise_;
+    /*! Number of tiles with noise, to skip decay when there's none.*/
+    int nbNoisyTiles_;
+    /*! Danger around an armed ped, centered on his tile.*/
+    std::vector<uint8> armedStamp_;
+    /*! Number of tiles of the footprint on each side of the center.*/
+    int armedRadius_;
+    /*! Noise around a shot, centered on its tile.*/
+    std::vector<uint8> shotStamp_;
+    /*! Number of tiles of the noise on each side of the center.*/
+    int shotRadius_;
+    /*! Armed peds and the position of their footprint.*/
+    std::vector<Source> sources_;
+    /*! Period for lowering noise.*/
+    fs_utils::Timer decayTimer_;
+};
+
+#endif  // IA_THREATMAP_H_
@@ -110,8 +110,11 @@ typedef struct Key {
 #define isLetterD(codePoint) codePoint == 0x0064 || codePoint == 0x0044 || codePoint == 0x0004
 #define isLetterG(codePoint) codePoint == 0x0067 || codePoint == 0x0047
 #define isLetterH(codePoint) codePoint == 0x0068 || codePoint == 0x0048
+#define isLetterO(codePoint) codePoint == 0x006F || codePoint == 0x004F || codePoint == 0x000F
 #define isLetterQ(codePoint) codePoint == 0x0071 || codePoint == 0x0051
 #define isLetterP(codePoint) codePoint == 0x0070 || codePoint == 0x0050
+#define isLetterR(codePoint) codePoint == 0x0072 || codePoint == 0x0052 || codePoint == 0x0012
+#define isLetterT(codePoint) codePoint == 0x0074 || codePoint == 0x0054 || codePoint == 0x0014
 
 #define K_PLUS    0x002B
 #define K_MINUS    0x002D
@@ -36,12 +36,13 @@
 Map::Map(TileManager * tileManager, uint16 anId) : tile_manager_(tileManager)
 {
     id_ = anId;
-    a_tiles_ = NULL;
+    layerSize_ = 0;
+    a_tileIds_ = NULL;
 }
 
 Map::~Map()
 {
-    delete[] a_tiles_;
+    delete[] a_tileIds_;
 }
 
 bool Map::loadMap(uint8 * mapData)
@@ -54,30 +55,22 @@ bool Map::loadMap(uint8 * mapData)
     LOG(Log::k_FLG_GFX, "Map", "loadMap",
         ("Map size in tiles: max_x = %d, max_y = %d, max_z = %d.", max_x_, max_y_, max_z_));
 
-    uint32 *lookup = new uint32[max_x_ * max_y_];
+    layerSize_ = max_x_ * max_y_;
     // NOTE : increased map height by 1 to enable range check on higher tiles
-    a_tiles_ = new Tile*[max_x_ * max_y_ * (max_z_ + 1)];
-
-    for (int i = 0; i < max_x_ * max_y_; i++)
-        lookup[i] = READ_LE_UINT32(mapData + 12 + i * 4);
-    for (int h = 0, z_real = max_z_ + 1; h < max_y_; h++)
-        for (int w = 0; w < max_x_; w++) {
-            int idx = h * max_x_ + w;
-
-            for (int z = 0; z < max_z_; z++) {
-                uint8 tileNum = *(mapData + 12 + lookup[idx] + z);
-                a_tiles_[idx * z_real + z] = tile_manager_->getTile(tileNum);
-
-            }
+    // the top layer stays filled with tile 0
+    a_tileIds_ = new uint8[layerSize_ * (max_z_ + 1)];
+    memset(a_tileIds_, 0, layerSize_ * (max_z_ + 1));
+
+    // in the file, each column of tiles is stored at an offset
+    // given by the lookup table
+    for (int idx = 0; idx < layerSize_; idx++) {
+        const uint8 *column = mapData + 12 + READ_LE_UINT32(mapData + 12 + idx * 4);
+        for (int z = 0; z < max_z_; z++) {
+            a_tileIds_[idx + z * layerSize_] = column[z];
         }
-    delete[] lookup;
+    }
 
     max_z_++;
-    for (int h = 0, z = max_z_ - 1; h < max_y_; h++) {
-        for (int w = 0; w < max_x_; w++) {
-            a_tiles_[(h * max_x_ + w) * max_z_ + z] = tile_manager_->getTile(0);
-        }
-    }
 
     map_width_ = (max_x_ + max_y_) * (TILE_WIDTH / 2);
     map_height_ = (max_x_ + max_y_ + max_z_) * TILE_HEIGHT / 3;
@@ -227,7 +220,7 @@ Tile * Map::getTileAt(int x, int y, int z)
         return tile_manager_->getTile(0);
     }
 
-    return a_tiles_[(y * max_x_ + x) * max_z_ + z];
+    return tile_manager_->getTile(a_tileIds_[cellIndex(x, y, z)]);
 }
 
 int Map::tileAt(int x, int y, int z)
@@ -239,7 +232,16 @@ int Map::tileAt(int x, int y, int z)
     if (z < 0 || z >= max_z_)
         return 0;
 
-    return a_tiles_[(y * max_x_ + x) * max_z_ + z]->id();
+    return a_tileIds_[cellIndex(x, y, z)];
+}
+
+/*!
+ * Same as getTileAt(x, y, z)->getWalkData() but without
+ * reading the tile.
+ */
+uint8 Map::walkDataAt(int x, int y, int z)
+{
+    return tile_manager_->walkData((uint8) tileAt(x, y, z));
 }
 
 void Map::patchMap(int x, int y, int z, uint8 tileNum)
@@ -247,7 +249,27 @@ void Map::patchMap(int x, int y, int z, uint8 tileNum)
     assert((x >= 0 && x < max_x_)
         && (y >= 0 && y < max_y_)
         && (z >= 0 && z < max_z_));
-    a_tiles_[(y * max_x_ + x) * max_z_ + z] = tile_manager_->getTile(tileNum);
+    a_tileIds_[cellIndex(x, y, z)] = tileNum;
+    drawList_.clear();
+    roadGraph_.clear();
+}
+
+size_t Map::memorySize() {
+    return sizeof(Map) + cellsMemory() + drawList_.memorySize() + roadGraph_.memorySize();
+}
+
+const TileDrawList & Map::drawList() {
+    if (!drawList_.isBuilt()) {
+        drawList_.build(this);
+    }
+    return drawList_;
+}
+
+RoadGraph & Map::roadGraph() {
+    if (!roadGraph_.isBuilt()) {
+        roadGraph_.build(this);
+    }
+    return roadGraph_;
 }
 
 
@@ -303,6 +325,220 @@ bool Map::isTileWalkableByCar(int x, int y, int z)
     return  pTile->isRoad();
 }
 
+/*!
+ * Returns the lanes of a road tile as a direction for each of the 4 moves
+ * a vehicle can do from it : 0xF000 to x - 1, 0x00F0 to x + 1, 0x0F00 to
+ * y - 1 and 0x000F to y + 1. A move is allowed when its nibble has the
+ * expected direction.
+ * \param x X coordinate
+ * \param y Y coordinate
+ * \param z Z coordinate
+ * \return 0xFFFF if every move is allowed, 0 if none.
+ */
+uint16 Map::roadLanes(int x, int y, int z) {
+    uint16 dir = 0x0;
+    int near_tile;
+
+    switch(tileAt(x, y, z)){
+        case 80:
+            if(tileAt(x + 1, y, z) == 80)
+                dir = (0)|(0xFFF0);
+            if(tileAt(x - 1, y, z) == 80)
+                dir = (4<<8)|(0xF0FF);
+            break;
+        case 81:
+            if(tileAt(x, y - 1, z) == 81)
+                dir = (2<<4)|(0xFF0F);
+            if(tileAt(x, y + 1, z) == 81)
+                dir = (6<<12)|(0x0FFF);
+            break;
+        case 106:
+            dir = (0)|(2<<4)|(6<<12)|(0x0F00);
+
+            if(tileAt(x + 1, y - 1, z) != 118)
+                dir |= 0x0FF0;
+            if(tileAt(x + 1, y + 1, z) != 118)
+                dir |= 0xFF00;
+            near_tile = tileAt(x + 1, y, z);
+            if (near_tile == 108 || near_tile == 109)
+                dir = (dir & 0x0FFF) | 0x6000;
+
+            break;
+        case 107:
+            dir = (2<<4)|(4<<8)|(6<<12)|(0x000F);
+
+            if(tileAt(x - 1, y - 1, z) != 118)
+                dir |= 0x00FF;
+            if(tileAt(x - 1, y + 1, z) != 118)
+                dir |= 0xF00F;
+            near_tile = tileAt(x - 1, y, z);
+            if (near_tile == 108 || near_tile == 109)
+                dir = (dir & 0xFF0F) | 0x0020;
+
+            break;
+        case 108:
+            dir = (0)|(2<<4)|(4<<8)|(0xF000);
+
+            if(tileAt(x + 1, y - 1, z) != 118)
+                dir |= 0xF00F;
+            if(tileAt(x - 1, y - 1, z) != 118)
+                dir |= 0xFF00;
+            near_tile = tileAt(x, y - 1, z);
+            if (near_tile == 106 || near_tile == 107)
+                dir = dir & 0xFFF0;
+
+            break;
+        case 109:
+            dir = (0)|(4<<8)|(6<<12)|(0x00F0);
+
+            if(tileAt(x + 1, y + 1, z) != 118)
+                dir |= 0x00FF;
+            if(tileAt(x - 1, y + 1, z) != 118)
+                dir |= 0x0FF0;
+            near_tile = tileAt(x, y + 1, z);
+            if (near_tile == 106 || near_tile == 107)
+                dir = (dir & 0xF0FF) | 0x0400;
+
+            break;
+        case 110:
+            dir = (0) | (2<<4)|(0xFF00);
+            break;
+        case 111:
+            dir = (0) | (6<<12)|(0x0FF0);
+            break;
+        case 112:
+            dir = (2<<4)|(4<<8)|(0xF00F);
+            break;
+        case 113:
+            dir = (4<<8)|(6<<12)|(0x00FF);
+            break;
+        /*case 119:
+            // TODO: Greenland map needs fixing
+            dir = 0xFFFF;
+            near_tile = tileAt(x, y + 1, z);
+            if (near_tile == 107 || near_tile == 225 || near_tile == 226)
+                dir = (dir & 0xF0FF) | 0x0400;
+            near_tile = tileAt(x, y + 1, z);
+            if (near_tile == 106 || near_tile == 225 || near_tile == 226)
+               dir &= 0xFFF0;
+            near_tile = tileAt(x + 1, y, z);
+            if (near_tile == 109 || near_tile == 225 || near_tile == 226)
+                dir = (dir & 0xFF0F) | 0x0020;
+            near_tile = tileAt(x - 1, y, z);
+            if (near_tile == 108 || near_tile == 225 || near_tile == 226)
+                dir = (dir & 0x0FFF) | 0x6000;
+            if (dir ==0xFFFF)
+                dir = 0x0;
+            break;*/
+        case 120:
+            dir = (0)|(2<<4)|(0xFF00);
+            break;
+        case 121:
+            dir = (0)|(6<<12)|(0x0FF0);
+            break;
+        case 122:
+            dir = (4<<8)|(6<<12)|(0x00FF);
+            break;
+        case 123:
+            dir = (2<<4)|(4<<8)|(0xF00F);
+            break;
+        case 225:/*
+            if(getTileAt(x + 1, y, z)->type() == Tile::kRoadPedCross)
+                dir = (0)|(0xFFF0);
+            else if(getTileAt(x - 1, y, z)->type() == Tile::kRoadPedCross)
+                dir = (4<<8)|(0xF0FF);
+            else {*/
+                dir = 0xFFFF;
+                near_tile = tileAt(x, y + 1, z);
+                if (/*near_tile == 119 || */near_tile == 106
+                    || near_tile == 107 || near_tile == 80 || near_tile == 225)
+                    dir = (dir & 0xF0FF) | 0x0400;
+                near_tile = tileAt(x, y - 1, z);
+                if (/*near_tile == 119 || */near_tile == 106
+                    || near_tile == 107 || near_tile == 80 || near_tile == 225)
+                    dir &= 0xFFF0;
+                near_tile = tileAt(x + 1, y, z);
+                if (/*near_tile == 119 || */near_tile == 108 || near_tile == 81)
+                    dir = (dir & 0xFF0F) | 0x0020;
+                near_tile = tileAt(x - 1, y, z);
+                if (/*near_tile == 119 || */near_tile == 109 || near_tile == 81)
+                    dir = (dir & 0x0FFF) | 0x6000;
+                if (dir == 0xFFFF)
+                    dir = 0x0;
+            //}
+            break;
+        case 226:/*
+            if(getTileAt(x, y - 1, z)->type() == Tile::kRoadPedCross)
+                dir = (2<<4)|(0xFF0F);
+            else if(getTileAt(x, y + 1, z)->type() == Tile::kRoadPedCross)
+                dir = (6<<12)|(0x0FFF);
+            else {*/
+                dir = 0xFFFF;
+                near_tile = tileAt(x, y + 1, z);
+                if (/*near_tile == 119 || */near_tile == 106 || near_tile == 80)
+                    dir = (dir & 0xF0FF) | 0x0400;
+                near_tile = tileAt(x, y - 1, z);
+                if (/*near_tile == 119 || */near_tile == 107 || near_tile == 80)
+                    dir &= 0xFFF0;
+                near_tile = tileAt(x + 1, y, z);
+                if (/*near_tile == 119 || */near_tile == 108 || near_tile == 109
+                    || near_tile == 81 || near_tile == 226)
+                    dir = (dir & 0xFF0F) | 0x0020;
+                near_tile = tileAt(x - 1, y, z);
+                if (/*near_tile == 119 || */near_tile == 108 || near_tile == 109
+                    || near_tile == 81 || near_tile == 226)
+                    dir = (dir & 0x0FFF) | 0x6000;
+                if (dir == 0xFFFF)
+                    dir = 0;
+            //}
+            break;
+        default:
+            dir = 0xFFFF;
+    }
+
+    return dir;
+}
+
+/*!
+ * Returns true if a vehicle can drive from a road tile to the next one :
+ * the lanes of both tiles must go the same way.
+ * \param x X coordinate of start tile
+ * \param y Y coordinate of start tile
+ * \param toX X coordinate of next tile
+ * \param toY Y coordinate of next tile
+ * \param z Z coordinate of both tiles
+ */
+bool Map::isRoadLinked(int x, int y, int toX, int toY, int z) {
+    if(!(isTileWalkableByCar(toX, toY, z)))
+        return false;
+
+    uint16 dirStart = roadLanes(x, y, z);
+    uint16 dirEnd = roadLanes(toX, toY, z);
+    if (dirStart == 0x0 || dirEnd == 0x0)
+        return false;
+    if (dirStart == 0xFFFF || dirEnd == 0xFFFF)
+        return true;
+
+    if (((dirStart & 0xF000) != 0xF000)
+        || ((dirEnd & 0xF000) != 0xF000))
+        if ((dirStart & 0xF000) == (dirEnd & 0xF000))
+                return true;
+    if (((dirStart & 0x0F00) != 0x0F00)
+        || ((dirEnd & 0x0F00) != 0x0F00))
+        if ((dirStart & 0x0F00) == (dirEnd & 0x0F00))
+                return true;
+    if (((dirStart & 0x00F0) != 0x00F0)
+        || ((dirEnd & 0x00F0) != 0x00F0))
+        if ((dirStart & 0x00F0) == (dirEnd & 0x00F0))
+                return true;
+    if (((dirStart & 0x000F) != 0x000F)
+        || ((dirEnd & 0x000F) != 0x000F))
+        if ((dirStart & 0x000F) == (dirEnd & 0x000F))
+                return true;
+
+    return false;
+}
+
 const uint8 MiniMap::kOverlayNone = 0;
 const uint8 MiniMap::kOverlayOurAgent = 1;
 const uint8 MiniMap::kOverlayEnemyAgent = 2;
@@ -27,6 +27,8 @@
 
 #include "common.h"
 #include "model/position.h"
+#include "gfx/tiledrawlist.h"
+#include "roadgraph.h"
 
 class Tile;
 class TileManager;
@@ -67,18 +69,49 @@ public:
     int maxZAt(int x, int y);
     Tile * getTileAt(int x, int y, int z);
     int tileAt(int x, int y, int z);
+    //! Returns the walk data of the tile at the given position
+    uint8 walkDataAt(int x, int y, int z);
+    //! Returns the tile id of every cell, see cellIndex()
+    const uint8 * tileIds() { return a_tileIds_; }
+    //! Returns the index of a cell in tileIds()
+    int cellIndex(int x, int y, int z) { return x + y * max_x_ + z * layerSize_; }
+    //! Returns the number of bytes used to store the cells
+    int cellsMemory() { return layerSize_ * max_z_; }
+    //! Returns the memory used by the map and its lists in bytes
+    size_t memorySize();
+    //! Returns the tiles used by this map
+    TileManager * tileManager() { return tile_manager_; }
     void patchMap(int x, int y, int z, uint8 tileNum);
+    //! Returns the opaque tiles in drawing order
+    const TileDrawList & drawList();
     //! Return true if tile at given position is traversable by car
     bool isTileWalkableByCar(int x, int y, int z);
+    //! Returns the directions of the lanes of a road tile
+    uint16 roadLanes(int x, int y, int z);
+    //! Return true if a car can drive from a tile to the next one
+    bool isRoadLinked(int x, int y, int toX, int toY, int z);
+    //! Returns the graph of the road lanes
+    RoadGraph & roadGraph();
 
 protected:
     /*!  Every map has a unique ID which is used to identify the
     name of the file containing map data.*/
     uint16 id_;
     int max_x_, max_y_, max_z_;
-    Tile **a_tiles_;
+    /*! Number of cells in a layer of the map.*/
+    int layerSize_;
+    /*!
+     * Tile id of each cell. Cells are stored layer by layer and row by row
+     * like the walkable surfaces of a mission, so both can be walked
+     * with the same index.
+     */
+    uint8 *a_tileIds_;
     TileManager *tile_manager_;
     int map_width_, map_height_;
+    /*! Built on first use, after the map has been patched.*/
+    TileDrawList drawList_;
+    /*! Built on first use, after the map has been patched.*/
+    RoadGraph roadGraph_;
 };
 
 /*!
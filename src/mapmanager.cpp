@@ -24,18 +24,32 @@
 
 #include <stdio.h>
 #include <assert.h>
+#include <string.h>
+
+#include "SDL.h"
+
 #include "mapmanager.h"
 #include "utils/file.h"
+#include "utils/assetcache.h"
 #include "utils/log.h"
+#include "utils/profiler.h"
 
 MapManager::MapManager()
 {
+    budget_ = 0;
+    useCounter_ = 0;
+    pPrefetchThread_ = NULL;
+    prefetchMapNum_ = 0;
+    pPrefetchMap_ = NULL;
+    resetStats();
 }
 
 MapManager::~MapManager()
 {
-    for (unsigned int i = 0; i < maps_.size(); i++)
-        delete maps_[i];
+    finishPrefetch();
+    for (std::map<int, Entry>::iterator it = maps_.begin(); it != maps_.end(); it++) {
+        delete it->second.pMap;
+    }
 }
 
 /*!
@@ -47,81 +61,242 @@ bool MapManager::initialize()
     return tileManager_.loadTiles();
 }
 
+void MapManager::resetStats() {
+    memset(&stats_, 0, sizeof(Stats));
+}
+
 /*!
  * Loads the given map.
  * First look in the map cache if the map already exists.
  * If the map exists, returns it. Otherwise, creates a new one.
+ * If a map is being loaded in the background, waits for it first.
  * \param i_mapNum The map id.
  * \return NULL if map could not be loaded
  */
 Map * MapManager::loadMap(uint16 i_mapNum)
 {
-    char tmp[100];
-    int size;
-
     LOG(Log::k_FLG_IO, "MapManager", "loadMap()", ("loading map %i", i_mapNum));
+    finishPrefetch();
+
     // First look in cache
-    if (maps_.find(i_mapNum) != maps_.end()) {
+    std::map<int, Entry>::iterator it = maps_.find(i_mapNum);
+    if (it != maps_.end()) {
         LOG(Log::k_FLG_IO, "MapManager", "loadMap()", ("Map is already in cache"));
-        return maps_[i_mapNum];
+        it->second.lastUse = ++useCounter_;
+        stats_.hits++;
+        return it->second.pMap;
     }
-    
+
     // Not found so construct new one
     LOG(Log::k_FLG_IO, "MapManager", "loadMap()", ("Load new map"));
+    Map *pMap = createMap(i_mapNum);
+    if (pMap == NULL) {
+        return NULL;
+    }
+    stats_.misses++;
+    addMap(pMap);
+
+    return pMap;
+}
+
+/*!
+ * Returns the map if found in cache.
+ * The map must have been loaded first.
+ * \param i_mapNum Map id.
+ * \return NULL if map is not found
+ */
+Map *MapManager::map(int i_mapNum)
+{
+    //make sure the map is loaded
+    std::map<int, Entry>::iterator it = maps_.find(i_mapNum);
+    if (it == maps_.end()) {
+        LOG(Log::k_FLG_IO, "MapManager", "map", ("map %d not in cache", i_mapNum));
+        return NULL;
+    }
+
+    return it->second.pMap;
+}
+
+/*!
+ * Starts a thread that loads the map so that a later call to loadMap()
+ * does not have to read and decode it. Nothing is done if the map is
+ * already in cache. Only one map is loaded at a time.
+ * \param i_mapNum The map id.
+ */
+void MapManager::prefetchMap(uint16 i_mapNum)
+{
+    finishPrefetch();
+    if (maps_.find(i_mapNum) != maps_.end()) {
+        return;
+    }
+
+    prefetchMapNum_ = i_mapNum;
+    pPrefetchMap_ = NULL;
+    pPrefetchThread_ = SDL_CreateThread(prefetchLoop, this);
+    if (pPrefetchThread_ == NULL) {
+        // map will be loaded when needed
+        FSERR(Log::k_FLG_IO, "MapManager", "prefetchMap", ("Unable to create thread : %s\n", SDL_GetError()));
+    }
+}
+
+int MapManager::prefetchLoop(void *pData) {
+    MapManager *pManager = static_cast<MapManager *>(pData);
+    Profiler::setThreadName("map prefetch");
+    // only the map is created here, the cache is updated by the main thread
+    pManager->pPrefetchMap_ = pManager->createMap(pManager->prefetchMapNum_);
+    return 0;
+}
+
+void MapManager::finishPrefetch()
+{
+    if (pPrefetchThread_ == NULL) {
+        return;
+    }
+
+    SDL_WaitThread(pPrefetchThread_, NULL);
+    pPrefetchThread_ = NULL;
+    if (pPrefetchMap_ != NULL) {
+        LOG(Log::k_FLG_IO, "MapManager", "finishPrefetch", ("Map %d loaded in background", prefetchMapNum_));
+        stats_.prefetches++;
+        addMap(pPrefetchMap_);
+        pPrefetchMap_ = NULL;
+    }
+}
+
+/*!
+ * A mission holds its map so that it is not deleted while
+ * the mission is played.
+ */
+void MapManager::holdMap(int i_mapNum)
+{
+    std::map<int, Entry>::iterator it = maps_.find(i_mapNum);
+    if (it != maps_.end()) {
+        it->second.nbHolds++;
+    }
+}
+
+void MapManager::releaseMap(int i_mapNum)
+{
+    std::map<int, Entry>::iterator it = maps_.find(i_mapNum);
+    if (it != maps_.end() && it->second.nbHolds > 0) {
+        it->second.nbHolds--;
+    }
+}
+
+void MapManager::clearCache()
+{
+    finishPrefetch();
+    std::map<int, Entry>::iterator it = maps_.begin();
+    while (it != maps_.end()) {
+        if (it->second.nbHolds == 0) {
+            delete it->second.pMap;
+            maps_.erase(it++);
+        } else {
+            it++;
+        }
+    }
+}
+
+size_t MapManager::residentBytes()
+{
+    size_t size = 0;
+    for (std::map<int, Entry>::iterator it = maps_.begin(); it != maps_.end(); it++) {
+        size += it->second.pMap->memorySize();
+    }
+    return size;
+}
+
+/*!
+ * Reads the map file, decodes it and patches the maps that need it.
+ * Does not use the cache so it can be called by the prefetch thread :
+ * File::loadOriginalData() can be called by several threads and tiles
+ * are only read, they don't change once loaded.
+ * \param i_mapNum The map id.
+ * \return NULL if map could not be loaded
+ */
+Map * MapManager::createMap(uint16 i_mapNum)
+{
+    char tmp[100];
     sprintf(tmp, "map%02d.dat", i_mapNum);
-    uint8 *mapData = File::loadOriginalFile(tmp, size);
-    if (mapData == NULL) {
+    FileData mapData;
+    if (!File::loadOriginalData(tmp, &mapData)) {
         return NULL;
     }
 
-    maps_[i_mapNum] = new Map(&tileManager_, i_mapNum);
-    maps_[i_mapNum]->loadMap(mapData);
+    Map *pMap = new Map(&tileManager_, i_mapNum);
+    pMap->loadMap(mapData.data());
     // patch for "YUKON" map
     if (i_mapNum == 0x27) {
-        maps_[i_mapNum]->patchMap(60, 63, 1, 0x27);
-        maps_[i_mapNum]->patchMap(61, 63, 1, 0x27);
-        maps_[i_mapNum]->patchMap(62, 63, 1, 0x27);
-        maps_[i_mapNum]->patchMap(60, 64, 1, 0x27);
-        maps_[i_mapNum]->patchMap(61, 64, 1, 0x27);
-        maps_[i_mapNum]->patchMap(62, 64, 1, 0x27);
-        maps_[i_mapNum]->patchMap(60, 65, 1, 0x27);
-        maps_[i_mapNum]->patchMap(61, 65, 1, 0x27);
-        maps_[i_mapNum]->patchMap(62, 65, 1, 0x27);
-        maps_[i_mapNum]->patchMap(60, 66, 1, 0x27);
-        maps_[i_mapNum]->patchMap(61, 66, 1, 0x27);
-        maps_[i_mapNum]->patchMap(62, 66, 1, 0x27);
-        maps_[i_mapNum]->patchMap(60, 67, 1, 0x27);
-        maps_[i_mapNum]->patchMap(61, 67, 1, 0x27);
-        maps_[i_mapNum]->patchMap(62, 67, 1, 0x27);
+        pMap->patchMap(60, 63, 1, 0x27);
+        pMap->patchMap(61, 63, 1, 0x27);
+        pMap->patchMap(62, 63, 1, 0x27);
+        pMap->patchMap(60, 64, 1, 0x27);
+        pMap->patchMap(61, 64, 1, 0x27);
+        pMap->patchMap(62, 64, 1, 0x27);
+        pMap->patchMap(60, 65, 1, 0x27);
+        pMap->patchMap(61, 65, 1, 0x27);
+        pMap->patchMap(62, 65, 1, 0x27);
+        pMap->patchMap(60, 66, 1, 0x27);
+        pMap->patchMap(61, 66, 1, 0x27);
+        pMap->patchMap(62, 66, 1, 0x27);
+        pMap->patchMap(60, 67, 1, 0x27);
+        pMap->patchMap(61, 67, 1, 0x27);
+        pMap->patchMap(62, 67, 1, 0x27);
     }
     // patch for "INDONESIA" map
     // TODO: find better way to block access for our agents
     if (i_mapNum == 0x5B) {
-        maps_[i_mapNum]->patchMap(49, 27, 2, 0);
-        maps_[i_mapNum]->patchMap(49, 28, 2, 0);
-        maps_[i_mapNum]->patchMap(49, 29, 2, 0);
+        pMap->patchMap(49, 27, 2, 0);
+        pMap->patchMap(49, 28, 2, 0);
+        pMap->patchMap(49, 29, 2, 0);
     }
 
-    delete[] mapData;
+    return pMap;
+}
 
-    return maps_[i_mapNum];
+void MapManager::addMap(Map *pMap)
+{
+    Entry entry;
+    entry.pMap = pMap;
+    entry.lastUse = ++useCounter_;
+    entry.nbHolds = 0;
+    maps_[pMap->id()] = entry;
+    evictMaps(pMap->id());
 }
 
 /*!
- * Returns the map if found in cache.
- * The map must have been loaded first.
- * \param i_mapNum Map id.
- * \return NULL if map is not found
+ * Deletes the least recently used maps while the cache is over budget.
+ * Maps held by a mission are kept, as well as the given map.
+ * \param keptMapNum Id of the map that has just been added
  */
-Map *MapManager::map(int i_mapNum)
+void MapManager::evictMaps(int keptMapNum)
 {
-    //make sure the map is loaded
-    if (maps_.find(i_mapNum) == maps_.end()) {
-        LOG(Log::k_FLG_IO, "MapManager", "map", ("map %d not in cache", i_mapNum));
-        return NULL;
+    if (budget_ == 0) {
+        return;
     }
 
-    return maps_[i_mapNum];
-}
+    size_t resident = residentBytes();
+    while (resident > budget_) {
+        std::map<int, Entry>::iterator oldest = maps_.end();
+        for (std::map<int, Entry>::iterator it = maps_.begin(); it != maps_.end(); it++) {
+            if (it->first != keptMapNum && it->second.nbHolds == 0 &&
+                (oldest == maps_.end() || it->second.lastUse < oldest->second.lastUse)) {
+                oldest = it;
+            }
+        }
+        if (oldest == maps_.end()) {
+            // every other map is in use
+            break;
+        }
 
+        LOG(Log::k_FLG_IO, "MapManager", "evictMaps", ("Deleting map %d", oldest->first));
+        resident -= oldest->second.pMap->memorySize();
+        delete oldest->second.pMap;
+        maps_.erase(oldest);
+        stats_.evictions++;
+    }
 
+    LOG(Log::k_FLG_IO, "MapManager", "evictMaps", ("%d maps in cache using %d KB, hits %d, misses %d, prefetches %d, evictions %d",
+        (int) maps_.size(), (int) (resident / 1024), stats_.hits, stats_.misses,
+        stats_.prefetches, stats_.evictions));
+}
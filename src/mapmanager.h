@@ -31,24 +31,92 @@
 #include "map.h"
 #include "gfx/tilemanager.h"
 
+struct SDL_Thread;
+
 /*!
  * Map manager class.
+ * Loaded maps are kept in a cache. When the maps use more memory than
+ * the budget, the least recently used ones are deleted, except those
+ * held by a mission. A map can be loaded in the background before it
+ * is needed.
  */
 class MapManager {
 public:
+    //! Counters of the cache
+    struct Stats {
+        //! Number of maps found in cache
+        uint32 hits;
+        //! Number of maps loaded when asked
+        uint32 misses;
+        //! Number of maps loaded in the background
+        uint32 prefetches;
+        //! Number of maps deleted to stay within budget
+        uint32 evictions;
+    };
+
     MapManager();
     ~MapManager();
 
     //! Initialize the manager
     bool initialize();
+    //! Sets the memory the maps should not use more than, 0 for no limit
+    void setMemoryBudget(size_t bytes) { budget_ = bytes; }
+    size_t memoryBudget() { return budget_; }
     //! Load the map with the given id
     Map * loadMap(uint16 i_mapNum);
     //! Look in the cache for the map with the given id
     Map *map(int mapNum);
+    //! Starts loading the map in the background
+    void prefetchMap(uint16 i_mapNum);
+    //! Prevents the map from being deleted until it is released
+    void holdMap(int mapNum);
+    //! Allows the map to be deleted when the cache is full
+    void releaseMap(int mapNum);
+    //! Deletes all maps that are not held
+    void clearCache();
+
+    //! Returns the memory used by the maps in cache in bytes
+    size_t residentBytes();
+    //! Returns the number of maps in cache
+    size_t nbMaps() { return maps_.size(); }
+    const Stats & stats() { return stats_; }
+    void resetStats();
+
+protected:
+    //! A map in the cache
+    struct Entry {
+        Map *pMap;
+        //! Value of the use counter when map was last used
+        uint32 lastUse;
+        //! Number of holders of the map
+        int nbHolds;
+    };
+
+    //! Reads the map file and creates the map
+    Map * createMap(uint16 i_mapNum);
+    //! Waits for the map loaded in the background and adds it to the cache
+    void finishPrefetch();
+    //! Adds the map to the cache
+    void addMap(Map *pMap);
+    //! Deletes maps until the cache fits in the budget
+    void evictMaps(int keptMapNum);
+    //! Entry point of the background loading thread
+    static int prefetchLoop(void *pData);
 
 protected:
-    std::map<int, Map *> maps_;
+    std::map<int, Entry> maps_;
     TileManager tileManager_;
+    /*! Maximum memory used by maps in bytes.*/
+    size_t budget_;
+    /*! Incremented each time a map is used.*/
+    uint32 useCounter_;
+    Stats stats_;
+    /*! Thread loading a map in the background or NULL.*/
+    SDL_Thread *pPrefetchThread_;
+    /*! Id of the map loaded in the background.*/
+    uint16 prefetchMapNum_;
+    /*! Map loaded in the background, set by the thread.*/
+    Map *pPrefetchMap_;
 };
 
 #endif
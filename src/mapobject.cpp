@@ -31,6 +31,7 @@
 #include "model/vehicle.h"
 #include "core/gamesession.h"
 #include "mission.h"
+#include "mapobjectgrid.h"
 
 uint16 SFXObject::sfxIdCnt = 0;
 const int Static::kStaticOrientation1 = 0;
@@ -43,12 +44,17 @@ MapObject::MapObject(uint16 anId, int m, ObjectNature aNature):
     dir_(0),
     time_show_anim_(-1), time_showing_anim_(-1),
     is_frame_drawn_(false),
-    state_(0xFFFFFFFF)
+    state_(0xFFFFFFFF),
+    pGrid_(NULL), gridCell_(-1), gridSeq_(0), gridStamp_(0)
 {
     nature_ = aNature;
     id_ = anId;
 }
 
+void MapObject::moveInGrid() {
+    pGrid_->update(this);
+}
+
 const char* MapObject::natureName() {
     switch (nature_) {
     case kNaturePed:
@@ -75,6 +81,7 @@ void MapObject::setOffX(int n)
         pos_.ox -= 256;
         pos_.tx++;
     }
+    updateGridCell();
 }
 
 void MapObject::setOffY(int n)
@@ -88,6 +95,7 @@ void MapObject::setOffY(int n)
         pos_.oy -= 256;
         pos_.ty++;
     }
+    updateGridCell();
 }
 
 void MapObject::setOffZ(int n)
@@ -611,6 +619,10 @@ bool ShootableMovableMapObject::addOffsetToPosition(int nOffX, int nOffY)
         changed = true;
     }
 
+    if (changed) {
+        updateGridCell();
+    }
+
     return changed;
 }
 
@@ -37,6 +37,7 @@
 
 class Mission;
 class WeaponInstance;
+class MapObjectGrid;
 
 /*!
  * Map object class.
@@ -96,10 +97,12 @@ public:
         pos_.ox = off_x;
         pos_.oy = off_y;
         pos_.oz = off_z;
+        updateGridCell();
     }
 
     void setPosition(const TilePoint &pos) {
         pos_.initFrom(pos);
+        updateGridCell();
     }
 
     /*!
@@ -115,8 +118,8 @@ public:
     int tileY() const { return pos_.ty; }
     int tileZ() const { return pos_.tz; }
 
-    void setTileX(int x) { pos_.tx = x; }
-    void setTileY(int y) { pos_.ty = y; }
+    void setTileX(int x) { pos_.tx = x; updateGridCell(); }
+    void setTileY(int y) { pos_.ty = y; updateGridCell(); }
     void setTileZ(int z) { pos_.tz = z; }
 
     int offX() const { return pos_.ox; }
@@ -233,6 +236,7 @@ public:
     }
 
     void setFrame(int frame) { frame_ = frame;}
+    int frame() const { return frame_; }
     void setFrameFromObject(MapObject *m) {
         frame_ = m->frame_;
     }
@@ -269,7 +273,23 @@ public:
 
     void offzOnStairs(uint8 twd);
 
+    /*!
+     * Must be called when object's tile has changed so the grid of
+     * mission objects stays up to date.
+     */
+    void updateGridCell() {
+        if (pGrid_ != NULL) {
+            moveInGrid();
+        }
+    }
+    //! Returns the order of insertion in the grid of mission objects
+    uint32 gridOrder() const { return gridSeq_; }
+
 protected:
+    friend class MapObjectGrid;
+
+    void moveInGrid();
+
     //! the nature of this object
     ObjectNature nature_;
     //! Id of the object. Id is unique within a nature
@@ -305,6 +325,14 @@ protected:
      */
     bool is_frame_drawn_;
     uint32 state_;
+    //! Grid of mission objects the object is in, NULL if none
+    MapObjectGrid *pGrid_;
+    //! Cell of the grid where the object is
+    int gridCell_;
+    //! Order of insertion in the grid
+    uint32 gridSeq_;
+    //! Last grid query that has returned the object
+    uint32 gridStamp_;
 
     void addOffs(int &x, int &y);
 };
@@ -467,8 +495,9 @@ public:
     }
     /*!
      * Clear path to destination and sets speed to 0.
+     * Virtual as peds also drop their pending path request.
      */
-    void clearDestination() {
+    virtual void clearDestination() {
         dest_path_.clear();
         speed_ = 0;
     }
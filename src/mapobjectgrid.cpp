@@ -0,0 +1,222 @@
+/************************************************************************
+ *                                                                      *
+ *  FreeSynd - a remake of the classic Bullfrog game "Syndicate".       *
+ *                                                                      *
+ *   Copyright (C) 2005  Stuart Binge  <skbinge@gmail.com>              *
+ *   Copyright (C) 2005  Joost Peters  <joostp@users.sourceforge.net>   *
+ *   Copyright (C) 2006  Trent Waddington <qg@biodome.org>              *
+ *   Copyright (C) 2006  Tarjei Knapstad <tarjei.knapstad@gmail.com>    *
+ *   Copyright (C) 2010  Benoit Blancard <benblan@users.sourceforge.net>*
+ *   Copyright (C) 2010  Bohdan Stelmakh <chamel@users.sourceforge.net> *
+ *                                                                      *
+ *    This program is free software;  you can redistribute it and / or  *
+ *  modify it  under the  terms of the  GNU General  Public License as  *
+ *  published by the Free Software Foundation; either version 2 of the  *
+ *  License, or (at your option) any later version.                     *
+ *                                                                      *
+ *    This program is  distributed in the hope that it will be useful,  *
+ *  but WITHOUT  ANY WARRANTY;  without even  the implied  warranty of  *
+ *  MERCHANTABILITY  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU  *
+ *  General Public License for more details.                            *
+ *                                                                      *
+ *    You can view the GNU  General Public License, online, at the GNU  *
+ *  project's  web  site;  see <http://www.gnu.org/licenses/gpl.html>.  *
+ *  The full text of the license is also included in the file COPYING.  *
+ *                                                                      *
+ ************************************************************************/
+
+#include <algorithm>
+
+#include "mapobjectgrid.h"
+#include "mapobject.h"
+
+const int MapObjectGrid::kCellTiles = 4;
+const int MapObjectGrid::kCellShift = 2;
+const int MapObjectGrid::kGridSize = 64;
+
+//! Largest half size of an object, in world coordinates
+static const int kMaxObjectSize = 384;
+
+MapObjectGrid::MapObjectGrid() {
+    cells_ = new std::vector<MapObject *>[kGridSize * kGridSize];
+    nextSeq_ = 0;
+    queryStamp_ = 0;
+    nbObjects_ = 0;
+}
+
+MapObjectGrid::~MapObjectGrid() {
+    clear();
+    delete [] cells_;
+}
+
+void MapObjectGrid::add(MapObject *pObject) {
+    if (pObject->pGrid_ != NULL) {
+        // object is already in a grid
+        pObject->pGrid_->remove(pObject);
+    }
+
+    pObject->pGrid_ = this;
+    pObject->gridSeq_ = nextSeq_++;
+    pObject->gridStamp_ = queryStamp_;
+    pObject->gridCell_ = cellOfTile(pObject->tileX(), pObject->tileY());
+    cells_[pObject->gridCell_].push_back(pObject);
+    nbObjects_++;
+}
+
+void MapObjectGrid::remove(MapObject *pObject) {
+    if (pObject->pGrid_ != this) {
+        return;
+    }
+
+    std::vector<MapObject *> &cell = cells_[pObject->gridCell_];
+    std::vector<MapObject *>::iterator it = std::find(cell.begin(), cell.end(), pObject);
+    if (it != cell.end()) {
+        // order in a cell does not matter
+        *it = cell.back();
+        cell.pop_back();
+        nbObjects_--;
+    }
+    pObject->pGrid_ = NULL;
+    pObject->gridCell_ = -1;
+}
+
+/*!
+ * Called when an object position has changed.
+ */
+void MapObjectGrid::update(MapObject *pObject) {
+    int cellIndx = cellOfTile(pObject->tileX(), pObject->tileY());
+    if (cellIndx == pObject->gridCell_) {
+        return;
+    }
+
+    std::vector<MapObject *> &cell = cells_[pObject->gridCell_];
+    std::vector<MapObject *>::iterator it = std::find(cell.begin(), cell.end(), pObject);
+    if (it != cell.end()) {
+        *it = cell.back();
+        cell.pop_back();
+    }
+    pObject->gridCell_ = cellIndx;
+    cells_[cellIndx].push_back(pObject);
+}
+
+void MapObjectGrid::clear() {
+    for (int i = 0; i < kGridSize * kGridSize; i++) {
+        for (size_t j = 0; j < cells_[i].size(); j++) {
+            cells_[i][j]->pGrid_ = NULL;
+            cells_[i][j]->gridCell_ = -1;
+        }
+        cells_[i].clear();
+    }
+    nbObjects_ = 0;
+    nextSeq_ = 0;
+}
+
+/*!
+ * Objects are not filtered on distance : caller must still check them.
+ * \param centerW Center of the searched area
+ * \param range Distance from the center
+ * \param natures Mask of MapObject::ObjectNature
+ * \param result Objects found, sorted by order of insertion
+ */
+void MapObjectGrid::findInRange(const WorldPoint &centerW, int range, int natures,
+    std::vector<MapObject *> &result)
+{
+    result.clear();
+    queryStamp_++;
+
+    int margin = range + kMaxObjectSize;
+    int minX = ((centerW.x - margin) / 256) >> kCellShift;
+    int maxX = ((centerW.x + margin) / 256) >> kCellShift;
+    int minY = ((centerW.y - margin) / 256) >> kCellShift;
+    int maxY = ((centerW.y + margin) / 256) >> kCellShift;
+    // cells are wrapped, so no need to look at more than the whole grid
+    if (maxX - minX >= kGridSize) {
+        maxX = minX + kGridSize - 1;
+    }
+    if (maxY - minY >= kGridSize) {
+        maxY = minY + kGridSize - 1;
+    }
+
+    for (int y = minY; y <= maxY; y++) {
+        for (int x = minX; x <= maxX; x++) {
+            collectCell((x & (kGridSize - 1)) + (y & (kGridSize - 1)) * kGridSize,
+                natures, result);
+        }
+    }
+
+    std::sort(result.begin(), result.end(), isAddedBefore);
+}
+
+/*!
+ * The line is followed by steps of half a cell and, at each step, the cell
+ * and its neighbours are searched : it covers all objects whose center
+ * is closer than a cell to the line.
+ * \param startW Line start
+ * \param endW Line end
+ * \param natures Mask of MapObject::ObjectNature
+ * \param result Objects found, sorted by order of insertion
+ */
+void MapObjectGrid::findNearLine(const WorldPoint &startW, const WorldPoint &endW, int natures,
+    std::vector<MapObject *> &result)
+{
+    result.clear();
+    queryStamp_++;
+
+    const int step = (kCellTiles * 256) / 2;
+    int dx = endW.x - startW.x;
+    int dy = endW.y - startW.y;
+    int length = abs(dx) > abs(dy) ? abs(dx) : abs(dy);
+    int nbSteps = length / step + 1;
+
+    int lastCx = -1, lastCy = -1;
+    for (int i = 0; i <= nbSteps; i++) {
+        int x = startW.x + (int)((int64)dx * i / nbSteps);
+        int y = startW.y + (int)((int64)dy * i / nbSteps);
+        int cx = (x / 256) >> kCellShift;
+        int cy = (y / 256) >> kCellShift;
+        if (cx != lastCx || cy != lastCy) {
+            collectCellsAround(cx, cy, natures, result);
+            lastCx = cx;
+            lastCy = cy;
+        }
+    }
+
+    std::sort(result.begin(), result.end(), isAddedBefore);
+}
+
+/*!
+ * \param posT Tile
+ * \param natures Mask of MapObject::ObjectNature
+ * \param result Objects found, sorted by order of insertion. Caller must
+ * check objects are on the tile.
+ */
+void MapObjectGrid::findAtTile(const TilePoint &posT, int natures, std::vector<MapObject *> &result) {
+    result.clear();
+    queryStamp_++;
+    collectCell(cellOfTile(posT.tx, posT.ty), natures, result);
+    std::sort(result.begin(), result.end(), isAddedBefore);
+}
+
+void MapObjectGrid::collectCell(int cell, int natures, std::vector<MapObject *> &result) {
+    std::vector<MapObject *> &objects = cells_[cell];
+    for (size_t i = 0; i < objects.size(); i++) {
+        MapObject *pObject = objects[i];
+        if ((pObject->nature() & natures) && pObject->gridStamp_ != queryStamp_) {
+            pObject->gridStamp_ = queryStamp_;
+            result.push_back(pObject);
+        }
+    }
+}
+
+void MapObjectGrid::collectCellsAround(int cx, int cy, int natures, std::vector<MapObject *> &result) {
+    for (int y = cy - 1; y <= cy + 1; y++) {
+        for (int x = cx - 1; x <= cx + 1; x++) {
+            collectCell((x & (kGridSize - 1)) + (y & (kGridSize - 1)) * kGridSize,
+                natures, result);
+        }
+    }
+}
+
+bool MapObjectGrid::isAddedBefore(const MapObject *pObj1, const MapObject *pObj2) {
+    return pObj1->gridSeq_ < pObj2->gridSeq_;
+}
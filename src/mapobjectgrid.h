@@ -0,0 +1,101 @@
+/************************************************************************
+ *                                                                      *
+ *  FreeSynd - a remake of the classic Bullfrog game "Syndicate".       *
+ *                                                                      *
+ *   Copyright (C) 2005  Stuart Binge  <skbinge@gmail.com>              *
+ *   Copyright (C) 2005  Joost Peters  <joostp@users.sourceforge.net>   *
+ *   Copyright (C) 2006  Trent Waddington <qg@biodome.org>              *
+ *   Copyright (C) 2006  Tarjei Knapstad <tarjei.knapstad@gmail.com>    *
+ *   Copyright (C) 2010  Benoit Blancard <benblan@users.sourceforge.net>*
+ *   Copyright (C) 2010  Bohdan Stelmakh <chamel@users.sourceforge.net> *
+ *                                                                      *
+ *    This program is free software;  you can redistribute it and / or  *
+ *  modify it  under the  terms of the  GNU General  Public License as  *
+ *  published by the Free Software Foundation; either version 2 of the  *
+ *  License, or (at your option) any later version.                     *
+ *                                                                      *
+ *    This program is  distributed in the hope that it will be useful,  *
+ *  but WITHOUT  ANY WARRANTY;  without even  the implied  warranty of  *
+ *  MERCHANTABILITY  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU  *
+ *  General Public License for more details.                            *
+ *                                                                      *
+ *    You can view the GNU  General Public License, online, at the GNU  *
+ *  project's  web  site;  see <http://www.gnu.org/licenses/gpl.html>.  *
+ *  The full text of the license is also included in the file COPYING.  *
+ *                                                                      *
+ ************************************************************************/
+
+#ifndef MAPOBJECTGRID_H
+#define MAPOBJECTGRID_H
+
+#include <vector>
+
+#include "common.h"
+#include "model/position.h"
+
+class MapObject;
+
+/*!
+ * A spatial hash of the objects of a mission.
+ * Objects are put in buckets of kCellTiles x kCellTiles tiles so queries only
+ * look at objects near the searched area instead of all mission objects.
+ * Objects update their bucket when their tile changes (see
+ * MapObject::updateGridCell()).
+ * Queries return objects sorted in the order they were added to the grid,
+ * which is the order of the mission lists, so results do not depend on
+ * the way objects moved between buckets.
+ */
+class MapObjectGrid {
+public:
+    //! Number of tiles on x and y in a cell
+    static const int kCellTiles;
+    //! Number of cells on x and y, cells are wrapped above that size
+    static const int kGridSize;
+
+    MapObjectGrid();
+    ~MapObjectGrid();
+
+    //! Adds an object in the grid
+    void add(MapObject *pObject);
+    //! Removes an object from the grid
+    void remove(MapObject *pObject);
+    //! Moves the object to the cell of its current position
+    void update(MapObject *pObject);
+    //! Removes all objects
+    void clear();
+
+    //! Returns objects of given natures that may be in range of the point
+    void findInRange(const WorldPoint &centerW, int range, int natures,
+        std::vector<MapObject *> &result);
+    //! Returns objects of given natures that may block the line
+    void findNearLine(const WorldPoint &startW, const WorldPoint &endW, int natures,
+        std::vector<MapObject *> &result);
+    //! Returns objects of given natures on the cell of the tile
+    void findAtTile(const TilePoint &posT, int natures, std::vector<MapObject *> &result);
+
+    //! Returns the number of objects in the grid
+    size_t size() { return nbObjects_; }
+
+protected:
+    //! Returns the index of the cell that holds the given tile
+    int cellOfTile(int tx, int ty) {
+        return ((tx >> kCellShift) & (kGridSize - 1))
+            + ((ty >> kCellShift) & (kGridSize - 1)) * kGridSize;
+    }
+    void collectCell(int cell, int natures, std::vector<MapObject *> &result);
+    void collectCellsAround(int cx, int cy, int natures, std::vector<MapObject *> &result);
+    static bool isAddedBefore(const MapObject *pObj1, const MapObject *pObj2);
+
+protected:
+    //! Bits to shift a tile coordinate to get a cell coordinate
+    static const int kCellShift;
+    /*! Objects in each cell.*/
+    std::vector<MapObject *> *cells_;
+    /*! Order given to the next added object.*/
+    uint32 nextSeq_;
+    /*! Id of current query, used to return an object once.*/
+    uint32 queryStamp_;
+    size_t nbObjects_;
+};
+
+#endif
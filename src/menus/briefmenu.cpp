@@ -32,6 +32,7 @@
 #include "briefmenu.h"
 #include "menus/gamemenuid.h"
 #include "core/missionbriefing.h"
+#include "utils/profiler.h"
 
 const int BriefMenu::kMiniMapScreenX = 504;
 const int BriefMenu::kMiniMapScreenY = 220;
@@ -39,9 +40,6 @@ const int BriefMenu::kMiniMapWidth = 120;
 const int BriefMenu::kMiniMapHeight = 120;
 const int BriefMenu::kMaxLinePerPage = 14;
 
-#if 0
-#define EXECUTION_SPEED_TIME
-#endif
 BriefMenu::BriefMenu(MenuManager * m)
     : Menu(m, fs_game_menus::kMenuIdBrief, fs_game_menus::kMenuIdMap, "mbrief.dat", "mbrieout.dat"),
         start_line_(0), p_briefing_(NULL), mm_renderer_() {
@@ -282,21 +280,14 @@ void BriefMenu::update_briefing_text()
 }
 
 void BriefMenu::handleRender(DirtyList &dirtyList) {
+    PROFILE_ZONE("BriefMenu::handleRender");
 
     g_Screen.drawLogo(18, 14, g_Session.getLogo(), g_Session.getLogoColour());
 
     // write briefing
-#ifdef EXECUTION_SPEED_TIME
-    printf("---------------------------");
-    printf("start time %i.%i\n", SDL_GetTicks()/1000, SDL_GetTicks()%1000);
-#endif
     if (dirtyList.intersectsList(22, 86, 460, 220)) {
         render_briefing_text();
     }
-#ifdef EXECUTION_SPEED_TIME
-    printf("+++++++++++++++++++++++++++");
-    printf("end time %i.%i\n", SDL_GetTicks()/1000, SDL_GetTicks()%1000);
-#endif
     // NOTE: enhance levels: 0 = 10px(5), 1 = 8px(4), 2 = 6px(3), 3 - 4px(2),
     // 4 - 2px(1); x = 502(251), y = 218(109), 124x124(62x62)
     // enemy peds are at maximum enhance lvl
@@ -38,10 +38,20 @@
 #include "menus/logoutmenu.h"
 #include "menus/flimenu.h"
 #include "utils/log.h"
+#include "app.h"
 
 Menu * GameMenuFactory::createMenu(const int menuId) {
     Menu *pMenu = NULL;
 
+    // Intro can be played while game data is still loading but
+    // other menus need all the data
+    if (menuId != fs_game_menus::kMenuIdFliTitle &&
+        menuId != fs_game_menus::kMenuIdFliIntro && !g_App.waitForStartup()) {
+        FSERR(Log::k_FLG_UI, "GameMenuFactory", "createMenu", ("Cannot create Menu %d : game data not loaded\n", menuId));
+        g_App.quit();
+        return NULL;
+    }
+
     if (menuId == fs_game_menus::kMenuIdMain) {
         pMenu =  new MainMenu(pManager_);
     } else if (menuId == fs_game_menus::kMenuIdBrief) {
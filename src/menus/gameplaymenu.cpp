@@ -28,6 +28,8 @@
 
 #include <stdio.h>
 #include <assert.h>
+#include <time.h>
+#include <ctype.h>
 #include "app.h"
 #include "gameplaymenu.h"
 #include "menus/gamemenuid.h"
@@ -36,6 +38,7 @@
 #include "model/vehicle.h"
 #include "mission.h"
 #include "model/shot.h"
+#include "utils/profiler.h"
 
 #ifdef _WIN32
 #include <windows.h>
@@ -46,12 +49,13 @@ const int SCROLL_STEP = 16;
 
 const int GameplayMenu::kMiniMapScreenX = 0;
 const int GameplayMenu::kMiniMapScreenY = 46 + 44 + 10 + 46 + 44 + 15 + 2 * 32 + 2;
+const int GameplayMenu::kMaxSimStepsPerTick = 5;
 
 //#define ANIM_PLUS_FRAME_VIEW
 
 GameplayMenu::GameplayMenu(MenuManager *m) :
 Menu(m, fs_game_menus::kMenuIdGameplay, fs_game_menus::kMenuIdDebrief, "", "mscrenup.dat"),
-tick_count_(0), last_animate_tick_(0), last_motion_tick_(0),
+tick_count_(0), last_motion_tick_(0),
 last_motion_x_(320), last_motion_y_(240), mission_hint_ticks_(0),
 mission_hint_(0), mission_(NULL), selection_(),
 target_(NULL),
@@ -63,6 +67,13 @@ mm_renderer_(), warningTimer_(20000)
     scroll_y_ = 0;
     ipa_chng_.ipa_chng = -1;
     canPlayPoliceWarnSound_ = true;
+    simStep_ = 33;
+    simAccumulator_ = 0;
+    nbSimSteps_ = 0;
+    simTime_ = 0;
+    nbFrames_ = 0;
+    renderTime_ = 0;
+    showProfiler_ = false;
     g_gameCtrl.addListener(this, GameEvent::kMission);
 }
 
@@ -286,13 +297,22 @@ void GameplayMenu::initWorldCoords()
  */
 void GameplayMenu::handleShow() {
     mission_ = g_Session.getMission();
+    simStep_ = 1000 / g_Ctx.getSimRate();
+    ReplayHeader replayHeader;
+    prepareReplay(&replayHeader);
     mission_->start();
+    startReplay(&replayHeader);
     // init selection to the first selectable agent
     selection_.setSquad(mission_->getSquad());
 
     // init menu internal state
     isButtonSelectAllPressed_ = false;
     initWorldCoords();
+    simAccumulator_ = 0;
+    nbSimSteps_ = 0;
+    simTime_ = 0;
+    nbFrames_ = 0;
+    renderTime_ = 0;
 
     // set graphic palette
     menu_manager_->setPaletteForMission(g_Session.getSelectedBlock().mis_id);
@@ -322,24 +342,12 @@ int qanim = 1959, qframe = 0;
 
 void GameplayMenu::handleTick(int elapsed)
 {
+    PROFILE_ZONE("GameplayMenu::handleTick");
     if (paused_)
         return;
     bool change = false;
     tick_count_ += elapsed;
 
-    if (!mission_->completed() && !mission_->failed()) {
-        // Update stats
-        mission_->stats()->incrMissionDuration(elapsed);
-
-        // Checks mission objectives
-        mission_->checkObjectives();
-    }
-
-    if (!canPlayPoliceWarnSound_ && warningTimer_.update(elapsed)) {
-        // wait an amount of time before allowing another warning
-        canPlayPoliceWarnSound_ = true;
-    }
-
     // Scroll the map
     if (scroll_x_ != 0) {
         change = scrollOnX();
@@ -351,59 +359,302 @@ void GameplayMenu::handleTick(int elapsed)
         scroll_y_ = 0;
     }
 
-    if (tick_count_ - last_animate_tick_ > 33) {
-        int diff = tick_count_ - last_animate_tick_;
-        last_animate_tick_ = tick_count_;
+    // Simulation advances by steps of fixed duration whatever the time
+    // between two frames. When the game is too late, remaining time is
+    // dropped instead of running more steps and being later.
+    simAccumulator_ += elapsed;
+    int nbSteps = 0;
+    while (simAccumulator_ >= simStep_ && nbSteps < kMaxSimStepsPerTick) {
+        change |= simulateStep(simStep_);
+        simAccumulator_ -= simStep_;
+        nbSteps++;
+    }
+    if (simAccumulator_ >= simStep_) {
+        simAccumulator_ = 0;
+    }
 
-        for (size_t i = 0; i < mission_->numSfxObjects(); i++) {
-            SFXObject *pSfx = mission_->sfxObjects(i);
-            change |= pSfx->animate(diff);
-            if (pSfx->sfxLifeOver()) {
-                mission_->delSfxObject(i);
-                i--;
-            }
-        }
+    if (nbSteps > 0) {
+        updateMarkersPosition();
+    }
 
-        for (size_t i = 0; i < mission_->numPeds(); i++)
-            change |= mission_->ped(i)->animate(diff, mission_);
+    updateMinimap(elapsed);
 
+    if (change) {
+        needRendering();
+        // force target to update
+        handleMouseMotion(last_motion_x_, last_motion_y_, 0, KMD_NONE);
+    }
 
-        for (size_t i = 0; i < mission_->numVehicles(); i++)
-            change |= mission_->vehicle(i)->animate(diff);
+    drawMissionHint(elapsed);
+}
 
-        for (size_t i = 0; i < mission_->numWeaponsOnGround(); i++)
-            change |= mission_->weaponOnGround(i)->animate(diff);
+/*!
+ * Runs one step of the mission simulation.
+ * \param elapsed Duration of the step
+ * \return True if something has changed on screen
+ */
+bool GameplayMenu::simulateStep(int elapsed)
+{
+    uint64 startTime = fs_utils::microTime();
+
+    // when replaying, gives the commands that the player gave before that step
+    PlayerCommand cmd;
+    while (replay_.nextCommand(nbSimSteps_, &cmd)) {
+        executeCommand(cmd);
+    }
+
+    bool change = mission_->simulateStep(elapsed);
+
+    if (!canPlayPoliceWarnSound_ && warningTimer_.update(elapsed)) {
+        // wait an amount of time before allowing another warning
+        canPlayPoliceWarnSound_ = true;
+    }
 
-        for (size_t i = 0; i < mission_->numStatics(); i++)
-            change |= mission_->statics(i)->animate(diff, mission_);
+    nbSimSteps_++;
+    simTime_ += fs_utils::microTime() - startTime;
 
-        for (size_t i = 0; i < mission_->numPrjShots(); i++) {
-            change |= mission_->prjShots(i)->animate(diff, mission_);
-            if (mission_->prjShots(i)->isLifeOver()) {
-                mission_->delPrjShot(i);
-                i--;
+    if (replay_.isEndStep(nbSimSteps_)) {
+        replay_.checkEnd(mission_->stateChecksum());
+    }
+
+    return change;
+}
+
+/*!
+ * Loads the replay file or chooses a seed for the recording and
+ * seeds the random generator with it.
+ * Must be called before mission starts as start uses random numbers.
+ * \param pHeader Receives the parameters of the mission
+ */
+void GameplayMenu::prepareReplay(ReplayHeader *pHeader)
+{
+    pHeader->missionId = g_Session.getSelectedBlock().mis_id;
+    pHeader->seed = 0;
+    pHeader->simStep = simStep_;
+    pHeader->pathWorkers = g_Ctx.getPathWorkers() > 0;
+    pHeader->startChecksum = 0;
+
+    if (!g_Ctx.getReplayFile().empty()) {
+        ReplayHeader recorded;
+        if (replay_.startPlaying(g_Ctx.getReplayFile(), &recorded)) {
+            if (recorded.missionId != pHeader->missionId ||
+                recorded.pathWorkers != pHeader->pathWorkers) {
+                FSERR(Log::k_FLG_GAME, "GameplayMenu", "prepareReplay", ("Replay is for mission %d %s path workers\n",
+                    recorded.missionId, recorded.pathWorkers ? "with" : "without"))
+                replay_.stopPlaying();
+            } else {
+                *pHeader = recorded;
+                simStep_ = recorded.simStep;
+                srand(recorded.seed);
             }
         }
+    } else if (!g_Ctx.getRecordFile().empty()) {
+        pHeader->seed = (uint32) time(NULL);
+        srand(pHeader->seed);
+    }
+}
 
-        updateMarkersPosition();
+/*!
+ * Once mission has started, begins recording or checks that the mission
+ * starts as it did when it was recorded. If not (agents are not equipped
+ * the same way for example), the replay is stopped.
+ * \param pHeader Parameters of the mission
+ */
+void GameplayMenu::startReplay(ReplayHeader *pHeader)
+{
+    uint32 checksum = mission_->stateChecksum();
+    if (replay_.isPlaying()) {
+        if (checksum != pHeader->startChecksum) {
+            FSERR(Log::k_FLG_GAME, "GameplayMenu", "startReplay", ("Mission does not start as in replay, squad may be different\n"))
+            replay_.stopPlaying();
+        }
+    } else if (!g_Ctx.getRecordFile().empty()) {
+        pHeader->startChecksum = checksum;
+        replay_.startRecording(g_Ctx.getRecordFile(), *pHeader);
     }
+}
 
-    updateMinimap(elapsed);
+/*!
+ * Commands given by the player go through this method so they can
+ * be recorded. During a replay, only recorded commands are executed.
+ * \param cmd The command
+ */
+void GameplayMenu::issueCommand(const PlayerCommand &cmd)
+{
+    if (replay_.isPlaying()) {
+        return;
+    }
 
-    updateIPALevelMeters(elapsed);
+    replay_.record(nbSimSteps_, cmd);
+    executeCommand(cmd);
+}
 
-    if (change) {
-        needRendering();
-        // force target to update
-        handleMouseMotion(last_motion_x_, last_motion_y_, 0, KMD_NONE);
+/*!
+ * Executes the given command.
+ * \param cmd The command
+ */
+void GameplayMenu::executeCommand(const PlayerCommand &cmd)
+{
+    switch (cmd.type) {
+    case PlayerCommand::kCmdSelectAgent:
+        selectAgent(cmd.args[0], cmd.args[1] != 0);
+        break;
+    case PlayerCommand::kCmdSelectAll:
+        selectAllAgents(cmd.args[0] != 0);
+        break;
+    case PlayerCommand::kCmdSetIpa:
+        setIPAForAgent(cmd.args[0], (IPAStim::IPAType) cmd.args[1], cmd.args[2]);
+        break;
+    case PlayerCommand::kCmdSelectWeapon:
+        handleWeaponSelection(cmd.args[0], cmd.args[1] != 0);
+        break;
+    case PlayerCommand::kCmdPutdownWeapon:
+        if (selection_.leader()) {
+            selection_.leader()->addActionPutdown(cmd.args[0], cmd.args[1] != 0);
+        }
+        break;
+    case PlayerCommand::kCmdPickupWeapon:
+        if (cmd.args[0] < (int) mission_->numWeaponsOnGround()) {
+            selection_.pickupWeapon(mission_->weaponOnGround(cmd.args[0]), cmd.args[1] != 0);
+        }
+        break;
+    case PlayerCommand::kCmdFollowPed:
+        if (cmd.args[0] < (int) mission_->numPeds()) {
+            selection_.followPed(mission_->ped(cmd.args[0]), cmd.args[1] != 0);
+        }
+        break;
+    case PlayerCommand::kCmdEnterVehicle:
+        if (cmd.args[0] < (int) mission_->numVehicles()) {
+            selection_.enterOrLeaveVehicle(mission_->vehicle(cmd.args[0]), cmd.args[1] != 0);
+        }
+        break;
+    case PlayerCommand::kCmdMoveTo:
+        {
+            TilePoint mapPt(cmd.args[0], cmd.args[1], cmd.args[2],
+                cmd.args[3], cmd.args[4], cmd.args[5]);
+            selection_.moveTo(mapPt, cmd.args[6] != 0);
+        }
+        break;
+    case PlayerCommand::kCmdShootAt:
+        {
+            WorldPoint aimedAtLocW;
+            aimedAtLocW.x = cmd.args[0];
+            aimedAtLocW.y = cmd.args[1];
+            aimedAtLocW.z = cmd.args[2];
+            isPlayerShooting_ = true;
+            selection_.shootAt(aimedAtLocW);
+        }
+        break;
+    case PlayerCommand::kCmdUpdateShootingTarget:
+        {
+            WorldPoint aimedAtLocW;
+            aimedAtLocW.x = cmd.args[0];
+            aimedAtLocW.y = cmd.args[1];
+            aimedAtLocW.z = cmd.args[2];
+            for (SquadSelection::Iterator it = selection_.begin(); it != selection_.end(); ++it) {
+                PedInstance *pAgent = *it;
+                if (pAgent->isUsingWeapon()) {
+                    // If ped is currently shooting
+                    // then update the action with new shooting target
+                    pAgent->updateShootingTarget(aimedAtLocW);
+                }
+            }
+        }
+        break;
+    case PlayerCommand::kCmdStopShooting:
+        stopShootingEvent();
+        break;
+    case PlayerCommand::kCmdSuicide:
+        {
+            // save current selection as it will be modified when agents die
+            std::vector<PedInstance *> agents_suicide;
+            for (SquadSelection::Iterator it = selection_.begin();
+                            it != selection_.end(); ++it) {
+                    agents_suicide.push_back(*it);
+            }
+
+            for (size_t i=0; i < agents_suicide.size(); i++) {
+                agents_suicide[i]->commitSuicide();
+            }
+        }
+        break;
+    default:
+        break;
     }
+}
 
-    drawMissionHint(elapsed);
+/*!
+ * Sets the command to pick up, follow or enter the object under the mouse.
+ * Objects are identified by their index in the mission.
+ * \param addAction True to append the action
+ * \param pCmd The command to set
+ * \return False if there is no usable target
+ */
+bool GameplayMenu::setCommandOnTarget(bool addAction, PlayerCommand *pCmd)
+{
+    if (target_ == NULL) {
+        return false;
+    }
+
+    pCmd->args[0] = -1;
+    pCmd->args[1] = addAction ? 1 : 0;
+    switch (target_->nature()) {
+    case MapObject::kNatureWeapon:
+        pCmd->type = PlayerCommand::kCmdPickupWeapon;
+        for (size_t i = 0; i < mission_->numWeaponsOnGround(); i++) {
+            if (mission_->weaponOnGround(i) == target_) {
+                pCmd->args[0] = i;
+                break;
+            }
+        }
+        break;
+    case MapObject::kNaturePed:
+        pCmd->type = PlayerCommand::kCmdFollowPed;
+        for (size_t i = 0; i < mission_->numPeds(); i++) {
+            if (mission_->ped(i) == target_) {
+                pCmd->args[0] = i;
+                break;
+            }
+        }
+        break;
+    case MapObject::kNatureVehicle:
+        pCmd->type = PlayerCommand::kCmdEnterVehicle;
+        for (size_t i = 0; i < mission_->numVehicles(); i++) {
+            if (mission_->vehicle(i) == target_) {
+                pCmd->args[0] = i;
+                break;
+            }
+        }
+        break;
+    default:
+        break;
+    }
+
+    return pCmd->args[0] != -1;
+}
+
+/*!
+ * Issues the command for selected agents to go to the given point.
+ * \param mapPt Destination
+ * \param addAction True to append the action
+ */
+void GameplayMenu::issueMoveTo(const TilePoint &mapPt, bool addAction)
+{
+    PlayerCommand cmd(PlayerCommand::kCmdMoveTo);
+    cmd.args[0] = mapPt.tx;
+    cmd.args[1] = mapPt.ty;
+    cmd.args[2] = mapPt.tz;
+    cmd.args[3] = mapPt.ox;
+    cmd.args[4] = mapPt.oy;
+    cmd.args[5] = mapPt.oz;
+    cmd.args[6] = addAction ? 1 : 0;
+    issueCommand(cmd);
 }
 
 void GameplayMenu::handleRender(DirtyList &dirtyList)
 {
-    g_Screen.clear(0);
+    PROFILE_ZONE("GameplayMenu::handleRender");
+    uint64 startTime = fs_utils::microTime();
     map_renderer_.render(displayOriginPt_);
     g_Screen.drawRect(0,0, 129, GAME_SCREEN_HEIGHT);
     agt_sel_renderer_.render(selection_, mission_->getSquad());
@@ -467,7 +718,52 @@ void GameplayMenu::handleRender(DirtyList &dirtyList)
     }
     sprintf(tmp, "FPS : %.2f FRAMES PER SEC", fps);
     gameFont()->drawText(10, Screen::kScreenHeight - 15, tmp, 14);
+    // text is over the map so map must be drawn again under it
+    map_renderer_.addDirtyArea(Screen::kScreenPanelWidth, Screen::kScreenHeight - 15,
+        Screen::kScreenWidth - Screen::kScreenPanelWidth, 15);
 #endif
+
+    if (showProfiler_) {
+        drawProfiler();
+    }
+
+    nbFrames_++;
+    renderTime_ += fs_utils::microTime() - startTime;
+}
+
+/*!
+ * Draws one line per zone with its average and maximum time per frame
+ * over the last frames. Zones are indented by their depth.
+ */
+void GameplayMenu::drawProfiler()
+{
+    const int kLineHeight = 12;
+    const int x = Screen::kScreenPanelWidth + 4;
+    const std::vector<Profiler::ZoneStats> &zones = Profiler::zoneStats();
+    int height = (zones.size() + 1) * kLineHeight + 4;
+    if (height > Screen::kScreenHeight) {
+        height = Screen::kScreenHeight;
+    }
+    g_Screen.drawRect(Screen::kScreenPanelWidth, 0,
+        Screen::kScreenWidth - Screen::kScreenPanelWidth, height);
+
+    char tmp[100];
+    int y = 2;
+    sprintf(tmp, "ZONE : AVG MS / MAX MS / CALLS%s", Profiler::isCapturing() ? " - CAPTURING" : "");
+    gameFont()->drawText(x, y, tmp, 14);
+    for (size_t i = 0; i < zones.size() && y + 2 * kLineHeight <= height; i++) {
+        y += kLineHeight;
+        const Profiler::ZoneStats &zone = zones[i];
+        int len = snprintf(tmp, sizeof(tmp), "%*s%s : %.2f / %.2f / %.0f", zone.depth * 2, "",
+            zone.name, zone.avgMs, zone.maxMs, zone.calls);
+        for (int c = 0; c < len && c < (int) sizeof(tmp); c++) {
+            tmp[c] = toupper(tmp[c]);
+        }
+        gameFont()->drawText(x, y, tmp, 14);
+    }
+    // text is over the map so map must be drawn again under it
+    map_renderer_.addDirtyArea(Screen::kScreenPanelWidth, 0,
+        Screen::kScreenWidth - Screen::kScreenPanelWidth, height);
 }
 
 void GameplayMenu::handleLeave()
@@ -476,11 +772,31 @@ void GameplayMenu::handleLeave()
 
     g_System.hideCursor();
     menu_manager_->setDefaultPalette();
+
+    if (replay_.isRecording()) {
+        replay_.stopRecording(nbSimSteps_, mission_->stateChecksum());
+    } else if (replay_.isPlaying()) {
+        replay_.stopPlaying();
+        // timings are printed so builds can be compared
+        printf("Replay : %d steps of %d ms, %d us per step, %d frames, %d us per frame\n",
+            nbSimSteps_, simStep_, nbSimSteps_ ? (int)(simTime_ / nbSimSteps_) : 0,
+            nbFrames_, nbFrames_ ? (int)(renderTime_ / nbFrames_) : 0);
+    }
+
     mission_->end();
     selection_.clear();
 
+    if (nbSimSteps_ != 0) {
+        LOG(Log::k_FLG_GAME, "GameplayMenu", "handleLeave", ("%d simulation steps of %d ms, %d us per step",
+            nbSimSteps_, simStep_, (int)(simTime_ / nbSimSteps_)));
+    }
+    if (nbFrames_ != 0) {
+        LOG(Log::k_FLG_GAME, "GameplayMenu", "handleLeave", ("%d frames, %d us per frame",
+            nbFrames_, (int)(renderTime_ / nbFrames_)));
+    }
+
     tick_count_ = 0;
-    last_animate_tick_ = 0;
+    simAccumulator_ = 0;
     last_motion_tick_ = 0;
     last_motion_x_ = 320;
     last_motion_y_ = 240;
@@ -509,16 +825,19 @@ void GameplayMenu::handleMouseMotion(int x, int y, int state, const int modKeys)
                 ipa_chng_.agent_used, x);
 
             // if agent is in selected group we will update all groups IPA
+            PlayerCommand cmd(PlayerCommand::kCmdSetIpa);
+            cmd.args[1] = ipa_chng_.ipa_chng;
+            cmd.args[2] = percent;
             if (selection_.isAgentSelected(ipa_chng_.agent_used)) {
                 for (uint8 i = 0; i < AgentManager::kMaxSlot; ++i) {
                     if (selection_.isAgentSelected(i)) {
-                        setIPAForAgent(i, (IPAStim::IPAType)ipa_chng_.ipa_chng,
-                            percent);
+                        cmd.args[0] = i;
+                        issueCommand(cmd);
                     }
                 }
             } else {
-                setIPAForAgent(ipa_chng_.agent_used,
-                    (IPAStim::IPAType)ipa_chng_.ipa_chng, percent);
+                cmd.args[0] = ipa_chng_.agent_used;
+                issueCommand(cmd);
             }
             return;
         } else
@@ -644,21 +963,18 @@ void GameplayMenu::handleMouseMotion(int x, int y, int state, const int modKeys)
     }
 
     if (x < 129 && isPlayerShooting_) {
-        stopShootingEvent();
+        issueCommand(PlayerCommand(PlayerCommand::kCmdStopShooting));
     }
 
     if (isPlayerShooting_) {
         // update direction for each shooting player
         WorldPoint aimedAtLocW;
         if (getAimedAt(x, y, &aimedAtLocW)) {
-            for (SquadSelection::Iterator it = selection_.begin(); it != selection_.end(); ++it) {
-                PedInstance *pAgent = *it;
-                if (pAgent->isUsingWeapon()) {
-                    // If ped is currently shooting
-                    // then update the action with new shooting target
-                    pAgent->updateShootingTarget(aimedAtLocW);
-                }
-            }
+            PlayerCommand cmd(PlayerCommand::kCmdUpdateShootingTarget);
+            cmd.args[0] = aimedAtLocW.x;
+            cmd.args[1] = aimedAtLocW.y;
+            cmd.args[2] = aimedAtLocW.z;
+            issueCommand(cmd);
         }
     }
 }
@@ -682,19 +998,32 @@ bool GameplayMenu::handleMouseDown(int x, int y, int button, const int modKeys)
                 // Handle agent selection. Click on an agent changes selection
                 // to it. If control key is pressed, add or removes agent from
                 // current selection.
-                selectAgent(selEvt.agentSlot, ctrl);
+                {
+                    PlayerCommand cmd(PlayerCommand::kCmdSelectAgent);
+                    cmd.args[0] = selEvt.agentSlot;
+                    cmd.args[1] = ctrl ? 1 : 0;
+                    issueCommand(cmd);
+                }
                 break;
             case SelectorEvent::kSelectIpa:
-                ipa_chng_.ipa_chng = selEvt.IpaType;
-                ipa_chng_.agent_used = selEvt.agentSlot;
-                setIPAForAgent(selEvt.agentSlot, selEvt.IpaType, selEvt.percentage);
+                {
+                    ipa_chng_.ipa_chng = selEvt.IpaType;
+                    ipa_chng_.agent_used = selEvt.agentSlot;
+                    PlayerCommand cmd(PlayerCommand::kCmdSetIpa);
+                    cmd.args[0] = selEvt.agentSlot;
+                    cmd.args[1] = selEvt.IpaType;
+                    cmd.args[2] = selEvt.percentage;
+                    issueCommand(cmd);
+                }
                 break;
             case SelectorEvent::kNone:
                 break;
             }
         } else if (y >= 42 + 48 && y < 42 + 48 + 10) {
             // User clicked on the select all button
-            selectAllAgents();
+            PlayerCommand cmd(PlayerCommand::kCmdSelectAll);
+            cmd.args[0] = isButtonSelectAllPressed_ ? 0 : 1;
+            issueCommand(cmd);
         }
         else if (y >= 2 + 46 + 44 + 10 + 46 + 44 + 15
                  && y < 2 + 46 + 44 + 10 + 46 + 44 + 15 + 64)
@@ -728,13 +1057,13 @@ void GameplayMenu::handleClickOnWeaponSelector(int x, int y, int button,
     if (pLeader->isAlive()) {
         bool is_ctrl = (modKeys & KMD_CTRL) != 0;
         if (w_num < pLeader->numWeapons()) {
-            if (button == kMouseLeftButton) {
-                // Button 1 : selection/deselection of weapon for all selection
-                handleWeaponSelection(w_num, is_ctrl);
-            } else {
-                // Button 3 : drop weapon from selected agent inventory
-                pLeader->addActionPutdown(w_num, is_ctrl);
-            }
+            // Button 1 : selection/deselection of weapon for all selection
+            // Button 3 : drop weapon from selected agent inventory
+            PlayerCommand cmd(button == kMouseLeftButton ?
+                PlayerCommand::kCmdSelectWeapon : PlayerCommand::kCmdPutdownWeapon);
+            cmd.args[0] = w_num;
+            cmd.args[1] = is_ctrl ? 1 : 0;
+            issueCommand(cmd);
         }
     }
     // redraw weapon selector
@@ -761,15 +1090,6 @@ void GameplayMenu::setIPAForAgent(size_t slot, IPAStim::IPAType ipa_type, int pe
     }
 }
 
-void GameplayMenu::updateIPALevelMeters(int elapsed)
-{
-    for (size_t agent = 0; agent < AgentManager::kMaxSlot; ++agent) {
-        PedInstance *ped = mission_->getSquad()->member(agent);
-        if (ped && ped->isAlive())
-            ped->updtIPATime(elapsed);
-    }
-}
-
 void GameplayMenu::handleClickOnMap(int x, int y, int button, const int modKeys) {
     TilePoint mapPt = mission_->get_map()->screenToTilePoint(displayOriginPt_.x + x - 129,
                     displayOriginPt_.y + y);
@@ -792,27 +1112,21 @@ void GameplayMenu::handleClickOnMap(int x, int y, int button, const int modKeys)
     bool ctrl = (modKeys & KMD_CTRL) != 0;
     if (button == kMouseLeftButton) {
         if (target_) {
-            switch (target_->nature()) {
-            case MapObject::kNatureWeapon:
-                selection_.pickupWeapon(dynamic_cast<WeaponInstance *>(target_), ctrl);
-                break;
-            case MapObject::kNaturePed:
-                selection_.followPed(dynamic_cast<PedInstance *>(target_), ctrl);
-                break;
-            case MapObject::kNatureVehicle:
-                selection_.enterOrLeaveVehicle(dynamic_cast<Vehicle *>(target_), ctrl);
-                break;
-            default:
-                break;
+            PlayerCommand cmd;
+            if (setCommandOnTarget(ctrl, &cmd)) {
+                issueCommand(cmd);
             }
         } else if (mission_->getWalkable(mapPt)) {
-            selection_.moveTo(mapPt, ctrl);
+            issueMoveTo(mapPt, ctrl);
         }
     } else if (button == kMouseRightButton) {
         WorldPoint aimedAtLocW;
         if (getAimedAt(x, y, &aimedAtLocW)) {
-            isPlayerShooting_ = true;
-            selection_.shootAt(aimedAtLocW);
+            PlayerCommand cmd(PlayerCommand::kCmdShootAt);
+            cmd.args[0] = aimedAtLocW.x;
+            cmd.args[1] = aimedAtLocW.y;
+            cmd.args[2] = aimedAtLocW.z;
+            issueCommand(cmd);
         }
     }
 }
@@ -832,7 +1146,7 @@ void GameplayMenu::handleClickOnMinimap(int x, int y) {
     if (mission_->getWalkableClosestByZ(pt))
     {
         // Destination is walkable so go
-        selection_.moveTo(pt, false);
+        issueMoveTo(pt, false);
      }
 }
 
@@ -887,7 +1201,7 @@ void GameplayMenu::handleMouseUp(int x, int y, int button, const int modKeys)
     ipa_chng_.ipa_chng = -1;
 
     if (button == kMouseRightButton && isPlayerShooting_) {
-        stopShootingEvent();
+        issueCommand(PlayerCommand(PlayerCommand::kCmdStopShooting));
     }
 
 }
@@ -900,6 +1214,9 @@ bool GameplayMenu::handleUnknownKey(Key key, const int modKeys) {
     if (isLetterP(key.unicode)) {
         if (paused_) {
             paused_ = false;
+            // erase the pause message
+            map_renderer_.invalidate();
+            needRendering();
         } else {
             paused_ = true;
             // TODO: translate all paused texts
@@ -913,7 +1230,7 @@ bool GameplayMenu::handleUnknownKey(Key key, const int modKeys) {
             g_Screen.drawRect(txt_posx - 10, txt_posy - 5,
                 txt_width + 20, txt_height + 10);
             gameFont()->drawText(txt_posx, txt_posy, str_paused.c_str(), 11);
-            stopShootingEvent();
+            issueCommand(PlayerCommand(PlayerCommand::kCmdStopShooting));
         }
         return true;
     }
@@ -958,19 +1275,15 @@ bool GameplayMenu::handleUnknownKey(Key key, const int modKeys) {
     if (key.keyVirt == KVT_NUMPAD0) {
         /* This code is exactly the same as for clicking on "group-button"
          * as you can see above. */
-        selectAllAgents();
+        PlayerCommand cmd(PlayerCommand::kCmdSelectAll);
+        cmd.args[0] = isButtonSelectAllPressed_ ? 0 : 1;
+        issueCommand(cmd);
     }
-    else if (key.keyVirt == KVT_NUMPAD1) {
-        selectAgent(0, ctrl);
-    }
-    else if (key.keyVirt == KVT_NUMPAD2) {
-        selectAgent(1, ctrl);
-    }
-    else if (key.keyVirt == KVT_NUMPAD3) {
-        selectAgent(2, ctrl);
-    }
-    else if (key.keyVirt == KVT_NUMPAD4) {
-        selectAgent(3, ctrl);
+    else if (key.keyVirt >= KVT_NUMPAD1 && key.keyVirt <= KVT_NUMPAD4) {
+        PlayerCommand cmd(PlayerCommand::kCmdSelectAgent);
+        cmd.args[0] = key.keyVirt - KVT_NUMPAD1;
+        cmd.args[1] = ctrl ? 1 : 0;
+        issueCommand(cmd);
     } else if (key.keyFunc == KFC_LEFT) { // Scroll the map to the left
         scroll_x_ = -SCROLL_STEP;
     } else if (key.keyFunc == KFC_RIGHT) { // Scroll the map to the right
@@ -992,24 +1305,40 @@ bool GameplayMenu::handleUnknownKey(Key key, const int modKeys) {
     } else if (key.keyFunc == KFC_F4) {
         mission_->endWithStatus(Mission::kMissionStatusFailed);
         return true;
+    } else if ((isLetterT(key.unicode)) && ctrl) { // show danger on the minimap
+        mm_renderer_.setDrawThreats(!mm_renderer_.isDrawingThreats());
+        needRendering();
+        return true;
     }
 #endif
     else if (key.keyFunc >= KFC_F5 && key.keyFunc <= KFC_F12) {
         // Those keys are direct access to inventory
-        uint8 weapon_idx = (uint8) key.keyFunc - (uint8) KFC_F5;
-        handleWeaponSelection(weapon_idx, ctrl);
+        PlayerCommand cmd(PlayerCommand::kCmdSelectWeapon);
+        cmd.args[0] = (uint8) key.keyFunc - (uint8) KFC_F5;
+        cmd.args[1] = ctrl ? 1 : 0;
+        issueCommand(cmd);
         return true;
     } else if ((isLetterD(key.unicode)) && ctrl) { // selected agents are killed with 'd'
-        // save current selection as it will be modified when agents die
-        std::vector<PedInstance *> agents_suicide;
-        for (SquadSelection::Iterator it = selection_.begin();
-                        it != selection_.end(); ++it) {
-                agents_suicide.push_back(*it);
+        issueCommand(PlayerCommand(PlayerCommand::kCmdSuicide));
+    } else if ((isLetterO(key.unicode)) && ctrl) { // show time of profiler zones
+        showProfiler_ = !showProfiler_;
+        if (showProfiler_) {
+            Profiler::setEnabled(true);
+        } else if (!Profiler::isCapturing()) {
+            Profiler::setEnabled(false);
         }
-
-        for (size_t i=0; i < agents_suicide.size(); i++) {
-            agents_suicide[i]->commitSuicide();
+        map_renderer_.invalidate();
+        needRendering();
+    } else if ((isLetterR(key.unicode)) && ctrl) { // start/stop capture of profiler trace
+        if (Profiler::isCapturing()) {
+            char name[64];
+            sprintf(name, "profile-%u.json", (unsigned int) time(NULL));
+            Profiler::stopCapture(File::homeFullPath(name));
+            Profiler::setEnabled(showProfiler_);
+        } else {
+            Profiler::startCapture();
         }
+        needRendering();
     } else {
         consumed = false;
     }
@@ -1322,12 +1651,12 @@ void GameplayMenu::selectAgent(size_t agentNo, bool addToGroup) {
 
 /*!
  * Selects all agents.
- * \param invert If true, selects only the agents that were not already
- * selected.
+ * \param selectAll If true, selects all agents, else only the leader
+ * stays selected.
  */
-void GameplayMenu::selectAllAgents() {
+void GameplayMenu::selectAllAgents(bool selectAll) {
     bool prv_state = isButtonSelectAllPressed_;
-    isButtonSelectAllPressed_ = !isButtonSelectAllPressed_;
+    isButtonSelectAllPressed_ = selectAll;
     selection_.selectAllAgents(isButtonSelectAllPressed_);
     updateSelectAll();
     if (isButtonSelectAllPressed_ != prv_state) {
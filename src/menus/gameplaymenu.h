@@ -32,6 +32,7 @@
 #include "minimaprenderer.h"
 #include "squadselection.h"
 #include "core/gameevent.h"
+#include "core/missionreplay.h"
 
 class Mission;
 class IPAStim;
@@ -69,6 +70,8 @@ protected:
     void drawSelectAllButton();
     void drawMissionHint(int elapsed);
     void drawWeaponSelectors();
+    //! Draws the time of the profiler zones over the map
+    void drawProfiler();
     //! Scroll the map horizontally.
     bool scrollOnX();
     //! Scroll the map vertically.
@@ -78,7 +81,7 @@ protected:
     //! Selects/deselects an agent
     void selectAgent(size_t agentNo, bool addToGroup);
     //! Selects/deselects all agents
-    void selectAllAgents();
+    void selectAllAgents(bool selectAll);
     //! Reacts to a weapon selection/deselection
     void handleWeaponSelection(uint8 weapon_idx, bool ctrl);
 
@@ -95,18 +98,33 @@ protected:
     void updateMinimap(int elapsed);
     //! Update the select all button state
     void updateSelectAll();
-    //! Update the target value for adrenaline etc for an agent
-    void updateIPALevelMeters(int elapsed);
 
     void updateMarkersPosition();
+    //! Runs one step of the mission simulation
+    bool simulateStep(int elapsed);
+
+    //! Records the command if needed and executes it
+    void issueCommand(const PlayerCommand &cmd);
+    //! Executes a command given by the player or read from a replay
+    void executeCommand(const PlayerCommand &cmd);
+    //! Sets the command to use the object under the mouse
+    bool setCommandOnTarget(bool addAction, PlayerCommand *pCmd);
+    //! Issues the command to go to the given point
+    void issueMoveTo(const TilePoint &mapPt, bool addAction);
+    //! Loads replay or seeds random generator before mission start
+    void prepareReplay(ReplayHeader *pHeader);
+    //! Starts recording or checks replay after mission start
+    void startReplay(ReplayHeader *pHeader);
 
 protected:
     /*! Origin of the minimap on the screen.*/
     static const int kMiniMapScreenX;
     /*! Origin of the minimap on the screen.*/
     static const int kMiniMapScreenY;
+    /*! Maximum number of simulation steps run in one tick.*/
+    static const int kMaxSimStepsPerTick;
 
-    int tick_count_, last_animate_tick_;
+    int tick_count_;
     int last_motion_tick_, last_motion_x_, last_motion_y_;
     int mission_hint_ticks_, mission_hint_;
     Mission *mission_;
@@ -136,6 +154,22 @@ protected:
     bool canPlayPoliceWarnSound_;
     /*! Delay between 2 police warnings.*/
     fs_utils::Timer warningTimer_;
+    /*! Duration of a simulation step in ms.*/
+    int simStep_;
+    /*! Time not yet simulated.*/
+    int simAccumulator_;
+    /*! Number of simulation steps since mission start.*/
+    int nbSimSteps_;
+    /*! Time spent in simulation since mission start in microseconds.*/
+    uint64 simTime_;
+    /*! Number of frames rendered since mission start.*/
+    int nbFrames_;
+    /*! Time spent in rendering since mission start in microseconds.*/
+    uint64 renderTime_;
+    /*! Records or plays the commands of the player.*/
+    MissionReplay replay_;
+    /*! True to show the time of the profiler zones.*/
+    bool showProfiler_;
 
     // when ipa is manipulated this represents
     struct IPA_manipulation {
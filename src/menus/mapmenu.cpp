@@ -31,6 +31,7 @@
 #include "menus/mapmenu.h"
 #include "menus/gamemenuid.h"
 #include "core/gamesession.h"
+#include "core/gamecontroller.h"
 #include "gfx/screen.h"
 #include "system.h"
 #include "menus/menumanager.h"
@@ -111,7 +112,7 @@ struct BlockDisplay {
  */
 MapMenu::MapMenu(MenuManager * m)
     :  Menu(m, fs_game_menus::kMenuIdMap, fs_game_menus::kMenuIdMain, "mmap.dat", "mmapout.dat"),
-mapblk_data_(NULL), select_tick_count_(0) {
+mapblk_data_(NULL), select_tick_count_(0), prefetchMissionId_(-1) {
     //
     briefButId_ = addOption(17, 347, 128, 25, "#MAP_BRIEF_BUT",
         FontManager::SIZE_2, fs_game_menus::kMenuIdBrief);
@@ -180,6 +181,12 @@ void MapMenu::handleBlockSelected() {
         getOption(briefButId_)->setVisible(true);
     }
 
+    if (getOption(briefButId_)->isVisible() && blk.mis_id != prefetchMissionId_) {
+        // the map will be needed by the briefing
+        g_gameCtrl.missions().prefetchMap(blk.mis_id);
+        prefetchMissionId_ = blk.mis_id;
+    }
+
     // Update the country informations
     getStatic(txtCountryId_)->setText(blk.name);
 
@@ -330,6 +337,8 @@ void MapMenu::handleShow() {
     // Show the mouse
     g_System.showCursor();
 
+    // maps may have been deleted from cache since last time
+    prefetchMissionId_ = -1;
     // State of the briefing button
     handleBlockSelected();
 
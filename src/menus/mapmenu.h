@@ -91,6 +91,8 @@ protected:
 
     /*! Id of the briefing button.*/
     int briefButId_;
+    /*! Id of the last mission whose map was prefetched.*/
+    int prefetchMissionId_;
 };
 
 #endif
@@ -25,6 +25,8 @@
  *                                                                      *
  ************************************************************************/
 
+#include <algorithm>
+
 #include "menus/maprenderer.h"
 #include "mission.h"
 #include "agentmanager.h"
@@ -35,48 +37,364 @@
 #include "gfx/tile.h"
 #include "system.h"
 #include "menus/squadselection.h"
+#include "utils/profiler.h"
+
+// Define this to browse the cells with the diagonal sweep used before
+// the tile draw list at each render and log when tiles or objects
+// would not be drawn in the same order (debug builds only as it logs)
+//#define CHECK_DRAW_ORDER
 
 void MapRenderer::init(Mission *pMission, SquadSelection *pSelection) {
     pMission_ = pMission;
     pMap_ = pMission->get_map();
     pSelection_ = pSelection;
+
+    drawnObjects_.clear();
+    newDrawnObjects_.clear();
+    dirtyArea_.clear();
+    redrawAll_ = true;
+}
+
+/*!
+ * Marks a part of the screen that has been drawn over by something else
+ * than the map so that the map is drawn there again.
+ * \param x Screen coordinates
+ * \param y Screen coordinates
+ * \param width Width of the rect
+ * \param height Height of the rect
+ */
+void MapRenderer::addDirtyArea(int x, int y, int width, int height) {
+    dirtyArea_.add(x - Screen::kScreenPanelWidth + lastViewport_.x,
+        y + lastViewport_.y, width, height);
 }
 
 /**
  * Draw tiles and map objects.
+ * Only the parts of the map that have changed since the last render are
+ * drawn : tiles and objects are drawn in the usual order but clipped to
+ * those parts, so objects stay hidden behind the tiles in front of them.
  */
 void MapRenderer::render(const Point2D &viewport) {
+    PROFILE_ZONE("MapRenderer::render");
+
+    const int mapWidth = Screen::kScreenWidth - Screen::kScreenPanelWidth;
+
+    listObjectsToDraw(viewport);
+    renderId_++;
+    shiftScreen(viewport);
+    setSweepWindow(viewport);
+    listObjectCells();
+    stats_.tilesVisited = stats_.tilesDrawn = 0;
+
+    // nothing is drawn while measuring objects
+    newDrawnObjects_.clear();
+    g_Screen.setClipRect(0, 0, 0, 0);
+    renderTiles(viewport, kPassMeasure);
+    g_Screen.resetClipRect();
+
+    // objects that were drawn last time but not this time must be erased
+    for (size_t i = 0; i < drawnObjects_.size(); i++) {
+        if (drawnObjects_[i].renderId != renderId_) {
+            const DirtyRect &area = drawnObjects_[i].area;
+            dirtyArea_.add(area.x, area.y, area.width, area.height);
+        }
+    }
+    std::sort(newDrawnObjects_.begin(), newDrawnObjects_.end(), DrawnObject::isBefore);
+    drawnObjects_.swap(newDrawnObjects_);
+
+    if (redrawAll_) {
+        dirtyArea_.clear();
+        dirtyArea_.add(viewport.x, viewport.y, mapWidth, Screen::kScreenHeight);
+        redrawAll_ = false;
+    }
+
+    // clear the parts to redraw
+    nbScreenRects_ = 0;
+    for (int i = 0; i < dirtyArea_.size(); i++) {
+        const DirtyRect &area = dirtyArea_.rectAt(i);
+        int x = area.x - viewport.x + Screen::kScreenPanelWidth;
+        int y = area.y - viewport.y;
+        int right = x + area.width;
+        int bottom = y + area.height;
+        x = x < Screen::kScreenPanelWidth ? Screen::kScreenPanelWidth : x;
+        y = y < 0 ? 0 : y;
+        right = right > Screen::kScreenWidth ? Screen::kScreenWidth : right;
+        bottom = bottom > Screen::kScreenHeight ? Screen::kScreenHeight : bottom;
+        if (x < right && y < bottom) {
+            DirtyRect &rect = screenRects_[nbScreenRects_++];
+            rect.x = x;
+            rect.y = y;
+            rect.width = right - x;
+            rect.height = bottom - y;
+            g_Screen.drawRect(x, y, rect.width, rect.height, 0);
+        }
+    }
+    dirtyArea_.clear();
+
+    if (nbScreenRects_ > 0) {
+        renderTiles(viewport, kPassDraw);
+        g_Screen.resetClipRect();
+    }
+
+#ifdef _DEBUG
+    if (g_System.getKeyModState() & KMD_LALT) {
+        for (SquadSelection::Iterator it = pSelection_->begin();
+            it != pSelection_->end(); ++it) {
+            (*it)->showPath(viewport.x, viewport.y);
+        }
+        // paths are erased by next render
+        redrawAll_ = true;
+    }
+#endif
+}
+
+/*!
+ * When the viewport has moved since last render, moves what's on screen
+ * accordingly and marks the parts of the map that were not visible before.
+ */
+void MapRenderer::shiftScreen(const Point2D &viewport) {
+    const int mapWidth = Screen::kScreenWidth - Screen::kScreenPanelWidth;
+    int dx = viewport.x - lastViewport_.x;
+    int dy = viewport.y - lastViewport_.y;
+    lastViewport_ = viewport;
+
+    if (redrawAll_ || (dx == 0 && dy == 0)) {
+        return;
+    }
+
+    if (dx >= mapWidth || -dx >= mapWidth ||
+        dy >= Screen::kScreenHeight || -dy >= Screen::kScreenHeight) {
+        redrawAll_ = true;
+        return;
+    }
+
+    g_Screen.shiftArea(Screen::kScreenPanelWidth, 0, mapWidth, Screen::kScreenHeight, -dx, -dy);
+    if (dx > 0) {
+        dirtyArea_.add(viewport.x + mapWidth - dx, viewport.y, dx, Screen::kScreenHeight);
+    } else if (dx < 0) {
+        dirtyArea_.add(viewport.x, viewport.y, -dx, Screen::kScreenHeight);
+    }
+    if (dy > 0) {
+        dirtyArea_.add(viewport.x, viewport.y + Screen::kScreenHeight - dy, mapWidth, dy);
+    } else if (dy < 0) {
+        dirtyArea_.add(viewport.x, viewport.y, mapWidth, -dy);
+    }
+}
+
+/*!
+ * Computes which cells are browsed for the viewport. These are the limits
+ * of the diagonal sweep over the cells that may be on screen.
+ */
+void MapRenderer::setSweepWindow(const Point2D &viewport) {
+    TilePoint mtp = pMap_->screenToTilePoint(viewport.x, viewport.y);
+    int chk = Screen::kScreenWidth / (TILE_WIDTH / 2) + 2
+        + Screen::kScreenHeight / (TILE_HEIGHT / 3) + pMap_->maxZ() * 2;
+
+    sweep_.originX = mtp.tx;
+    sweep_.firstX = mtp.tx < 0 ? 0 : mtp.tx;
+    sweep_.firstDiag = mtp.ty - 8 < 0 ? 0 : mtp.ty - 8;
+    sweep_.endDiag = mtp.ty - 8 + chk;
+    sweep_.firstY = sweep_.firstDiag;
+    sweep_.firstSum = mtp.tx + mtp.ty - 8 - 1;
+    sweep_.endSum = sweep_.firstSum + sweep_.endDiag + pMap_->maxZ() + 1;
+
+    sweep_.firstScreenX = viewport.x - TILE_WIDTH * 2;
+    sweep_.endScreenX = viewport.x + Screen::kScreenWidth -
+                Screen::kScreenPanelWidth + 128 - TILE_WIDTH * 2;
+    sweep_.firstScreenY = viewport.y - TILE_HEIGHT * 2;
+    sweep_.endScreenY = viewport.y + Screen::kScreenHeight + 128 - TILE_HEIGHT * 2;
+}
+
+/*!
+ * Returns true if the cell is browsed for the current viewport.
+ * \param x X coordinate of the cell
+ * \param y Y coordinate of the cell
+ * \param z Z coordinate of the tile, objects at z - 1 are drawn with the cell
+ */
+bool MapRenderer::isCellInSweep(int x, int y, int z) const {
+    if (x < sweep_.firstX || x >= pMap_->maxX() || y < sweep_.firstY || y >= pMap_->maxY() ||
+        z < 0 || z > pMap_->maxZ() + 1) {
+        return false;
+    }
+
+    int diag = x + y - sweep_.originX;
+    int sum = x + y + z;
+    if (diag < sweep_.firstDiag || diag >= sweep_.endDiag ||
+        sum < sweep_.firstSum || sum >= sweep_.endSum) {
+        return false;
+    }
+
+    int screenX = (pMap_->maxX() + (x - y)) * (TILE_WIDTH / 2);
+    int screenY = ((pMap_->maxZ() + x + y) - (z - 1)) * (TILE_HEIGHT / 3);
+    return screenX >= sweep_.firstScreenX && screenX < sweep_.endScreenX &&
+        screenY >= sweep_.firstScreenY && screenY < sweep_.endScreenY;
+}
+
+/*!
+ * Lists the cells that have objects on them in drawing order and sorts
+ * the objects on each of these cells from back to front.
+ */
+void MapRenderer::listObjectCells() {
+    objectCells_.clear();
+    size_t first = 0;
+    while (first < objects_.size()) {
+        uint32 key = objects_[first].cellKey;
+        size_t end = first + 1;
+        while (end < objects_.size() && objects_[end].cellKey == key) {
+            end++;
+        }
+
+        if (isCellInSweep(TileDrawList::keyX(key), TileDrawList::keyY(key),
+            TileDrawList::keyZ(key))) {
+            ObjectCell cell = { key, (int) first, (int) (end - first) };
+            objectCells_.push_back(cell);
+            sortObjectsOnCell(cell);
+        }
+        first = end;
+    }
+    stats_.objectCells = (int) objectCells_.size();
+}
+
+/*!
+ * Lists the opaque tiles that are on screen in drawing order. Only the
+ * blocks of the draw list covered by the screen are looked at.
+ */
+void MapRenderer::listVisibleTiles(const Point2D &viewport) {
+    const TileDrawList &drawList = pMap_->drawList();
+    // a tile that starts more than a tile away on the left or top is not drawn
+    int firstX = viewport.x - TILE_WIDTH + 1;
+    int firstY = viewport.y - TILE_HEIGHT + 1;
+    firstX = firstX < sweep_.firstScreenX ? sweep_.firstScreenX : firstX;
+    firstY = firstY < sweep_.firstScreenY ? sweep_.firstScreenY : firstY;
+    int firstCol = drawList.colAt(firstX);
+    int lastCol = drawList.colAt(sweep_.endScreenX - 1);
+    int firstRow = drawList.rowAt(firstY);
+    int lastRow = drawList.rowAt(sweep_.endScreenY - 1);
+    firstCol = firstCol < 0 ? 0 : firstCol;
+    firstRow = firstRow < 0 ? 0 : firstRow;
+    lastCol = lastCol >= drawList.nbCols() ? drawList.nbCols() - 1 : lastCol;
+    lastRow = lastRow >= drawList.nbRows() ? drawList.nbRows() - 1 : lastRow;
+
+    visibleTiles_.clear();
+    for (int row = firstRow; row <= lastRow; row++) {
+        for (int col = firstCol; col <= lastCol; col++) {
+            const TileDrawList::Entry *pEnd = drawList.blockEnd(col, row);
+            for (const TileDrawList::Entry *pEntry = drawList.blockBegin(col, row);
+                pEntry != pEnd; pEntry++) {
+                int x = TileDrawList::keyX(pEntry->key);
+                int y = TileDrawList::keyY(pEntry->key);
+                int z = TileDrawList::keyZ(pEntry->key);
+                stats_.tilesVisited++;
+                if (isCellInSweep(x, y, z) &&
+                    (pMap_->maxX() + (x - y)) * (TILE_WIDTH / 2) >= firstX &&
+                    ((pMap_->maxZ() + x + y) - (z - 1)) * (TILE_HEIGHT / 3) >= firstY) {
+                    visibleTiles_.push_back(*pEntry);
+                }
+            }
+        }
+    }
+    std::sort(visibleTiles_.begin(), visibleTiles_.end(), TileDrawList::isBefore);
+}
+
+/*!
+ * Browses the tiles from back to front.
+ * \param viewport Position of the screen on the map
+ * \param pass When measuring, only objects are measured. When drawing,
+ *  tiles and objects are drawn in the parts to redraw.
+ */
+void MapRenderer::renderTiles(const Point2D &viewport, ERenderPass pass) {
     // TODO: list of bugs to fix in rendering
     //  - Some advert panels lack a corner
+    int cmx = viewport.x - Screen::kScreenPanelWidth;
+
+    if (pass == kPassMeasure) {
+        for (size_t i = 0; i < objectCells_.size(); i++) {
+            uint32 key = objectCells_[i].key;
+            int x = TileDrawList::keyX(key);
+            int y = TileDrawList::keyY(key);
+            int z = TileDrawList::keyZ(key);
+            Point2D screenPos = {
+                (pMap_->maxX() + (x - y)) * (TILE_WIDTH / 2) - cmx + TILE_WIDTH / 2,
+                ((pMap_->maxZ() + x + y) - (z - 1)) * (TILE_HEIGHT / 3) - viewport.y + TILE_HEIGHT / 3 * 2};
+            measureObjectsOnTile(objectCells_[i], screenPos, viewport);
+        }
+        return;
+    }
+
+    listVisibleTiles(viewport);
+
+    // tiles and objects are merged in drawing order, the tile of a cell
+    // being drawn before the objects on it
+    size_t nextTile = 0;
+    size_t nextCell = 0;
+    while (nextTile < visibleTiles_.size() || nextCell < objectCells_.size()) {
+        if (nextTile < visibleTiles_.size() && (nextCell == objectCells_.size() ||
+            visibleTiles_[nextTile].key <= objectCells_[nextCell].key)) {
+            const TileDrawList::Entry &entry = visibleTiles_[nextTile++];
+            int x = TileDrawList::keyX(entry.key);
+            int y = TileDrawList::keyY(entry.key);
+            int z = TileDrawList::keyZ(entry.key);
+            drawTile(entry.pTile, (pMap_->maxX() + (x - y)) * (TILE_WIDTH / 2) - cmx,
+                ((pMap_->maxZ() + x + y) - (z - 1)) * (TILE_HEIGHT / 3) - viewport.y);
+            stats_.tilesDrawn++;
+        } else {
+            const ObjectCell &cell = objectCells_[nextCell++];
+            int x = TileDrawList::keyX(cell.key);
+            int y = TileDrawList::keyY(cell.key);
+            int z = TileDrawList::keyZ(cell.key);
+            Point2D screenPos = {
+                (pMap_->maxX() + (x - y)) * (TILE_WIDTH / 2) - cmx + TILE_WIDTH / 2,
+                ((pMap_->maxZ() + x + y) - (z - 1)) * (TILE_HEIGHT / 3) - viewport.y + TILE_HEIGHT / 3 * 2};
+            drawObjectsOnTile(cell, screenPos);
+        }
+    }
+
+#if defined(CHECK_DRAW_ORDER) && defined(_DEBUG)
+    checkDrawOrder(viewport);
+#endif
+}
+
+#if defined(CHECK_DRAW_ORDER) && defined(_DEBUG)
+/*!
+ * Browses the cells with the diagonal sweep used before the tile draw
+ * list and compares the tiles and object cells met to those drawn by
+ * renderTiles().
+ */
+void MapRenderer::checkDrawOrder(const Point2D &viewport) {
+    // a cell key and true if it's the tile, false if it's the objects
+    std::vector<std::pair<uint32, bool> > order;
+    for (size_t nextTile = 0, nextCell = 0;
+        nextTile < visibleTiles_.size() || nextCell < objectCells_.size();) {
+        if (nextTile < visibleTiles_.size() && (nextCell == objectCells_.size() ||
+            visibleTiles_[nextTile].key <= objectCells_[nextCell].key)) {
+            order.push_back(std::make_pair(visibleTiles_[nextTile++].key, true));
+        } else {
+            order.push_back(std::make_pair(objectCells_[nextCell++].key, false));
+        }
+    }
+
+    std::vector<std::pair<uint32, bool> > sweepOrder;
     TilePoint mtp = pMap_->screenToTilePoint(viewport.x, viewport.y);
     int sw = mtp.tx;
     int chk = Screen::kScreenWidth / (TILE_WIDTH / 2) + 2
         + Screen::kScreenHeight / (TILE_HEIGHT / 3) + pMap_->maxZ() * 2;
     int sh = mtp.ty - 8;
-
     int shm = sh + chk;
-
-    DEBUG_SPEED_INIT
-
-    listObjectsToDraw(viewport);
-
-    int cmw = viewport.x + Screen::kScreenWidth -
-                Screen::kScreenPanelWidth + 128;
+    int cmw = viewport.x + Screen::kScreenWidth - Screen::kScreenPanelWidth + 128;
     int cmh = viewport.y + Screen::kScreenHeight + 128;
-    int cmx = viewport.x - Screen::kScreenPanelWidth;
-     //  z = 0 - is minimap data and mapdata
     int chky = sh < 0 ? 0 : sh;
     int zr = shm + pMap_->maxZ() + 1;
+    size_t nextObject = 0;
     for (int inc = 0; inc < zr; ++inc) {
         int ye = sh + inc;
         int ys = ye - pMap_->maxZ() - 2;
-        int tile_z = pMap_->maxZ() + 1;  // the Z coord of the next tile to draw
+        int tile_z = pMap_->maxZ() + 1;
         for (int yb = ys; yb < ye; ++yb) {
             if (yb < 0 || yb < sh || yb >= shm) {
                 --tile_z;
                 continue;
             }
-            int tile_y = yb;  // The Y coord of the tile to draw
+            int tile_y = yb;
             for (int tile_x = sw; tile_y >= chky && tile_x < pMap_->maxX(); ++tile_x) {
                 if (tile_x < 0 || tile_y >= pMap_->maxY()) {
                     --tile_y;
@@ -88,32 +406,24 @@ void MapRenderer::render(const Point2D &viewport) {
                     && screen_w + TILE_WIDTH * 2 < cmw
                     && coord_h >= viewport.y - TILE_HEIGHT * 2
                     && coord_h + TILE_HEIGHT * 2 < cmh) {
-#if 0
-                    if (z > 2)
-                        continue;
-#endif
-                    // draw a tile
-                    if (tile_z < pMap_->maxZ()) {
-                        Tile *p_tile = pMap_->getTileAt(tile_x, tile_y, tile_z);
-                        if (p_tile->notTransparent()) {
-                            int dx = 0, dy = 0;
-                            if (screen_w - viewport.x < 0)
-                                dx = -(screen_w - viewport.x);
-                            if (coord_h - viewport.y < 0)
-                                dy = -(coord_h - viewport.y);
-                            if (dx < TILE_WIDTH && dy < TILE_HEIGHT) {
-                                p_tile->drawToScreen(screen_w - cmx, coord_h - viewport.y);
-                            }
-                        }
+                    uint32 key = TileDrawList::cellKey(tile_x, tile_y, tile_z);
+                    if (tile_z < pMap_->maxZ() &&
+                        pMap_->getTileAt(tile_x, tile_y, tile_z)->notTransparent() &&
+                        viewport.x - screen_w < TILE_WIDTH &&
+                        viewport.y - coord_h < TILE_HEIGHT) {
+                        sweepOrder.push_back(std::make_pair(key, true));
                     }
-
-                    // draw everything that's on the tile
                     if (tile_z - 1 >= 0) {
-                        TilePoint currentTile(tile_x, tile_y, tile_z - 1);
-                        Point2D screenPos = {screen_w - cmx + TILE_WIDTH / 2,
-                            coord_h - viewport.y + TILE_HEIGHT / 3 * 2};
-
-                        drawObjectsOnTile(currentTile, screenPos);
+                        // objects_ is sorted by cell so look for the cell
+                        // among all objects
+                        while (nextObject < objects_.size() &&
+                            objects_[nextObject].cellKey < key) {
+                            nextObject++;
+                        }
+                        if (nextObject < objects_.size() &&
+                            objects_[nextObject].cellKey == key) {
+                            sweepOrder.push_back(std::make_pair(key, false));
+                        }
                     }
                 }
                 --tile_y;
@@ -122,25 +432,82 @@ void MapRenderer::render(const Point2D &viewport) {
         }
     }
 
-    freeUnreleasedResources();
-
-#ifdef _DEBUG
-    if (g_System.getKeyModState() & KMD_LALT) {
-        for (SquadSelection::Iterator it = pSelection_->begin();
-            it != pSelection_->end(); ++it) {
-            (*it)->showPath(viewport.x, viewport.y);
-        }
+    size_t i = 0;
+    while (i < order.size() && i < sweepOrder.size() && order[i] == sweepOrder[i]) {
+        i++;
     }
+    if (i < order.size() || i < sweepOrder.size()) {
+        uint32 key = i < order.size() ? order[i].first : sweepOrder[i].first;
+        LOG(Log::k_FLG_GFX, "MapRenderer", "checkDrawOrder",
+            ("Draw order differs at %d from viewport (%d, %d) near cell (%d, %d, %d) : %d / %d draws",
+            (int) i, viewport.x, viewport.y, TileDrawList::keyX(key),
+            TileDrawList::keyY(key), TileDrawList::keyZ(key),
+            (int) order.size(), (int) sweepOrder.size()));
+    }
+}
 #endif
 
-    DEBUG_SPEED_LOG("MapRenderer::render")
+/*!
+ * Draws the tile in each part of the screen to redraw it covers.
+ */
+void MapRenderer::drawTile(Tile *pTile, int x, int y) {
+    DirtyRect tileRect = {x, y, TILE_WIDTH, TILE_HEIGHT};
+    for (int i = 0; i < nbScreenRects_; i++) {
+        const DirtyRect &rect = screenRects_[i];
+        if (DirtyArea::intersect(tileRect, rect)) {
+            g_Screen.setClipRect(rect.x, rect.y, rect.width, rect.height);
+            pTile->drawToScreen(x, y);
+        }
+    }
 }
 
-int MapRenderer::tileHashKey(MapObject * m) {
-    return tileHashKey(m->position());
+/*!
+ * Finds the part of the screen covered by each object on the given tile.
+ * When an object has moved or changed since last render, the parts it
+ * covered then and covers now must be redrawn.
+ * Statics don't move and only change with their state and animation,
+ * so they are redrawn only when those change. Other objects are always redrawn.
+ */
+void MapRenderer::measureObjectsOnTile(const ObjectCell &cell, const Point2D &screenPos,
+        const Point2D &viewport) {
+    for (int i = cell.first; i < cell.first + cell.count; i++) {
+        ObjectToDraw &obj = objects_[i];
+        MapObject *pMapObject = obj.pObject;
+        g_Screen.startTracking();
+        pMapObject->draw(screenPos.x, screenPos.y);
+        DirtyRect area = g_Screen.stopTracking();
+        obj.area = area;
+
+        // areas are kept in map coordinates so they stay right after a scroll
+        area.x += viewport.x - Screen::kScreenPanelWidth;
+        area.y += viewport.y;
+
+        DrawnObject drawn = { pMapObject, area, pMapObject->frame(),
+            pMapObject->stateMasks(), renderId_ };
+        std::vector<DrawnObject>::iterator itLast = std::lower_bound(
+            drawnObjects_.begin(), drawnObjects_.end(), drawn, DrawnObject::isBefore);
+        bool isNew = itLast == drawnObjects_.end() || itLast->pObject != pMapObject;
+        if (isNew || !pMapObject->is(MapObject::kNatureStatic) ||
+            itLast->frame != drawn.frame || itLast->state != drawn.state ||
+            itLast->area.x != area.x || itLast->area.y != area.y ||
+            itLast->area.width != area.width || itLast->area.height != area.height) {
+            if (!isNew) {
+                dirtyArea_.add(itLast->area.x, itLast->area.y, itLast->area.width, itLast->area.height);
+            }
+            dirtyArea_.add(area.x, area.y, area.width, area.height);
+        }
+
+        if (!isNew) {
+            // the object is still drawn so it must not be erased
+            itLast->renderId = renderId_;
+        }
+        newDrawnObjects_.push_back(drawn);
+    }
 }
 
 void MapRenderer::listObjectsToDraw(const Point2D &viewport) {
+    objects_.clear();
+
     /*if (tilex < 0)
         tilex = 0;
     if (tiley < 0)
@@ -190,6 +557,9 @@ void MapRenderer::listObjectsToDraw(const Point2D &viewport) {
             addObjectToDraw(pSfx);
         }
     }
+
+    sortObjectsByCell();
+    stats_.objects = (int) objects_.size();
 }
 
 /**
@@ -212,105 +582,93 @@ bool MapRenderer::isObjectInsideDrawingArea(MapObject *pObject, const Point2D &v
 }
 
 /**
- * Draw all objects on the given tile.
- * \param tilePos const TilePoint& tile coordinates
+ * Draw all objects on the given cell.
+ * \param cell Objects to draw
  * \param screenPos const Point2D& position of tile on the screen
  * \return int number of objects for debug
  *
  */
-int MapRenderer::drawObjectsOnTile(const TilePoint & tilePos, const Point2D &screenPos) {
-    int tileKey = tileHashKey(tilePos);
+int MapRenderer::drawObjectsOnTile(const ObjectCell &cell, const Point2D &screenPos) {
     int nbDrawnObjects = 0;
 
-    std::map<int, ObjectToDraw *>::iterator it = objectsByTile_.find(tileKey);
-    if(it != objectsByTile_.end()) {
-        ObjectToDraw *pObj = it->second;
-        objectsByTile_.erase(it);
-        while(pObj != NULL) {
-            pObj->getObject()->draw(screenPos.x, screenPos.y);
-            ObjectToDraw *pNext = pObj->getNext();
-            pool_.releaseResource(pObj);
-            pObj = pNext;
-            nbDrawnObjects++;
+    for (int i = cell.first; i < cell.first + cell.count; i++) {
+        const ObjectToDraw &obj = objects_[i];
+        // draw object in each part to redraw it covers
+        for (int j = 0; j < nbScreenRects_; j++) {
+            const DirtyRect &rect = screenRects_[j];
+            if (DirtyArea::intersect(obj.area, rect)) {
+                g_Screen.setClipRect(rect.x, rect.y, rect.width, rect.height);
+                obj.pObject->draw(screenPos.x, screenPos.y);
+                nbDrawnObjects++;
+            }
         }
     }
 
     return nbDrawnObjects;
 }
 
-
 /**
- * Adds an object to the list of objects to draw for the tile it's on.
- * For a given tile object are sorted from back to front so that
- * objects in the back are drawn first.
+ * Adds an object to the list of objects to draw. The object is drawn
+ * with the cell above the tile it's on.
  * \param pObjectToAdd MapObject* Object to add
  * \return void
  *
  */
 void MapRenderer::addObjectToDraw(MapObject *pObjectToAdd) {
-    int tileKey;
-    ObjectToDraw *pNewEntry = pool_.getResource();
-    pNewEntry->setObject(pObjectToAdd);
-
+    TilePoint pos(pObjectToAdd->position());
     if (pObjectToAdd->is(MapObject::kNatureVehicle)) {
         // vehicle are associated with the tile just above (z+1)
         // because it is bigger than a tile so all tiles below must be drawn first
-        TilePoint vehiclePos( pObjectToAdd->position());
-        vehiclePos.tz += 1;
-        tileKey = tileHashKey(vehiclePos);
-    } else {
-        tileKey = tileHashKey(pObjectToAdd);
+        pos.tz += 1;
+    }
+    if (pos.tx < 0 || pos.ty < 0 || pos.tz < 0) {
+        return;
     }
 
-    std::map<int, ObjectToDraw *>::iterator element = objectsByTile_.find(tileKey);
-    if(element == objectsByTile_.end()) {
-        // no element has been set with the tile so add the first element
-        objectsByTile_[tileKey] = pNewEntry;
-    } else {
-        // there is at leastone element already set with the tile
-        ObjectToDraw *pObjectInList = element->second;
-        if (pObjectToAdd->isBehindObjectOnSameTile(pObjectInList->getObject())) {
-            // first case is when the new object should be first in the list
-            pNewEntry->setNext(pObjectInList);
-            objectsByTile_[tileKey] = pNewEntry;
-        } else {
-            // second case is when new object is somewhere in the list
-            while (pObjectInList != NULL) {
-                if (pObjectInList->getNext() != NULL) {
-                    if (pObjectToAdd->isBehindObjectOnSameTile(pObjectInList->getNext()->getObject())) {
-                        pObjectInList->insertNext(pNewEntry);
-                        break;
-                    } else {
-                        pObjectInList = pObjectInList->getNext();
-                    }
-                } else {
-                    pObjectInList->setNext(pNewEntry);
-                    break;
-                }
-            }
+    ObjectToDraw obj;
+    obj.pObject = pObjectToAdd;
+    obj.cellKey = TileDrawList::cellKey(pos.tx, pos.ty, pos.tz + 1);
+    obj.area.x = obj.area.y = obj.area.width = obj.area.height = 0;
+    objects_.push_back(obj);
+}
+
+/*!
+ * Sorts objects by cell with a radix sort on the cell key. The sort is
+ * stable and uses a buffer kept between renders, so it does not allocate
+ * memory.
+ */
+void MapRenderer::sortObjectsByCell() {
+    sortBuffer_.resize(objects_.size());
+    for (int shift = 0; shift < 32; shift += 8) {
+        int starts[257] = { 0 };
+        for (size_t i = 0; i < objects_.size(); i++) {
+            starts[((objects_[i].cellKey >> shift) & 0xFF) + 1]++;
+        }
+        for (int digit = 0; digit < 256; digit++) {
+            starts[digit + 1] += starts[digit];
+        }
+        for (size_t i = 0; i < objects_.size(); i++) {
+            sortBuffer_[starts[(objects_[i].cellKey >> shift) & 0xFF]++] = objects_[i];
         }
+        objects_.swap(sortBuffer_);
     }
 }
 
-/**
- * Objects that were listed for drawing may be bigger than objects really drawn.
- * So remove those objects from the list.
- * \return void
- *
+/*!
+ * Sorts the objects on the cell from back to front so that objects in
+ * the back are drawn first. Each object is put before the first object
+ * listed before it that it is behind.
  */
-void MapRenderer::freeUnreleasedResources() {
-    int nbFreed = 0;
-    std::map<int, ObjectToDraw *>::iterator itr = objectsByTile_.begin();
-    while (itr != objectsByTile_.end()) {
-        std::map<int, ObjectToDraw *>::iterator toErase = itr;
-        ++itr;
-        ObjectToDraw *pObj = toErase->second;
-        while(pObj != NULL) {
-            ObjectToDraw *pNext = pObj->getNext();
-            pool_.releaseResource(pObj);
-            nbFreed++;
-            pObj = pNext;
+void MapRenderer::sortObjectsOnCell(const ObjectCell &cell) {
+    for (int i = cell.first + 1; i < cell.first + cell.count; i++) {
+        ObjectToDraw obj = objects_[i];
+        int pos = cell.first;
+        while (pos < i && !obj.pObject->isBehindObjectOnSameTile(objects_[pos].pObject)) {
+            pos++;
+        }
+        for (int j = i; j > pos; j--) {
+            objects_[j] = objects_[j - 1];
         }
-        objectsByTile_.erase(toErase);
+        objects_[pos] = obj;
     }
 }
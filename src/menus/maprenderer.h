@@ -28,18 +28,18 @@
 #ifndef MENUS_MAPRENDERER_H_
 #define MENUS_MAPRENDERER_H_
 
-#include <list>
 #include <vector>
-#include <set>
-#include <map>
 
 #include "common.h"
 #include "utils/log.h"
 #include "model/position.h"
+#include "gfx/dirtylist.h"
+#include "gfx/tiledrawlist.h"
 
 class Mission;
 class Map;
 class MapObject;
+class Tile;
 class Vehicle;
 class PedInstance;
 class WeaponInstance;
@@ -47,138 +47,167 @@ class Static;
 class SFXObject;
 class SquadSelection;
 
-class PoolableResource {
-public:
-    PoolableResource() { free_ = true; }
-    virtual ~PoolableResource() {}
-
-    bool isFree() { return free_; }
-    void setFree(bool free) { free_ = free; }
-
-    virtual void handleRelease() {}
-
-private:
-    bool free_;
-};
-
-class ObjectToDraw : public PoolableResource {
+/*!
+ * Draws the map and the objects on it in the map area of the screen.
+ * The screen is not redrawn entirely each time : what was drawn last time
+ * is kept and only the parts where an object has moved or changed, and the
+ * parts uncovered by a scroll, are drawn again.
+ * Objects are listed in flat buffers that are reused from one render to
+ * the next, so once they are big enough no memory is allocated.
+ */
+class MapRenderer {
 public:
-    ObjectToDraw() {
-        handleRelease();
-    }
+    /*!
+     * Numbers about the last render.
+     */
+    struct RenderStats {
+        /*! Opaque tiles looked at in the blocks covered by the screen.*/
+        int tilesVisited;
+        /*! Tiles drawn in the parts to redraw.*/
+        int tilesDrawn;
+        /*! Cells with objects on them.*/
+        int objectCells;
+        /*! Objects listed for drawing.*/
+        int objects;
+    };
 
-    void handleRelease() {
-        pObject_ = NULL;
-        pNext_ = NULL;
+    MapRenderer() : nbScreenRects_(0), redrawAll_(true), renderId_(0) {
+        lastViewport_.x = lastViewport_.y = 0;
+        stats_.tilesVisited = stats_.tilesDrawn = stats_.objectCells = stats_.objects = 0;
     }
 
-    MapObject * getObject() { return pObject_; }
-    ObjectToDraw * getNext() { return pNext_; }
+    void init(Mission *pMission, SquadSelection *pSelection);
 
-    void setObject(MapObject *pObj) { pObject_ = pObj; }
-    void setNext(ObjectToDraw *pNext) {
-        pNext_ = pNext;
-    }
-    void insertNext(ObjectToDraw *pNext) {
-        pNext->setNext(pNext_);
-        pNext_ = pNext;
-    }
+    void render(const Point2D &worldPos);
 
+    //! The given part of the screen will be redrawn by the next render
+    void addDirtyArea(int x, int y, int width, int height);
+    //! The whole map will be redrawn by the next render
+    void invalidate() { redrawAll_ = true; }
+    //! Returns numbers about the last render
+    const RenderStats & stats() const { return stats_; }
 
 private:
-    MapObject *pObject_;
-    ObjectToDraw *pNext_;
-};
-
-template<class T>
-class Pool {
-public:
-    Pool(int nbInitialRes) {
-        totalResourceCreated_ = 0;
-        for (int nbRes = 0; nbRes < nbInitialRes; nbRes++) {
-            pool_.push_back(new T());
-            totalResourceCreated_++;
-        }
-    }
-    ~Pool() {
-        for (typename std::list < T * >::iterator it = pool_.begin();
-         it != pool_.end(); it++) {
-             T * pRes = (*it);
-            delete pRes;
-            totalResourceCreated_--;
-        }
-
-        pool_.clear();
-
-        if (totalResourceCreated_ > 0) {
-            FSERR(Log::k_FLG_MEM, "Pool", "~Pool", ("There %d unfreed resource(s)", totalResourceCreated_));
-        }
+    /*! An object to draw during the current render.*/
+    struct ObjectToDraw {
+        MapObject *pObject;
+        /*! Drawing order of the cell where the object is drawn.*/
+        uint32 cellKey;
+        /*! Part of the screen covered by the object.*/
+        DirtyRect area;
     };
 
-    T * getResource() {
-        T *pResource = NULL;
-
-        if (pool_.empty()) {
-            pResource = new T();
-            totalResourceCreated_++;
-        } else {
-            pResource = pool_.front();
-            pool_.pop_front();
+    /*! What has been drawn for an object by the last render.*/
+    struct DrawnObject {
+        MapObject *pObject;
+        /*! Area covered by the object in map coordinates.*/
+        DirtyRect area;
+        /*! Frame of the object animation.*/
+        int frame;
+        /*! State of the object.*/
+        uint32 state;
+        /*! Id of the last render that drew the object.*/
+        uint32 renderId;
+
+        static bool isBefore(const DrawnObject &o1, const DrawnObject &o2) {
+            return o1.pObject < o2.pObject;
         }
+    };
 
-        pResource->setFree(false);
-        return pResource;
-    }
+    /*!
+     * The tiles are browsed twice : first to find where objects are and
+     * which parts of the map must be redrawn, then to redraw those parts.
+     */
+    enum ERenderPass {
+        kPassMeasure,
+        kPassDraw
+    };
 
-    void releaseResource(T * pResource) {
-        if (!pResource->isFree()) {
-            pResource->handleRelease();
-            pool_.push_back(pResource);
-            pResource->setFree(true);
+    /*!
+     * A cell of the map with objects to draw.
+     */
+    struct ObjectCell {
+        /*! Drawing order of the cell, see TileDrawList::cellKey().*/
+        uint32 key;
+        /*! Index of the first object of the cell in objects_.*/
+        int first;
+        /*! Number of objects on the cell.*/
+        int count;
+
+        static bool isBefore(const ObjectCell &c1, const ObjectCell &c2) {
+            return c1.key < c2.key;
         }
-    }
-
-private:
-    std::list<T *> pool_;
-    int totalResourceCreated_;
-};
-
-class MapRenderer {
-public:
-    MapRenderer() : pool_(10) {}
-
-    void init(Mission *pMission, SquadSelection *pSelection);
-
-    void render(const Point2D &worldPos);
+    };
 
-private:
-    /**
-     * Return a integer which is a hash for identifying easily
-     * a tile instead of use the 3 usual coordinates.
-     * \param tilePos
-     * \return int
+    /*!
+     * Limits of the cells browsed for a viewport. Cells are browsed in
+     * diagonals starting from the top left of the screen.
      */
-    static int tileHashKey(const TilePoint & tilePos) {
-        return tilePos.tx | (tilePos.ty << 8) | (tilePos.tz << 16);
-    }
+    struct SweepWindow {
+        /*! X coordinate of the cell at the top left of the screen.*/
+        int originX;
+        /*! First x coordinate.*/
+        int firstX;
+        /*! Range of x + y - originX.*/
+        int firstDiag, endDiag;
+        /*! First y coordinate.*/
+        int firstY;
+        /*! Range of x + y + z.*/
+        int firstSum, endSum;
+        /*! Range of the map coordinates of a cell.*/
+        int firstScreenX, endScreenX, firstScreenY, endScreenY;
+    };
 
-    //! Get the hashkey of the tile for the given object
-    static int tileHashKey(MapObject * m);
+    void setSweepWindow(const Point2D &viewport);
+    bool isCellInSweep(int x, int y, int z) const;
+    void listObjectCells();
+    void listVisibleTiles(const Point2D &viewport);
+    void renderTiles(const Point2D &viewport, ERenderPass pass);
+    //! Only defined with CHECK_DRAW_ORDER, see maprenderer.cpp
+    void checkDrawOrder(const Point2D &viewport);
+    void shiftScreen(const Point2D &viewport);
+    void measureObjectsOnTile(const ObjectCell &cell, const Point2D &screenPos,
+        const Point2D &viewport);
+    void drawTile(Tile *pTile, int x, int y);
 
     void listObjectsToDraw(const Point2D &viewport);
     bool isObjectInsideDrawingArea(MapObject *pObject, const Point2D &viewport);
-    int drawObjectsOnTile(const TilePoint & tilePos, const Point2D &screenPos);
+    int drawObjectsOnTile(const ObjectCell &cell, const Point2D &screenPos);
     void addObjectToDraw(MapObject *pObject);
-    void freeUnreleasedResources();
+    void sortObjectsByCell();
+    void sortObjectsOnCell(const ObjectCell &cell);
 
 private:
     Mission *pMission_;
     Map *pMap_;
     SquadSelection *pSelection_;
 
-    Pool<ObjectToDraw> pool_;
-    /*! This map contains for each tile the list of objects to draw.*/
-    std::map<int, ObjectToDraw *> objectsByTile_;
+    /*! Objects to draw sorted by cell, then from back to front.*/
+    std::vector<ObjectToDraw> objects_;
+    /*! Used to sort objects_.*/
+    std::vector<ObjectToDraw> sortBuffer_;
+    /*! What was drawn for each object by the last render, sorted by object.*/
+    std::vector<DrawnObject> drawnObjects_;
+    /*! What is drawn for each object by the current render.*/
+    std::vector<DrawnObject> newDrawnObjects_;
+    /*! Parts of the map to redraw in map coordinates.*/
+    DirtyArea dirtyArea_;
+    /*! Parts of the screen redrawn by the current render.*/
+    DirtyRect screenRects_[DirtyArea::kMaxRects];
+    int nbScreenRects_;
+    /*! True when the whole map must be redrawn.*/
+    bool redrawAll_;
+    /*! Viewport of the last render.*/
+    Point2D lastViewport_;
+    /*! Incremented at each render.*/
+    uint32 renderId_;
+    /*! Cells browsed by the current render.*/
+    SweepWindow sweep_;
+    /*! Cells with objects in drawing order.*/
+    std::vector<ObjectCell> objectCells_;
+    /*! Opaque tiles on screen in drawing order.*/
+    std::vector<TileDrawList::Entry> visibleTiles_;
+    RenderStats stats_;
 };
 
 #endif  // MENUS_MAPRENDERER_H_
@@ -68,69 +68,87 @@ MenuManager::~MenuManager()
  * \param loadIntroFont If true loads the intro sprites and font
  */
 bool MenuManager::initialize(bool loadIntroFont) {
-    bool res = false;
+    if (!loadMenuSprites()) {
+        return false;
+    }
+    if (loadIntroFont && !loadIntroFontSprites()) {
+        return false;
+    }
+    return loadFonts();
+}
+
+/*!
+ * Loads the sprites used by all menus.
+ */
+bool MenuManager::loadMenuSprites() {
     int size = 0, tabSize = 0;
     uint8 *data, *tabData;
 
-    // Loads menu sprites
-    LOG(Log::k_FLG_GFX, "MenuManager", "initialize", ("Loading menu sprites ..."))
+    LOG(Log::k_FLG_GFX, "MenuManager", "loadMenuSprites", ("Loading menu sprites ..."))
     tabData = File::loadOriginalFile("mspr-0.tab", tabSize);
     if (!tabData) {
-        FSERR(Log::k_FLG_UI, "MenuManager", "initialize", ("Failed reading file %s", "mspr-0.tab"));
+        FSERR(Log::k_FLG_UI, "MenuManager", "loadMenuSprites", ("Failed reading file %s", "mspr-0.tab"));
         return false;
     }
     data = File::loadOriginalFile("mspr-0.dat", size);
     if (!data) {
-        FSERR(Log::k_FLG_UI, "MenuManager", "initialize", ("Failed reading file %s", "mspr-0.dat"));
+        FSERR(Log::k_FLG_UI, "MenuManager", "loadMenuSprites", ("Failed reading file %s", "mspr-0.dat"));
         delete[] tabData;
         return false;
     }
 
-    res = menuSprites_.loadSprites(tabData, tabSize, data, true);
+    bool res = menuSprites_.loadSprites(tabData, tabSize, data, true);
     delete[] tabData;
     delete[] data;
     if (res) {
-        LOG(Log::k_FLG_GFX, "MenuManager", "initialize", ("%d sprites loaded", tabSize / 6))
+        LOG(Log::k_FLG_GFX, "MenuManager", "loadMenuSprites", ("%d sprites loaded", tabSize / 6))
     } else {
-        FSERR(Log::k_FLG_UI, "MenuManager", "initialize", ("Failed loading menu sprites"));
-        return false;
+        FSERR(Log::k_FLG_UI, "MenuManager", "loadMenuSprites", ("Failed loading menu sprites"));
     }
+    return res;
+}
 
-    // loads intro sprites
-    if (loadIntroFont) {
-        LOG(Log::k_FLG_GFX, "MenuManager", "initialize", ("Loading intro sprites ..."))
-
-        tabData = File::loadOriginalFile("mfnt-0.tab", tabSize);
-        if (!tabData) {
-            FSERR(Log::k_FLG_UI, "MenuManager", "initialize", ("Failed reading file %s", "mfnt-0.tab"));
-            return false;
-        }
-        data = File::loadOriginalFile("mfnt-0.dat", size);
-        if (!data) {
-            FSERR(Log::k_FLG_UI, "MenuManager", "initialize", ("Failed reading file %s", "mfnt-0.dat"));
-            delete[] tabData;
-            return false;
-        }
+/*!
+ * Loads the sprites of the font used by the intro.
+ */
+bool MenuManager::loadIntroFontSprites() {
+    int size = 0, tabSize = 0;
+    uint8 *data, *tabData;
 
-        pIntroFontSprites_ = new SpriteManager();
-        res = pIntroFontSprites_->loadSprites(tabData, tabSize, data, true);
+    LOG(Log::k_FLG_GFX, "MenuManager", "loadIntroFontSprites", ("Loading intro sprites ..."))
+    tabData = File::loadOriginalFile("mfnt-0.tab", tabSize);
+    if (!tabData) {
+        FSERR(Log::k_FLG_UI, "MenuManager", "loadIntroFontSprites", ("Failed reading file %s", "mfnt-0.tab"));
+        return false;
+    }
+    data = File::loadOriginalFile("mfnt-0.dat", size);
+    if (!data) {
+        FSERR(Log::k_FLG_UI, "MenuManager", "loadIntroFontSprites", ("Failed reading file %s", "mfnt-0.dat"));
         delete[] tabData;
-        delete[] data;
-        if (res) {
-            LOG(Log::k_FLG_GFX, "MenuManager", "initialize", ("%d sprites loaded", tabSize / 6))
-        } else {
-            FSERR(Log::k_FLG_UI, "MenuManager", "initialize", ("Failed loading intro sprites"));
-            return false;
-        }
+        return false;
     }
 
-    // Loads fonts
-    LOG(Log::k_FLG_GFX, "MenuManager", "initialize", ("Loading fonts ..."))
-    res = fonts_.loadFonts(&menuSprites_, pIntroFontSprites_);
-
+    pIntroFontSprites_ = new SpriteManager();
+    bool res = pIntroFontSprites_->loadSprites(tabData, tabSize, data, true);
+    delete[] tabData;
+    delete[] data;
+    if (res) {
+        LOG(Log::k_FLG_GFX, "MenuManager", "loadIntroFontSprites", ("%d sprites loaded", tabSize / 6))
+    } else {
+        FSERR(Log::k_FLG_UI, "MenuManager", "loadIntroFontSprites", ("Failed loading intro sprites"));
+    }
     return res;
 }
 
+/*!
+ * Creates the fonts from the menu sprites and intro sprites which must
+ * have been loaded.
+ */
+bool MenuManager::loadFonts() {
+    LOG(Log::k_FLG_GFX, "MenuManager", "loadFonts", ("Loading fonts ..."))
+    return fonts_.loadFonts(&menuSprites_, pIntroFontSprites_);
+}
+
 /*!
  * Destroy all menus and resources.
  */
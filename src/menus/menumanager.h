@@ -61,6 +61,12 @@ public:
     ~MenuManager();
 
     bool initialize(bool loadIntroFont);
+    //! Loads the sprites used by all menus
+    bool loadMenuSprites();
+    //! Loads the sprites of the intro font
+    bool loadIntroFontSprites();
+    //! Creates fonts once sprites are loaded
+    bool loadFonts();
 
     //! Destroy all menus and resources
     void destroy();
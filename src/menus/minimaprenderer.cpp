@@ -218,6 +218,7 @@ GamePlayMinimapRenderer::GamePlayMinimapRenderer() :
     mm_timer_weap(300, false), mm_timer_ped(260, false),
     mm_timer_signal(250) {
     p_mission_ = NULL;
+    b_draw_threats_ = false;
     handleClearSignal();
     g_gameCtrl.addListener(this, GameEvent::kMission);
 }
@@ -470,6 +471,10 @@ void GamePlayMinimapRenderer::render(uint16 screen_x, uint16 screen_y) {
         }
     }
 
+    if (b_draw_threats_) {
+        drawThreats(minimap_layer);
+    }
+
     // Draw the minimap cross
     drawFillRect(minimap_layer, cross_x_, 0, 1, (mm_maxtile_ + 1) * pixpertile_, fs_cmn::kColorBlack);
     drawFillRect(minimap_layer, 0, cross_y_, (mm_maxtile_ + 1) * pixpertile_, 1, fs_cmn::kColorBlack);
@@ -497,6 +502,34 @@ void GamePlayMinimapRenderer::render(uint16 screen_x, uint16 screen_y) {
     g_Screen.blit(screen_x, screen_y, kMiniMapSizePx, kMiniMapSizePx, minimap_final_layer);
 }
 
+/*!
+ * Tiles in range of an armed ped are red and tiles where only shots
+ * were heard are yellow. The higher the danger, the more pixels are drawn.
+ */
+void GamePlayMinimapRenderer::drawThreats(uint8 *a_minimap) {
+    const ThreatMap &threats = p_mission_->threats();
+    int rowSize = pixpertile_ * (mm_maxtile_ + 1);
+    for (int j = 0; j < mm_maxtile_; ++j) {
+        for (int i = 0; i < mm_maxtile_; ++i) {
+            int danger = threats.danger(world_tx_ + i, world_ty_ + j);
+            if (danger == 0) {
+                continue;
+            }
+            uint8 color = threats.hasArmedPedInRange(world_tx_ + i, world_ty_ + j) ?
+                fs_cmn::kColorLightRed : fs_cmn::kColorYellow;
+            bool full = danger >= ThreatMap::kArmedPedLevel;
+            uint8 *draw_base = a_minimap + (j + 1) * pixpertile_ * rowSize + (i + 1) * pixpertile_;
+            for (int y = 0; y < pixpertile_; ++y) {
+                for (int x = 0; x < pixpertile_; ++x) {
+                    if (full || ((x + y) & 1) == 0) {
+                        draw_base[y * rowSize + x] = color;
+                    }
+                }
+            }
+        }
+    }
+}
+
 void GamePlayMinimapRenderer::drawVehicles(uint8 *a_minimap) {
     for (size_t i = 0; i < p_mission_->numVehicles(); i++) {
         Vehicle *p_vehicle = p_mission_->vehicle(i);
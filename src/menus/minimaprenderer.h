@@ -168,6 +168,10 @@ class GamePlayMinimapRenderer : public MinimapRenderer, GameEventListener {
 
     //! Handles game events
     void handleGameEvent(GameEvent evt);
+
+    //! Shows or hides danger of the threat map (for debugging)
+    void setDrawThreats(bool draw) { b_draw_threats_ = draw; }
+    bool isDrawingThreats() { return b_draw_threats_; }
  protected:
 
     /*!
@@ -189,6 +193,8 @@ class GamePlayMinimapRenderer : public MinimapRenderer, GameEventListener {
     void drawWeapons(uint8 * a_minimap);
     //! Draw visible peds
     void drawPedestrians(uint8 * a_minimap);
+    //! Draw danger on visible tiles
+    void drawThreats(uint8 * a_minimap);
     /*!
      * Returns true if coords is visible on the map
      * \param tx tile coord in world coord.
@@ -316,6 +322,8 @@ class GamePlayMinimapRenderer : public MinimapRenderer, GameEventListener {
     fs_utils::BoolTimer mm_timer_ped;
     /*! Timer for the signal.*/
     fs_utils::Timer mm_timer_signal;
+    /*! If true, danger of the threat map is drawn.*/
+    bool b_draw_threats_;
 };
 
 #endif  // MENUS_MINIMAPRENDERER_H_
@@ -338,6 +338,9 @@ void SquadSelection::shootAt(const WorldPoint &aimedLocW) {
 /**
  * Return true if the given object is in the line of fire of at least
  * one selected agent.
+ * This is not a sight test shared between peds : it is only called for the
+ * target under the mouse and also checks objects in the line of fire, so
+ * it doesn't go through Perception.
  * \param pMission Mission*
  * \param pTarget ShootableMapObject*
  * \return bool
@@ -33,16 +33,54 @@
 #include "mission.h"
 #include "gfx/screen.h"
 #include "app.h"
+#include "appcontext.h"
 #include "model/objectivedesc.h"
 #include "utils/log.h"
 #include "model/vehicle.h"
 #include "model/squad.h"
 #include "model/shot.h"
+#include "pathworkers.h"
+#include "surfacecache.h"
+#include "utils/ccrc32.h"
+#include "utils/timer.h"
+#include "utils/profiler.h"
+
+// Define this to also check lines with the former sampling
+// implementation of checkBlockedByTile() and log when verdicts differ
+//#define CHECK_BLOCKED_BY_TILE
 
 const uint8 Mission::kBMaskBlockerTargetOutOfMap = 0x20;
 const uint8 Mission::kBMaskBlockerTargetObjectUpdated = 0x02;
 const uint8 Mission::kBMaskBlockerTargetPosUpdated = 0x04;
 
+void SimProfile::reset() {
+    nbSteps = 0;
+    totalTime = 0;
+    for (int i = 0; i < kNbParts; i++) {
+        partTime[i] = 0;
+    }
+}
+
+/*!
+ * Adds to the given part the time elapsed since lastTime.
+ * \param part The part that has just been run
+ * \param lastTime Time when the part started
+ * \return The current time so it can be used for the next part
+ */
+uint64 SimProfile::addTime(EPart part, uint64 lastTime) {
+    uint64 now = fs_utils::microTime();
+    partTime[part] += now - lastTime;
+    return now;
+}
+
+const char *SimProfile::partName(int part) {
+    static const char *names[kNbParts] = {
+        "objectives", "sfx", "peds", "path_results", "vehicles",
+        "weapons", "statics", "shots", "squad"
+    };
+    return part >= 0 && part < kNbParts ? names[part] : "unknown";
+}
+
 /*!
  * Initialize the statistics.
  * \param nbAgents Number of agents for the mission
@@ -67,7 +105,8 @@ Mission::Mission(const LevelData::MapInfos & map_infos)
 
     mtsurfaces_ = NULL;
     mdpoints_ = NULL;
-    mdpoints_cp_ = NULL;
+    p_path_workers_ = NULL;
+    memset(&surfaceKey_, 0, sizeof(surfaceKey_));
     i_map_id_ = READ_LE_UINT16(map_infos.map);
     p_map_ = NULL;
     min_x_= READ_LE_UINT16(map_infos.min_x) / 2;
@@ -81,6 +120,13 @@ Mission::Mission(const LevelData::MapInfos & map_infos)
 
 Mission::~Mission()
 {
+    // objects are deleted below
+    objectsGrid_.clear();
+    // workers may still reference peds
+    if (p_path_workers_) {
+        delete p_path_workers_;
+        p_path_workers_ = NULL;
+    }
     for (unsigned int i = 0; i < vehicles_.size(); i++)
         delete vehicles_[i];
     for (unsigned int i = 0; i < peds_.size(); i++)
@@ -97,12 +143,17 @@ Mission::~Mission()
     for (unsigned int i = 0; i < objectives_.size(); i++)
         delete objectives_[i];
     armedPedsVec_.clear();
+    mdregions_.logStats();
     clrSurfaces();
 
     if (p_minimap_) {
         delete p_minimap_;
     }
 
+    if (p_map_) {
+        g_App.maps().releaseMap(p_map_->id());
+    }
+
     if (p_squad_) {
         delete p_squad_;
     }
@@ -121,6 +172,7 @@ void Mission::removeArmedPed(PedInstance *pPed) {
     for (size_t i = 0; i < armedPedsVec_.size();  i++) {
         if (pPed == armedPedsVec_[i]) {
             armedPedsVec_.erase(armedPedsVec_.begin() + i);
+            threats_.removeArmedPed(pPed);
             break;
         }
     }
@@ -144,6 +196,11 @@ void Mission::objectiveMsg(std::string& msg) {
  */
 void Mission::set_map(Map *p_map) {
     if (p_map) {
+        // the map must stay in the cache while the mission is played
+        g_App.maps().holdMap(p_map->id());
+        if (p_map_) {
+            g_App.maps().releaseMap(p_map_->id());
+        }
         p_map_ = p_map;
         p_map_->mapDimensions(&mmax_x_, &mmax_y_, &mmax_z_);
 
@@ -169,6 +226,11 @@ void Mission::start()
     LOG(Log::k_FLG_GAME, "Mission", "start()", ("Start mission"));
     // Reset mission statistics
     stats_.init(p_squad_->size());
+    perception_.reset();
+    threats_.init(p_map_->maxX(), p_map_->maxY());
+    for (size_t i = 0; i < armedPedsVec_.size(); i++) {
+        threats_.addArmedPed(armedPedsVec_[i]);
+    }
 
     cur_objective_ = 0;
 
@@ -250,6 +312,144 @@ void Mission::checkObjectives() {
     }
 }
 
+/*!
+ * Runs one step of the mission simulation : objectives, animation of
+ * all objects and IPA levels of agents.
+ * \param elapsed Duration of the step
+ * \param pProfile If not NULL, receives the time spent in each part
+ * \return True if something has changed on screen
+ */
+bool Mission::simulateStep(int elapsed, SimProfile *pProfile)
+{
+    PROFILE_ZONE("Mission::simulateStep");
+    uint64 startTime = pProfile ? fs_utils::microTime() : 0;
+    uint64 lastTime = startTime;
+    bool change = false;
+
+    if (!completed() && !failed()) {
+        // Update stats
+        stats_.incrMissionDuration(elapsed);
+
+        // Checks mission objectives
+        checkObjectives();
+    }
+    if (pProfile)
+        lastTime = pProfile->addTime(SimProfile::kPartObjectives, lastTime);
+
+    for (size_t i = 0; i < sfx_objects_.size(); i++) {
+        SFXObject *pSfx = sfx_objects_[i];
+        change |= pSfx->animate(elapsed);
+        if (pSfx->sfxLifeOver()) {
+            delSfxObject(i);
+            i--;
+        }
+    }
+    if (pProfile)
+        lastTime = pProfile->addTime(SimProfile::kPartSfx, lastTime);
+
+    // paths requested by peds during the previous step are given just
+    // before peds move, so workers have searched them while the end of
+    // the previous step and the frame were processed
+    applyPathResults();
+    if (pProfile)
+        lastTime = pProfile->addTime(SimProfile::kPartPathResults, lastTime);
+
+    perception_.update(elapsed);
+    threats_.update(elapsed);
+    for (size_t i = 0; i < peds_.size(); i++)
+        change |= peds_[i]->animate(elapsed, this);
+    if (pProfile)
+        lastTime = pProfile->addTime(SimProfile::kPartPeds, lastTime);
+
+    for (size_t i = 0; i < vehicles_.size(); i++)
+        change |= vehicles_[i]->animate(elapsed);
+    if (pProfile)
+        lastTime = pProfile->addTime(SimProfile::kPartVehicles, lastTime);
+
+    for (size_t i = 0; i < weaponsOnGround_.size(); i++)
+        change |= weaponsOnGround_[i]->animate(elapsed);
+    if (pProfile)
+        lastTime = pProfile->addTime(SimProfile::kPartWeapons, lastTime);
+
+    for (size_t i = 0; i < statics_.size(); i++)
+        change |= statics_[i]->animate(elapsed, this);
+    if (pProfile)
+        lastTime = pProfile->addTime(SimProfile::kPartStatics, lastTime);
+
+    for (size_t i = 0; i < prj_shots_.size(); i++) {
+        change |= prj_shots_[i]->animate(elapsed, this);
+        if (prj_shots_[i]->isLifeOver()) {
+            delPrjShot(i);
+            i--;
+        }
+    }
+    if (pProfile)
+        lastTime = pProfile->addTime(SimProfile::kPartShots, lastTime);
+
+    for (size_t agent = 0; agent < AgentManager::kMaxSlot; ++agent) {
+        PedInstance *ped = p_squad_->member(agent);
+        if (ped && ped->isAlive())
+            ped->updtIPATime(elapsed);
+    }
+
+    if (pProfile) {
+        lastTime = pProfile->addTime(SimProfile::kPartSquad, lastTime);
+        pProfile->nbSteps++;
+        pProfile->totalTime += lastTime - startTime;
+    }
+
+    return change;
+}
+
+/*!
+ * Adds the given value to a FNV-1a hash.
+ */
+static void hashValue(uint32 *pHash, int value) {
+    for (int i = 0; i < 4; i++) {
+        *pHash ^= (value >> (i * 8)) & 0xFF;
+        *pHash *= 16777619u;
+    }
+}
+
+/*!
+ * Computes a checksum of position, health and inventory of all peds and
+ * position and health of all vehicles. Two runs of a mission that went the
+ * same way give the same checksum.
+ */
+uint32 Mission::stateChecksum()
+{
+    uint32 hash = 2166136261u;
+    for (size_t i = 0; i < peds_.size(); i++) {
+        PedInstance *pPed = peds_[i];
+        const TilePoint &pos = pPed->position();
+        hashValue(&hash, pos.tx);
+        hashValue(&hash, pos.ty);
+        hashValue(&hash, pos.tz);
+        hashValue(&hash, pos.ox);
+        hashValue(&hash, pos.oy);
+        hashValue(&hash, pos.oz);
+        hashValue(&hash, pPed->health());
+        hashValue(&hash, pPed->numWeapons());
+        for (uint8 w = 0; w < pPed->numWeapons(); w++) {
+            hashValue(&hash, pPed->weapon(w)->getClass()->getType());
+            hashValue(&hash, pPed->weapon(w)->ammoRemaining());
+        }
+    }
+
+    for (size_t i = 0; i < vehicles_.size(); i++) {
+        const TilePoint &pos = vehicles_[i]->position();
+        hashValue(&hash, pos.tx);
+        hashValue(&hash, pos.ty);
+        hashValue(&hash, pos.tz);
+        hashValue(&hash, pos.ox);
+        hashValue(&hash, pos.oy);
+        hashValue(&hash, vehicles_[i]->health());
+    }
+
+    hashValue(&hash, (int) weaponsOnGround_.size());
+    return hash;
+}
+
 /*!
  * Ends the mission with the given status.
  * \param status The ending status
@@ -295,6 +495,8 @@ void Mission::transferWeaponsFromPedInstanceToAgent(PedInstance* p, Agent* pAg)
 void Mission::end()
 {
     LOG(Log::k_FLG_GAME, "Mission", "end()", ("End mission"));
+    p_map_->roadGraph().logStats();
+    perception_.logStats();
     for (unsigned int i = p_squad_->size(); i < peds_.size(); i++) {
         PedInstance *p = peds_[i];
         // TODO: influence country happiness with number of killed overall
@@ -360,43 +562,66 @@ void Mission::addWeaponToGround(WeaponInstance * w)
             return;
     }
     weaponsOnGround_.push_back(w);
+    objectsGrid_.add(w);
 }
 
 void Mission::removeWeaponOnGround(WeaponInstance *pWeapon) {
     for (unsigned int i = 0; i < weaponsOnGround_.size(); i++) {
         if (weaponsOnGround_[i] == pWeapon) {
             weaponsOnGround_.erase(weaponsOnGround_.begin() + i);
+            objectsGrid_.remove(pWeapon);
         }
     }
 }
 
+void Mission::addPed(PedInstance *p) {
+    peds_.push_back(p);
+    objectsGrid_.add(p);
+}
+
+void Mission::addVehicle(Vehicle *pVehicle) {
+    vehicles_.push_back(pVehicle);
+    objectsGrid_.add(pVehicle);
+}
+
+void Mission::addStatic(Static *pStatic) {
+    statics_.push_back(pStatic);
+    objectsGrid_.add(pStatic);
+}
+
 MapObject * Mission::findObjectWithNatureAtPos(int tilex, int tiley, int tilez,
                             MapObject::ObjectNature *nature, int *searchIndex,
                             bool only) {
 
+    // searchIndex is the order in the grid of the next object to look at
     const TilePoint position(tilex, tiley, tilez);
     switch(*nature) {
         case MapObject::kNaturePed:
-            for (unsigned int i = *searchIndex; i < peds_.size(); i++) {
+            objectsGrid_.findAtTile(position, MapObject::kNaturePed, tileObjectsVec_);
+            for (size_t i = 0; i < tileObjectsVec_.size(); i++) {
+                MapObject *pPed = tileObjectsVec_[i];
                 // dead peds are included because doors stay opened even with dead corpses
                 // it also prevents glitches with a closed door over a dead body
-                if (peds_[i]->sameTile(position)) {
-                    *searchIndex = i + 1;
+                if (pPed->gridOrder() >= (uint32) *searchIndex && pPed->sameTile(position)) {
+                    *searchIndex = pPed->gridOrder() + 1;
                     *nature = MapObject::kNaturePed;
-                    return peds_[i];
+                    return pPed;
                 }
             }
             if(only)
                 return NULL;
             *searchIndex = 0;
         case MapObject::kNatureVehicle:
-            for (unsigned int i = *searchIndex; i < vehicles_.size(); i++)
-                if (vehicles_[i]->sameTile(position))
+            objectsGrid_.findAtTile(position, MapObject::kNatureVehicle, tileObjectsVec_);
+            for (size_t i = 0; i < tileObjectsVec_.size(); i++) {
+                MapObject *pVehicle = tileObjectsVec_[i];
+                if (pVehicle->gridOrder() >= (uint32) *searchIndex && pVehicle->sameTile(position))
                 {
-                    *searchIndex = i + 1;
+                    *searchIndex = pVehicle->gridOrder() + 1;
                     *nature = MapObject::kNatureVehicle;
-                    return vehicles_[i];
+                    return pVehicle;
                 }
+            }
             break;
         default:
             FSERR(Log::k_FLG_GAME, "Mission", "findObjectWithNatureAtPos", ("Undefined nature %i\n", *nature));
@@ -444,8 +669,7 @@ bool Mission::setSurfaces() {
     int mmax_m_all = mmax_x_ * mmax_y_ * mmax_z_;
     mtsurfaces_ = (uint8 *)malloc(mmax_m_all * sizeof(uint8));
     mdpoints_ = (floodPointDesc *)malloc(mmax_m_all * sizeof(floodPointDesc));
-    mdpoints_cp_ = (floodPointDesc *)malloc(mmax_m_all * sizeof(floodPointDesc));
-    if(mtsurfaces_ == NULL || mdpoints_ == NULL || mdpoints_cp_ == NULL) {
+    if(mtsurfaces_ == NULL || mdpoints_ == NULL) {
         clrSurfaces();
         FSERR(Log::k_FLG_GAME, "Mission", "setSurfaces", ("Memory allocation error\n"));
         return false;
@@ -453,13 +677,11 @@ bool Mission::setSurfaces() {
     mmax_m_xy = mmax_x_ * mmax_y_;
     memset((void *)mtsurfaces_, 0, mmax_m_all * sizeof(uint8));
     memset((void *)mdpoints_, 0, mmax_m_all * sizeof(floodPointDesc));
-    for (int ix = 0; ix < mmax_x_; ++ix) {
-        for (int iy = 0; iy < mmax_y_; ++iy) {
-            for (int iz = 0; iz < mmax_z_; ++iz) {
-                mtsurfaces_[ix + iy * mmax_x_ + iz * mmax_m_xy] =
-                    p_map_->getTileAt(ix, iy, iz)->getWalkData();
-            }
-        }
+    // the map stores its cells in the same order as the surfaces
+    const uint8 *tileIds = p_map_->tileIds();
+    TileManager *pTileMgr = p_map_->tileManager();
+    for (int i = 0; i < mmax_m_all; ++i) {
+        mtsurfaces_[i] = pTileMgr->walkData(tileIds[i]);
     }
 
     // to make surfaces where large doors are located walkable
@@ -489,16 +711,60 @@ bool Mission::setSurfaces() {
     //printf("surface data size %i\n", sizeof(surfaceDesc) * mmax_m_all);
     //printf("flood data size %i\n", sizeof(floodPointDesc) * mmax_m_all);
 
+    // walkable tiles are found from the tiles where peds stand
+    std::vector<TilePoint> seeds;
     for (unsigned int i = 0; i < peds_.size(); ++i) {
         PedInstance *p = peds_[i];
-        int x = p->tileX();
-        int y = p->tileY();
-        int z = p->tileZ();
-        if (z >= mmax_z_ || z < 0 || p->isDead()) {
+        if (p->tileZ() >= mmax_z_ || p->tileZ() < 0 || p->isDead()) {
             // TODO : check on all maps those peds correct position
             p->setTileZ(mmax_z_ - 1);
             continue;
         }
+        seeds.push_back(p->position());
+    }
+
+    CCRC32 crc;
+    surfaceKey_.mapId = i_map_id_;
+    surfaceKey_.maxX = mmax_x_;
+    surfaceKey_.maxY = mmax_y_;
+    surfaceKey_.maxZ = mmax_z_;
+    surfaceKey_.surfacesCrc = crc.FullCRC(mtsurfaces_, mmax_m_all);
+    surfaceKey_.seedsCrc = 0;
+    for (size_t i = 0; i < seeds.size(); i++) {
+        int32 tile[3] = { seeds[i].tx, seeds[i].ty, seeds[i].tz };
+        crc.PartialCRC(&surfaceKey_.seedsCrc, (const unsigned char *) tile, sizeof(tile));
+    }
+
+    if (!SurfaceCache::find(surfaceKey_, mdpoints_)) {
+        floodSurfaces(seeds);
+        SurfaceCache::store(surfaceKey_, mdpoints_);
+    }
+
+    // the search mirror is copied once, afterwards each search restores
+    // only the nodes it has modified
+    if (!mdsearch_.flood.allocate(mdpoints_, mmax_m_all)) {
+        clrSurfaces();
+        FSERR(Log::k_FLG_GAME, "Mission", "setSurfaces", ("Memory allocation error\n"));
+        return false;
+    }
+    // a failure here only means path finding will not be sped up
+    mdregions_.build(mdpoints_, mmax_x_, mmax_y_, mmax_z_);
+    // built once for the map, vehicles search their routes with it
+    get_map()->roadGraph();
+    return true;
+}
+
+/*!
+ * Defines the directions in which peds can move from each tile that
+ * can be reached from the given tiles.
+ * \param seeds Tiles where the flood starts
+ */
+void Mission::floodSurfaces(const std::vector<TilePoint> &seeds) {
+    int mmax_m_all = mmax_x_ * mmax_y_ * mmax_z_;
+    for (size_t i = 0; i < seeds.size(); ++i) {
+        int x = seeds[i].tx;
+        int y = seeds[i].ty;
+        int z = seeds[i].tz;
         if (mdpoints_[x + y * mmax_x_ + z * mmax_m_xy].bfNodeDesc == m_fdNotDefined) {
             WorldPoint stodef;
             std::vector<WorldPoint> vtodefine;
@@ -2215,7 +2481,34 @@ bool Mission::setSurfaces() {
 
     printf("flood walkables %i\n", cw);
 #endif
-    return true;
+}
+
+/*!
+ * Returns the pool of threads that search paths for peds.
+ * Pool is created on first call if configuration asks for path workers.
+ * \return NULL if paths must be searched in the main thread.
+ */
+PathWorkers * Mission::pathWorkers() {
+    if (p_path_workers_ == NULL && g_Ctx.getPathWorkers() > 0 && mdpoints_ != NULL) {
+        p_path_workers_ = new PathWorkers(this);
+        if (!p_path_workers_->start(g_Ctx.getPathWorkers())) {
+            FSERR(Log::k_FLG_GAME, "Mission", "pathWorkers", ("Cannot start path workers, paths are searched in main thread\n"));
+            delete p_path_workers_;
+            p_path_workers_ = NULL;
+            g_Ctx.setPathWorkers(0);
+        }
+    }
+
+    return p_path_workers_;
+}
+
+/*!
+ * Gives peds the paths they requested since last call.
+ */
+void Mission::applyPathResults() {
+    if (p_path_workers_) {
+        p_path_workers_->applyResults();
+    }
 }
 
 void Mission::clrSurfaces() {
@@ -2228,10 +2521,15 @@ void Mission::clrSurfaces() {
         free(mdpoints_);
         mdpoints_ = NULL;
     }
-    if(mdpoints_cp_ != NULL) {
-        free(mdpoints_cp_);
-        mdpoints_cp_ = NULL;
+    if (p_path_workers_) {
+        // workers use the surfaces
+        delete p_path_workers_;
+        p_path_workers_ = NULL;
     }
+    mdsearch_.flood.release();
+    mdsearch_.astar.release();
+    mdsearch_.corridor.stamps.clear();
+    mdregions_.clear();
 }
 
 /*!
@@ -2475,25 +2773,6 @@ MapObject * Mission::checkBlockedByObject(WorldPoint * pStartPt, WorldPoint * pE
     double closest = *dist;
     MapObject *pBlocker = NULL;
 
-    for (unsigned int i = 0; i < statics_.size(); ++i) {
-        Static * s_blocker = statics_[i];
-        if (s_blocker->isExcludedFromBlockers())
-            continue;
-        if (s_blocker->isBlocker(&copyStartPt, &copyEndPt, inc_xyz)) {
-            int cx = pStartPt->x - copyStartPt.x;
-            int cy = pStartPt->y - copyStartPt.y;
-            int cz = pStartPt->z - copyStartPt.z;
-            double dist_blocker = sqrt((double) (cx * cx + cy * cy + cz * cz));
-            if (closest == -1 || dist_blocker < closest) {
-                closest = dist_blocker;
-                pBlocker = s_blocker;
-                blockStartPt = copyStartPt;
-                blockEndPt = copyEndPt;
-            }
-            copyStartPt = *pStartPt;
-            copyEndPt = *pEndPt;
-        }
-    }
     // if shooter is a Ped and is shooting from a vehicle,
     // then skip that vehicle in the search
     Vehicle *pShooterVehicle = NULL;
@@ -2501,57 +2780,50 @@ MapObject * Mission::checkBlockedByObject(WorldPoint * pStartPt, WorldPoint * pE
         const PedInstance *pPed = static_cast<const PedInstance *>(pOrigin);
         pShooterVehicle = pPed->inVehicle(); // can be null
     }
-    for (unsigned int i = 0; i < vehicles_.size(); ++i) {
-        Vehicle * pVehicle = vehicles_[i];
-        if (pVehicle != pShooterVehicle) {
-            if (pVehicle->isBlocker(&copyStartPt, &copyEndPt, inc_xyz)) {
-                int cx = pStartPt->x - copyStartPt.x;
-                int cy = pStartPt->y - copyStartPt.y;
-                int cz = pStartPt->z - copyStartPt.z;
-                double dist_blocker = sqrt((double) (cx * cx + cy * cy + cz * cz));
-                if (closest == -1 || dist_blocker < closest) {
-                    closest = dist_blocker;
-                    pBlocker = pVehicle;
-                    blockStartPt = copyStartPt;
-                    blockEndPt = copyEndPt;
-                }
-                copyStartPt = *pStartPt;
-                copyEndPt = *pEndPt;
+
+    // only objects near the line are looked at, by nature in that order
+    static const MapObject::ObjectNature kNaturesOrder[] = {
+        MapObject::kNatureStatic, MapObject::kNatureVehicle,
+        MapObject::kNaturePed, MapObject::kNatureWeapon
+    };
+    objectsGrid_.findNearLine(*pStartPt, *pEndPt, MapObject::kNatureStatic
+        | MapObject::kNatureVehicle | MapObject::kNaturePed | MapObject::kNatureWeapon,
+        blockersVec_);
+
+    for (int n = 0; n < 4; n++) {
+        for (size_t i = 0; i < blockersVec_.size(); ++i) {
+            MapObject *pObject = blockersVec_[i];
+            if (!pObject->is(kNaturesOrder[n])) {
+                continue;
             }
-        }
-    }
 
-    for (unsigned int i = 0; i < peds_.size(); ++i) {
-        PedInstance * p_blocker = peds_[i];
-        if (p_blocker->isAlive() && p_blocker != pOrigin && p_blocker->inVehicle() == NULL) {
-            if (p_blocker->isBlocker(&copyStartPt, &copyEndPt, inc_xyz)) {
-                int cx = pStartPt->x - copyStartPt.x;
-                int cy = pStartPt->y - copyStartPt.y;
-                int cz = pStartPt->z - copyStartPt.z;
-                double dist_blocker = sqrt((double) (cx * cx + cy * cy + cz * cz));
-                if (closest == -1 || dist_blocker < closest) {
-                    closest = dist_blocker;
-                    pBlocker = p_blocker;
-                    blockStartPt = copyStartPt;
-                    blockEndPt = copyEndPt;
+            bool canBlock = true;
+            switch (kNaturesOrder[n]) {
+            case MapObject::kNatureStatic:
+                canBlock = !static_cast<Static *>(pObject)->isExcludedFromBlockers();
+                break;
+            case MapObject::kNatureVehicle:
+                canBlock = pObject != pShooterVehicle;
+                break;
+            case MapObject::kNaturePed:
+                {
+                    PedInstance *p_blocker = static_cast<PedInstance *>(pObject);
+                    canBlock = p_blocker->isAlive() && p_blocker != pOrigin && p_blocker->inVehicle() == NULL;
                 }
-                copyStartPt = *pStartPt;
-                copyEndPt = *pEndPt;
+                break;
+            default:
+                canBlock = !static_cast<WeaponInstance *>(pObject)->hasOwner();
+                break;
             }
-        }
-    }
 
-    for (unsigned int i = 0; i < weaponsOnGround_.size(); ++i) {
-        WeaponInstance *pWeapon = weaponsOnGround_[i];
-        if (!pWeapon->hasOwner()) {
-            if (pWeapon->isBlocker(&copyStartPt, &copyEndPt, inc_xyz)) {
+            if (canBlock && pObject->isBlocker(&copyStartPt, &copyEndPt, inc_xyz)) {
                 int cx = pStartPt->x - copyStartPt.x;
                 int cy = pStartPt->y - copyStartPt.y;
                 int cz = pStartPt->z - copyStartPt.z;
                 double dist_blocker = sqrt((double) (cx * cx + cy * cy + cz * cz));
                 if (closest == -1 || dist_blocker < closest) {
                     closest = dist_blocker;
-                    pBlocker = pWeapon;
+                    pBlocker = pObject;
                     blockStartPt = copyStartPt;
                     blockEndPt = copyEndPt;
                 }
@@ -2570,46 +2842,20 @@ MapObject * Mission::checkBlockedByObject(WorldPoint * pStartPt, WorldPoint * pE
 }
 
 /*!
- * Verify that the path from originPosW to pTargetPosW is not blocked by a tile.
- * If such a tile exists, pTargetPosW is updated with the position of the blocking tile.
- * \param originPosW Path starting point
- * \param pTargetPosW Path end point
- * \param updateLoc Set to true to update pTargetPosW when blocking tile is found
- * \param distanceMax Maximum distance we cannot cross. If distanceMax is
- *   reached before pTargetPosW, then path is stopped.
- * \param pInitialDistance This is the distance between origin and initial target position
- * \return a bitmask indicating the type of result:
- *      - 0b(1) : target in range
- *      - 3b(8) : distanceMax is reached
- *      - 4b(16): blocker tile, "pTargetLoc" is set
- *      - 5b(32): out of visible reach
+ * Former implementation of Mission::checkBlockedByTile() that samples the
+ * line every 8 units. Kept to compare verdicts with the tile traversal.
+ * pTargetPosW is updated as when updateLoc is true.
  */
-uint8 Mission::checkBlockedByTile(const WorldPoint & originPosW, WorldPoint *pTargetPosW,
-                                  bool updateLoc, double distanceMax, double *pInitialDistance) {
-    // TODO: some objects mid point is higher then map z
-    assert(distanceMax >= 0);
-
+uint8 Mission::checkBlockedByTileSampled(const WorldPoint & originPosW, WorldPoint *pTargetPosW,
+                                  double distanceMax) {
     int cx = originPosW.x;
     int cy = originPosW.y;
     int cz = originPosW.z;
-    if (cz > (mmax_z_ - 1) * 128)
-        return kBMaskBlockerTargetOutOfMap;
-
-    // This variable will store the target location as it may moves if
-    // a tile blocks the path.
     WorldPoint tmpTargetWLoc = *pTargetPosW;
 
-    if (tmpTargetWLoc.z > (mmax_z_ - 1) * 128)
-        return kBMaskBlockerTargetOutOfMap;
-
-    // This is the distance between the origin and the target
-    double distanceToTarget = 0;
-    distanceToTarget = sqrt((double)((tmpTargetWLoc.x - cx) * (tmpTargetWLoc.x - cx) + (tmpTargetWLoc.y - cy) * (tmpTargetWLoc.y - cy)
+    double distanceToTarget = sqrt((double)((tmpTargetWLoc.x - cx) * (tmpTargetWLoc.x - cx) + (tmpTargetWLoc.y - cy) * (tmpTargetWLoc.y - cy)
         + (tmpTargetWLoc.z - cz) * (tmpTargetWLoc.z - cz)));
     uint8 block_mask = 1;
-
-    if (pInitialDistance)
-        *pInitialDistance = distanceToTarget;
     if (distanceToTarget == 0)
         return block_mask;
 
@@ -2618,26 +2864,15 @@ uint8 Mission::checkBlockedByTile(const WorldPoint & originPosW, WorldPoint *pTa
     double sz = (double) cz;
 
     if (distanceToTarget >= distanceMax) {
-        // the distance we have to cross (distanceToTarget) is higher than the maximum
-        // distance we are allowed to cross (distanceMax)
-
-        // update target position according to distanceMax
         double dist_k = (double)distanceMax / distanceToTarget;
         tmpTargetWLoc.x = cx + (int)((tmpTargetWLoc.x - cx) * dist_k);
         tmpTargetWLoc.y = cy + (int)((tmpTargetWLoc.y - cy) * dist_k);
         tmpTargetWLoc.z = cz + (int)((tmpTargetWLoc.z - cz) * dist_k);
-        // set mask to indicate distanceMax is reached
         block_mask = 8;
-        if (updateLoc) {
-            *pTargetPosW = tmpTargetWLoc;
-        }
+        *pTargetPosW = tmpTargetWLoc;
         distanceToTarget = distanceMax;
     }
 
-    // NOTE: these values are less then 1.
-    // If they are incremented, time required to check range will be shorter but less precise check,
-    // If decremented longer but more precise.
-    // Increment is (n * 8)
     double incrX = ((tmpTargetWLoc.x - cx) * 8) / distanceToTarget;
     double incrY = ((tmpTargetWLoc.y - cy) * 8) / distanceToTarget;
     double incrZ = ((tmpTargetWLoc.z - cz) * 8) / distanceToTarget;
@@ -2646,7 +2881,6 @@ uint8 Mission::checkBlockedByTile(const WorldPoint & originPosW, WorldPoint *pTa
     int oldy = cy / 256;
     int oldz = cz / 128;
     double dist_close = distanceToTarget;
-    // look note before, should be same increment
     double dist_dec = 1.0 * 8;
 
     while (dist_close > dist_dec) {
@@ -2685,23 +2919,10 @@ uint8 Mission::checkBlockedByTile(const WorldPoint & originPosW, WorldPoint *pTa
                     sx -= incrX;
                     sy -= incrY;
                     sz -= incrZ;
-                    double dsx = sx - (double)cx;
-                    double dsy = sy - (double)cy;
-                    double dsz = sz - (double)cz;
-                    tmpTargetWLoc.x = (int)sx;
-                    tmpTargetWLoc.y = (int)sy;
-                    tmpTargetWLoc.z = (int)sz;
-                    dist_close = sqrt(dsx * dsx + dsy * dsy + dsz * dsz);
-                    // set mask to indicate path is blocked by a tile
-                    if (block_mask == 1)
-                        block_mask = 16;
-                    else
-                        block_mask |= 16;
-                    if (updateLoc) {
-                        pTargetPosW->x = (int)sx;
-                        pTargetPosW->y = (int)sy;
-                        pTargetPosW->z = (int)sz;
-                    }
+                    block_mask = block_mask == 1 ? 16 : block_mask | 16;
+                    pTargetPosW->x = (int)sx;
+                    pTargetPosW->y = (int)sy;
+                    pTargetPosW->z = (int)sz;
                     break;
                 }
             }
@@ -2713,7 +2934,287 @@ uint8 Mission::checkBlockedByTile(const WorldPoint & originPosW, WorldPoint *pTa
         sy += incrY;
         sz += incrZ;
         dist_close -= dist_dec;
-    } // end while
+    }
+
+    return block_mask;
+}
+
+/*!
+ * Returns the highest offset on z that is inside a slope tile at the given
+ * offsets on x and y.
+ */
+static inline int slopeHeight(unsigned char twd, int offx, int offy) {
+    switch (twd) {
+        case 0x01:
+            return 127 - (offy >> 1);
+        case 0x02:
+            return offy >> 1;
+        case 0x03:
+            return offx >> 1;
+        default: // 0x04
+            return 127 - (offx >> 1);
+    }
+}
+
+/*!
+ * Returns how high the point is above the slope of the given tile.
+ * Points on the tile borders are brought back inside the tile.
+ * \return a value <= 0 if point is inside the slope.
+ */
+static inline int heightAboveSlope(unsigned char twd, const WorldPoint &pt,
+                                   int tileX, int tileY, int tileZ) {
+    int offx = pt.x - tileX * 256;
+    int offy = pt.y - tileY * 256;
+    int offz = pt.z - tileZ * 128;
+    offx = offx < 0 ? 0 : (offx > 255 ? 255 : offx);
+    offy = offy < 0 ? 0 : (offy > 255 ? 255 : offy);
+    offz = offz < 0 ? 0 : (offz > 127 ? 127 : offz);
+    return offz - slopeHeight(twd, offx, offy);
+}
+
+/*!
+ * Position on the line at t = num / den.
+ */
+static inline void pointOnLine(const WorldPoint &origin, int dx, int dy, int dz,
+                                int64 num, int64 den, WorldPoint *pPoint) {
+    pPoint->x = origin.x + (int)(dx * num / den);
+    pPoint->y = origin.y + (int)(dy * num / den);
+    pPoint->z = origin.z + (int)(dz * num / den);
+}
+
+/*!
+ * Walks through the tiles crossed by the line from originPosW to targetPosW,
+ * each tile being visited once (Amanatides & Woo traversal).
+ * The line crosses a tile boundary on an axis at t = num / den where
+ * den is the length of the line on that axis : crossings are compared
+ * with integers by cross multiplication.
+ * As before, the tile of the origin is only checked if it's a slope.
+ * \param originPosW Line starting point
+ * \param targetPosW Line end point
+ * \param pHitPosW Set with the point where line enters a blocking tile
+ * \return true if a tile blocks the line.
+ */
+bool Mission::findBlockingTile(const WorldPoint & originPosW, const WorldPoint & targetPosW,
+                               WorldPoint *pHitPosW) {
+    int dx = targetPosW.x - originPosW.x;
+    int dy = targetPosW.y - originPosW.y;
+    int dz = targetPosW.z - originPosW.z;
+
+    int tileX = originPosW.x / 256;
+    int tileY = originPosW.y / 256;
+    int tileZ = originPosW.z / 128;
+    int stepX = dx > 0 ? 1 : (dx < 0 ? -1 : 0);
+    int stepY = dy > 0 ? 1 : (dy < 0 ? -1 : 0);
+    int stepZ = dz > 0 ? 1 : (dz < 0 ? -1 : 0);
+
+    // Next crossing on each axis, an axis with no movement is never
+    // crossed : den = 0 makes it greater than any other crossing
+    int64 numX = 1, denX = 0;
+    int64 numY = 1, denY = 0;
+    int64 numZ = 1, denZ = 0;
+    if (dx != 0) {
+        numX = abs((dx > 0 ? (tileX + 1) * 256 : tileX * 256) - originPosW.x);
+        denX = abs(dx);
+    }
+    if (dy != 0) {
+        numY = abs((dy > 0 ? (tileY + 1) * 256 : tileY * 256) - originPosW.y);
+        denY = abs(dy);
+    }
+    if (dz != 0) {
+        numZ = abs((dz > 0 ? (tileZ + 1) * 128 : tileZ * 128) - originPosW.z);
+        denZ = abs(dz);
+    }
+
+    int64 entryNum = 0, entryDen = 1;
+    bool isOriginTile = true;
+
+    while (tileX >= 0 && tileX < mmax_x_ && tileY >= 0 && tileY < mmax_y_
+        && tileZ >= 0 && tileZ < mmax_z_)
+    {
+        // Line leaves current tile at the closest crossing, or ends in it
+        int axis = 0;
+        int64 exitNum = numX, exitDen = denX;
+        if (numY * exitDen < exitNum * denY) {
+            axis = 1;
+            exitNum = numY;
+            exitDen = denY;
+        }
+        if (numZ * exitDen < exitNum * denZ) {
+            axis = 2;
+            exitNum = numZ;
+            exitDen = denZ;
+        }
+        bool isLastTile = exitNum >= exitDen;
+        if (isLastTile) {
+            exitNum = 1;
+            exitDen = 1;
+        }
+
+        unsigned char twd = mtsurfaces_[tileX + tileY * mmax_x_ + tileZ * mmax_m_xy];
+        bool isSlope = twd >= 0x01 && twd <= 0x04;
+        if ((!isOriginTile || isSlope) && !(twd == 0x00 || twd == 0x0C || twd == 0x10)) {
+            WorldPoint entryPt;
+            pointOnLine(originPosW, dx, dy, dz, entryNum, entryDen, &entryPt);
+            if (!isSlope) {
+                *pHitPosW = entryPt;
+                return true;
+            }
+
+            // the slope is a plane, so comparing line height to slope
+            // height at entry and exit of the tile is enough
+            WorldPoint exitPt;
+            pointOnLine(originPosW, dx, dy, dz, exitNum, exitDen, &exitPt);
+            int entryAbove = heightAboveSlope(twd, entryPt, tileX, tileY, tileZ);
+            int exitAbove = heightAboveSlope(twd, exitPt, tileX, tileY, tileZ);
+
+            if (entryAbove <= 0) {
+                *pHitPosW = entryPt;
+                return true;
+            } else if (exitAbove <= 0) {
+                pHitPosW->x = entryPt.x + (exitPt.x - entryPt.x) * entryAbove / (entryAbove - exitAbove);
+                pHitPosW->y = entryPt.y + (exitPt.y - entryPt.y) * entryAbove / (entryAbove - exitAbove);
+                pHitPosW->z = entryPt.z + (exitPt.z - entryPt.z) * entryAbove / (entryAbove - exitAbove);
+                return true;
+            }
+        }
+
+        if (isLastTile) {
+            break;
+        }
+
+        entryNum = exitNum;
+        entryDen = exitDen;
+        isOriginTile = false;
+        switch (axis) {
+            case 0:
+                tileX += stepX;
+                numX += 256;
+                break;
+            case 1:
+                tileY += stepY;
+                numY += 256;
+                break;
+            default:
+                tileZ += stepZ;
+                numZ += 128;
+                break;
+        }
+    }
+
+    return false;
+}
+
+/*!
+ * Verify that the path from originPosW to pTargetPosW is not blocked by a tile.
+ * If such a tile exists, pTargetPosW is updated with the position of the blocking tile.
+ * \param originPosW Path starting point
+ * \param pTargetPosW Path end point
+ * \param updateLoc Set to true to update pTargetPosW when blocking tile is found
+ * \param distanceMax Maximum distance we cannot cross. If distanceMax is
+ *   reached before pTargetPosW, then path is stopped.
+ * \param pInitialDistance This is the distance between origin and initial target position
+ * \return a bitmask indicating the type of result:
+ *      - 0b(1) : target in range
+ *      - 3b(8) : distanceMax is reached
+ *      - 4b(16): blocker tile, "pTargetLoc" is set
+ *      - 5b(32): out of visible reach
+ */
+uint8 Mission::checkBlockedByTile(const WorldPoint & originPosW, WorldPoint *pTargetPosW,
+                                  bool updateLoc, double distanceMax, double *pInitialDistance) {
+    PROFILE_ZONE("Mission::checkBlockedByTile");
+    // TODO: some objects mid point is higher then map z
+    assert(distanceMax >= 0);
+
+    int cx = originPosW.x;
+    int cy = originPosW.y;
+    int cz = originPosW.z;
+    if (cz > (mmax_z_ - 1) * 128)
+        return kBMaskBlockerTargetOutOfMap;
+
+    // This variable will store the target location as it may moves if
+    // a tile blocks the path.
+    WorldPoint tmpTargetWLoc = *pTargetPosW;
+
+    if (tmpTargetWLoc.z > (mmax_z_ - 1) * 128)
+        return kBMaskBlockerTargetOutOfMap;
+
+#ifdef CHECK_BLOCKED_BY_TILE
+    WorldPoint sampledPosW = *pTargetPosW;
+    uint8 sampledMask = checkBlockedByTileSampled(originPosW, &sampledPosW, distanceMax);
+#endif
+
+    // This is the distance between the origin and the target
+    double distanceToTarget = 0;
+    distanceToTarget = sqrt((double)((tmpTargetWLoc.x - cx) * (tmpTargetWLoc.x - cx) + (tmpTargetWLoc.y - cy) * (tmpTargetWLoc.y - cy)
+        + (tmpTargetWLoc.z - cz) * (tmpTargetWLoc.z - cz)));
+    uint8 block_mask = 1;
+
+    if (pInitialDistance)
+        *pInitialDistance = distanceToTarget;
+    if (distanceToTarget == 0)
+        return block_mask;
+
+    if (distanceToTarget >= distanceMax) {
+        // the distance we have to cross (distanceToTarget) is higher than the maximum
+        // distance we are allowed to cross (distanceMax)
+
+        // update target position according to distanceMax
+        double dist_k = (double)distanceMax / distanceToTarget;
+        tmpTargetWLoc.x = cx + (int)((tmpTargetWLoc.x - cx) * dist_k);
+        tmpTargetWLoc.y = cy + (int)((tmpTargetWLoc.y - cy) * dist_k);
+        tmpTargetWLoc.z = cz + (int)((tmpTargetWLoc.z - cz) * dist_k);
+        // set mask to indicate distanceMax is reached
+        block_mask = 8;
+        if (updateLoc) {
+            *pTargetPosW = tmpTargetWLoc;
+        }
+        distanceToTarget = distanceMax;
+    }
+
+    WorldPoint hitPosW;
+    if (findBlockingTile(originPosW, tmpTargetWLoc, &hitPosW)) {
+        // Blocking point is moved back by 8 units on the line
+        // so it stays outside the blocking tile
+        int hx = hitPosW.x - cx;
+        int hy = hitPosW.y - cy;
+        int hz = hitPosW.z - cz;
+        double distToHit = sqrt((double)(hx * hx + hy * hy + hz * hz));
+        if (distToHit > 8) {
+            double back_k = 8 / distanceToTarget;
+            hitPosW.x -= (int)((tmpTargetWLoc.x - cx) * back_k);
+            hitPosW.y -= (int)((tmpTargetWLoc.y - cy) * back_k);
+            hitPosW.z -= (int)((tmpTargetWLoc.z - cz) * back_k);
+        } else {
+            hitPosW = originPosW;
+        }
+
+        // set mask to indicate path is blocked by a tile
+        if (block_mask == 1)
+            block_mask = 16;
+        else
+            block_mask |= 16;
+        if (updateLoc) {
+            *pTargetPosW = hitPosW;
+        }
+    }
+
+#ifdef CHECK_BLOCKED_BY_TILE
+    if ((sampledMask & 16) != (block_mask & 16)) {
+        LOG(Log::k_FLG_GAME, "Mission", "checkBlockedByTile",
+            ("Verdicts differ from (%d, %d, %d) : sampled %d, traversal %d",
+            cx, cy, cz, sampledMask, block_mask));
+    } else if ((block_mask & 16) && updateLoc) {
+        int ex = sampledPosW.x - pTargetPosW->x;
+        int ey = sampledPosW.y - pTargetPosW->y;
+        int ez = sampledPosW.z - pTargetPosW->z;
+        if (ex * ex + ey * ey + ez * ez > 16 * 16) {
+            LOG(Log::k_FLG_GAME, "Mission", "checkBlockedByTile",
+                ("Hit points differ from (%d, %d, %d) : sampled (%d, %d, %d), traversal (%d, %d, %d)",
+                cx, cy, cz, sampledPosW.x, sampledPosW.y, sampledPosW.z,
+                pTargetPosW->x, pTargetPosW->y, pTargetPosW->z));
+        }
+    }
+#endif
 
     return block_mask;
 }
@@ -34,6 +34,11 @@
 #include "common.h"
 #include "mapobject.h"
 #include "map.h"
+#include "pathregions.h"
+#include "surfacecache.h"
+#include "mapobjectgrid.h"
+#include "ia/perception.h"
+#include "ia/threatmap.h"
 #include "model/leveldata.h"
 #include "core/gameevent.h"
 
@@ -42,6 +47,7 @@ class PedInstance;
 class Agent;
 class ObjectiveDesc;
 class Squad;
+class PathWorkers;
 class ProjectileShot;
 class GaussGunShot;
 class Weapon;
@@ -107,6 +113,44 @@ private:
     int nbOfHits_;
 };
 
+/*!
+ * Time spent in each part of the simulation by Mission::simulateStep().
+ */
+class SimProfile {
+public:
+    /*!
+     * Parts of a simulation step, in the order they are run.
+     */
+    enum EPart {
+        kPartObjectives = 0,
+        kPartSfx,
+        kPartPeds,
+        kPartPathResults,
+        kPartVehicles,
+        kPartWeapons,
+        kPartStatics,
+        kPartShots,
+        kPartSquad,
+        kNbParts
+    };
+
+    SimProfile() { reset(); }
+
+    //! Clears all counters
+    void reset();
+    //! Adds time spent in part since lastTime and returns current time
+    uint64 addTime(EPart part, uint64 lastTime);
+    //! Returns the name of the given part
+    static const char *partName(int part);
+
+    /*! Number of simulated steps.*/
+    uint32 nbSteps;
+    /*! Total time of all steps in microseconds.*/
+    uint64 totalTime;
+    /*! Time spent in each part in microseconds.*/
+    uint64 partTime[kNbParts];
+};
+
 /*!
  * Contains information read from original mission data file.
  */
@@ -158,6 +202,11 @@ public:
     void checkObjectives();
     void objectiveMsg(std::string& msg);
 
+    //! Runs one step of simulation of all mission objects
+    bool simulateStep(int elapsed, SimProfile *pProfile = NULL);
+    //! Returns a checksum of the state of peds and vehicles
+    uint32 stateChecksum();
+
     //*************************************
     // Map
     //*************************************
@@ -192,11 +241,11 @@ public:
     //*************************************
     size_t numPeds() { return peds_.size(); }
     PedInstance *ped(size_t i) { return peds_[i]; }
-    void addPed(PedInstance *p) { peds_.push_back(p); }
+    void addPed(PedInstance *p);
 
     size_t numVehicles() { return vehicles_.size(); }
     Vehicle *vehicle(size_t i) { return vehicles_[i]; }
-    void addVehicle(Vehicle *pVehicle) { vehicles_.push_back(pVehicle); }
+    void addVehicle(Vehicle *pVehicle);
 
     size_t numWeaponsOnGround() { return weaponsOnGround_.size(); }
     WeaponInstance *weaponOnGround(size_t i) { return weaponsOnGround_[i]; }
@@ -205,7 +254,10 @@ public:
 
     size_t numStatics() { return statics_.size(); }
     Static *statics(size_t i) { return statics_[i]; }
-    void addStatic(Static *pStatic) { statics_.push_back(pStatic); }
+    void addStatic(Static *pStatic);
+
+    //! Returns the grid of peds, vehicles, statics and weapons on ground
+    MapObjectGrid & objectsGrid() { return objectsGrid_; }
 
     size_t numSfxObjects() { return sfx_objects_.size(); }
     SFXObject *sfxObjects(size_t i) { return sfx_objects_[i]; }
@@ -255,6 +307,7 @@ public:
      */
     void addArmedPed(PedInstance *pPed) {
         armedPedsVec_.push_back(pPed);
+        threats_.addArmedPed(pPed);
     }
     /*!
      * Returns the number of currently armed peds.
@@ -277,9 +330,15 @@ public:
 
     /*! Return the mission statistics. */
     MissionStats *stats() { return &stats_; }
+    /*! Returns who can see whom, shared by all peds.*/
+    Perception & perception() { return perception_; }
+    /*! Returns where armed peds and shots make the map dangerous.*/
+    ThreatMap & threats() { return threats_; }
 
     bool setSurfaces();
     void clrSurfaces();
+    //! Returns what the directions map was computed from
+    const SurfaceCache::Key & surfaceKey() { return surfaceKey_; }
     bool getWalkable(TilePoint &mtp);
     bool getWalkableClosestByZ(TilePoint &mtp);
     bool getShootableTile(TilePoint *pLocT);
@@ -290,6 +349,8 @@ public:
     //*************************************
     //! Check if a tile is blocking the line between originLoc and pTargetPosW
     uint8 checkBlockedByTile(const WorldPoint & originLoc, WorldPoint *pTargetPosW, bool updateLoc, double distanceMax, double *pFinalDest = NULL);
+    //! Former implementation of checkBlockedByTile, kept to compare results with it
+    uint8 checkBlockedByTileSampled(const WorldPoint & originLoc, WorldPoint *pTargetPosW, double distanceMax);
     //! Check if an object is blocking the line between originLoc and pTargetPosW
     MapObject * checkBlockedByObject(WorldPoint * originLoc, WorldPoint * pTargetPosW,
         double *dist, const ShootableMapObject *pOrigin);
@@ -304,14 +365,21 @@ public:
     uint8 *mtsurfaces_;
     // map-directions points
     floodPointDesc *mdpoints_;
-    // for copy in pathfinding
-    floodPointDesc *mdpoints_cp_;
+    // working data of pathfinding done in the main thread
+    pathSearchDesc mdsearch_;
+    // walkable regions built with mdpoints_, used to speed up path finding
+    PathRegions mdregions_;
     // initialized in set_map, used for in-class calculations
     // map maximum x,y,z values
     int mmax_x_, mmax_y_, mmax_z_;
     // initialized in setSurfaces, used for in-class calculations
     int mmax_m_xy;
 
+    //! Returns the path workers or NULL if paths are searched in main thread
+    PathWorkers * pathWorkers();
+    //! Gives to peds the paths found by workers since last call
+    void applyPathResults();
+
     MiniMap * getMiniMap() { return p_minimap_; }
     /*!
      * Returns the current squad.
@@ -322,8 +390,12 @@ protected:
     bool sWalkable(char thisTile, char upperTile);
     bool isSurface(char thisTile);
     bool isStairs(char thisTile);
+    //! Defines directions of all tiles that can be reached from the seeds
+    void floodSurfaces(const std::vector<TilePoint> &seeds);
 
     void transferWeaponsFromPedInstanceToAgent(PedInstance *p, Agent *pAg);
+    //! Finds the first tile blocking the line between two points
+    bool findBlockingTile(const WorldPoint & originPosW, const WorldPoint & targetPosW, WorldPoint *pHitPosW);
 
 protected:
 
@@ -369,6 +441,20 @@ protected:
      * walkdata->minimap_colours_ in function createMinimap
      */
     MiniMap *p_minimap_;
+    /*! Spatial index of peds, vehicles, statics and weapons on ground.*/
+    MapObjectGrid objectsGrid_;
+    /*! Objects returned by the grid in checkBlockedByObject().*/
+    std::vector<MapObject *> blockersVec_;
+    /*! Objects returned by the grid in findObjectWithNatureAtPos().*/
+    std::vector<MapObject *> tileObjectsVec_;
+    /*! Threads searching paths for peds, created on first request.*/
+    PathWorkers *p_path_workers_;
+    /*! What the directions map was computed from.*/
+    SurfaceCache::Key surfaceKey_;
+    /*! Answers to visibility queries for the current perception tick.*/
+    Perception perception_;
+    /*! Danger on each tile, shared by behaviours.*/
+    ThreatMap threats_;
     /*!
      * The squad selected for the mission. It contains only active agents.
      */
@@ -28,6 +28,7 @@
 #include "missionmanager.h"
 #include "app.h"
 #include "utils/file.h"
+#include "utils/assetcache.h"
 #include "utils/log.h"
 #include "resources.h"
 #include "core/gamecontroller.h"
@@ -123,6 +124,20 @@ MissionBriefing *MissionManager::loadBriefing(int n) {
     return p_mb;
 }
 
+/*!
+ * Reads the mission file to get the map id and asks the map manager
+ * to load the map in the background, so that the briefing and the
+ * mission don't wait for it.
+ * \param n Mission id.
+ */
+void MissionManager::prefetchMap(int n)
+{
+    LevelData::LevelDataAll level_data;
+    if (load_level_data(n, level_data)) {
+        g_App.maps().prefetchMap(READ_LE_UINT16(level_data.mapinfos.map));
+    }
+}
+
 #define copydata(x, y) memcpy(&level_data.x, data + y, sizeof(level_data.x))
 
 /*!
@@ -159,16 +174,18 @@ Mission *MissionManager::loadMission(int n)
 /*!
  * Creates a Mission object from the LevelDataAll structure and fills the overlay for the
  * briefing minimap.
+ * Only the file and the given structure are used, so missions can be read
+ * by several threads at once (see MissionIndex).
  */
 bool MissionManager::load_level_data(int n, LevelData::LevelDataAll &level_data) {
     char tmp[100];
-    int size;
 
     sprintf(tmp, GAME_PATTERN, n);
-    uint8 *data = File::loadOriginalFile(tmp, size);
-    if (data == NULL) {
+    FileData gameData;
+    if (!File::loadOriginalData(tmp, &gameData)) {
         return false;
     }
+    uint8 *data = gameData.data();
 
 #if 1
     hackMissions(n, data);
@@ -423,56 +440,52 @@ void MissionManager::createWeapons(const LevelData::LevelDataAll &level_data, Da
     }
 }
 
-WeaponInstance * MissionManager::create_weapon_instance(const LevelData::Weapons &gamdata) {
-    Weapon::WeaponType wType = Weapon::Unknown;
-    WeaponInstance *pNewWeapon = NULL;
-
-    switch (gamdata.sub_type) {
+/*!
+ * \param value Sub type of the weapon in the game data
+ * \return Weapon::Unknown if value is not a weapon type.
+ */
+Weapon::WeaponType MissionManager::weaponTypeFromValue(uint8 value) {
+    switch (value) {
         case 0x01:
-            wType = Weapon::Persuadatron;
-            break;
+            return Weapon::Persuadatron;
         case 0x02:
-            wType = Weapon::Pistol;
-            break;
+            return Weapon::Pistol;
         case 0x03:
-            wType = Weapon::GaussGun;
-            break;
+            return Weapon::GaussGun;
         case 0x04:
-            wType = Weapon::Shotgun;
-            break;
+            return Weapon::Shotgun;
         case 0x05:
-            wType = Weapon::Uzi;
-            break;
+            return Weapon::Uzi;
         case 0x06:
-            wType = Weapon::Minigun;
-            break;
+            return Weapon::Minigun;
         case 0x07:
-            wType = Weapon::Laser;
-            break;
+            return Weapon::Laser;
         case 0x08:
-            wType = Weapon::Flamer;
-            break;
+            return Weapon::Flamer;
         case 0x09:
-            wType = Weapon::LongRange;
-            break;
+            return Weapon::LongRange;
         case 0x0A:
-            wType = Weapon::Scanner;
-            break;
+            return Weapon::Scanner;
         case 0x0B:
-            wType = Weapon::MediKit;
-            break;
+            return Weapon::MediKit;
         case 0x0C:
-            wType = Weapon::TimeBomb;
-            break;
+            return Weapon::TimeBomb;
         case 0x0D:
-            wType = Weapon::AccessCard;
-            break;
+            return Weapon::AccessCard;
         case 0x11:
-            wType = Weapon::EnergyShield;
-            break;
+            return Weapon::EnergyShield;
         default:
-            FSERR(Log::k_FLG_GAME, "Mission", "create_weapon_instance", ("unknown weapon type : %d", gamdata.sub_type));
-            return NULL;
+            return Weapon::Unknown;
+    }
+}
+
+WeaponInstance * MissionManager::create_weapon_instance(const LevelData::Weapons &gamdata) {
+    WeaponInstance *pNewWeapon = NULL;
+
+    Weapon::WeaponType wType = weaponTypeFromValue(gamdata.sub_type);
+    if (wType == Weapon::Unknown) {
+        FSERR(Log::k_FLG_GAME, "Mission", "create_weapon_instance", ("unknown weapon type : %d", gamdata.sub_type));
+        return NULL;
     }
 
     Weapon *pWeapon = g_gameCtrl.weaponManager().getWeapon(wType);
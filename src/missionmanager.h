@@ -30,6 +30,7 @@
 #include "common.h"
 #include "model/leveldata.h"
 #include "ia/actions.h"
+#include "model/weapon.h"
 
 class Mission;
 class MissionBriefing;
@@ -48,6 +49,12 @@ public:
     Mission *loadMission(int n);
     //! Loads briefing for the given mission id
     MissionBriefing *loadBriefing(int n);
+    //! Starts loading the map of the given mission id in the background
+    void prefetchMap(int n);
+    //! Reads the mission file and return a representation of that file
+    bool load_level_data(int n, LevelData::LevelDataAll &level_data);
+    //! Returns the type of weapon for the given value of the game data
+    static Weapon::WeaponType weaponTypeFromValue(uint8 value);
 
 private:
     /*!
@@ -72,8 +79,6 @@ private:
 private:
     //! When loading missions, possibly adds some info to the data
     void hackMissions(int n, uint8 *data);
-    //! Reads the mission file and return a representation of that file
-    bool load_level_data(int n, LevelData::LevelDataAll &level_data);
     // Instanciate a mission from the data file
     Mission * create_mission(LevelData::LevelDataAll &level_data);
     //! Creates all weapons
@@ -337,9 +337,18 @@ void Explosion::generateFlameWaves(Mission *pMission, WorldPoint *pOrigin, doubl
 void Explosion::getAllShootablesWithinRange(Mission *pMission,
                                        const WorldPoint &originLocW,
                                        std::vector<ShootableMapObject *> &objInRangeVec) {
+    // Only objects near the explosion are looked at
+    std::vector<MapObject *> candidates;
+    pMission->objectsGrid().findInRange(originLocW, dmg_.range, MapObject::kNaturePed
+        | MapObject::kNatureStatic | MapObject::kNatureVehicle | MapObject::kNatureWeapon,
+        candidates);
+
     // Look at all peds alive, in range of explosion and not in a vehicle
-    for (size_t i = 0; i < pMission->numPeds(); ++i) {
-        PedInstance *p = pMission->ped(i);
+    for (size_t i = 0; i < candidates.size(); ++i) {
+        if (!candidates[i]->is(MapObject::kNaturePed)) {
+            continue;
+        }
+        PedInstance *p = static_cast<PedInstance *>(candidates[i]);
         if (p->isAlive() && p->isCloseTo(originLocW, dmg_.range) && p->inVehicle() == NULL) {
             WorldPoint pedPosW(p->position());
             if (pMission->checkBlockedByTile(originLocW, &pedPosW, false, dmg_.range) == 1) {
@@ -348,8 +357,11 @@ void Explosion::getAllShootablesWithinRange(Mission *pMission,
         }
     }
 
-    for (size_t i = 0; i < pMission->numStatics(); ++i) {
-        Static *st = pMission->statics(i);
+    for (size_t i = 0; i < candidates.size(); ++i) {
+        if (!candidates[i]->is(MapObject::kNatureStatic)) {
+            continue;
+        }
+        Static *st = static_cast<Static *>(candidates[i]);
         if (!st->isExcludedFromBlockers() && st->isAlive() && st->isCloseTo(originLocW, dmg_.range)) {
             WorldPoint staticPosW(st->position());
             if (pMission->checkBlockedByTile(originLocW, &staticPosW, false, dmg_.range) == 1) {
@@ -359,8 +371,11 @@ void Explosion::getAllShootablesWithinRange(Mission *pMission,
     }
 
     // look at all vehicles
-    for (size_t i = 0; i < pMission->numVehicles(); ++i) {
-        ShootableMapObject *v = pMission->vehicle(i);
+    for (size_t i = 0; i < candidates.size(); ++i) {
+        if (!candidates[i]->is(MapObject::kNatureVehicle)) {
+            continue;
+        }
+        ShootableMapObject *v = static_cast<ShootableMapObject *>(candidates[i]);
         if (v->isAlive() && v->isCloseTo(originLocW, dmg_.range)) {
             WorldPoint vehiclePosW(v->position());
             if (pMission->checkBlockedByTile(originLocW, &vehiclePosW, false, dmg_.range) == 1) {
@@ -370,8 +385,11 @@ void Explosion::getAllShootablesWithinRange(Mission *pMission,
     }
 
     // look at all bombs on the ground except the weapon that generated the shot
-    for (size_t i = 0; i < pMission->numWeaponsOnGround(); ++i) {
-        WeaponInstance *w = pMission->weaponOnGround(i);
+    for (size_t i = 0; i < candidates.size(); ++i) {
+        if (!candidates[i]->is(MapObject::kNatureWeapon)) {
+            continue;
+        }
+        WeaponInstance *w = static_cast<WeaponInstance *>(candidates[i]);
         if (w->isInstanceOf(Weapon::TimeBomb) && w != dmg_.pWeapon && !w->hasOwner() && w->isAlive()) {
             WorldPoint weaponPosW(w->position());
             if (pMission->checkBlockedByTile(originLocW, &weaponPosW, false, dmg_.range) == 1) {
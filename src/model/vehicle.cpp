@@ -35,6 +35,7 @@
 #include "gfx/screen.h"
 #include "vehicle.h"
 #include "model/shot.h"
+#include "utils/log.h"
 
 const uint8 Vehicle::kVehicleTypeLargeArmored = 0x01;
 const uint8 Vehicle::kVehicleTypeLargeArmoredDamaged = 0x04;
@@ -172,203 +173,6 @@ GenericCar::GenericCar(VehicleAnimation * pAnimation, uint16 anId, uint8 aType,
     hold_on_.wayFree = 0;
 }
 
-uint16 GenericCar::tileDir(int x, int y, int z) {
-    uint16 dir = 0x0;
-    int near_tile;
-    Map *pMap = g_App.maps().map(map());
-
-    switch(pMap->tileAt(x, y, z)){
-        case 80:
-            if(g_App.maps().map(map())->tileAt(x + 1, y, z) == 80)
-                dir = (0)|(0xFFF0);
-            if(pMap->tileAt(x - 1, y, z) == 80)
-                dir = (4<<8)|(0xF0FF);
-            break;
-        case 81:
-            if(pMap->tileAt(x, y - 1, z) == 81)
-                dir = (2<<4)|(0xFF0F);
-            if(pMap->tileAt(x, y + 1, z) == 81)
-                dir = (6<<12)|(0x0FFF);
-            break;
-        case 106:
-            dir = (0)|(2<<4)|(6<<12)|(0x0F00);
-
-            if(pMap->tileAt(x + 1, y - 1, z) != 118)
-                dir |= 0x0FF0;
-            if(pMap->tileAt(x + 1, y + 1, z) != 118)
-                dir |= 0xFF00;
-            near_tile = pMap->tileAt(x + 1, y, z);
-            if (near_tile == 108 || near_tile == 109)
-                dir = (dir & 0x0FFF) | 0x6000;
-
-            break;
-        case 107:
-            dir = (2<<4)|(4<<8)|(6<<12)|(0x000F);
-
-            if(pMap->tileAt(x - 1, y - 1, z) != 118)
-                dir |= 0x00FF;
-            if(pMap->tileAt(x - 1, y + 1, z) != 118)
-                dir |= 0xF00F;
-            near_tile = pMap->tileAt(x - 1, y, z);
-            if (near_tile == 108 || near_tile == 109)
-                dir = (dir & 0xFF0F) | 0x0020;
-
-            break;
-        case 108:
-            dir = (0)|(2<<4)|(4<<8)|(0xF000);
-
-            if(pMap->tileAt(x + 1, y - 1, z) != 118)
-                dir |= 0xF00F;
-            if(pMap->tileAt(x - 1, y - 1, z) != 118)
-                dir |= 0xFF00;
-            near_tile = pMap->tileAt(x, y - 1, z);
-            if (near_tile == 106 || near_tile == 107)
-                dir = dir & 0xFFF0;
-
-            break;
-        case 109:
-            dir = (0)|(4<<8)|(6<<12)|(0x00F0);
-
-            if(pMap->tileAt(x + 1, y + 1, z) != 118)
-                dir |= 0x00FF;
-            if(pMap->tileAt(x - 1, y + 1, z) != 118)
-                dir |= 0x0FF0;
-            near_tile = pMap->tileAt(x, y + 1, z);
-            if (near_tile == 106 || near_tile == 107)
-                dir = (dir & 0xF0FF) | 0x0400;
-
-            break;
-        case 110:
-            dir = (0) | (2<<4)|(0xFF00);
-            break;
-        case 111:
-            dir = (0) | (6<<12)|(0x0FF0);
-            break;
-        case 112:
-            dir = (2<<4)|(4<<8)|(0xF00F);
-            break;
-        case 113:
-            dir = (4<<8)|(6<<12)|(0x00FF);
-            break;
-        /*case 119:
-            // TODO: Greenland map needs fixing
-            dir = 0xFFFF;
-            near_tile = pMap->tileAt(x, y + 1, z);
-            if (near_tile == 107 || near_tile == 225 || near_tile == 226)
-                dir = (dir & 0xF0FF) | 0x0400;
-            near_tile = pMap->tileAt(x, y + 1, z);
-            if (near_tile == 106 || near_tile == 225 || near_tile == 226)
-               dir &= 0xFFF0;
-            near_tile = pMap->tileAt(x + 1, y, z);
-            if (near_tile == 109 || near_tile == 225 || near_tile == 226)
-                dir = (dir & 0xFF0F) | 0x0020;
-            near_tile = pMap->tileAt(x - 1, y, z);
-            if (near_tile == 108 || near_tile == 225 || near_tile == 226)
-                dir = (dir & 0x0FFF) | 0x6000;
-            if (dir ==0xFFFF)
-                dir = 0x0;
-            break;*/
-        case 120:
-            dir = (0)|(2<<4)|(0xFF00);
-            break;
-        case 121:
-            dir = (0)|(6<<12)|(0x0FF0);
-            break;
-        case 122:
-            dir = (4<<8)|(6<<12)|(0x00FF);
-            break;
-        case 123:
-            dir = (2<<4)|(4<<8)|(0xF00F);
-            break;
-        case 225:/*
-            if(g_App.maps().map(map())->getTileAt(x + 1, y, z)->type() == Tile::kRoadPedCross)
-                dir = (0)|(0xFFF0);
-            else if(g_App.maps().map(map())->getTileAt(x - 1, y, z)->type() == Tile::kRoadPedCross)
-                dir = (4<<8)|(0xF0FF);
-            else {*/
-                dir = 0xFFFF;
-                near_tile = pMap->tileAt(x, y + 1, z);
-                if (/*near_tile == 119 || */near_tile == 106
-                    || near_tile == 107 || near_tile == 80 || near_tile == 225)
-                    dir = (dir & 0xF0FF) | 0x0400;
-                near_tile = pMap->tileAt(x, y - 1, z);
-                if (/*near_tile == 119 || */near_tile == 106
-                    || near_tile == 107 || near_tile == 80 || near_tile == 225)
-                    dir &= 0xFFF0;
-                near_tile = pMap->tileAt(x + 1, y, z);
-                if (/*near_tile == 119 || */near_tile == 108 || near_tile == 81)
-                    dir = (dir & 0xFF0F) | 0x0020;
-                near_tile = pMap->tileAt(x - 1, y, z);
-                if (/*near_tile == 119 || */near_tile == 109 || near_tile == 81)
-                    dir = (dir & 0x0FFF) | 0x6000;
-                if (dir == 0xFFFF)
-                    dir = 0x0;
-            //}
-            break;
-        case 226:/*
-            if(g_App.maps().map(map())->getTileAt(x, y - 1, z)->type() == Tile::kRoadPedCross)
-                dir = (2<<4)|(0xFF0F);
-            else if(g_App.maps().map(map())->getTileAt(x, y + 1, z)->type() == Tile::kRoadPedCross)
-                dir = (6<<12)|(0x0FFF);
-            else {*/
-                dir = 0xFFFF;
-                near_tile = pMap->tileAt(x, y + 1, z);
-                if (/*near_tile == 119 || */near_tile == 106 || near_tile == 80)
-                    dir = (dir & 0xF0FF) | 0x0400;
-                near_tile = pMap->tileAt(x, y - 1, z);
-                if (/*near_tile == 119 || */near_tile == 107 || near_tile == 80)
-                    dir &= 0xFFF0;
-                near_tile = pMap->tileAt(x + 1, y, z);
-                if (/*near_tile == 119 || */near_tile == 108 || near_tile == 109
-                    || near_tile == 81 || near_tile == 226)
-                    dir = (dir & 0xFF0F) | 0x0020;
-                near_tile = pMap->tileAt(x - 1, y, z);
-                if (/*near_tile == 119 || */near_tile == 108 || near_tile == 109
-                    || near_tile == 81 || near_tile == 226)
-                    dir = (dir & 0x0FFF) | 0x6000;
-                if (dir == 0xFFFF)
-                    dir = 0;
-            //}
-            break;
-        default:
-            dir = 0xFFFF;
-    }
-
-    return dir;
-}
-
-bool GenericCar::dirWalkable(TilePoint *p, int x, int y, int z) {
-    Map *pMap = g_App.maps().map(map());
-    if(!(pMap->isTileWalkableByCar(x,y,z)))
-        return false;
-
-    uint16 dirStart = tileDir(p->tx,p->ty,p->tz);
-    uint16 dirEnd = tileDir(x,y,z);
-    if (dirStart == 0x0 || dirEnd == 0x0)
-        return false;
-    if (dirStart == 0xFFFF || dirEnd == 0xFFFF)
-        return true;
-
-    if (((dirStart & 0xF000) != 0xF000)
-        || ((dirEnd & 0xF000) != 0xF000))
-        if ((dirStart & 0xF000) == (dirEnd & 0xF000))
-                return true;
-    if (((dirStart & 0x0F00) != 0x0F00)
-        || ((dirEnd & 0x0F00) != 0x0F00))
-        if ((dirStart & 0x0F00) == (dirEnd & 0x0F00))
-                return true;
-    if (((dirStart & 0x00F0) != 0x00F0)
-        || ((dirEnd & 0x00F0) != 0x00F0))
-        if ((dirStart & 0x00F0) == (dirEnd & 0x00F0))
-                return true;
-    if (((dirStart & 0x000F) != 0x000F)
-        || ((dirEnd & 0x000F) != 0x000F))
-        if ((dirStart & 0x000F) == (dirEnd & 0x000F))
-                return true;
-
-    return false;
-}
-
 /*!
  * Sets a destination point for the vehicle to reach at given speed.
  * \param m
@@ -377,9 +181,6 @@ bool GenericCar::dirWalkable(TilePoint *p, int x, int y, int z) {
  * \return true if destination has been set correctly.
  */
 bool GenericCar::initMovementToDestination(Mission *pMission, const TilePoint &destinationPt, int newSpeed) {
-    std::map < TilePoint, uint16 > open;
-    std::set < TilePoint > closed;
-    std::map < TilePoint, TilePoint > parent;
     int basex = pos_.tx, basey = pos_.ty;
     std::vector < TilePoint > path2add;
     path2add.reserve(16);
@@ -418,103 +219,10 @@ bool GenericCar::initMovementToDestination(Mission *pMission, const TilePoint &d
         }
     }
 
-    TilePoint closest;
-    float closest_dist = 100000;
-
-    uint16 wrong_dir = (uint16)getDirection(4);
-    if (wrong_dir == 0x0)
-        wrong_dir = 0x0400;
-    else if(wrong_dir == 0x1)
-        wrong_dir = 0x6000;
-    else if(wrong_dir == 0x2)
-        wrong_dir = 0x0;
-    else if(wrong_dir == 0x3)
-        wrong_dir = 0x0020;
-    open.insert(std::pair< TilePoint, uint16 >(TilePoint(basex, basey, z, pos_.ox, pos_.oy),
-        wrong_dir));
-    int watchDog = 1000;
-
-    while (!open.empty()) {
-        watchDog--;
-        float dist = 100000;
-        TilePoint p;
-        std::map < TilePoint, uint16 >::iterator pit;
-        for (std::map < TilePoint, uint16 >::iterator it = open.begin();
-             it != open.end(); it++)
-        {
-            float d =
-                sqrt((float) (x - it->first.tx) * (x - it->first.tx) +
-                     (y - it->first.ty) * (y - it->first.ty));
-            if (d < dist) {
-                dist = d;
-                p = it->first;
-                pit = it;       // it cannot be const_iterator because of this assign
-                wrong_dir = it->second;
-            }
-        }
-        if (dist < closest_dist) {
-            closest = p;
-            closest_dist = dist;
-        }
-        //printf("found best dist %f in %i nodes\n", dist, open.size());
-        open.erase(pit);
-        closed.insert(p);
-
-        if ((p.tx == x && p.ty == y && p.tz == z)
-            || watchDog < 0)
-        {
-            if (watchDog < 0) {
-                p = closest;
-                dest_path_.
-                    push_front(TilePoint
-                               (p.tx, p.ty, p.tz, ox, oy));
-            } else
-                dest_path_.push_front(TilePoint(x, y, z, ox, oy));
-            while (parent.find(p) != parent.end()) {
-                p = parent[p];
-                if (p.tx == pos_.tx && p.ty == pos_.ty
-                    && p.tz == z)
-                    break;
-                dest_path_.push_front(p);
-            }
-            break;
-        }
-
-        std::map <TilePoint, uint16> neighbours;
-        uint16 goodDir = tileDir(p.tx, p.ty, p.tz);
-
-        if (wrong_dir != 0x6000 && p.tx > 0) {
-            if (dirWalkable(&p, p.tx - 1, p.ty, p.tz)
-                && ((goodDir & 0xF000) == 0x6000 || goodDir == 0xFFFF))
-                neighbours[TilePoint(p.tx - 1, p.ty, p.tz)] = 0x0020;
-        }
-
-        if (wrong_dir != 0x0020 && p.tx < g_App.maps().map(map())->maxX()) {
-            if (dirWalkable(&p, p.tx + 1, p.ty, p.tz)
-                && ((goodDir & 0x00F0) == 0x0020 || goodDir == 0xFFFF))
-                neighbours[TilePoint(p.tx + 1, p.ty, p.tz)] = 0x6000;
-        }
-
-        if (wrong_dir != 0x0400 && p.ty > 0)
-            if (dirWalkable(&p, p.tx, p.ty - 1, p.tz)
-                && ((goodDir & 0x0F00) == 0x0400 || goodDir == 0xFFFF))
-                neighbours[TilePoint(p.tx, p.ty - 1, p.tz)] = 0x0;
-
-        if (wrong_dir != 0x0000 && p.ty < g_App.maps().map(map())->maxY())
-            if (dirWalkable(&p, p.tx, p.ty + 1, p.tz)
-                && ((goodDir & 0x000F) == 0x0 || goodDir == 0xFFFF))
-                neighbours[TilePoint(p.tx, p.ty + 1, p.tz)] = 0x0400;
-
-        for (std::map <TilePoint, uint16>::iterator it = neighbours.begin();
-            it != neighbours.end(); it++)
-            if (dirWalkable(&p, it->first.tx, it->first.ty,
-                it->first.tz)
-                && open.find(it->first) == open.end()
-                && closed.find(it->first) == closed.end())
-            {
-                parent[it->first] = p;
-                open.insert(*it);
-            }
+    // the vehicle can't turn back
+    int startMove = RoadGraph::moveFromDirection(getDirection(4));
+    if (!findRoute(pMap, basex, basey, z, startMove, TilePoint(x, y, z, ox, oy))) {
+        return false;
     }
 
     if(!dest_path_.empty()) {
@@ -527,7 +235,7 @@ bool GenericCar::initMovementToDestination(Mission *pMission, const TilePoint &d
         {
             // TODO : adjust offsets respecting direction relative to
             // close next tiles
-            switch(tileDir(it->tx, it->ty, it->tz)) {
+            switch(pMap->roadLanes(it->tx, it->ty, it->tz)) {
                 case 0xFFF0:
                 case 0xFF20:
                     it->ox = 200;
@@ -564,8 +272,8 @@ bool GenericCar::initMovementToDestination(Mission *pMission, const TilePoint &d
                 default:
 #if 0
 #if _DEBUG
-                    printf("hmm tileDir %X at %i, %i, %i\n",
-                        (unsigned int)tileDir(it->tileX(), it->tileY(),
+                    printf("hmm roadLanes %X at %i, %i, %i\n",
+                        (unsigned int)pMap->roadLanes(it->tileX(), it->tileY(),
                         it->tileZ()), it->tileX(), it->tileY(), it->tileZ());
                     printf("tileAt %i\n",
                         (unsigned int)g_App.maps().map(map())->tileAt(
@@ -591,6 +299,34 @@ bool GenericCar::initMovementToDestination(Mission *pMission, const TilePoint &d
     return !dest_path_.empty();
 }
 
+/*!
+ * Finds the shortest route on the road level with the lanes graph of the map.
+ * \param pMap The map
+ * \param basex Tile where route starts
+ * \param basey Tile where route starts
+ * \param z Road level
+ * \param startMove Move by which the vehicle has entered the start tile
+ * \param targetPt Tile to reach with the offsets to stop at
+ * \return false if there is no route. Else route is in dest_path_.
+ */
+bool GenericCar::findRoute(Map *pMap, int basex, int basey, int z, int startMove,
+        const TilePoint &targetPt) {
+    std::vector<TilePoint> route;
+    if (!pMap->roadGraph().findRoute(basex, basey, z, startMove,
+        targetPt.tx, targetPt.ty, &route)) {
+        return false;
+    }
+
+    // route goes from start to target, tile of vehicle is not part of it
+    dest_path_.push_front(targetPt);
+    for (int i = (int)route.size() - 2; i >= 0; i--) {
+        if (route[i].tx == pos_.tx && route[i].ty == pos_.ty)
+            break;
+        dest_path_.push_front(route[i]);
+    }
+    return true;
+}
+
 bool GenericCar::findPathToNearestWalkableTile(Map *pMap, const TilePoint &startPt, int *basex, int *basey, std::vector < TilePoint > *path2add) {
     int dBest = 100000, dCur;
     std::vector < TilePoint > path2wtile;
@@ -710,6 +446,7 @@ bool GenericCar::doMove(int elapsed, Mission *m)
             pos_.ox = dest_path_.front().ox;
             pos_.ty = dest_path_.front().ty;
             pos_.tx = dest_path_.front().tx;
+            updateGridCell();
             dest_path_.pop_front();
             // There's no following point so stop moving
             if (dest_path_.size() == 0)
@@ -183,8 +183,9 @@ public:
 
 protected:
     bool findPathToNearestWalkableTile(Map *pMap, const TilePoint &startPt, int *basex, int *basey, std::vector < TilePoint > *path2add);
-    uint16 tileDir(int x, int y, int z);
-    bool dirWalkable(TilePoint *p, int x, int y, int z);
+    //! Finds the shortest route on the road level to the target tile
+    bool findRoute(Map *pMap, int basex, int basey, int z, int startMove,
+            const TilePoint &targetPt);
 
 protected:
     //! Vehicle driver
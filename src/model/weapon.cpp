@@ -449,6 +449,8 @@ void WeaponInstance::fire(Mission *pMission, fs_dmg::DamageToInflict &dmg, int e
         if (pOwner_ && pOwner_->isOurAgent()) {
             pMission->stats()->incrShots(ammoUsed);
         }
+        // everyone around hears the shot
+        pMission->threats().addShot(dmg.originLocW);
     }
 }
 
@@ -0,0 +1,389 @@
+/************************************************************************
+ *                                                                      *
+ *  FreeSynd - a remake of the classic Bullfrog game "Syndicate".       *
+ *                                                                      *
+ *   Copyright (C) 2016  Benoit Blancard <benblan@users.sourceforge.net>*
+ *                                                                      *
+ *    This program is free software;  you can redistribute it and / or  *
+ *  modify it  under the  terms of the  GNU General  Public License as  *
+ *  published by the Free Software Foundation; either version 2 of the  *
+ *  License, or (at your option) any later version.                     *
+ *                                                                      *
+ *    This program is  distributed in the hope that it will be useful,  *
+ *  but WITHOUT  ANY WARRANTY;  without even  the implied  warranty of  *
+ *  MERCHANTABILITY  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU  *
+ *  General Public License for more details.                            *
+ *                                                                      *
+ *    You can view the GNU  General Public License, online, at the GNU  *
+ *  project's  web  site;  see <http://www.gnu.org/licenses/gpl.html>.  *
+ *  The full text of the license is also included in the file COPYING.  *
+ *                                                                      *
+ ************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+
+#include "SDL.h"
+
+#include "pathregions.h"
+#include "utils/log.h"
+#include "utils/timer.h"
+
+const int PathRegions::kSectorSize = 8;
+const int PathRegions::kMinCorridorDistance = 16;
+const size_t PathRegions::kMaxCachedRoutes = 512;
+
+//! tile offsets for direction bits 0x01, 0x02, 0x04 ... 0x80
+static const int kDirOffsetX[8] = { 0, 1, 1, 1, 0, -1, -1, -1 };
+static const int kDirOffsetY[8] = { 1, 1, 0, -1, -1, -1, 0, 1 };
+
+//! Order of open list : lowest f first
+typedef std::pair<uint32, uint32> RouteNode;
+struct RouteNodeGreater {
+    bool operator()(const RouteNode &a, const RouteNode &b) const {
+        return a.first > b.first;
+    }
+};
+
+PathRegions::PathRegions() {
+    clusters_ = NULL;
+    maxX_ = maxY_ = maxZ_ = maxXY_ = 0;
+    nbComponents_ = 0;
+    searchGen_ = 0;
+    buildTime_ = 0;
+    memset(&stats_, 0, sizeof(Stats));
+    pMutex_ = SDL_CreateMutex();
+}
+
+PathRegions::~PathRegions() {
+    clear();
+    SDL_DestroyMutex(pMutex_);
+}
+
+void PathRegions::clear() {
+    if (clusters_ != NULL) {
+        free(clusters_);
+        clusters_ = NULL;
+    }
+    clusterInfos_.clear();
+    routeCache_.clear();
+    searchStamps_.clear();
+    searchCosts_.clear();
+    searchParents_.clear();
+    nbComponents_ = 0;
+    searchGen_ = 0;
+    buildTime_ = 0;
+    memset(&stats_, 0, sizeof(Stats));
+}
+
+/*!
+ * Cuts walkable tiles in clusters, links them and finds components.
+ * \param pPoints Directions map
+ * \param maxX Map size on X axis
+ * \param maxY Map size on Y axis
+ * \param maxZ Map size on Z axis
+ * \return false if memory could not be allocated.
+ */
+bool PathRegions::build(const floodPointDesc *pPoints, int maxX, int maxY, int maxZ) {
+    clear();
+    uint64 startTime = fs_utils::microTime();
+
+    maxX_ = maxX;
+    maxY_ = maxY;
+    maxZ_ = maxZ;
+    maxXY_ = maxX * maxY;
+    int nbTiles = maxXY_ * maxZ;
+    clusters_ = (uint32 *)malloc(nbTiles * sizeof(uint32));
+    if (clusters_ == NULL) {
+        FSERR(Log::k_FLG_GAME, "PathRegions", "build", ("Memory allocation error\n"));
+        return false;
+    }
+    memset((void *)clusters_, 0, nbTiles * sizeof(uint32));
+    // cluster 0 means no cluster
+    clusterInfos_.resize(1);
+
+    // clusters : tiles connected inside a sector
+    std::vector<uint32> toVisit;
+    toVisit.reserve(kSectorSize * kSectorSize * maxZ);
+    for (int indx = 0; indx < nbTiles; ++indx) {
+        if (clusters_[indx] != 0
+            || (pPoints[indx].bfNodeDesc & m_fdWalkable) == 0)
+            continue;
+
+        uint32 clusterId = clusterInfos_.size();
+        int sx = (indx % maxX_) / kSectorSize;
+        int sy = ((indx % maxXY_) / maxX_) / kSectorSize;
+        int sumX = 0, sumY = 0, sumZ = 0, nb = 0;
+
+        clusters_[indx] = clusterId;
+        toVisit.push_back(indx);
+        while (!toVisit.empty()) {
+            uint32 cindx = toVisit.back();
+            toVisit.pop_back();
+            int cx = cindx % maxX_;
+            int cy = (cindx % maxXY_) / maxX_;
+            int cz = cindx / maxXY_;
+            sumX += cx;
+            sumY += cy;
+            sumZ += cz;
+            nb++;
+
+            uint8 dirs[3] = { pPoints[cindx].dirh, pPoints[cindx].dirm,
+                pPoints[cindx].dirl };
+            for (int level = 0; level < 3; ++level) {
+                for (int d = 0; d < 8 && dirs[level] != 0; ++d) {
+                    if ((dirs[level] & (1 << d)) == 0)
+                        continue;
+                    int nx = cx + kDirOffsetX[d];
+                    int ny = cy + kDirOffsetY[d];
+                    if (nx / kSectorSize != sx || ny / kSectorSize != sy)
+                        continue;
+                    uint32 nindx = nx + ny * maxX_ + (cz + 1 - level) * maxXY_;
+                    if (clusters_[nindx] == 0
+                        && (pPoints[nindx].bfNodeDesc & m_fdWalkable) != 0) {
+                        clusters_[nindx] = clusterId;
+                        toVisit.push_back(nindx);
+                    }
+                }
+            }
+        }
+
+        ClusterInfo info;
+        info.x = sumX / nb;
+        info.y = sumY / nb;
+        info.z = sumZ / nb;
+        info.component = 0;
+        clusterInfos_.push_back(info);
+    }
+
+    // links : walkable tiles of two clusters next to each other
+    for (int indx = 0; indx < nbTiles; ++indx) {
+        uint32 clusterId = clusters_[indx];
+        if (clusterId == 0)
+            continue;
+        int cx = indx % maxX_;
+        int cy = (indx % maxXY_) / maxX_;
+        int cz = indx / maxXY_;
+        uint8 dirs[3] = { pPoints[indx].dirh, pPoints[indx].dirm,
+            pPoints[indx].dirl };
+        for (int level = 0; level < 3; ++level) {
+            for (int d = 0; d < 8 && dirs[level] != 0; ++d) {
+                if ((dirs[level] & (1 << d)) == 0)
+                    continue;
+                uint32 nindx = (cx + kDirOffsetX[d]) + (cy + kDirOffsetY[d]) * maxX_
+                    + (cz + 1 - level) * maxXY_;
+                uint32 nclusterId = clusters_[nindx];
+                if (nclusterId != 0 && nclusterId != clusterId) {
+                    clusterInfos_[clusterId].links.push_back(nclusterId);
+                }
+            }
+        }
+    }
+    for (size_t i = 1; i < clusterInfos_.size(); ++i) {
+        std::vector<uint32> &links = clusterInfos_[i].links;
+        std::sort(links.begin(), links.end());
+        links.erase(std::unique(links.begin(), links.end()), links.end());
+    }
+
+    // components : links are followed both ways as the flood path finding
+    // expects directions to be symmetric
+    std::vector< std::vector<uint32> > reverseLinks(clusterInfos_.size());
+    for (size_t i = 1; i < clusterInfos_.size(); ++i) {
+        std::vector<uint32> &links = clusterInfos_[i].links;
+        for (size_t l = 0; l < links.size(); ++l) {
+            reverseLinks[links[l]].push_back(i);
+        }
+    }
+    for (size_t i = 1; i < clusterInfos_.size(); ++i) {
+        if (clusterInfos_[i].component != 0)
+            continue;
+        nbComponents_++;
+        clusterInfos_[i].component = nbComponents_;
+        toVisit.push_back(i);
+        while (!toVisit.empty()) {
+            uint32 c = toVisit.back();
+            toVisit.pop_back();
+            for (int way = 0; way < 2; ++way) {
+                std::vector<uint32> &links =
+                    way == 0 ? clusterInfos_[c].links : reverseLinks[c];
+                for (size_t l = 0; l < links.size(); ++l) {
+                    if (clusterInfos_[links[l]].component == 0) {
+                        clusterInfos_[links[l]].component = nbComponents_;
+                        toVisit.push_back(links[l]);
+                    }
+                }
+            }
+        }
+    }
+
+    buildTime_ = fs_utils::microTime() - startTime;
+    searchStamps_.assign(clusterInfos_.size(), 0);
+    searchCosts_.resize(clusterInfos_.size());
+    searchParents_.resize(clusterInfos_.size());
+
+    LOG(Log::k_FLG_GAME, "PathRegions", "build",
+        ("%d clusters, %d components built in %d us", (int)nbClusters(),
+        nbComponents_, (int)buildTime_));
+    return true;
+}
+
+/*!
+ * \param fromIndx Index of start tile in directions map
+ * \param toIndx Index of end tile in directions map
+ * \return false if tiles are not in the same component.
+ */
+bool PathRegions::isReachable(uint32 fromIndx, uint32 toIndx) {
+    stats_.queries++;
+    uint32 fromCluster = clusters_[fromIndx];
+    uint32 toCluster = clusters_[toIndx];
+    if (fromCluster == 0 || toCluster == 0
+        || clusterInfos_[fromCluster].component != clusterInfos_[toCluster].component) {
+        stats_.rejected++;
+        return false;
+    }
+    return true;
+}
+
+/*!
+ * Finds the coarse route between the clusters of the two tiles and marks
+ * its clusters and their direct neighbours as being the corridor.
+ * \param fromIndx Index of start tile in directions map
+ * \param toIndx Index of end tile in directions map
+ * \param pCorridor Where clusters are marked
+ * \return false if no route was found.
+ */
+bool PathRegions::buildCorridor(uint32 fromIndx, uint32 toIndx, corridorDesc *pCorridor) {
+    uint32 fromCluster = clusters_[fromIndx];
+    uint32 toCluster = clusters_[toIndx];
+    if (fromCluster == 0 || toCluster == 0) {
+        return false;
+    }
+
+    SDL_LockMutex(pMutex_);
+    uint64 key = ((uint64)fromCluster << 32) | toCluster;
+    std::map<uint64, std::vector<uint32> >::iterator it = routeCache_.find(key);
+    if (it == routeCache_.end()) {
+        stats_.misses++;
+        uint64 startTime = fs_utils::microTime();
+        std::vector<uint32> route;
+        bool found = searchRoute(fromCluster, toCluster, &route);
+        stats_.queryTime += fs_utils::microTime() - startTime;
+        if (routeCache_.size() >= kMaxCachedRoutes) {
+            routeCache_.clear();
+        }
+        // a missing route is cached as an empty one
+        it = routeCache_.insert(std::make_pair(key, route)).first;
+        if (!found) {
+            it->second.clear();
+        }
+    } else {
+        stats_.hits++;
+    }
+
+    // copied as cache may be cleared by another thread
+    std::vector<uint32> route(it->second);
+    SDL_UnlockMutex(pMutex_);
+
+    if (route.empty()) {
+        return false;
+    }
+
+    if (pCorridor->stamps.size() != clusterInfos_.size()) {
+        pCorridor->stamps.assign(clusterInfos_.size(), 0);
+        pCorridor->gen = 0;
+    }
+    if (++pCorridor->gen == 0) {
+        std::fill(pCorridor->stamps.begin(), pCorridor->stamps.end(), 0);
+        pCorridor->gen = 1;
+    }
+    for (size_t i = 0; i < route.size(); ++i) {
+        pCorridor->stamps[route[i]] = pCorridor->gen;
+        const std::vector<uint32> &links = clusterInfos_[route[i]].links;
+        for (size_t l = 0; l < links.size(); ++l) {
+            pCorridor->stamps[links[l]] = pCorridor->gen;
+        }
+    }
+    return true;
+}
+
+void PathRegions::countFallback() {
+    SDL_LockMutex(pMutex_);
+    stats_.fallbacks++;
+    SDL_UnlockMutex(pMutex_);
+}
+
+/*!
+ * A* over the clusters graph.
+ * \param fromCluster Start cluster
+ * \param toCluster End cluster
+ * \param pRoute Clusters from start to end
+ * \return false if there is no route.
+ */
+bool PathRegions::searchRoute(uint32 fromCluster, uint32 toCluster,
+    std::vector<uint32> *pRoute)
+{
+    if (++searchGen_ == 0) {
+        std::fill(searchStamps_.begin(), searchStamps_.end(), 0);
+        searchGen_ = 1;
+    }
+
+    std::vector<RouteNode> open;
+    searchStamps_[fromCluster] = searchGen_;
+    searchCosts_[fromCluster] = 0;
+    searchParents_[fromCluster] = fromCluster;
+    open.push_back(RouteNode(distance(fromCluster, toCluster), fromCluster));
+
+    bool found = false;
+    while (!open.empty()) {
+        std::pop_heap(open.begin(), open.end(), RouteNodeGreater());
+        RouteNode current = open.back();
+        open.pop_back();
+        uint32 c = current.second;
+        uint32 cost = searchCosts_[c];
+        if (current.first != cost + distance(c, toCluster)) {
+            // cluster has been reached later with a lower cost
+            continue;
+        }
+        if (c == toCluster) {
+            found = true;
+            break;
+        }
+
+        const std::vector<uint32> &links = clusterInfos_[c].links;
+        for (size_t l = 0; l < links.size(); ++l) {
+            uint32 n = links[l];
+            uint32 ncost = cost + distance(c, n);
+            if (searchStamps_[n] == searchGen_ && searchCosts_[n] <= ncost)
+                continue;
+            searchStamps_[n] = searchGen_;
+            searchCosts_[n] = ncost;
+            searchParents_[n] = c;
+            open.push_back(RouteNode(ncost + distance(n, toCluster), n));
+            std::push_heap(open.begin(), open.end(), RouteNodeGreater());
+        }
+    }
+
+    if (found) {
+        for (uint32 c = toCluster; c != fromCluster; c = searchParents_[c]) {
+            pRoute->push_back(c);
+        }
+        pRoute->push_back(fromCluster);
+        std::reverse(pRoute->begin(), pRoute->end());
+    }
+    return found;
+}
+
+//! Distance in tiles between the centers of two clusters
+int PathRegions::distance(uint32 clusterA, uint32 clusterB) const {
+    const ClusterInfo &a = clusterInfos_[clusterA];
+    const ClusterInfo &b = clusterInfos_[clusterB];
+    return std::max(abs(a.x - b.x), std::max(abs(a.y - b.y), abs(a.z - b.z)));
+}
+
+void PathRegions::logStats() const {
+    LOG(Log::k_FLG_GAME, "PathRegions", "logStats",
+        ("queries %d, rejected %d, route cache hits %d, misses %d, fallbacks %d, route search time %d us",
+        stats_.queries, stats_.rejected, stats_.hits, stats_.misses,
+        stats_.fallbacks, (int)stats_.queryTime));
+}
@@ -0,0 +1,137 @@
+/************************************************************************
+ *                                                                      *
+ *  FreeSynd - a remake of the classic Bullfrog game "Syndicate".       *
+ *                                                                      *
+ *   Copyright (C) 2016  Benoit Blancard <benblan@users.sourceforge.net>*
+ *                                                                      *
+ *    This program is free software;  you can redistribute it and / or  *
+ *  modify it  under the  terms of the  GNU General  Public License as  *
+ *  published by the Free Software Foundation; either version 2 of the  *
+ *  License, or (at your option) any later version.                     *
+ *                                                                      *
+ *    This program is  distributed in the hope that it will be useful,  *
+ *  but WITHOUT  ANY WARRANTY;  without even  the implied  warranty of  *
+ *  MERCHANTABILITY  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU  *
+ *  General Public License for more details.                            *
+ *                                                                      *
+ *    You can view the GNU  General Public License, online, at the GNU  *
+ *  project's  web  site;  see <http://www.gnu.org/licenses/gpl.html>.  *
+ *  The full text of the license is also included in the file COPYING.  *
+ *                                                                      *
+ ************************************************************************/
+
+#ifndef PATHREGIONS_H
+#define PATHREGIONS_H
+
+#include <vector>
+#include <map>
+
+#include "common.h"
+#include "pathsurfaces.h"
+
+struct SDL_mutex;
+
+/*!
+ * Abstract graph of the walkable space of a mission.
+ * Map is cut in sectors of kSectorSize x kSectorSize tiles, each set of
+ * connected walkable tiles inside a sector is a cluster and clusters that
+ * have walkable tiles next to each other are linked. Clusters that are
+ * linked together form a component.
+ * It is built once from the directions map and is used to :
+ * - reject in O(1) a path query between two different components
+ * - find a coarse route between far away tiles, the tile path is then
+ *   searched only inside the clusters of that route (the corridor).
+ * Once built, graph is only read except for the route cache and counters
+ * which are protected by a mutex.
+ */
+class PathRegions {
+public:
+    //! Counters of path queries
+    struct Stats {
+        //! Number of reachability queries
+        uint32 queries;
+        //! Number of queries rejected because tiles are not connected
+        uint32 rejected;
+        //! Number of coarse routes found in cache
+        uint32 hits;
+        //! Number of coarse routes searched
+        uint32 misses;
+        //! Number of times the tile search failed inside the corridor
+        uint32 fallbacks;
+        //! Time spent in coarse route searches in microseconds
+        uint64 queryTime;
+    };
+
+    //! Size in tiles of a sector side
+    static const int kSectorSize;
+    //! Under this distance in tiles, a corridor is not used
+    static const int kMinCorridorDistance;
+
+    PathRegions();
+    ~PathRegions();
+
+    //! Builds the graph from given directions map
+    bool build(const floodPointDesc *pPoints, int maxX, int maxY, int maxZ);
+    //! Frees all data
+    void clear();
+
+    //! Returns true if graph has been built
+    bool isBuilt() const { return clusters_ != NULL; }
+    //! Returns false if there can be no path between the two tiles
+    bool isReachable(uint32 fromIndx, uint32 toIndx);
+    //! Marks the clusters of the coarse route between the two tiles
+    bool buildCorridor(uint32 fromIndx, uint32 toIndx, corridorDesc *pCorridor);
+    //! Returns true if tile is in the given corridor
+    bool isInCorridor(uint32 indx, const corridorDesc &corridor) const {
+        return corridor.stamps[clusters_[indx]] == corridor.gen;
+    }
+    //! Called when tile search has failed inside the corridor
+    void countFallback();
+
+    size_t nbClusters() const { return clusterInfos_.size() - 1; }
+    uint32 nbComponents() const { return nbComponents_; }
+    //! Time spent in the last build in microseconds
+    uint64 buildTime() const { return buildTime_; }
+    const Stats & stats() const { return stats_; }
+    //! Writes counters to the log
+    void logStats() const;
+
+protected:
+    //! Description of a cluster
+    struct ClusterInfo {
+        //! Mean position of the cluster tiles
+        int x, y, z;
+        //! Id of the component cluster belongs to
+        uint32 component;
+        //! Clusters that can be reached from this one
+        std::vector<uint32> links;
+    };
+
+    bool searchRoute(uint32 fromCluster, uint32 toCluster,
+        std::vector<uint32> *pRoute);
+    int distance(uint32 clusterA, uint32 clusterB) const;
+
+protected:
+    //! Maximum number of routes kept in cache
+    static const size_t kMaxCachedRoutes;
+
+    int maxX_, maxY_, maxZ_, maxXY_;
+    //! Cluster id of each tile, 0 for non walkable tiles
+    uint32 *clusters_;
+    //! Clusters data, index 0 is unused
+    std::vector<ClusterInfo> clusterInfos_;
+    uint32 nbComponents_;
+    //! Routes already searched, key is (from cluster << 32 | to cluster)
+    std::map<uint64, std::vector<uint32> > routeCache_;
+    //! Working data of route search, valid when stamp equals searchGen_
+    std::vector<uint32> searchStamps_;
+    std::vector<uint32> searchCosts_;
+    std::vector<uint32> searchParents_;
+    uint32 searchGen_;
+    uint64 buildTime_;
+    Stats stats_;
+    //! Corridors can be built from path workers threads
+    SDL_mutex *pMutex_;
+};
+
+#endif
@@ -23,6 +23,10 @@
 #ifndef PATHSURFACES_H
 #define PATHSURFACES_H
 
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
 #include "common.h"
 #include "model/position.h"
 
@@ -107,5 +111,313 @@
         uint16 n;
     } lvlNodesDesc;
 
+    /*!
+     * Working data of a ped path search.
+     * nodes is a mirror of the mission directions map in which the search
+     * marks base, target and link points. Every node that the search modifies
+     * is recorded in bv or tv, so only those nodes have to be restored
+     * before the next search instead of copying back the whole map.
+     */
+    class floodSearchDesc {
+    public:
+        floodSearchDesc() : nodes(NULL) {}
+
+        //! Allocates the mirror as a copy of pOrigin
+        bool allocate(const floodPointDesc *pOrigin, uint32 nb) {
+            release();
+            nodes = (floodPointDesc *)malloc(nb * sizeof(floodPointDesc));
+            if (nodes == NULL) {
+                return false;
+            }
+            memcpy((void *)nodes, (const void *)pOrigin, nb * sizeof(floodPointDesc));
+            bv.reserve(8192);
+            tv.reserve(8192);
+            bn.reserve(512);
+            tn.reserve(512);
+            return true;
+        }
+
+        void release() {
+            free(nodes);
+            nodes = NULL;
+            bv.clear();
+            tv.clear();
+            bn.clear();
+            tn.clear();
+        }
+
+        //! Drops every mark left by the last search, nodes become equal to pOrigin again
+        void reset(const floodPointDesc *pOrigin) {
+            for (std::vector <toSetDesc>::iterator it = bv.begin();
+                it != bv.end(); ++it) {
+                *(it->pNode) = pOrigin[it->pNode - nodes];
+            }
+            for (std::vector <toSetDesc>::iterator it = tv.begin();
+                it != tv.end(); ++it) {
+                *(it->pNode) = pOrigin[it->pNode - nodes];
+            }
+            bv.clear();
+            tv.clear();
+            bn.clear();
+            tn.clear();
+        }
+
+        //! mirror of the directions map, modified by search
+        floodPointDesc *nodes;
+        //! nodes reached from base
+        std::vector <toSetDesc> bv;
+        //! nodes reached from target
+        std::vector <toSetDesc> tv;
+        //! number of nodes per level and index start in bv
+        std::vector <lvlNodesDesc> bn;
+        //! number of nodes per level and index start in tv
+        std::vector <lvlNodesDesc> tn;
+    };
+
+    /*!
+     * Working data of the A* ped path search.
+     * Arrays are indexed like the directions map. A node entry is valid only
+     * when its stamp equals the current generation, so nothing has to be
+     * cleared between searches.
+     */
+    class astarSearchDesc {
+    public:
+        //! An entry in the open list
+        struct openNode {
+            //! cost from base + estimated cost to target
+            uint32 f;
+            //! estimated cost to target
+            uint32 h;
+            //! index of the node in the directions map
+            uint32 indx;
+        };
+
+        astarSearchDesc() : generation(0), nbNodes(0), stamps(NULL),
+            costs(NULL), parents(NULL) {}
+
+        //! Allocates arrays for a map of given number of nodes
+        bool allocate(uint32 nb) {
+            release();
+            stamps = (uint32 *)malloc(nb * sizeof(uint32));
+            costs = (uint32 *)malloc(nb * sizeof(uint32));
+            parents = (uint32 *)malloc(nb * sizeof(uint32));
+            if (stamps == NULL || costs == NULL || parents == NULL) {
+                release();
+                return false;
+            }
+            memset((void *)stamps, 0, nb * sizeof(uint32));
+            nbNodes = nb;
+            generation = 0;
+            return true;
+        }
+
+        void release() {
+            free(stamps);
+            free(costs);
+            free(parents);
+            stamps = NULL;
+            costs = NULL;
+            parents = NULL;
+            nbNodes = 0;
+            open.clear();
+        }
+
+        //! Starts a new search, previous node entries become invalid
+        void newSearch() {
+            open.clear();
+            if (++generation == 0) {
+                // stamps wrapped, old stamps could be taken as valid
+                memset((void *)stamps, 0, nbNodes * sizeof(uint32));
+                generation = 1;
+            }
+        }
+
+        //! Current search generation
+        uint32 generation;
+        //! Number of nodes in arrays
+        uint32 nbNodes;
+        //! generation in which node has been reached
+        uint32 *stamps;
+        //! number of steps from base to node
+        uint32 *costs;
+        //! index of node from which node has been reached
+        uint32 *parents;
+        //! binary heap of nodes to expand
+        std::vector <openNode> open;
+    };
+
+    /*!
+     * Working data of the A* search of vehicle routes.
+     * A node is a tile of the road level entered in one of 4 directions,
+     * because a vehicle can't turn back. Arrays are indexed by node and a
+     * node entry is valid only when its stamp equals the current generation.
+     * The open list is a binary heap that keeps the position of each node,
+     * so a node is moved up in place when a shorter way to it is found.
+     */
+    class carSearchDesc {
+    public:
+        //! heap position of a node that is not in the open list
+        static const uint32 kNotInOpen = 0xFFFFFFFF;
+
+        carSearchDesc() : generation(0), nbNodes(0), stamps(NULL),
+            costs(NULL), estimates(NULL), parents(NULL), heapPos(NULL) {}
+
+        //! Allocates arrays for a map of given number of nodes
+        bool allocate(uint32 nb) {
+            release();
+            stamps = (uint32 *)malloc(nb * sizeof(uint32));
+            costs = (uint32 *)malloc(nb * sizeof(uint32));
+            estimates = (uint32 *)malloc(nb * sizeof(uint32));
+            parents = (uint32 *)malloc(nb * sizeof(uint32));
+            heapPos = (uint32 *)malloc(nb * sizeof(uint32));
+            if (stamps == NULL || costs == NULL || estimates == NULL
+                || parents == NULL || heapPos == NULL) {
+                release();
+                return false;
+            }
+            memset((void *)stamps, 0, nb * sizeof(uint32));
+            nbNodes = nb;
+            generation = 0;
+            open.reserve(1024);
+            return true;
+        }
+
+        void release() {
+            free(stamps);
+            free(costs);
+            free(estimates);
+            free(parents);
+            free(heapPos);
+            stamps = NULL;
+            costs = NULL;
+            estimates = NULL;
+            parents = NULL;
+            heapPos = NULL;
+            nbNodes = 0;
+            open.clear();
+        }
+
+        //! Starts a new search, previous node entries become invalid
+        void newSearch() {
+            open.clear();
+            if (++generation == 0) {
+                // stamps wrapped, old stamps could be taken as valid
+                memset((void *)stamps, 0, nbNodes * sizeof(uint32));
+                generation = 1;
+            }
+        }
+
+        //! Marks the node as reached by this search, out of the open list
+        void reach(uint32 indx) {
+            stamps[indx] = generation;
+            heapPos[indx] = kNotInOpen;
+        }
+
+        //! Adds the node to the open list or moves it up after its cost has been lowered
+        void push(uint32 indx) {
+            if (heapPos[indx] == kNotInOpen) {
+                heapPos[indx] = open.size();
+                open.push_back(indx);
+            }
+            siftUp(heapPos[indx]);
+        }
+
+        //! Removes the node with the lowest cost from the open list and returns it
+        uint32 pop() {
+            uint32 top = open[0];
+            heapPos[top] = kNotInOpen;
+            open[0] = open.back();
+            open.pop_back();
+            if (!open.empty()) {
+                heapPos[open[0]] = 0;
+                siftDown(0);
+            }
+            return top;
+        }
+
+        //! Current search generation
+        uint32 generation;
+        //! Number of nodes in arrays
+        uint32 nbNodes;
+        //! generation in which node has been reached
+        uint32 *stamps;
+        //! number of steps from base to node
+        uint32 *costs;
+        //! estimated number of steps from node to target
+        uint32 *estimates;
+        //! index of node from which node has been reached
+        uint32 *parents;
+        //! position of node in open or kNotInOpen
+        uint32 *heapPos;
+        //! binary heap of nodes to expand
+        std::vector <uint32> open;
+
+    private:
+        //! lowest cost first then closest to target
+        bool isBefore(uint32 a, uint32 b) const {
+            uint32 fa = costs[a] + estimates[a];
+            uint32 fb = costs[b] + estimates[b];
+            if (fa != fb)
+                return fa < fb;
+            return estimates[a] < estimates[b];
+        }
+
+        void siftUp(uint32 pos) {
+            uint32 indx = open[pos];
+            while (pos > 0) {
+                uint32 up = (pos - 1) / 2;
+                if (!isBefore(indx, open[up]))
+                    break;
+                open[pos] = open[up];
+                heapPos[open[pos]] = pos;
+                pos = up;
+            }
+            open[pos] = indx;
+            heapPos[indx] = pos;
+        }
+
+        void siftDown(uint32 pos) {
+            uint32 indx = open[pos];
+            uint32 size = open.size();
+            while (true) {
+                uint32 child = pos * 2 + 1;
+                if (child >= size)
+                    break;
+                if (child + 1 < size && isBefore(open[child + 1], open[child]))
+                    child++;
+                if (!isBefore(open[child], indx))
+                    break;
+                open[pos] = open[child];
+                heapPos[open[pos]] = pos;
+                pos = child;
+            }
+            open[pos] = indx;
+            heapPos[indx] = pos;
+        }
+    };
+
+    /*!
+     * Clusters of walkable regions a path search is restricted to.
+     * A cluster is in the corridor when its stamp equals gen.
+     * \see PathRegions
+     */
+    class corridorDesc {
+    public:
+        corridorDesc() : gen(0) {}
+
+        std::vector <uint32> stamps;
+        uint32 gen;
+    };
+
+    /*!
+     * All the working data of one ped path search. Mission owns one for
+     * the searches done in the main thread and each path worker owns its own.
+     */
+    struct pathSearchDesc {
+        floodSearchDesc flood;
+        astarSearchDesc astar;
+        corridorDesc corridor;
+    };
+
 #endif
 
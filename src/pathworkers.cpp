@@ -0,0 +1,204 @@
+/************************************************************************
+ *                                                                      *
+ *  FreeSynd - a remake of the classic Bullfrog game "Syndicate".       *
+ *                                                                      *
+ *   Copyright (C) 2016  Benoit Blancard <benblan@users.sourceforge.net>*
+ *                                                                      *
+ *    This program is free software;  you can redistribute it and / or  *
+ *  modify it  under the  terms of the  GNU General  Public License as  *
+ *  published by the Free Software Foundation; either version 2 of the  *
+ *  License, or (at your option) any later version.                     *
+ *                                                                      *
+ *    This program is  distributed in the hope that it will be useful,  *
+ *  but WITHOUT  ANY WARRANTY;  without even  the implied  warranty of  *
+ *  MERCHANTABILITY  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU  *
+ *  General Public License for more details.                            *
+ *                                                                      *
+ *    You can view the GNU  General Public License, online, at the GNU  *
+ *  project's  web  site;  see <http://www.gnu.org/licenses/gpl.html>.  *
+ *  The full text of the license is also included in the file COPYING.  *
+ *                                                                      *
+ ************************************************************************/
+
+#include "SDL.h"
+
+#include "pathworkers.h"
+#include "mission.h"
+#include "ped.h"
+#include "utils/log.h"
+#include "utils/profiler.h"
+
+PathWorkers::PathWorkers(Mission *pMission) {
+    pMission_ = pMission;
+    nextRequest_ = 0;
+    nbDone_ = 0;
+    lastId_ = 0;
+    stopping_ = false;
+    pMutex_ = SDL_CreateMutex();
+    pWorkCond_ = SDL_CreateCond();
+    pDoneCond_ = SDL_CreateCond();
+}
+
+PathWorkers::~PathWorkers() {
+    stop();
+    SDL_DestroyCond(pDoneCond_);
+    SDL_DestroyCond(pWorkCond_);
+    SDL_DestroyMutex(pMutex_);
+}
+
+/*!
+ * Each worker gets its own copy of the mission directions map.
+ * \param nbWorkers Number of threads
+ * \return false if no thread could be started.
+ */
+bool PathWorkers::start(int nbWorkers) {
+    uint32 nbNodes = pMission_->mmax_x_ * pMission_->mmax_y_ * pMission_->mmax_z_;
+    stopping_ = false;
+
+    for (int i = 0; i < nbWorkers; i++) {
+        Worker *pWorker = new Worker();
+        pWorker->pOwner = this;
+        pWorker->pThread = NULL;
+        if (!pWorker->search.flood.allocate(pMission_->mdpoints_, nbNodes)) {
+            FSERR(Log::k_FLG_GAME, "PathWorkers", "start", ("Memory allocation error\n"));
+            delete pWorker;
+            break;
+        }
+        pWorker->pThread = SDL_CreateThread(workerLoop, pWorker);
+        if (pWorker->pThread == NULL) {
+            FSERR(Log::k_FLG_GAME, "PathWorkers", "start", ("Unable to create thread : %s\n", SDL_GetError()));
+            pWorker->search.flood.release();
+            delete pWorker;
+            break;
+        }
+        workers_.push_back(pWorker);
+    }
+
+    LOG(Log::k_FLG_GAME, "PathWorkers", "start", ("%d path workers started", (int)workers_.size()));
+    return !workers_.empty();
+}
+
+void PathWorkers::stop() {
+    SDL_LockMutex(pMutex_);
+    stopping_ = true;
+    SDL_CondBroadcast(pWorkCond_);
+    SDL_UnlockMutex(pMutex_);
+
+    for (size_t i = 0; i < workers_.size(); i++) {
+        SDL_WaitThread(workers_[i]->pThread, NULL);
+        workers_[i]->search.flood.release();
+        workers_[i]->search.astar.release();
+        delete workers_[i];
+    }
+    workers_.clear();
+
+    for (size_t i = 0; i < requests_.size(); i++) {
+        delete requests_[i];
+    }
+    requests_.clear();
+    nextRequest_ = 0;
+    nbDone_ = 0;
+}
+
+/*!
+ * \param pPed Ped that asks for a path
+ * \param basePt Where the ped is
+ * \param destPt Where the ped goes, already clipped to the map
+ * \param newSpeed Speed the ped will walk at
+ * \return id of the request.
+ */
+uint32 PathWorkers::request(PedInstance *pPed, const TilePoint &basePt,
+    const TilePoint &destPt, int newSpeed)
+{
+    Request *pRequest = new Request();
+    pRequest->pPed = pPed;
+    pRequest->basePt = basePt;
+    pRequest->destPt = destPt;
+    pRequest->newSpeed = newSpeed;
+    pRequest->done = false;
+    pRequest->found = false;
+
+    SDL_LockMutex(pMutex_);
+    // 0 is never used as an id, so a ped can use it as "no request"
+    if (++lastId_ == 0) {
+        lastId_ = 1;
+    }
+    pRequest->id = lastId_;
+    requests_.push_back(pRequest);
+    SDL_CondSignal(pWorkCond_);
+    SDL_UnlockMutex(pMutex_);
+
+    return pRequest->id;
+}
+
+/*!
+ * Called by the game at the same point of each tick, before peds post
+ * new requests, so the requests of the previous tick have been searched
+ * during the rest of that tick and the rendering of the frame. Blocks only
+ * if workers are not done yet, as paths must be applied at the same tick
+ * whatever the threads timing.
+ */
+void PathWorkers::applyResults() {
+    std::vector<Request *> results;
+
+    SDL_LockMutex(pMutex_);
+    if (requests_.empty()) {
+        SDL_UnlockMutex(pMutex_);
+        return;
+    }
+    while (nbDone_ != requests_.size()) {
+        SDL_CondWait(pDoneCond_, pMutex_);
+    }
+    results.swap(requests_);
+    nextRequest_ = 0;
+    nbDone_ = 0;
+    SDL_UnlockMutex(pMutex_);
+
+    for (size_t i = 0; i < results.size(); i++) {
+        Request *pRequest = results[i];
+        pRequest->pPed->applyPathResult(pMission_, pRequest->id, pRequest->found,
+            pRequest->path, pRequest->destPt, pRequest->newSpeed);
+        delete pRequest;
+    }
+}
+
+size_t PathWorkers::nbPending() {
+    SDL_LockMutex(pMutex_);
+    size_t nb = requests_.size();
+    SDL_UnlockMutex(pMutex_);
+    return nb;
+}
+
+int PathWorkers::workerLoop(void *pData) {
+    Worker *pWorker = static_cast<Worker *>(pData);
+    Profiler::setThreadName("path worker");
+    pWorker->pOwner->processRequests(pWorker);
+    return 0;
+}
+
+/*!
+ * Takes requests one by one until pool is stopped.
+ * \param pWorker The worker running this loop
+ */
+void PathWorkers::processRequests(Worker *pWorker) {
+    SDL_LockMutex(pMutex_);
+    while (!stopping_) {
+        if (nextRequest_ == requests_.size()) {
+            SDL_CondWait(pWorkCond_, pMutex_);
+            continue;
+        }
+
+        Request *pRequest = requests_[nextRequest_++];
+        SDL_UnlockMutex(pMutex_);
+
+        pRequest->path.reserve(256);
+        pRequest->found = PedInstance::findPath(pMission_, pRequest->basePt,
+            pRequest->destPt, &(pWorker->search), pRequest->path);
+
+        SDL_LockMutex(pMutex_);
+        pRequest->done = true;
+        nbDone_++;
+        SDL_CondSignal(pDoneCond_);
+    }
+    SDL_UnlockMutex(pMutex_);
+}
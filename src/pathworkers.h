@@ -0,0 +1,111 @@
+/************************************************************************
+ *                                                                      *
+ *  FreeSynd - a remake of the classic Bullfrog game "Syndicate".       *
+ *                                                                      *
+ *   Copyright (C) 2016  Benoit Blancard <benblan@users.sourceforge.net>*
+ *                                                                      *
+ *    This program is free software;  you can redistribute it and / or  *
+ *  modify it  under the  terms of the  GNU General  Public License as  *
+ *  published by the Free Software Foundation; either version 2 of the  *
+ *  License, or (at your option) any later version.                     *
+ *                                                                      *
+ *    This program is  distributed in the hope that it will be useful,  *
+ *  but WITHOUT  ANY WARRANTY;  without even  the implied  warranty of  *
+ *  MERCHANTABILITY  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU  *
+ *  General Public License for more details.                            *
+ *                                                                      *
+ *    You can view the GNU  General Public License, online, at the GNU  *
+ *  project's  web  site;  see <http://www.gnu.org/licenses/gpl.html>.  *
+ *  The full text of the license is also included in the file COPYING.  *
+ *                                                                      *
+ ************************************************************************/
+
+#ifndef PATHWORKERS_H
+#define PATHWORKERS_H
+
+#include <vector>
+
+#include "common.h"
+#include "pathsurfaces.h"
+#include "model/position.h"
+
+struct SDL_Thread;
+struct SDL_mutex;
+struct SDL_cond;
+class Mission;
+class PedInstance;
+
+/*!
+ * A pool of threads that search paths for peds.
+ * Peds post their requests during a tick, workers search them in
+ * parallel, each with its own search data, while the rest of the tick and
+ * the frame are processed. At a fixed point of the next tick,
+ * applyResults() gives the paths to the peds in the order of the requests,
+ * waiting only for the requests that are not done yet. That way, the result
+ * of a mission does not depend on the threads timing and the main thread
+ * does not wait for the searches it has just posted.
+ * Workers only read mission surfaces, so those must not change while the
+ * pool exists.
+ */
+class PathWorkers {
+public:
+    PathWorkers(Mission *pMission);
+    ~PathWorkers();
+
+    //! Starts the given number of threads
+    bool start(int nbWorkers);
+    //! Stops all threads, pending requests are dropped
+    void stop();
+
+    //! Posts a path request and returns its id
+    uint32 request(PedInstance *pPed, const TilePoint &basePt,
+        const TilePoint &destPt, int newSpeed);
+    //! Gives paths of pending requests to peds
+    void applyResults();
+
+    //! Returns the number of requests not yet applied
+    size_t nbPending();
+
+protected:
+    //! A path request
+    struct Request {
+        uint32 id;
+        PedInstance *pPed;
+        TilePoint basePt;
+        TilePoint destPt;
+        int newSpeed;
+        //! Set by worker when search is over
+        bool done;
+        bool found;
+        std::vector<TilePoint> path;
+    };
+
+    //! A thread with its search data
+    struct Worker {
+        PathWorkers *pOwner;
+        SDL_Thread *pThread;
+        pathSearchDesc search;
+    };
+
+    static int workerLoop(void *pData);
+    void processRequests(Worker *pWorker);
+
+protected:
+    Mission *pMission_;
+    std::vector<Worker *> workers_;
+    /*! Requests not yet applied, in order of arrival.*/
+    std::vector<Request *> requests_;
+    /*! Index of the first request not taken by a worker.*/
+    size_t nextRequest_;
+    /*! Number of requests done by workers.*/
+    size_t nbDone_;
+    uint32 lastId_;
+    bool stopping_;
+    SDL_mutex *pMutex_;
+    /*! Signaled when a request is posted or when pool stops.*/
+    SDL_cond *pWorkCond_;
+    /*! Signaled when a request is done.*/
+    SDL_cond *pDoneCond_;
+};
+
+#endif
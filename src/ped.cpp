@@ -732,6 +732,8 @@ PedInstance::PedInstance(Ped *ped, uint16 anId, int m, bool isOur) :
     pUseWeaponAction_ = NULL;
     panicImmuned_ = false;
     totalPersuasionPoints_ = 0;
+    pathRequestId_ = 0;
+    pathRequestFailed_ = false;
     pSelectedWeaponBeforeMedikit_ = NULL;
 }
 
@@ -335,6 +335,24 @@ public:
     //*************************************
     //! See ShootableMovableMapObject::initMovementToDestination()
     bool initMovementToDestination(Mission *m, const TilePoint &destinationPt, int newSpeed = -1);
+    //! Same as initMovementToDestination() but path may be searched by path workers
+    bool requestMovementToDestination(Mission *m, const TilePoint &destinationPt, int newSpeed = -1);
+    //! Sets the path found by path workers for the given request
+    void applyPathResult(Mission *m, uint32 requestId, bool found,
+        std::vector<TilePoint> &path, const TilePoint &destinationPt, int newSpeed);
+    //! Returns true if ped is waiting for path workers to find its path
+    bool isWaitingForPath() { return pathRequestId_ != 0; }
+    //! Returns true if path workers found no path for last request
+    bool hasPathRequestFailed() { return pathRequestFailed_; }
+    //! Clears destination and drops pending path request
+    void clearDestination() {
+        ShootableMovableMapObject::clearDestination();
+        pathRequestId_ = 0;
+        pathRequestFailed_ = false;
+    }
+    //! Searches a path between two points
+    static bool findPath(Mission *m, const TilePoint &basePt, const TilePoint &clippedDestPt,
+        pathSearchDesc *pSearch, std::vector<TilePoint> &pathToDestination);
 
     //! See ShootableMovableMapObject::doMove()
     bool doMove(int elapsed, Mission *pMission);
@@ -599,6 +617,7 @@ public:
         return hostiles_found_.find(hostile_found)
             != hostiles_found_.end();
     }
+    //! Unused : the sight of AI peds is checked by FollowToShootAction through Mission::perception()
     void verifyHostilesFound(Mission *m);
     bool getHostilesFoundIt(Msmod_t::iterator &it_s, Msmod_t::iterator &it_e)
     {
@@ -661,10 +680,15 @@ protected:
 
 private:
     inline int getClosestDirs(int dir, int& closest, int& closer);
-    bool floodMap(Mission *m, const TilePoint &clippedDestPt, floodPointDesc *mdpmirror);
-    void removeTilesWithNoChildsFromBase(Mission *m, unsigned short blvl, std::vector <toSetDesc> &bv, std::vector <lvlNodesDesc> &bn, floodPointDesc *mdpmirror);
-    void removeTilesWithNoChildsFromTarget(Mission *m, unsigned short tlvl, std::vector <toSetDesc> &tv, std::vector <lvlNodesDesc> &tn, floodPointDesc *mdpmirror);
-    void createPath(Mission *m, floodPointDesc *mdpmirror, std::vector<TilePoint> &cdestpath);
+    bool checkMovementToDestination(Mission *m, const TilePoint &destinationPt, TilePoint *pClippedDestPt);
+    bool setPathToDestination(Mission *m, std::vector<TilePoint> &cdestpath, const TilePoint &destinationPt, int newSpeed);
+    static bool findPathFlood(Mission *m, const TilePoint &basePt, const TilePoint &clippedDestPt, pathSearchDesc *pSearch, std::vector<TilePoint> &pathToDestination);
+    static bool findPathAStar(Mission *m, const TilePoint &basePt, const TilePoint &clippedDestPt, pathSearchDesc *pSearch, std::vector<TilePoint> &pathToDestination);
+    static bool searchAStar(Mission *m, const TilePoint &basePt, const TilePoint &clippedDestPt, pathSearchDesc *pSearch, bool inCorridor, std::vector<TilePoint> &pathToDestination);
+    static bool floodMap(Mission *m, const TilePoint &basePt, const TilePoint &clippedDestPt, floodSearchDesc *pSearch);
+    static void removeTilesWithNoChildsFromBase(Mission *m, unsigned short blvl, std::vector <toSetDesc> &bv, std::vector <lvlNodesDesc> &bn, floodPointDesc *mdpmirror);
+    static void removeTilesWithNoChildsFromTarget(Mission *m, unsigned short tlvl, std::vector <toSetDesc> &tv, std::vector <lvlNodesDesc> &tn, floodPointDesc *mdpmirror);
+    static void createPath(Mission *m, const TilePoint &basePt, floodPointDesc *mdpmirror, std::vector<TilePoint> &cdestpath);
     void buildFinalDestinationPath(Mission *m, std::vector<TilePoint> &cdestpath, const TilePoint &destinationPt);
 
 protected:
@@ -746,6 +770,10 @@ protected:
     bool panicImmuned_;
     //! This field is used to select a weapon after medikit was used
     WeaponInstance *pSelectedWeaponBeforeMedikit_;
+    //! Id of the path request posted to path workers, 0 if none
+    uint32 pathRequestId_;
+    //! True if path workers found no path for last request
+    bool pathRequestFailed_;
 };
 
 #endif
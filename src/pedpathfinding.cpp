@@ -24,17 +24,21 @@
  *                                                                      *
  ************************************************************************/
 
+#include <algorithm>
+
 #include "common.h"
+#include "appcontext.h"
 #include "mission.h"
 #include "ped.h"
 #include "pathsurfaces.h"
+#include "pathworkers.h"
 #include "gfx/tile.h"
 #include "utils/log.h"
+#include "utils/profiler.h"
 
-#if 0
-#include "SDL.h"
-#define EXECUTION_SPEED_TIME
-#endif
+// Define this to run both path finders on each request and log
+// when they disagree on the path length
+//#define CHECK_PATHFINDER_PATHS
 
 const uint8 floodPointDesc::kBMaskDirNorth = 0x10;
 const uint8 floodPointDesc::kBMaskDirNorthEast = 0x08;
@@ -46,31 +50,27 @@ const uint8 floodPointDesc::kBMaskDirWest = 0x40;
 const uint8 floodPointDesc::kBMaskDirNorthWest = 0x20;
 
 /*!
- * Sets a destination point for the ped to reach at given speed.
+ * Verifies that a path can exist to the given destination.
+ * Any current path or pending path request is dropped.
  * \param m
- * \param node destination point
- * \param newSpeed Speed of movement
- * \return true if destination has been set correctly.
+ * \param destinationPt destination point
+ * \param pClippedDestPt destination clipped to the map
+ * \return true if a path search is worth it.
  */
-bool PedInstance::initMovementToDestination(Mission *m, const TilePoint &destinationPt, int newSpeed) {
+bool PedInstance::checkMovementToDestination(Mission *m, const TilePoint &destinationPt, TilePoint *pClippedDestPt) {
 
     dest_path_.clear();
+    pathRequestId_ = 0;
+    pathRequestFailed_ = false;
 
     if (health_ <= 0) {
         return false;
     }
 
-    TilePoint clippedDestPt(destinationPt);
+    TilePoint &clippedDestPt = *pClippedDestPt;
+    clippedDestPt = destinationPt;
     m->get_map()->clip(&clippedDestPt);
 
-    // NOTE: this is a "flood" algorithm, it expands until it reaches other's
-    // flood point, then it removes unrelated points
-#ifdef EXECUTION_SPEED_TIME
-    printf("---------------------------");
-    printf("start time %i.%i\n", SDL_GetTicks()/1000, SDL_GetTicks()%1000);
-#endif
-
-
     floodPointDesc *targetd = &(m->mdpoints_[clippedDestPt.tx + clippedDestPt.ty * m->mmax_x_ + clippedDestPt.tz * m->mmax_m_xy]);
 
     floodPointDesc *based = &(m->mdpoints_[pos_.tx
@@ -116,39 +116,137 @@ bool PedInstance::initMovementToDestination(Mission *m, const TilePoint &destina
         // path finding even if costly
         return false;
     }
-#ifdef EXECUTION_SPEED_TIME
-    printf("directions-map copy start %i.%i\n", SDL_GetTicks()/1000, SDL_GetTicks()%1000);
-#endif
-    floodPointDesc *mdpmirror = m->mdpoints_cp_;
-    memcpy((void *)mdpmirror, (void *)m->mdpoints_,
-        m->mmax_x_ * m->mmax_y_ * m->mmax_z_ * sizeof(floodPointDesc));
 
-#ifdef EXECUTION_SPEED_TIME
-    printf("directions-map copy complete %i.%i\n", SDL_GetTicks()/1000, SDL_GetTicks()%1000);
-#endif
+    if (m->mdregions_.isBuilt() && !m->mdregions_.isReachable(
+        pos_.tx + pos_.ty * m->mmax_x_ + pos_.tz * m->mmax_m_xy,
+        clippedDestPt.tx + clippedDestPt.ty * m->mmax_x_ + clippedDestPt.tz * m->mmax_m_xy))
+    {
+        // no need to search, destination is not connected to ped position
+        return false;
+    }
 
-    if (!floodMap(m, clippedDestPt, mdpmirror)) {
+    return true;
+}
+
+/*!
+ * Sets a destination point for the ped to reach at given speed.
+ * \param m
+ * \param node destination point
+ * \param newSpeed Speed of movement
+ * \return true if destination has been set correctly.
+ */
+bool PedInstance::initMovementToDestination(Mission *m, const TilePoint &destinationPt, int newSpeed) {
+    TilePoint clippedDestPt;
+    if (!checkMovementToDestination(m, destinationPt, &clippedDestPt)) {
         return false;
     }
 
-#ifdef EXECUTION_SPEED_TIME
-    printf("non-related removed time %i.%i\n", SDL_GetTicks()/1000, SDL_GetTicks()%1000);
-#endif
+    // NOTE: path is searched either with the "flood" algorithm or with A*,
+    // depending on the configuration (see findPathFlood, findPathAStar)
 
     // path is created here
     std::vector<TilePoint> cdestpath;
     cdestpath.reserve(256);
 
-    createPath(m, mdpmirror, cdestpath);
+    bool found = findPath(m, pos_, clippedDestPt, &(m->mdsearch_), cdestpath);
+
+#ifdef CHECK_PATHFINDER_PATHS
+    {
+        std::vector<TilePoint> otherpath;
+        bool otherFound = g_Ctx.getPathFinder() == AppContext::PATHFINDER_ASTAR ?
+            findPathFlood(m, pos_, clippedDestPt, &(m->mdsearch_), otherpath) :
+            findPathAStar(m, pos_, clippedDestPt, &(m->mdsearch_), otherpath);
+        if (found != otherFound || cdestpath.size() != otherpath.size()) {
+            std::string posAsStr;
+            clippedDestPt.toString(&posAsStr);
+            LOG(Log::k_FLG_GAME, "PedInstance", "initMovementToDestination",
+                ("Ped %d : path finders differ to %s : %d steps / %d steps",
+                id_, posAsStr.c_str(), found ? (int)cdestpath.size() : -1,
+                otherFound ? (int)otherpath.size() : -1));
+        }
+    }
+#endif
+
+    if (!found) {
+        return false;
+    }
+
+    return setPathToDestination(m, cdestpath, clippedDestPt, newSpeed);
 
-#ifdef EXECUTION_SPEED_TIME
-    printf("path creation time %i.%i\n", SDL_GetTicks()/1000, SDL_GetTicks()%1000);
+#if 0
+    for (std::list <TilePoint>::iterator it = dest_path_.begin();
+        it != dest_path_.end(); ++it) {
+        printf("x %i, y %i, z %i\n", it->bfNodeDescileX(),it->tileY(),it->tileZ());
+    }
 #endif
+}
 
+/*!
+ * Same as initMovementToDestination() but when mission has path workers
+ * the path is searched by them : the method returns as soon as the request
+ * is posted and the ped waits for the result (see isWaitingForPath()).
+ * \param m
+ * \param destinationPt destination point
+ * \param newSpeed Speed of movement
+ * \return false if destination cannot be reached.
+ */
+bool PedInstance::requestMovementToDestination(Mission *m, const TilePoint &destinationPt, int newSpeed) {
+    PathWorkers *pWorkers = m->pathWorkers();
+    if (pWorkers == NULL) {
+        return initMovementToDestination(m, destinationPt, newSpeed);
+    }
+
+    TilePoint clippedDestPt;
+    if (!checkMovementToDestination(m, destinationPt, &clippedDestPt)) {
+        return false;
+    }
+
+    // ped does not move until path is found
+    speed_ = 0;
+    pathRequestId_ = pWorkers->request(this, pos_, clippedDestPt, newSpeed);
+    return true;
+}
+
+/*!
+ * Called by path workers when the path for a request has been searched.
+ * \param m
+ * \param requestId Id of the request
+ * \param found True if a path has been found
+ * \param path Tiles to walk
+ * \param destinationPt destination point
+ * \param newSpeed Speed of movement
+ */
+void PedInstance::applyPathResult(Mission *m, uint32 requestId, bool found,
+    std::vector<TilePoint> &path, const TilePoint &destinationPt, int newSpeed)
+{
+    if (requestId != pathRequestId_) {
+        // ped has asked for another path since
+        return;
+    }
+    pathRequestId_ = 0;
+
+    if (health_ <= 0 || !found || !setPathToDestination(m, path, destinationPt, newSpeed)) {
+        dest_path_.clear();
+        speed_ = 0;
+        pathRequestFailed_ = true;
+    }
+}
+
+/*!
+ * Smoothes the given tiles path into the ped destination path.
+ * \param m
+ * \param cdestpath tiles to walk, excluding current ped tile
+ * \param destinationPt destination point
+ * \param newSpeed Speed of movement
+ * \return true if destination has been set correctly.
+ */
+bool PedInstance::setPathToDestination(Mission *m, std::vector<TilePoint> &cdestpath,
+    const TilePoint &destinationPt, int newSpeed)
+{
     // TODO: smoother path
     // stairs to surface, surface to stairs correction
     if (!cdestpath.empty()) {
-        buildFinalDestinationPath(m, cdestpath, clippedDestPt);
+        buildFinalDestinationPath(m, cdestpath, destinationPt);
     }
 
     if (dest_path_.empty()) {
@@ -160,37 +258,230 @@ bool PedInstance::initMovementToDestination(Mission *m, const TilePoint &destina
         speed_ = newSpeed != -1 ? newSpeed : getDefaultSpeed();
         return true;
     }
+}
 
-#if 0
-    for (std::list <TilePoint>::iterator it = dest_path_.begin();
-        it != dest_path_.end(); ++it) {
-        printf("x %i, y %i, z %i\n", it->bfNodeDescileX(),it->tileY(),it->tileZ());
+/*!
+ * Searches a path with the algorithm selected in configuration.
+ * It only reads mission surfaces and may be called from path workers.
+ * \param m
+ * \param basePt starting point
+ * \param clippedDestPt destination point
+ * \param pSearch working data for the search
+ * \param pathToDestination tiles to walk, excluding starting tile
+ * \return false if no path was found.
+ */
+bool PedInstance::findPath(Mission *m, const TilePoint &basePt, const TilePoint &clippedDestPt,
+    pathSearchDesc *pSearch, std::vector<TilePoint> &pathToDestination)
+{
+    PROFILE_ZONE("PedInstance::findPath");
+    if (g_Ctx.getPathFinder() == AppContext::PATHFINDER_ASTAR) {
+        return findPathAStar(m, basePt, clippedDestPt, pSearch, pathToDestination);
     }
-#endif
-#ifdef EXECUTION_SPEED_TIME
-    dest_path_.clear();
-    printf("+++++++++++++++++++++++++++");
-    printf("end time %i.%i\n", SDL_GetTicks()/1000, SDL_GetTicks()%1000);
-#endif
+    return findPathFlood(m, basePt, clippedDestPt, pSearch, pathToDestination);
+}
+
+/*!
+ * Finds a path with the original flood algorithm : it expands from both
+ * base and target until they meet, then removes unrelated points.
+ * \param m
+ * \param basePt starting point
+ * \param clippedDestPt destination point
+ * \param pSearch working data for the search
+ * \param pathToDestination tiles to walk, excluding starting tile
+ * \return false if flood could not link base and target.
+ */
+bool PedInstance::findPathFlood(Mission *m, const TilePoint &basePt, const TilePoint &clippedDestPt,
+    pathSearchDesc *pSearch, std::vector<TilePoint> &pathToDestination)
+{
+    // mirror is kept equal to m->mdpoints_ between searches, only nodes
+    // touched by this search are restored at the end
+    floodSearchDesc *pFlood = &(pSearch->flood);
+
+    if (!floodMap(m, basePt, clippedDestPt, pFlood)) {
+        pFlood->reset(m->mdpoints_);
+        return false;
+    }
+
+    createPath(m, basePt, pFlood->nodes, pathToDestination);
+    pFlood->reset(m->mdpoints_);
+
+    return true;
+}
+
+//! Order of open list : lowest f first then closest to target
+static bool astarOpenNodeGreater(const astarSearchDesc::openNode &a,
+    const astarSearchDesc::openNode &b)
+{
+    if (a.f != b.f)
+        return a.f > b.f;
+    return a.h > b.h;
+}
+
+/*!
+ * Finds a path with A* over the same directions map used by the flood.
+ * When destination is far away, search is first restricted to the corridor
+ * of the coarse route found with the mission walkable regions. The path is
+ * then the shortest one in the corridor, which can be longer than the
+ * shortest one on the map as the corridor follows only one coarse route.
+ * \param m
+ * \param basePt starting point
+ * \param clippedDestPt destination point
+ * \param pSearch working data for the search
+ * \param pathToDestination tiles to walk, excluding starting tile
+ * \return false if there is no path to the destination.
+ */
+bool PedInstance::findPathAStar(Mission *m, const TilePoint &basePt, const TilePoint &clippedDestPt,
+    pathSearchDesc *pSearch, std::vector<TilePoint> &pathToDestination)
+{
+    PathRegions *pRegions = &(m->mdregions_);
+    int dist = std::max(abs(clippedDestPt.tx - basePt.tx),
+        std::max(abs(clippedDestPt.ty - basePt.ty), abs(clippedDestPt.tz - basePt.tz)));
+
+    if (pRegions->isBuilt() && dist >= PathRegions::kMinCorridorDistance
+        && pRegions->buildCorridor(
+            basePt.tx + basePt.ty * m->mmax_x_ + basePt.tz * m->mmax_m_xy,
+            clippedDestPt.tx + clippedDestPt.ty * m->mmax_x_ + clippedDestPt.tz * m->mmax_m_xy,
+            &(pSearch->corridor)))
+    {
+        if (searchAStar(m, basePt, clippedDestPt, pSearch, true, pathToDestination)) {
+            return true;
+        }
+        pRegions->countFallback();
+    }
+
+    return searchAStar(m, basePt, clippedDestPt, pSearch, false, pathToDestination);
 }
 
-bool PedInstance::floodMap(Mission *m, const TilePoint &clippedDestPt, floodPointDesc *mdpmirror) {
+/*!
+ * A* search over the directions map.
+ * Every step costs the same, as for flood levels, so without corridor paths
+ * have the same number of tiles as the ones found by flood. In a corridor,
+ * the path is only the shortest one through the tiles of the corridor.
+ * \param m
+ * \param basePt starting point
+ * \param clippedDestPt destination point
+ * \param pSearch working data for the search
+ * \param inCorridor True to search only tiles in the corridor of pSearch
+ * \param pathToDestination tiles to walk, excluding starting tile
+ * \return false if there is no path to the destination.
+ */
+bool PedInstance::searchAStar(Mission *m, const TilePoint &basePt, const TilePoint &clippedDestPt,
+    pathSearchDesc *pSearch, bool inCorridor, std::vector<TilePoint> &pathToDestination)
+{
+    PROFILE_ZONE("PedInstance::searchAStar");
+    // tile offsets for direction bits 0x01, 0x02, 0x04 ... 0x80
+    static const int kDirOffsetX[8] = { 0, 1, 1, 1, 0, -1, -1, -1 };
+    static const int kDirOffsetY[8] = { 1, 1, 0, -1, -1, -1, 0, 1 };
+
+    astarSearchDesc *pAStar = &(pSearch->astar);
+    if (pAStar->stamps == NULL) {
+        if (!pAStar->allocate(m->mmax_x_ * m->mmax_y_ * m->mmax_z_)) {
+            FSERR(Log::k_FLG_GAME, "PedInstance", "searchAStar", ("Memory allocation error\n"));
+            return false;
+        }
+    }
+    pAStar->newSearch();
+    const uint32 gen = pAStar->generation;
+
+    const uint32 baseIndx = basePt.tx + basePt.ty * m->mmax_x_ + basePt.tz * m->mmax_m_xy;
+    const uint32 targetIndx = clippedDestPt.tx + clippedDestPt.ty * m->mmax_x_
+        + clippedDestPt.tz * m->mmax_m_xy;
+
+    astarSearchDesc::openNode node;
+    node.indx = baseIndx;
+    node.h = std::max(abs(clippedDestPt.tx - basePt.tx),
+        std::max(abs(clippedDestPt.ty - basePt.ty), abs(clippedDestPt.tz - basePt.tz)));
+    node.f = node.h;
+    pAStar->stamps[baseIndx] = gen;
+    pAStar->costs[baseIndx] = 0;
+    pAStar->parents[baseIndx] = baseIndx;
+    pAStar->open.push_back(node);
+
+    bool found = false;
+    while (!pAStar->open.empty()) {
+        std::pop_heap(pAStar->open.begin(), pAStar->open.end(), astarOpenNodeGreater);
+        astarSearchDesc::openNode current = pAStar->open.back();
+        pAStar->open.pop_back();
+
+        uint32 cost = pAStar->costs[current.indx];
+        if (current.f != cost + current.h) {
+            // node has been reached later with a lower cost
+            continue;
+        }
+        if (current.indx == targetIndx) {
+            found = true;
+            break;
+        }
+
+        int cz = current.indx / m->mmax_m_xy;
+        int cy = (current.indx % m->mmax_m_xy) / m->mmax_x_;
+        int cx = current.indx % m->mmax_x_;
+        floodPointDesc *pfdp = &(m->mdpoints_[current.indx]);
+        // upper level, same level and lower level
+        uint8 dirs[3] = { pfdp->dirh, pfdp->dirm, pfdp->dirl };
+        for (int level = 0; level < 3; ++level) {
+            if (dirs[level] == 0)
+                continue;
+            int nz = cz + 1 - level;
+            for (int d = 0; d < 8; ++d) {
+                if ((dirs[level] & (1 << d)) == 0)
+                    continue;
+                int nx = cx + kDirOffsetX[d];
+                int ny = cy + kDirOffsetY[d];
+                uint32 nindx = nx + ny * m->mmax_x_ + nz * m->mmax_m_xy;
+                if ((m->mdpoints_[nindx].bfNodeDesc & m_fdWalkable) == 0)
+                    continue;
+                if (inCorridor && !m->mdregions_.isInCorridor(nindx, pSearch->corridor))
+                    continue;
+                if (pAStar->stamps[nindx] == gen
+                    && pAStar->costs[nindx] <= cost + 1)
+                    continue;
+
+                pAStar->stamps[nindx] = gen;
+                pAStar->costs[nindx] = cost + 1;
+                pAStar->parents[nindx] = current.indx;
+                node.indx = nindx;
+                node.h = std::max(abs(clippedDestPt.tx - nx),
+                    std::max(abs(clippedDestPt.ty - ny), abs(clippedDestPt.tz - nz)));
+                node.f = cost + 1 + node.h;
+                pAStar->open.push_back(node);
+                std::push_heap(pAStar->open.begin(), pAStar->open.end(), astarOpenNodeGreater);
+            }
+        }
+    }
+
+    if (!found) {
+        return false;
+    }
+
+    // path goes from target back to base, base tile is not part of it
+    size_t start = pathToDestination.size();
+    for (uint32 indx = targetIndx; indx != baseIndx; indx = pAStar->parents[indx]) {
+        pathToDestination.push_back(TilePoint(indx % m->mmax_x_,
+            (indx % m->mmax_m_xy) / m->mmax_x_, indx / m->mmax_m_xy));
+    }
+    std::reverse(pathToDestination.begin() + start, pathToDestination.end());
+
+    return true;
+}
+
+bool PedInstance::floodMap(Mission *m, const TilePoint &basePt, const TilePoint &clippedDestPt, floodSearchDesc *pSearch) {
+    PROFILE_ZONE("PedInstance::floodMap");
     unsigned char lt;
     unsigned short blvl = 0, tlvl = 0;
+    floodPointDesc *mdpmirror = pSearch->nodes;
     // these are all tiles that belong to base and target
-    std::vector <toSetDesc> bv;
-    std::vector <toSetDesc> tv;
-    bv.reserve(8192);
-    tv.reserve(8192);
+    std::vector <toSetDesc> &bv = pSearch->bv;
+    std::vector <toSetDesc> &tv = pSearch->tv;
     // these are used for setting values through algorithm
     toSetDesc sadd;
     floodPointDesc *pfdp;
     // setup
-    pfdp = &(mdpmirror[pos_.tx + pos_.ty * m->mmax_x_ + pos_.tz * m->mmax_m_xy]);
+    pfdp = &(mdpmirror[basePt.tx + basePt.ty * m->mmax_x_ + basePt.tz * m->mmax_m_xy]);
     pfdp->bfNodeDesc |= m_fdBasePoint;
-    sadd.coords.x = pos_.tx;
-    sadd.coords.y = pos_.ty;
-    sadd.coords.z = pos_.tz;
+    sadd.coords.x = basePt.tx;
+    sadd.coords.y = basePt.ty;
+    sadd.coords.z = basePt.tz;
     sadd.pNode = pfdp;
     bv.push_back(sadd);
     pfdp = &(mdpmirror[clippedDestPt.tx + clippedDestPt.ty * m->mmax_x_ + clippedDestPt.tz * m->mmax_m_xy]);
@@ -205,16 +496,11 @@ bool PedInstance::floodMap(Mission *m, const TilePoint &clippedDestPt, floodPoin
     ladd.indxs = 0;
     ladd.n = 1;
     // these are number of nodes per lvl and index start for "bv" and "tv"
-    std::vector <lvlNodesDesc> bn;
-    std::vector <lvlNodesDesc> tn;
-    bn.reserve(512);
-    tn.reserve(512);
+    std::vector <lvlNodesDesc> &bn = pSearch->bn;
+    std::vector <lvlNodesDesc> &tn = pSearch->tn;
     bn.push_back(ladd);
     tn.push_back(ladd);
     bool nodeset, lnknr = true;
-#ifdef EXECUTION_SPEED_TIME
-    printf("data allocation/setup complete %i.%i\n", SDL_GetTicks()/1000, SDL_GetTicks()%1000);
-#endif
 
 #ifdef FIND_DEFINED_TILE
     bool assertion_bool = true;
@@ -945,10 +1231,6 @@ bool PedInstance::floodMap(Mission *m, const TilePoint &clippedDestPt, floodPoin
         }
     } while (lnknr);
     //printf("bv %i, tv %i\n", bv.size(), tv.size());
-#ifdef EXECUTION_SPEED_TIME
-    printf("blvl %i, tlvl %i\n",tlvl, blvl);
-    printf("target reached in %i.%i\n", SDL_GetTicks()/1000, SDL_GetTicks()%1000);
-#endif
     if (!nodeset && lnknr) {
         return false;
     }
@@ -1015,9 +1297,6 @@ bool PedInstance::floodMap(Mission *m, const TilePoint &clippedDestPt, floodPoin
         }
         tn[tlvl].n -= nr;
     }
-#ifdef EXECUTION_SPEED_TIME
-    printf("tops removed time %i.%i\n", SDL_GetTicks()/1000, SDL_GetTicks()%1000);
-#endif
 
     // tiles that have no childs are removed
     removeTilesWithNoChildsFromBase(m, blvl, bv, bn, mdpmirror);
@@ -1303,8 +1582,9 @@ void PedInstance::removeTilesWithNoChildsFromTarget(Mission *m, unsigned short t
     }
 }
 
-void PedInstance::createPath(Mission *m, floodPointDesc *mdpmirror, std::vector<TilePoint> &pathToDestination) {
-    TilePoint currentTile(pos_.tx, pos_.ty, pos_.tz);
+void PedInstance::createPath(Mission *m, const TilePoint &basePt, floodPointDesc *mdpmirror, std::vector<TilePoint> &pathToDestination) {
+    PROFILE_ZONE("PedInstance::createPath");
+    TilePoint currentTile(basePt.tx, basePt.ty, basePt.tz);
     unsigned char ct = m_fdBasePoint;
     bool tnr = true, np = true;
     floodPointDesc *pfdp;
@@ -1807,6 +2087,7 @@ void PedInstance::createPath(Mission *m, floodPointDesc *mdpmirror, std::vector<
 }
 
 void PedInstance::buildFinalDestinationPath(Mission *m, std::vector<TilePoint> &cdestpath, const TilePoint &destinationPt) {
+    PROFILE_ZONE("PedInstance::buildFinalDestinationPath");
     TilePoint prvpn = TilePoint(pos_.tx, pos_.ty, pos_.tz, pos_.ox, pos_.oy);
     for (std::vector <TilePoint>::iterator it = cdestpath.begin();
             it != cdestpath.end(); ++it) {
@@ -2316,10 +2597,6 @@ void PedInstance::buildFinalDestinationPath(Mission *m, std::vector<TilePoint> &
             }
         }
     }
-
-#ifdef EXECUTION_SPEED_TIME
-    printf("smoothing time %i.%i\n", SDL_GetTicks()/1000, SDL_GetTicks()%1000);
-#endif
 }
 
 bool PedInstance::doMove(int elapsed, Mission *pMission)
@@ -2375,6 +2652,7 @@ bool PedInstance::doMove(int elapsed, Mission *pMission)
             pos_.tz = nxtTileZ;
             pos_.ty = nxtTileY;
             pos_.tx = nxtTileX;
+            updateGridCell();
             dest_path_.pop_front();
             if (dest_path_.empty())
                 speed_ = 0;
@@ -2669,6 +2947,7 @@ uint8 PedInstance::moveToDir(Mission* m, int elapsed, DirMoveType &dir_move,
 
                 pos_.tx = tilenx;
                 pos_.ty = tileny;
+                updateGridCell();
                 if (dir_move.dir_modifier != 0) {
                     dist_passsed += dist_inc;
                     posx = px;
@@ -0,0 +1,544 @@
+/************************************************************************
+ *                                                                      *
+ *  FreeSynd - a remake of the classic Bullfrog game "Syndicate".       *
+ *                                                                      *
+ *   Copyright (C) 2016  Benoit Blancard <benblan@users.sourceforge.net>*
+ *                                                                      *
+ *    This program is free software;  you can redistribute it and / or  *
+ *  modify it  under the  terms of the  GNU General  Public License as  *
+ *  published by the Free Software Foundation; either version 2 of the  *
+ *  License, or (at your option) any later version.                     *
+ *                                                                      *
+ *    This program is  distributed in the hope that it will be useful,  *
+ *  but WITHOUT  ANY WARRANTY;  without even  the implied  warranty of  *
+ *  MERCHANTABILITY  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU  *
+ *  General Public License for more details.                            *
+ *                                                                      *
+ *    You can view the GNU  General Public License, online, at the GNU  *
+ *  project's  web  site;  see <http://www.gnu.org/licenses/gpl.html>.  *
+ *  The full text of the license is also included in the file COPYING.  *
+ *                                                                      *
+ ************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+
+#include "roadgraph.h"
+#include "map.h"
+#include "utils/log.h"
+#include "utils/timer.h"
+
+const int RoadGraph::kMoveX[RoadGraph::kNbMoves] = { -1, 1, 0, 0 };
+const int RoadGraph::kMoveY[RoadGraph::kNbMoves] = { 0, 0, -1, 1 };
+const uint32 RoadGraph::kNone = 0xFFFFFFFF;
+const size_t RoadGraph::kMaxTables = 256;
+
+//! for each move : lane the current tile must have, see Map::roadLanes()
+static const uint16 kLaneMask[RoadGraph::kNbMoves] = { 0xF000, 0x00F0, 0x0F00, 0x000F };
+static const uint16 kLaneDir[RoadGraph::kNbMoves] = { 0x6000, 0x0020, 0x0400, 0x0000 };
+
+//! Order of open list : shortest first
+typedef std::pair<uint32, uint32> LengthNode;
+struct LengthNodeGreater {
+    bool operator()(const LengthNode &a, const LengthNode &b) const {
+        return a.first > b.first;
+    }
+};
+
+RoadGraph::RoadGraph() {
+    pMap_ = NULL;
+    maxX_ = maxY_ = 0;
+    nbTables_ = 0;
+    buildTime_ = 0;
+    memset(&stats_, 0, sizeof(Stats));
+}
+
+void RoadGraph::clear() {
+    pMap_ = NULL;
+    tileKeys_.clear();
+    nextFirst_.clear();
+    next_.clear();
+    nodeOf_.clear();
+    edgeOf_.clear();
+    offsetOf_.clear();
+    nodes_.clear();
+    edges_.clear();
+    inFirst_.clear();
+    inEdges_.clear();
+    tables_.clear();
+    nbTables_ = 0;
+    buildTime_ = 0;
+    memset(&stats_, 0, sizeof(Stats));
+}
+
+/*!
+ * Finds the road tiles of the map, the moves between them and chains
+ * the states that have only one way in and one way out into edges.
+ * \param pMap The map
+ */
+void RoadGraph::build(Map *pMap) {
+    clear();
+    uint64 startTime = fs_utils::microTime();
+
+    pMap_ = pMap;
+    maxX_ = pMap->maxX();
+    maxY_ = pMap->maxY();
+    int maxZ = pMap->maxZ();
+    // keys are pushed in increasing order
+    for (int z = 0; z < maxZ; z++) {
+        for (int y = 0; y < maxY_; y++) {
+            for (int x = 0; x < maxX_; x++) {
+                if (pMap->isTileWalkableByCar(x, y, z)) {
+                    tileKeys_.push_back(x + (y + z * maxY_) * maxX_);
+                }
+            }
+        }
+    }
+
+    // moves between states
+    uint32 nbStates = tileKeys_.size() * kNbMoves;
+    std::vector<uint32> nbIn(nbStates, 0);
+    nextFirst_.resize(nbStates + 1);
+    for (uint32 t = 0; t < tileKeys_.size(); t++) {
+        int x = tileKeys_[t] % maxX_;
+        int y = (tileKeys_[t] / maxX_) % maxY_;
+        int z = tileKeys_[t] / (maxX_ * maxY_);
+        for (int move = 0; move < kNbMoves; move++) {
+            nextFirst_[t * kNbMoves + move] = next_.size();
+            int moves[kNbMoves];
+            int nb = nextMoves(pMap, x, y, z, move, moves);
+            for (int i = 0; i < nb; i++) {
+                int n = tileIndex(x + kMoveX[moves[i]], y + kMoveY[moves[i]], z);
+                if (n != -1) {
+                    uint32 state = n * kNbMoves + moves[i];
+                    next_.push_back(state);
+                    nbIn[state]++;
+                }
+            }
+        }
+    }
+    nextFirst_[nbStates] = next_.size();
+
+    // nodes : states that can be reached and are not in the middle of a segment
+    nodeOf_.assign(nbStates, kNone);
+    for (uint32 s = 0; s < nbStates; s++) {
+        if (nbIn[s] != 0 && (nbIn[s] != 1 || nextFirst_[s + 1] - nextFirst_[s] != 1)) {
+            nodeOf_[s] = nodes_.size();
+            nodes_.push_back(s);
+        }
+    }
+
+    // edges : a state of a segment has only one way in, so it's on only
+    // one edge and following the only way out always ends on a node
+    edgeOf_.assign(nbStates, kNone);
+    offsetOf_.assign(nbStates, 0);
+    for (uint32 n = 0; n < nodes_.size(); n++) {
+        uint32 s = nodes_[n];
+        for (uint32 i = nextFirst_[s]; i < nextFirst_[s + 1]; i++) {
+            Edge edge;
+            edge.from = n;
+            edge.first = next_[i];
+            edge.length = 1;
+            uint32 cur = edge.first;
+            while (nodeOf_[cur] == kNone) {
+                edgeOf_[cur] = edges_.size();
+                offsetOf_[cur] = edge.length;
+                cur = next_[nextFirst_[cur]];
+                edge.length++;
+            }
+            edge.to = nodeOf_[cur];
+            edges_.push_back(edge);
+        }
+    }
+
+    // edges ending at each node, to build next-hop tables from the end
+    inFirst_.assign(nodes_.size() + 1, 0);
+    for (size_t e = 0; e < edges_.size(); e++) {
+        inFirst_[edges_[e].to + 1]++;
+    }
+    for (size_t n = 0; n < nodes_.size(); n++) {
+        inFirst_[n + 1] += inFirst_[n];
+    }
+    inEdges_.resize(edges_.size());
+    std::vector<uint32> inPos(inFirst_.begin(), inFirst_.end() - 1);
+    for (size_t e = 0; e < edges_.size(); e++) {
+        inEdges_[inPos[edges_[e].to]++] = e;
+    }
+    tables_.resize(nodes_.size());
+
+    buildTime_ = fs_utils::microTime() - startTime;
+    LOG(Log::k_FLG_GAME, "RoadGraph", "build",
+        ("%d road tiles, %d nodes, %d edges built in %d us", (int)nbTiles(),
+        (int)nbNodes(), (int)nbEdges(), (int)buildTime_));
+}
+
+/*!
+ * Returns the moves a vehicle can do from a road tile. It follows the
+ * lanes of the tile and can not turn back.
+ * \param pMap The map
+ * \param x Current tile
+ * \param y Current tile
+ * \param z Current tile
+ * \param move Move by which the vehicle has entered the tile
+ * \param pMoves Receives up to kNbMoves - 1 moves
+ * \return the number of moves.
+ */
+int RoadGraph::nextMoves(Map *pMap, int x, int y, int z, int move, int *pMoves) {
+    uint16 lanes = pMap->roadLanes(x, y, z);
+    int nb = 0;
+    for (int next = 0; next < kNbMoves; next++) {
+        if (next == (move ^ 1)) {
+            // can't turn back
+            continue;
+        }
+        int nx = x + kMoveX[next];
+        int ny = y + kMoveY[next];
+        if (nx < 0 || nx >= pMap->maxX() || ny < 0 || ny >= pMap->maxY()
+            || ((lanes & kLaneMask[next]) != kLaneDir[next] && lanes != 0xFFFF)) {
+            continue;
+        }
+        if (pMap->isRoadLinked(x, y, nx, ny, z)) {
+            pMoves[nb++] = next;
+        }
+    }
+    return nb;
+}
+
+/*!
+ * \param dir Direction of the vehicle, see MapObject::getDirection(4)
+ * \return the move that makes a vehicle face this direction.
+ */
+int RoadGraph::moveFromDirection(int dir) {
+    static const int kDirMoves[4] = { 3, 1, 2, 0 };
+    return kDirMoves[dir & 3];
+}
+
+int RoadGraph::tileIndex(int x, int y, int z) const {
+    uint32 key = x + (y + z * maxY_) * maxX_;
+    std::vector<uint32>::const_iterator it =
+        std::lower_bound(tileKeys_.begin(), tileKeys_.end(), key);
+    if (it == tileKeys_.end() || *it != key) {
+        return -1;
+    }
+    return it - tileKeys_.begin();
+}
+
+/*!
+ * \param x Start tile
+ * \param y Start tile
+ * \param z Road level
+ * \param move Move by which the vehicle has entered the start tile
+ * \param toX Tile to reach
+ * \param toY Tile to reach
+ * \param pRoute Receives the tiles from start to target
+ * \return false if there is no route.
+ */
+bool RoadGraph::findRoute(int x, int y, int z, int move, int toX, int toY,
+    std::vector<TilePoint> *pRoute)
+{
+    uint64 startTime = fs_utils::microTime();
+    stats_.routes++;
+    pRoute->clear();
+
+    bool found = false;
+    int from = tileIndex(x, y, z);
+    int to = tileIndex(toX, toY, z);
+    if (from != -1 && to != -1) {
+        found = searchGraph(from * kNbMoves + move, to, pRoute);
+    }
+
+    if (found) {
+        stats_.found++;
+    }
+    stats_.routeTime += fs_utils::microTime() - startTime;
+    return found;
+}
+
+/*!
+ * From each state that can follow the start, the vehicle can only go one
+ * way until it reaches a node : the entry. The target tile is reached from
+ * at most 4 nodes : the exits. The next-hop table of each exit gives the
+ * length from every entry so the shortest combination is taken.
+ * \param start State of the vehicle
+ * \param toTile Index of tile to reach
+ * \param pRoute Receives the tiles from start to target
+ * \return false if there is no route.
+ */
+bool RoadGraph::searchGraph(uint32 start, uint32 toTile, std::vector<TilePoint> *pRoute) {
+    addTile(start, pRoute);
+    if (start / kNbMoves == toTile) {
+        return true;
+    }
+
+    uint32 exitNodes[kNbMoves];
+    uint32 exitEdges[kNbMoves];
+    uint32 exitLengths[kNbMoves];
+    int nbExits = 0;
+    for (int move = 0; move < kNbMoves; move++) {
+        uint32 state = toTile * kNbMoves + move;
+        if (nodeOf_[state] != kNone) {
+            exitNodes[nbExits] = nodeOf_[state];
+            exitEdges[nbExits] = kNone;
+            exitLengths[nbExits] = 0;
+            nbExits++;
+        } else if (edgeOf_[state] != kNone) {
+            exitNodes[nbExits] = edges_[edgeOf_[state]].from;
+            exitEdges[nbExits] = edgeOf_[state];
+            exitLengths[nbExits] = offsetOf_[state];
+            nbExits++;
+        }
+    }
+
+    // tables are not cleared while they are used
+    if (nbTables_ + nbExits > kMaxTables) {
+        clearTables();
+    }
+    const std::vector<Hop> *pTables[kNbMoves];
+    for (int i = 0; i < nbExits; i++) {
+        pTables[i] = &table(exitNodes[i]);
+    }
+
+    uint32 bestLength = kNone;
+    uint32 bestNext = 0;
+    // -1 when target is on the way to the entry
+    int bestExit = -1;
+    const uint32 maxLength = nodeOf_.size();
+    for (uint32 i = nextFirst_[start]; i < nextFirst_[start + 1]; i++) {
+        uint32 state = next_[i];
+        uint32 length = 1;
+        // states that are not nodes have only one way out, a loop with
+        // no node is left when all its states have been seen
+        while (nodeOf_[state] == kNone && state / kNbMoves != toTile
+            && length <= maxLength) {
+            state = next_[nextFirst_[state]];
+            length++;
+        }
+
+        if (state / kNbMoves == toTile) {
+            if (length < bestLength) {
+                bestLength = length;
+                bestNext = i;
+                bestExit = -1;
+            }
+        } else if (nodeOf_[state] != kNone) {
+            uint32 entry = nodeOf_[state];
+            for (int e = 0; e < nbExits; e++) {
+                const Hop &hop = (*pTables[e])[entry];
+                if (hop.length != kNone
+                    && length + hop.length + exitLengths[e] < bestLength) {
+                    bestLength = length + hop.length + exitLengths[e];
+                    bestNext = i;
+                    bestExit = e;
+                }
+            }
+        }
+    }
+
+    if (bestLength == kNone) {
+        pRoute->clear();
+        return false;
+    }
+
+    // to the entry or to the target if it's on the way
+    uint32 state = next_[bestNext];
+    addTile(state, pRoute);
+    while (nodeOf_[state] == kNone && state / kNbMoves != toTile) {
+        state = next_[nextFirst_[state]];
+        addTile(state, pRoute);
+    }
+    if (bestExit == -1) {
+        return true;
+    }
+
+    // from entry to exit
+    const std::vector<Hop> &hops = *pTables[bestExit];
+    uint32 node = nodeOf_[state];
+    while (node != exitNodes[bestExit]) {
+        const Edge &edge = edges_[hops[node].edge];
+        addTiles(edge.first, edge.length, pRoute);
+        node = edge.to;
+    }
+
+    // from exit to target
+    if (exitEdges[bestExit] != kNone) {
+        addTiles(edges_[exitEdges[bestExit]].first, exitLengths[bestExit], pRoute);
+    }
+    return true;
+}
+
+/*!
+ * Searches from the given node backward along the edges to find, for
+ * every node, the length to the given one and the first edge to take.
+ * \param node Node to reach
+ * \return the table indexed by node.
+ */
+const std::vector<RoadGraph::Hop> & RoadGraph::table(uint32 node) {
+    std::vector<Hop> &hops = tables_[node];
+    if (!hops.empty()) {
+        stats_.hits++;
+        return hops;
+    }
+
+    stats_.misses++;
+    Hop none = { kNone, kNone };
+    hops.assign(nodes_.size(), none);
+    hops[node].length = 0;
+
+    std::vector<LengthNode> open;
+    open.push_back(LengthNode(0, node));
+    while (!open.empty()) {
+        std::pop_heap(open.begin(), open.end(), LengthNodeGreater());
+        LengthNode current = open.back();
+        open.pop_back();
+        uint32 n = current.second;
+        if (current.first != hops[n].length) {
+            // node has been reached later with a shorter length
+            continue;
+        }
+
+        for (uint32 i = inFirst_[n]; i < inFirst_[n + 1]; i++) {
+            const Edge &edge = edges_[inEdges_[i]];
+            uint32 length = current.first + edge.length;
+            if (length < hops[edge.from].length) {
+                hops[edge.from].length = length;
+                hops[edge.from].edge = inEdges_[i];
+                open.push_back(LengthNode(length, edge.from));
+                std::push_heap(open.begin(), open.end(), LengthNodeGreater());
+            }
+        }
+    }
+
+    nbTables_++;
+    return hops;
+}
+
+void RoadGraph::clearTables() {
+    for (size_t i = 0; i < tables_.size(); i++) {
+        // swapped to give back the memory
+        std::vector<Hop>().swap(tables_[i]);
+    }
+    nbTables_ = 0;
+}
+
+//! Adds the tiles of length states, the first one is given
+void RoadGraph::addTiles(uint32 state, uint32 length, std::vector<TilePoint> *pRoute) const {
+    addTile(state, pRoute);
+    for (uint32 i = 1; i < length; i++) {
+        state = next_[nextFirst_[state]];
+        addTile(state, pRoute);
+    }
+}
+
+void RoadGraph::addTile(uint32 state, std::vector<TilePoint> *pRoute) const {
+    pRoute->push_back(tile(state / kNbMoves));
+}
+
+TilePoint RoadGraph::tile(size_t indx) const {
+    uint32 key = tileKeys_[indx];
+    return TilePoint(key % maxX_, (key / maxX_) % maxY_, key / (maxX_ * maxY_));
+}
+
+/*!
+ * A* search over the road tiles with the same moves as the graph. It is
+ * the reference of "dump --check-roads", which compares the routes of the
+ * graph with its routes on all maps, and of "dump --bench-roads".
+ * \param pMap The map
+ * \param pSearch Working data of the search
+ * \param x Start tile
+ * \param y Start tile
+ * \param z Road level
+ * \param move Move by which the vehicle has entered the start tile
+ * \param toX Tile to reach
+ * \param toY Tile to reach
+ * \param pRoute Receives the tiles from start to target
+ * \return false if there is no route.
+ */
+bool RoadGraph::searchRoute(Map *pMap, carSearchDesc *pSearch, int x, int y,
+    int z, int move, int toX, int toY, std::vector<TilePoint> *pRoute)
+{
+    const int maxX = pMap->maxX();
+    pRoute->clear();
+    if (pSearch->nbNodes != (uint32)(maxX * pMap->maxY() * kNbMoves)) {
+        if (!pSearch->allocate(maxX * pMap->maxY() * kNbMoves)) {
+            FSERR(Log::k_FLG_GAME, "RoadGraph", "searchRoute", ("Memory allocation error\n"));
+            return false;
+        }
+    }
+    pSearch->newSearch();
+    const uint32 gen = pSearch->generation;
+
+    // a node is (tile index * kNbMoves + last move)
+    const uint32 startNode = (y * maxX + x) * kNbMoves + move;
+    pSearch->reach(startNode);
+    pSearch->costs[startNode] = 0;
+    pSearch->estimates[startNode] = abs(toX - x) + abs(toY - y);
+    pSearch->parents[startNode] = startNode;
+    pSearch->push(startNode);
+
+    bool found = false;
+    uint32 node = startNode;
+    while (!pSearch->open.empty()) {
+        node = pSearch->pop();
+        int cx = (node / kNbMoves) % maxX;
+        int cy = (node / kNbMoves) / maxX;
+        if (cx == toX && cy == toY) {
+            found = true;
+            break;
+        }
+
+        int moves[kNbMoves];
+        int nb = nextMoves(pMap, cx, cy, z, node % kNbMoves, moves);
+        uint32 cost = pSearch->costs[node] + 1;
+        for (int i = 0; i < nb; i++) {
+            int nx = cx + kMoveX[moves[i]];
+            int ny = cy + kMoveY[moves[i]];
+            uint32 nextNode = (ny * maxX + nx) * kNbMoves + moves[i];
+            if (pSearch->stamps[nextNode] == gen && pSearch->costs[nextNode] <= cost) {
+                continue;
+            }
+
+            if (pSearch->stamps[nextNode] != gen) {
+                pSearch->reach(nextNode);
+                pSearch->estimates[nextNode] = abs(toX - nx) + abs(toY - ny);
+            }
+            pSearch->costs[nextNode] = cost;
+            pSearch->parents[nextNode] = node;
+            pSearch->push(nextNode);
+        }
+    }
+
+    if (!found) {
+        return false;
+    }
+
+    for (;;) {
+        pRoute->push_back(TilePoint((node / kNbMoves) % maxX, (node / kNbMoves) / maxX, z));
+        if (node == startNode) {
+            break;
+        }
+        node = pSearch->parents[node];
+    }
+    std::reverse(pRoute->begin(), pRoute->end());
+    return true;
+}
+
+size_t RoadGraph::memorySize() const {
+    size_t size = sizeof(uint32) * (tileKeys_.capacity() + nextFirst_.capacity()
+        + next_.capacity() + nodeOf_.capacity() + edgeOf_.capacity()
+        + offsetOf_.capacity() + nodes_.capacity() + inFirst_.capacity()
+        + inEdges_.capacity());
+    size += sizeof(Edge) * edges_.capacity();
+    size += sizeof(std::vector<Hop>) * tables_.capacity();
+    for (size_t i = 0; i < tables_.size(); i++) {
+        size += sizeof(Hop) * tables_[i].capacity();
+    }
+    return size;
+}
+
+void RoadGraph::logStats() const {
+    LOG(Log::k_FLG_GAME, "RoadGraph", "logStats",
+        ("%d nodes, %d edges, %d KB, routes %d, found %d, table hits %d, misses %d, route time %d us",
+        (int)nbNodes(), (int)nbEdges(), (int)(memorySize() / 1024), stats_.routes,
+        stats_.found, stats_.hits, stats_.misses, (int)stats_.routeTime));
+}
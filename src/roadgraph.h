@@ -0,0 +1,168 @@
+/************************************************************************
+ *                                                                      *
+ *  FreeSynd - a remake of the classic Bullfrog game "Syndicate".       *
+ *                                                                      *
+ *   Copyright (C) 2016  Benoit Blancard <benblan@users.sourceforge.net>*
+ *                                                                      *
+ *    This program is free software;  you can redistribute it and / or  *
+ *  modify it  under the  terms of the  GNU General  Public License as  *
+ *  published by the Free Software Foundation; either version 2 of the  *
+ *  License, or (at your option) any later version.                     *
+ *                                                                      *
+ *    This program is  distributed in the hope that it will be useful,  *
+ *  but WITHOUT  ANY WARRANTY;  without even  the implied  warranty of  *
+ *  MERCHANTABILITY  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU  *
+ *  General Public License for more details.                            *
+ *                                                                      *
+ *    You can view the GNU  General Public License, online, at the GNU  *
+ *  project's  web  site;  see <http://www.gnu.org/licenses/gpl.html>.  *
+ *  The full text of the license is also included in the file COPYING.  *
+ *                                                                      *
+ ************************************************************************/
+
+#ifndef ROADGRAPH_H
+#define ROADGRAPH_H
+
+#include <vector>
+
+#include "common.h"
+#include "pathsurfaces.h"
+
+class Map;
+
+/*!
+ * Directed graph of the lanes of a map, used to find routes for vehicles.
+ * A vehicle enters a road tile by one of 4 moves and can not turn back, so
+ * a state of a vehicle is a road tile with the move it was entered by.
+ * States from which a vehicle can go only one way and that can be reached
+ * only one way are chained in road segments : the edges of the graph.
+ * The other states (crossings, lanes that merge, dead ends) are the nodes.
+ *
+ * Graph is built once for a map. For each node that a route has to reach,
+ * a table gives for every other node the first edge to take and the
+ * remaining length, tables are kept until too many have been built.
+ * Routes are only searched in the main thread.
+ */
+class RoadGraph {
+public:
+    //! Counters of route queries
+    struct Stats {
+        //! Number of routes asked
+        uint32 routes;
+        //! Number of routes found
+        uint32 found;
+        //! Number of next-hop tables found in cache
+        uint32 hits;
+        //! Number of next-hop tables built
+        uint32 misses;
+        //! Time spent in route queries in microseconds
+        uint64 routeTime;
+    };
+
+    //! Number of moves : to x - 1, x + 1, y - 1 and y + 1
+    static const int kNbMoves = 4;
+    //! Tile offsets for each move
+    static const int kMoveX[kNbMoves];
+    static const int kMoveY[kNbMoves];
+
+    RoadGraph();
+
+    //! Builds the graph from the roads of the map
+    void build(Map *pMap);
+    //! Frees all data
+    void clear();
+
+    //! Returns true if graph has been built
+    bool isBuilt() const { return pMap_ != NULL; }
+    //! Finds the shortest route between two road tiles
+    bool findRoute(int x, int y, int z, int move, int toX, int toY,
+        std::vector<TilePoint> *pRoute);
+
+    //! Returns the moves allowed from the given state
+    static int nextMoves(Map *pMap, int x, int y, int z, int move, int *pMoves);
+    //! Returns the move that enters a tile in the given direction
+    static int moveFromDirection(int dir);
+    //! Finds the shortest route by searching the tiles, without the graph
+    static bool searchRoute(Map *pMap, carSearchDesc *pSearch, int x, int y,
+        int z, int move, int toX, int toY, std::vector<TilePoint> *pRoute);
+
+    size_t nbTiles() const { return tileKeys_.size(); }
+    //! Returns the position of a road tile, index is lower than nbTiles()
+    TilePoint tile(size_t indx) const;
+    size_t nbNodes() const { return nodes_.size(); }
+    size_t nbEdges() const { return edges_.size(); }
+    //! Returns the number of next-hop tables in cache
+    size_t nbTables() const { return nbTables_; }
+    //! Time spent in the last build in microseconds
+    uint64 buildTime() const { return buildTime_; }
+    //! Returns the memory used by the graph and its tables in bytes
+    size_t memorySize() const;
+    const Stats & stats() const { return stats_; }
+    //! Writes the graph size and counters to the log
+    void logStats() const;
+
+protected:
+    //! A road segment between two nodes
+    struct Edge {
+        //! Node where segment starts
+        uint32 from;
+        //! Node where segment ends
+        uint32 to;
+        //! First state after the start node
+        uint32 first;
+        //! Number of tiles to go from start node to end node
+        uint32 length;
+    };
+
+    //! One entry of a next-hop table
+    struct Hop {
+        //! Number of tiles to go to the node of the table
+        uint32 length;
+        //! Edge to take first
+        uint32 edge;
+    };
+
+    //! Returns the index of a road tile or -1
+    int tileIndex(int x, int y, int z) const;
+    //! Searches the route from a state to a road tile
+    bool searchGraph(uint32 start, uint32 toTile, std::vector<TilePoint> *pRoute);
+    //! Returns the next-hop table to reach the given node
+    const std::vector<Hop> & table(uint32 node);
+    void clearTables();
+    //! Adds the tiles of the states from the given one up to a node
+    void addTiles(uint32 state, uint32 length, std::vector<TilePoint> *pRoute) const;
+    void addTile(uint32 state, std::vector<TilePoint> *pRoute) const;
+
+protected:
+    //! Marks a state that is not a node or not on an edge
+    static const uint32 kNone;
+    //! Maximum number of next-hop tables kept in cache
+    static const size_t kMaxTables;
+
+    Map *pMap_;
+    int maxX_, maxY_;
+    //! Position of road tiles, sorted : x + (y + z * maxY) * maxX
+    std::vector<uint32> tileKeys_;
+    //! States that can follow each state (tile * kNbMoves + move)
+    std::vector<uint32> nextFirst_;
+    std::vector<uint32> next_;
+    //! Node of each state or kNone
+    std::vector<uint32> nodeOf_;
+    //! Edge that goes through each state and position on it, or kNone
+    std::vector<uint32> edgeOf_;
+    std::vector<uint32> offsetOf_;
+    //! State of each node
+    std::vector<uint32> nodes_;
+    //! Edges sorted by start node
+    std::vector<Edge> edges_;
+    //! Edges ending at each node
+    std::vector<uint32> inFirst_;
+    std::vector<uint32> inEdges_;
+    //! Next-hop table of each node, empty when not built
+    std::vector< std::vector<Hop> > tables_;
+    size_t nbTables_;
+    uint64 buildTime_;
+    Stats stats_;
+};
+
+#endif
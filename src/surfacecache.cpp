@@ -0,0 +1,257 @@
+/************************************************************************
+ *                                                                      *
+ *  FreeSynd - a remake of the classic Bullfrog game "Syndicate".       *
+ *                                                                      *
+ *   Copyright (C) 2016  Benoit Blancard <benblan@users.sourceforge.net>*
+ *                                                                      *
+ *    This program is free software;  you can redistribute it and / or  *
+ *  modify it  under the  terms of the  GNU General  Public License as  *
+ *  published by the Free Software Foundation; either version 2 of the  *
+ *  License, or (at your option) any later version.                     *
+ *                                                                      *
+ *    This program is  distributed in the hope that it will be useful,  *
+ *  but WITHOUT  ANY WARRANTY;  without even  the implied  warranty of  *
+ *  MERCHANTABILITY  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU  *
+ *  General Public License for more details.                            *
+ *                                                                      *
+ *    You can view the GNU  General Public License, online, at the GNU  *
+ *  project's  web  site;  see <http://www.gnu.org/licenses/gpl.html>.  *
+ *  The full text of the license is also included in the file COPYING.  *
+ *                                                                      *
+ ************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include "surfacecache.h"
+#include "utils/ccrc32.h"
+#include "utils/file.h"
+#include "utils/log.h"
+
+/*!
+ * Header at the beginning of each file. Files are only read
+ * on the computer that wrote them so the header is written as is.
+ * It is followed by 4 bytes per tile : node description and
+ * directions up, ground and down.
+ */
+struct SurfaceCacheHeader {
+    char magic[4];
+    uint32 version;
+    int32 mapId;
+    int32 maxX;
+    int32 maxY;
+    int32 maxZ;
+    uint32 surfacesCrc;
+    uint32 seedsCrc;
+    //! CRC of the data that follows the header
+    uint32 dataCrc;
+};
+
+/*! Increase it when the format of files or the way directions are computed changes.*/
+static const uint32 kSurfaceCacheVersion = 1;
+/*! Number of bytes saved per tile.*/
+static const size_t kBytesPerNode = 4;
+
+const size_t SurfaceCache::kMaxEntries = 8;
+
+SurfaceCache::EMode SurfaceCache::mode_ = SurfaceCache::kModeDisk;
+std::vector<SurfaceCache::Entry> SurfaceCache::entries_;
+uint32 SurfaceCache::useCounter_ = 0;
+SurfaceCache::Stats SurfaceCache::stats_ = { 0, 0, 0, 0 };
+
+bool SurfaceCache::Key::operator==(const Key &other) const {
+    return mapId == other.mapId && maxX == other.maxX && maxY == other.maxY &&
+        maxZ == other.maxZ && surfacesCrc == other.surfacesCrc &&
+        seedsCrc == other.seedsCrc;
+}
+
+/*!
+ * Looks in memory first, then on disk if mode allows it. An entry read
+ * from disk is kept in memory.
+ * \param key What the directions map is computed from
+ * \param pPoints Receives the directions map, must be as big as the map
+ * \return False if directions map must be computed
+ */
+bool SurfaceCache::find(const Key &key, floodPointDesc *pPoints) {
+    if (mode_ == kModeOff) {
+        return false;
+    }
+
+    for (size_t i = 0; i < entries_.size(); i++) {
+        if (entries_[i].key == key) {
+            memcpy(pPoints, &(entries_[i].points[0]), nbNodes(key) * sizeof(floodPointDesc));
+            entries_[i].lastUse = ++useCounter_;
+            stats_.memoryHits++;
+            return true;
+        }
+    }
+
+    if (mode_ == kModeDisk && loadEntry(key, pPoints)) {
+        addEntry(key, pPoints);
+        stats_.diskHits++;
+        return true;
+    }
+
+    stats_.misses++;
+    return false;
+}
+
+void SurfaceCache::store(const Key &key, const floodPointDesc *pPoints) {
+    if (mode_ == kModeOff) {
+        return;
+    }
+
+    addEntry(key, pPoints);
+    if (mode_ == kModeDisk) {
+        saveEntry(key, pPoints);
+    }
+}
+
+void SurfaceCache::remove(const Key &key) {
+    for (size_t i = 0; i < entries_.size(); i++) {
+        if (entries_[i].key == key) {
+            entries_.erase(entries_.begin() + i);
+            break;
+        }
+    }
+    ::remove(entryPath(key).c_str());
+}
+
+void SurfaceCache::clear() {
+    entries_.clear();
+}
+
+void SurfaceCache::resetStats() {
+    memset(&stats_, 0, sizeof(Stats));
+}
+
+/*!
+ * When the cache is full, the least recently used entry is replaced.
+ */
+void SurfaceCache::addEntry(const Key &key, const floodPointDesc *pPoints) {
+    size_t pos = entries_.size();
+    if (pos == kMaxEntries) {
+        pos = 0;
+        for (size_t i = 1; i < entries_.size(); i++) {
+            if (entries_[i].lastUse < entries_[pos].lastUse) {
+                pos = i;
+            }
+        }
+    } else {
+        entries_.push_back(Entry());
+    }
+
+    Entry &entry = entries_[pos];
+    entry.key = key;
+    entry.points.assign(pPoints, pPoints + nbNodes(key));
+    entry.lastUse = ++useCounter_;
+}
+
+std::string SurfaceCache::entryPath(const Key &key) {
+    char name[64];
+    sprintf(name, "cache/surf%02d-%08x%08x.bin", key.mapId, key.surfacesCrc, key.seedsCrc);
+    return File::homeFullPath(name);
+}
+
+/*!
+ * A file that does not match the key or whose content is corrupted
+ * is removed.
+ */
+bool SurfaceCache::loadEntry(const Key &key, floodPointDesc *pPoints) {
+    std::string path = entryPath(key);
+    FILE *fp = fopen(path.c_str(), "rb");
+    if (fp == NULL) {
+        return false;
+    }
+
+    size_t nb = nbNodes(key);
+    std::vector<uint8> data(nb * kBytesPerNode);
+    SurfaceCacheHeader header;
+    bool valid = fread(&header, sizeof(header), 1, fp) == 1 &&
+        fread(&data[0], 1, data.size(), fp) == data.size();
+    fclose(fp);
+    valid = valid && memcmp(header.magic, "FSSF", 4) == 0 &&
+        header.version == kSurfaceCacheVersion && header.mapId == key.mapId &&
+        header.maxX == key.maxX && header.maxY == key.maxY && header.maxZ == key.maxZ &&
+        header.surfacesCrc == key.surfacesCrc && header.seedsCrc == key.seedsCrc;
+    if (valid) {
+        CCRC32 crc;
+        valid = crc.FullCRC(&data[0], data.size()) == header.dataCrc;
+    }
+    if (!valid) {
+        LOG(Log::k_FLG_IO, "SurfaceCache", "loadEntry", ("File %s is outdated", path.c_str()))
+        ::remove(path.c_str());
+        return false;
+    }
+
+    memset(pPoints, 0, nb * sizeof(floodPointDesc));
+    const uint8 *pData = &data[0];
+    for (size_t i = 0; i < nb; i++) {
+        pPoints[i].bfNodeDesc = pData[0];
+        pPoints[i].dirh = pData[1];
+        pPoints[i].dirm = pData[2];
+        pPoints[i].dirl = pData[3];
+        pData += kBytesPerNode;
+    }
+    return true;
+}
+
+/*!
+ * The file is written in a temporary file which is renamed at the end,
+ * so a file is never read while it is being written.
+ */
+void SurfaceCache::saveEntry(const Key &key, const floodPointDesc *pPoints) {
+    size_t nb = nbNodes(key);
+    std::vector<uint8> data(nb * kBytesPerNode);
+    uint8 *pData = &data[0];
+    for (size_t i = 0; i < nb; i++) {
+        pData[0] = pPoints[i].bfNodeDesc;
+        pData[1] = pPoints[i].dirh;
+        pData[2] = pPoints[i].dirm;
+        pData[3] = pPoints[i].dirl;
+        pData += kBytesPerNode;
+    }
+
+    SurfaceCacheHeader header;
+    memcpy(header.magic, "FSSF", 4);
+    header.version = kSurfaceCacheVersion;
+    header.mapId = key.mapId;
+    header.maxX = key.maxX;
+    header.maxY = key.maxY;
+    header.maxZ = key.maxZ;
+    header.surfacesCrc = key.surfacesCrc;
+    header.seedsCrc = key.seedsCrc;
+    CCRC32 crc;
+    header.dataCrc = crc.FullCRC(&data[0], data.size());
+
+    std::string cacheDir = File::homeFullPath("cache");
+#ifdef _WIN32
+    CreateDirectory(cacheDir.c_str(), NULL);
+#else
+    mkdir(cacheDir.c_str(), 0755);
+#endif
+    std::string path = entryPath(key);
+    std::string tmpPath = path + ".tmp";
+    FILE *fp = fopen(tmpPath.c_str(), "wb");
+    if (fp == NULL) {
+        FSERR(Log::k_FLG_IO, "SurfaceCache", "saveEntry", ("Cannot create file %s\n", tmpPath.c_str()))
+        return;
+    }
+    bool written = fwrite(&header, sizeof(header), 1, fp) == 1 &&
+        fwrite(&data[0], 1, data.size(), fp) == data.size();
+    written = fclose(fp) == 0 && written;
+    // rename() does not replace an existing file on Windows
+    ::remove(path.c_str());
+    if (!written || rename(tmpPath.c_str(), path.c_str()) != 0) {
+        FSERR(Log::k_FLG_IO, "SurfaceCache", "saveEntry", ("Cannot write file %s\n", path.c_str()))
+        ::remove(tmpPath.c_str());
+        return;
+    }
+    stats_.written++;
+}
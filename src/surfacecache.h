@@ -0,0 +1,128 @@
+/************************************************************************
+ *                                                                      *
+ *  FreeSynd - a remake of the classic Bullfrog game "Syndicate".       *
+ *                                                                      *
+ *   Copyright (C) 2016  Benoit Blancard <benblan@users.sourceforge.net>*
+ *                                                                      *
+ *    This program is free software;  you can redistribute it and / or  *
+ *  modify it  under the  terms of the  GNU General  Public License as  *
+ *  published by the Free Software Foundation; either version 2 of the  *
+ *  License, or (at your option) any later version.                     *
+ *                                                                      *
+ *    This program is  distributed in the hope that it will be useful,  *
+ *  but WITHOUT  ANY WARRANTY;  without even  the implied  warranty of  *
+ *  MERCHANTABILITY  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU  *
+ *  General Public License for more details.                            *
+ *                                                                      *
+ *    You can view the GNU  General Public License, online, at the GNU  *
+ *  project's  web  site;  see <http://www.gnu.org/licenses/gpl.html>.  *
+ *  The full text of the license is also included in the file COPYING.  *
+ *                                                                      *
+ ************************************************************************/
+
+#ifndef SURFACECACHE_H
+#define SURFACECACHE_H
+
+#include <string>
+#include <vector>
+
+#include "common.h"
+#include "pathsurfaces.h"
+
+/*!
+ * Keeps the directions maps computed by Mission::setSurfaces() so that
+ * loading a mission again does not compute them again.
+ * A directions map only depends on the surfaces of the tiles (large doors
+ * included) and on the tiles where peds stand, as the flood that defines
+ * walkable tiles starts from them. So an entry is found with a checksum
+ * of both and can't be used with data it was not computed from.
+ * Entries are kept in memory for the whole program, the least recently
+ * used is dropped when there are too many, and can be saved in the cache
+ * directory of the home path.
+ */
+class SurfaceCache {
+public:
+    /*!
+     * Where entries are kept.
+     */
+    enum EMode {
+        //! Directions maps are always computed
+        kModeOff = 0,
+        //! Entries are kept in memory
+        kModeMemory = 1,
+        //! Entries are kept in memory and saved on disk
+        kModeDisk = 2
+    };
+
+    //! What a directions map is computed from
+    struct Key {
+        int mapId;
+        int maxX;
+        int maxY;
+        int maxZ;
+        //! CRC of the tile surfaces
+        uint32 surfacesCrc;
+        //! CRC of the tiles where the flood starts
+        uint32 seedsCrc;
+
+        bool operator==(const Key &other) const;
+    };
+
+    //! Counters of the cache
+    struct Stats {
+        //! Number of entries found in memory
+        uint32 memoryHits;
+        //! Number of entries read from disk
+        uint32 diskHits;
+        //! Number of directions maps that had to be computed
+        uint32 misses;
+        //! Number of entries saved on disk
+        uint32 written;
+    };
+
+    //! Maximum number of entries kept in memory
+    static const size_t kMaxEntries;
+
+    static void setMode(EMode mode) { mode_ = mode; }
+    static EMode mode() { return mode_; }
+
+    //! Copies the directions map of the key in pPoints if there's one
+    static bool find(const Key &key, floodPointDesc *pPoints);
+    //! Keeps a copy of the directions map computed for the key
+    static void store(const Key &key, const floodPointDesc *pPoints);
+    //! Removes the entry of the key from memory and disk
+    static void remove(const Key &key);
+    //! Removes all entries from memory
+    static void clear();
+
+    static const Stats & stats() { return stats_; }
+    static void resetStats();
+
+private:
+    //! A directions map in memory
+    struct Entry {
+        Key key;
+        std::vector<floodPointDesc> points;
+        //! Value of the use counter when entry was last used
+        uint32 lastUse;
+    };
+
+    //! Returns the number of tiles of the map of the key
+    static size_t nbNodes(const Key &key) { return key.maxX * key.maxY * key.maxZ; }
+    //! Returns the path of the file for the given key
+    static std::string entryPath(const Key &key);
+    //! Reads the directions map from the file of the key
+    static bool loadEntry(const Key &key, floodPointDesc *pPoints);
+    //! Writes the directions map in the file of the key
+    static void saveEntry(const Key &key, const floodPointDesc *pPoints);
+    //! Keeps the directions map in memory
+    static void addEntry(const Key &key, const floodPointDesc *pPoints);
+
+    static EMode mode_;
+    static std::vector<Entry> entries_;
+    /*! Incremented each time an entry is used.*/
+    static uint32 useCounter_;
+    static Stats stats_;
+};
+
+#endif  // SURFACECACHE_H
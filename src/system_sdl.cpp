@@ -42,6 +42,7 @@ SystemSDL::SystemSDL(int depth) {
     screen_surf_ = NULL;
     temp_surf_ = NULL;
     cursor_surf_ = NULL;
+    cursor_drawn_ = false;
 }
 
 SystemSDL::~SystemSDL() {
@@ -132,6 +133,14 @@ bool SystemSDL::initialize(bool fullscreen) {
 }
 
 void SystemSDL::updateScreen() {
+#ifndef GP2X
+    if ((screen_surf_->flags & SDL_DOUBLEBUF) == 0) {
+        // with a single buffer, parts of the display can be updated
+        updateScreenRects();
+        return;
+    }
+#endif
+
     if (g_Screen.dirty()|| (cursor_visible_ && update_cursor_)) {
         SDL_LockSurface(temp_surf_);
 #ifdef GP2X
@@ -168,6 +177,72 @@ void SystemSDL::updateScreen() {
     }
 }
 
+/*!
+ * Copies only the dirty parts of the screen to the display surface and
+ * tells SDL to update only those parts and the cursor.
+ */
+void SystemSDL::updateScreenRects() {
+    if (!g_Screen.dirty() && !(cursor_visible_ && update_cursor_)) {
+        return;
+    }
+
+    const DirtyArea &area = g_Screen.dirtyArea();
+    // one rect per dirty rect, plus old and new cursor
+    SDL_Rect rects[DirtyArea::kMaxRects + 2];
+    int nbRects = 0;
+
+    SDL_LockSurface(temp_surf_);
+    for (int i = 0; i < area.size(); i++) {
+        const DirtyRect &r = area.rectAt(i);
+        const uint8 *src = g_Screen.pixels() + r.y * GAME_SCREEN_WIDTH + r.x;
+        uint8 *dst = (uint8 *) temp_surf_->pixels + r.y * temp_surf_->pitch + r.x;
+        for (int j = 0; j < r.height; j++) {
+            memcpy(dst, src, r.width);
+            src += GAME_SCREEN_WIDTH;
+            dst += temp_surf_->pitch;
+        }
+    }
+    SDL_UnlockSurface(temp_surf_);
+
+    for (int i = 0; i < area.size(); i++) {
+        const DirtyRect &r = area.rectAt(i);
+        SDL_Rect rect;
+        rect.x = r.x;
+        rect.y = r.y;
+        rect.w = r.width;
+        rect.h = r.height;
+        SDL_Rect dst = rect;
+        SDL_BlitSurface(temp_surf_, &rect, screen_surf_, &dst);
+        rects[nbRects++] = rect;
+    }
+
+    g_Screen.clearDirty();
+
+    if (cursor_drawn_) {
+        // restore what was under the cursor
+        SDL_Rect src = cursor_drawn_rect_;
+        SDL_Rect dst = src;
+        SDL_BlitSurface(temp_surf_, &src, screen_surf_, &dst);
+        rects[nbRects++] = cursor_drawn_rect_;
+        cursor_drawn_ = false;
+    }
+
+    if (cursor_visible_) {
+        SDL_Rect dst;
+
+        dst.x = cursor_x_ - cursor_hs_x_;
+        dst.y = cursor_y_ - cursor_hs_y_;
+        SDL_BlitSurface(cursor_surf_, &cursor_rect_, screen_surf_, &dst);
+        // SDL has clipped the destination rect to the screen
+        cursor_drawn_rect_ = dst;
+        cursor_drawn_ = true;
+        rects[nbRects++] = dst;
+        update_cursor_ = false;
+    }
+
+    SDL_UpdateRects(screen_surf_, nbRects, rects);
+}
+
 /*!
  * Using the keysym parameter, verify if the given key is a function key (ie
  * a not printable key) returns the corresponding entry in the KeyFunc enumeration.
@@ -375,6 +450,9 @@ void SystemSDL::setPalette6b3(const uint8 * pal, int cols) {
     }
 
     SDL_SetColors(temp_surf_, palette, 0, cols);
+    // colors are converted when the screen is copied to the display,
+    // so parts that did not change must be copied again
+    g_Screen.setAllDirty();
 }
 
 void SystemSDL::setPalette8b3(const uint8 * pal, int cols) {
@@ -387,6 +465,7 @@ void SystemSDL::setPalette8b3(const uint8 * pal, int cols) {
     }
 
     SDL_SetColors(temp_surf_, palette, 0, cols);
+    g_Screen.setAllDirty();
 }
 
 void SystemSDL::setColor(uint8 index, uint8 r, uint8 g, uint8 b) {
@@ -397,6 +476,7 @@ void SystemSDL::setColor(uint8 index, uint8 r, uint8 g, uint8 b) {
     color.b = b;
 
     SDL_SetColors(temp_surf_, &color, index, 1);
+    g_Screen.setAllDirty();
 }
 
 /*!
@@ -81,6 +81,9 @@ protected:
     //! Sets the key arguments with some key codes
     void checkKeyCodes(SDL_keysym sym, Key &key);
 
+    //! Sends only the changed parts of the screen to the display
+    void updateScreenRects();
+
 protected:
     /*! A constant that holds the cursor icon width and height.*/
     static const int CURSOR_WIDTH;
@@ -110,6 +113,10 @@ protected:
     /*! A flag that tells that cursor must be updated because
      the mouse has moved or the cursor has changed.*/
     bool update_cursor_;
+    /*! True if the cursor has been drawn on the screen surface.*/
+    bool cursor_drawn_;
+    /*! Where the cursor was drawn on the screen surface.*/
+    SDL_Rect cursor_drawn_rect_;
     /*!
      * This field is a bit buffer storing the state of modifier buttons.
      * When a bit is set, that means a button is pressed.
@@ -0,0 +1,287 @@
+/************************************************************************
+ *                                                                      *
+ *  FreeSynd - a remake of the classic Bullfrog game "Syndicate".       *
+ *                                                                      *
+ *   Copyright (C) 2016  Benoit Blancard <benblan@users.sourceforge.net>*
+ *                                                                      *
+ *    This program is free software;  you can redistribute it and / or  *
+ *  modify it  under the  terms of the  GNU General  Public License as  *
+ *  published by the Free Software Foundation; either version 2 of the  *
+ *  License, or (at your option) any later version.                     *
+ *                                                                      *
+ *    This program is  distributed in the hope that it will be useful,  *
+ *  but WITHOUT  ANY WARRANTY;  without even  the implied  warranty of  *
+ *  MERCHANTABILITY  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU  *
+ *  General Public License for more details.                            *
+ *                                                                      *
+ *    You can view the GNU  General Public License, online, at the GNU  *
+ *  project's  web  site;  see <http://www.gnu.org/licenses/gpl.html>.  *
+ *  The full text of the license is also included in the file COPYING.  *
+ *                                                                      *
+ ************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#endif
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include "utils/assetcache.h"
+#include "utils/ccrc32.h"
+#include "utils/file.h"
+#include "utils/log.h"
+
+/*!
+ * Header at the beginning of each cache entry. Entries are only read
+ * on the computer that wrote them so the header is written as is.
+ */
+struct AssetCacheHeader {
+    char magic[4];
+    uint32 version;
+    //! Size of the original file
+    uint32 sourceSize;
+    //! Modification time of the original file
+    uint32 sourceTime;
+    //! Size of the unpacked content that follows the header
+    uint32 dataSize;
+    //! CRC of the unpacked content
+    uint32 dataCrc;
+};
+
+/*! Increase it when the format of entries changes.*/
+static const uint32 kCacheVersion = 1;
+
+bool AssetCache::enabled_ = true;
+std::atomic<uint32> AssetCache::hits_(0);
+std::atomic<uint32> AssetCache::misses_(0);
+std::atomic<uint32> AssetCache::invalid_(0);
+std::atomic<uint32> AssetCache::written_(0);
+
+FileData::FileData() {
+    pData_ = NULL;
+    size_ = 0;
+    pMapping_ = NULL;
+    mappingSize_ = 0;
+}
+
+FileData::~FileData() {
+    release();
+}
+
+void FileData::release() {
+    if (pMapping_ != NULL) {
+#ifndef _WIN32
+        munmap(pMapping_, mappingSize_);
+#endif
+        pMapping_ = NULL;
+        mappingSize_ = 0;
+    } else if (pData_ != NULL) {
+        delete[] pData_;
+    }
+    pData_ = NULL;
+    size_ = 0;
+}
+
+void FileData::setBuffer(uint8 *pBuffer, int size) {
+    release();
+    pData_ = pBuffer;
+    size_ = size;
+}
+
+/*!
+ * Pages are read only when they are accessed and modified pages are
+ * private to the process. On Windows, the file is read in a buffer.
+ * \param path Full path of the file
+ * \param offset Number of bytes to skip at the beginning of the file
+ * \return False if the file cannot be mapped
+ */
+bool FileData::mapFile(const std::string &path, int offset) {
+    release();
+#ifdef _WIN32
+    FILE *fp = fopen(path.c_str(), "rb");
+    if (fp == NULL) {
+        return false;
+    }
+    fseek(fp, 0, SEEK_END);
+    int fileSize = ftell(fp);
+    if (fileSize <= offset) {
+        fclose(fp);
+        return false;
+    }
+    uint8 *pBuffer = new uint8[fileSize - offset + 1];
+    pBuffer[fileSize - offset] = '\0';
+    fseek(fp, offset, SEEK_SET);
+    size_t n = fread(pBuffer, 1, fileSize - offset, fp);
+    fclose(fp);
+    if ((int) n != fileSize - offset) {
+        delete[] pBuffer;
+        return false;
+    }
+    setBuffer(pBuffer, fileSize - offset);
+    return true;
+#else
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd == -1) {
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= offset) {
+        close(fd);
+        return false;
+    }
+    void *pMapping = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (pMapping == MAP_FAILED) {
+        return false;
+    }
+    pMapping_ = pMapping;
+    mappingSize_ = st.st_size;
+    pData_ = static_cast<uint8 *>(pMapping) + offset;
+    size_ = st.st_size - offset;
+    return true;
+#endif
+}
+
+std::string AssetCache::entryPath(const std::string &filename) {
+    std::string name("cache/");
+    for (size_t i = 0; i < filename.size(); i++) {
+        name.push_back(tolower(filename[i]));
+    }
+    name.append(".unp");
+    return File::homeFullPath(name);
+}
+
+bool AssetCache::sourceInfo(const std::string &path, uint32 *pSize, uint32 *pTime) {
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0) {
+        return false;
+    }
+    *pSize = (uint32) st.st_size;
+    *pTime = (uint32) st.st_mtime;
+    return true;
+}
+
+/*!
+ * An entry that does not match the original file is removed.
+ * \param filename Name of the original file
+ * \param sourcePath Full path of the original file
+ * \param pData Receives the unpacked content
+ * \return False if there's no valid entry
+ */
+bool AssetCache::load(const std::string &filename, const std::string &sourcePath, FileData *pData) {
+    uint32 sourceSize, sourceTime;
+    if (!sourceInfo(sourcePath, &sourceSize, &sourceTime)) {
+        return false;
+    }
+
+    std::string path = entryPath(filename);
+    FILE *fp = fopen(path.c_str(), "rb");
+    if (fp == NULL) {
+        misses_++;
+        return false;
+    }
+    AssetCacheHeader header;
+    size_t n = fread(&header, sizeof(header), 1, fp);
+    fclose(fp);
+
+    bool valid = n == 1 && memcmp(header.magic, "FSAC", 4) == 0 &&
+        header.version == kCacheVersion && header.sourceSize == sourceSize &&
+        header.sourceTime == sourceTime &&
+        pData->mapFile(path, sizeof(AssetCacheHeader)) &&
+        pData->size() == (int) header.dataSize;
+    if (valid) {
+        CCRC32 crc;
+        valid = crc.FullCRC(pData->data(), pData->size()) == header.dataCrc;
+    }
+
+    if (!valid) {
+        LOG(Log::k_FLG_IO, "AssetCache", "load", ("Entry for %s is outdated", filename.c_str()))
+        pData->release();
+        ::remove(path.c_str());
+        invalid_++;
+        return false;
+    }
+
+    hits_++;
+    return true;
+}
+
+/*!
+ * The entry is written in a temporary file which is renamed at the end,
+ * so an entry is never read while it is being written.
+ * \param filename Name of the original file
+ * \param sourcePath Full path of the original file
+ * \param data Unpacked content
+ * \param size Size of content
+ */
+void AssetCache::store(const std::string &filename, const std::string &sourcePath,
+        const uint8 *data, int size) {
+    AssetCacheHeader header;
+    if (!sourceInfo(sourcePath, &header.sourceSize, &header.sourceTime)) {
+        return;
+    }
+    memcpy(header.magic, "FSAC", 4);
+    header.version = kCacheVersion;
+    header.dataSize = size;
+    CCRC32 crc;
+    header.dataCrc = crc.FullCRC(data, size);
+
+    std::string cacheDir = File::homeFullPath("cache");
+#ifdef _WIN32
+    CreateDirectory(cacheDir.c_str(), NULL);
+#else
+    mkdir(cacheDir.c_str(), 0755);
+#endif
+
+    // each store has its own temporary file as threads may write the
+    // entry of the same file at the same time
+    static std::atomic<uint32> nbStores(0);
+    char suffix[16];
+    snprintf(suffix, sizeof(suffix), ".%u.tmp", (unsigned int) nbStores++);
+    std::string path = entryPath(filename);
+    std::string tmpPath = path + suffix;
+    FILE *fp = fopen(tmpPath.c_str(), "wb");
+    if (fp == NULL) {
+        FSERR(Log::k_FLG_IO, "AssetCache", "store", ("Cannot create cache entry %s\n", tmpPath.c_str()))
+        return;
+    }
+    bool written = fwrite(&header, sizeof(header), 1, fp) == 1 &&
+        fwrite(data, 1, size, fp) == (size_t) size;
+    written = fclose(fp) == 0 && written;
+    // rename() does not replace an existing file on Windows
+    ::remove(path.c_str());
+    if (!written || rename(tmpPath.c_str(), path.c_str()) != 0) {
+        FSERR(Log::k_FLG_IO, "AssetCache", "store", ("Cannot write cache entry %s\n", path.c_str()))
+        ::remove(tmpPath.c_str());
+        return;
+    }
+    written_++;
+}
+
+void AssetCache::remove(const std::string &filename) {
+    ::remove(entryPath(filename).c_str());
+}
+
+AssetCache::Stats AssetCache::stats() {
+    Stats stats;
+    stats.hits = hits_;
+    stats.misses = misses_;
+    stats.invalid = invalid_;
+    stats.written = written_;
+    return stats;
+}
+
+void AssetCache::resetStats() {
+    hits_ = 0;
+    misses_ = 0;
+    invalid_ = 0;
+    written_ = 0;
+}
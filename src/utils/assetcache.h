@@ -0,0 +1,117 @@
+/************************************************************************
+ *                                                                      *
+ *  FreeSynd - a remake of the classic Bullfrog game "Syndicate".       *
+ *                                                                      *
+ *   Copyright (C) 2016  Benoit Blancard <benblan@users.sourceforge.net>*
+ *                                                                      *
+ *    This program is free software;  you can redistribute it and / or  *
+ *  modify it  under the  terms of the  GNU General  Public License as  *
+ *  published by the Free Software Foundation; either version 2 of the  *
+ *  License, or (at your option) any later version.                     *
+ *                                                                      *
+ *    This program is  distributed in the hope that it will be useful,  *
+ *  but WITHOUT  ANY WARRANTY;  without even  the implied  warranty of  *
+ *  MERCHANTABILITY  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU  *
+ *  General Public License for more details.                            *
+ *                                                                      *
+ *    You can view the GNU  General Public License, online, at the GNU  *
+ *  project's  web  site;  see <http://www.gnu.org/licenses/gpl.html>.  *
+ *  The full text of the license is also included in the file COPYING.  *
+ *                                                                      *
+ ************************************************************************/
+
+#ifndef UTILS_ASSETCACHE_H_
+#define UTILS_ASSETCACHE_H_
+
+#include <atomic>
+#include <string>
+
+#include "common.h"
+
+/*!
+ * Content of a file in memory : either a mapping of the file or a buffer.
+ * Memory is released when the object is destroyed. Mapped content can be
+ * modified but changes are never written to the file.
+ */
+class FileData {
+public:
+    FileData();
+    ~FileData();
+
+    uint8 *data() { return pData_; }
+    int size() const { return size_; }
+    bool isMapped() const { return pMapping_ != NULL; }
+
+    //! Takes ownership of a buffer allocated with new[]
+    void setBuffer(uint8 *pBuffer, int size);
+    //! Maps the file and gives access to its content after offset
+    bool mapFile(const std::string &path, int offset);
+    //! Releases the memory
+    void release();
+
+private:
+    FileData(const FileData &);
+    FileData & operator=(const FileData &);
+
+    /*! Start of the content.*/
+    uint8 *pData_;
+    /*! Size of the content.*/
+    int size_;
+    /*! Start of the mapping or NULL if content is in a buffer.*/
+    void *pMapping_;
+    /*! Size of the mapping.*/
+    size_t mappingSize_;
+};
+
+/*!
+ * Keeps unpacked copies of RNC packed original files in the cache
+ * directory of the home path, so they are unpacked only once.
+ * An entry is used only if the original file has the same size and
+ * modification time as when the entry was written and if the content
+ * has the same CRC as when it was written.
+ */
+class AssetCache {
+public:
+    //! Counters of the cache
+    struct Stats {
+        //! Number of entries used
+        uint32 hits;
+        //! Number of packed files without entry
+        uint32 misses;
+        //! Number of entries that did not match their file
+        uint32 invalid;
+        //! Number of entries written
+        uint32 written;
+    };
+
+    static void setEnabled(bool enabled) { enabled_ = enabled; }
+    static bool isEnabled() { return enabled_; }
+
+    //! Reads the entry for the original file if it is valid
+    static bool load(const std::string &filename, const std::string &sourcePath, FileData *pData);
+    //! Writes the unpacked content of the original file
+    static void store(const std::string &filename, const std::string &sourcePath,
+        const uint8 *data, int size);
+    //! Removes the entry of the given original file
+    static void remove(const std::string &filename);
+
+    //! Returns the counters, files can be loaded by several threads at once
+    static Stats stats();
+    static void resetStats();
+
+private:
+    //! Returns the path of the entry for the given original file
+    static std::string entryPath(const std::string &filename);
+    //! Reads size and modification time of a file
+    static bool sourceInfo(const std::string &path, uint32 *pSize, uint32 *pTime);
+
+    /*! True to use the cache.*/
+    static bool enabled_;
+    /*! Counters, see Stats. They are atomic as loading threads update them.*/
+    static std::atomic<uint32> hits_;
+    static std::atomic<uint32> misses_;
+    static std::atomic<uint32> invalid_;
+    static std::atomic<uint32> written_;
+};
+
+#endif  // UTILS_ASSETCACHE_H_
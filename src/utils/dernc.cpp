@@ -39,21 +39,24 @@ namespace RNC_INTERNAL {
         } table[32];
     };
 
-    static uint16 crc_table[256];
-    static bool is_crc_setup = false;
+    // Built the first time it is used : that is thread safe as files
+    // can be unpacked by several threads at startup
+    struct CRCTable {
+        uint16 values[256];
 
-    void setupCRCTable() {
-        uint16 temp;
+        CRCTable() {
+            uint16 temp;
 
-        for (int i = 0; i < 256; ++i) {
-            temp = i;
+            for (int i = 0; i < 256; ++i) {
+                temp = i;
 
-            for (int j = 0; j < 8; ++j)
-                temp = (temp & 1 ? (temp >> 1) ^ 0xA001 : temp >> 1);
+                for (int j = 0; j < 8; ++j)
+                    temp = (temp & 1 ? (temp >> 1) ^ 0xA001 : temp >> 1);
 
-            crc_table[i] = temp;
-        } is_crc_setup = true;
-    }
+                values[i] = temp;
+            }
+        }
+    };
 
     uint32 bitPeek(BitStream &bit_stream, uint32 mask) {
         return bit_stream.bit_buffer &mask;
@@ -225,13 +228,12 @@ int rnc::unpackedLength(uint8 *packed_data) {
 
 uint16 rnc::crc(uint8 *data, int data_length) {
     using namespace RNC_INTERNAL;
-    if (!is_crc_setup)
-        setupCRCTable();
+    static const CRCTable crc_table;
 
     uint16 result = 0;
     do {
         result ^= *data++;
-        result = (result >> 8) ^ crc_table[result & 0xff];
+        result = (result >> 8) ^ crc_table.values[result & 0xff];
     } while (--data_length);
 
     return result;
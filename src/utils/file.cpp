@@ -41,9 +41,11 @@
 #endif
 
 #include "file.h"
+#include "assetcache.h"
 #include "dernc.h"
 #include "log.h"
 #include "portablefile.h"
+#include "profiler.h"
 
 std::string File::dataPath_ = "./data/";
 std::string File::ourDataPath_ = "./data/";
@@ -75,6 +77,19 @@ std::string File::dataFullPath(const std::string& filename) {
     return ourDataPath_ + filename;
 }
 
+/*!
+ * No control is made on the file existence.
+ * \param filename Path relative to the home directory
+ */
+std::string File::homeFullPath(const std::string& filename) {
+    std::string path(homePath_);
+    char c = path[path.size() - 1];
+    if (c != '\\' && c != '/')
+        path.append("/");
+    path.append(filename);
+    return path;
+}
+
 void File::getFullPathForSaveSlot(int slot, std::string &path) {
     path.erase();
 
@@ -175,6 +190,72 @@ uint8 *File::loadOriginalFile(const std::string& filename, int &filesize) {
     return data;
 }
 
+/*!
+ * \param filename Name of the original file
+ * \param pPath Receives the full path of the file
+ * \return False if the file does not exist
+ */
+bool File::originalFilePath(const std::string& filename, std::string *pPath) {
+    // try lowercase, then uppercase.
+    for (int i = 0; i < 2; i++) {
+        std::string path = originalDataFullPath(filename, i == 1);
+        FILE *fp = fopen(path.c_str(), "rb");
+        if (fp) {
+            fclose(fp);
+            *pPath = path;
+            return true;
+        }
+    }
+    return false;
+}
+
+/*!
+ * Files that are not packed are mapped in memory. Packed files are read
+ * from the asset cache if it has a valid entry for them, otherwise they are
+ * unpacked and an entry is written.
+ * It can be called by several threads at once : paths are set before
+ * loading starts and the asset cache counters are atomic.
+ * \param filename Name of the original file
+ * \param pData Receives the content
+ * \return False if file cannot be read.
+ */
+bool File::loadOriginalData(const std::string& filename, FileData *pData) {
+    PROFILE_ZONE("File::loadOriginalData");
+    pData->release();
+    std::string path;
+    if (!originalFilePath(filename, &path)) {
+        FSERR(Log::k_FLG_IO, "File", "loadOriginalData", ("ERROR: Couldn't open file '%s' (using path: '%s')\n",
+            filename.c_str(), dataPath_.c_str()));
+        return false;
+    }
+
+    uint8 signature[4];
+    FILE *fp = fopen(path.c_str(), "rb");
+    size_t n = fp ? fread(signature, 1, 4, fp) : 0;
+    if (fp) {
+        fclose(fp);
+    }
+    bool packed = n == 4 && READ_BE_UINT32(signature) == RNC_SIGNATURE;
+
+    if (!packed && pData->mapFile(path, 0)) {
+        return true;
+    }
+    if (packed && AssetCache::isEnabled() && AssetCache::load(filename, path, pData)) {
+        return true;
+    }
+
+    int size;
+    uint8 *data = loadOriginalFile(filename, size);
+    if (data == NULL || size == 0) {
+        return false;
+    }
+    pData->setBuffer(data, size);
+    if (packed && AssetCache::isEnabled()) {
+        AssetCache::store(filename, path, data, size);
+    }
+    return true;
+}
+
 void File::processSaveFile(const std::string& filename, std::vector<std::string> &files) {
     size_t extPos = filename.find_last_of('.');
     if (extPos == std::string::npos) return;
@@ -31,6 +31,8 @@
 #include <stdio.h>
 #include "common.h"
 
+class FileData;
+
 /*!
  * File class.
  */
@@ -44,12 +46,18 @@ public:
     static void setHomePath(const std::string& path);
 
     static uint8 *loadOriginalFile(const std::string& filename, int &filesize);
+    //! Loads the unpacked content of an original file, using the asset cache
+    static bool loadOriginalData(const std::string& filename, FileData *pData);
+    //! Finds which of the lowercase or uppercase name of the file exists
+    static bool originalFilePath(const std::string& filename, std::string *pPath);
     static FILE *openOriginalFile(const std::string& filename);
 
     //! Returns the full path of the given original game resource using the current root path.
     static std::string originalDataFullPath(const std::string& filename, bool uppercase);
     //! Returns the full path of the given resource using the current root path.
     static std::string dataFullPath(const std::string& filename);
+    //! Returns the full path of the given file in the home directory.
+    static std::string homeFullPath(const std::string& filename);
 
     //! Sets the filename fullpath for the given slot (from 0 to 9)
     static void getFullPathForSaveSlot(int slot, std::string &path);
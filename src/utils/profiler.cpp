@@ -0,0 +1,286 @@
+/************************************************************************
+ *                                                                      *
+ *  FreeSynd - a remake of the classic Bullfrog game "Syndicate".       *
+ *                                                                      *
+ *   Copyright (C) 2016  Benoit Blancard <benblan@users.sourceforge.net>*
+ *                                                                      *
+ *    This program is free software;  you can redistribute it and / or  *
+ *  modify it  under the  terms of the  GNU General  Public License as  *
+ *  published by the Free Software Foundation; either version 2 of the  *
+ *  License, or (at your option) any later version.                     *
+ *                                                                      *
+ *    This program is  distributed in the hope that it will be useful,  *
+ *  but WITHOUT  ANY WARRANTY;  without even  the implied  warranty of  *
+ *  MERCHANTABILITY  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU  *
+ *  General Public License for more details.                            *
+ *                                                                      *
+ *    You can view the GNU  General Public License, online, at the GNU  *
+ *  project's  web  site;  see <http://www.gnu.org/licenses/gpl.html>.  *
+ *  The full text of the license is also included in the file COPYING.  *
+ *                                                                      *
+ ************************************************************************/
+
+#include <stdio.h>
+
+#include "SDL.h"
+
+#include "utils/profiler.h"
+#include "utils/log.h"
+#include "utils/timer.h"
+
+const size_t Profiler::kMaxEvents = 1 << 20;
+const int Profiler::kFramesPerUpdate = 30;
+
+/*!
+ * A zone that has been run during a capture.
+ */
+struct ProfileEvent {
+    const char *name;
+    uint64 startTime;
+    uint32 duration;
+};
+
+/*!
+ * Time spent by a thread in a zone during the current frame.
+ */
+struct ProfileTotal {
+    const char *name;
+    int depth;
+    uint64 time;
+    uint32 calls;
+};
+
+/*!
+ * What is measured on a thread. Only the thread writes in it, the
+ * main thread reads it under the mutex.
+ */
+struct Profiler::ThreadData {
+    //! Id of the thread in the trace
+    int tid;
+    const char *name;
+    //! Number of zones the thread is in
+    int depth;
+    SDL_mutex *pMutex;
+    std::vector<ProfileEvent> events;
+    //! Events not kept during the capture as events was full
+    size_t nbDroppedEvents;
+    std::vector<ProfileTotal> totals;
+};
+
+/*! Protects the list of threads.*/
+static SDL_mutex *pThreadsMutex = NULL;
+
+std::atomic<bool> Profiler::enabled_(false);
+std::atomic<bool> Profiler::capturing_(false);
+uint64 Profiler::captureStart_ = 0;
+int Profiler::nbFrames_ = 0;
+std::vector<Profiler::ThreadData *> Profiler::threads_;
+std::vector<Profiler::ZoneStats> Profiler::sums_;
+std::vector<Profiler::ZoneStats> Profiler::zoneStats_;
+
+void Profiler::initialize() {
+    if (pThreadsMutex == NULL) {
+        pThreadsMutex = SDL_CreateMutex();
+    }
+    setThreadName("main");
+}
+
+void Profiler::destroy() {
+    enabled_ = false;
+    capturing_ = false;
+    for (size_t i = 0; i < threads_.size(); i++) {
+        SDL_DestroyMutex(threads_[i]->pMutex);
+        delete threads_[i];
+    }
+    threads_.clear();
+    sums_.clear();
+    zoneStats_.clear();
+    if (pThreadsMutex != NULL) {
+        SDL_DestroyMutex(pThreadsMutex);
+        pThreadsMutex = NULL;
+    }
+}
+
+/*!
+ * The data of a thread is kept until destroy() so that the events of
+ * threads that have ended can still be written.
+ */
+Profiler::ThreadData * Profiler::threadData() {
+    static thread_local ThreadData *pData = NULL;
+    if (pData == NULL) {
+        pData = new ThreadData();
+        pData->name = "thread";
+        pData->depth = 0;
+        pData->nbDroppedEvents = 0;
+        pData->pMutex = SDL_CreateMutex();
+        SDL_LockMutex(pThreadsMutex);
+        pData->tid = (int) threads_.size();
+        threads_.push_back(pData);
+        SDL_UnlockMutex(pThreadsMutex);
+    }
+    return pData;
+}
+
+void Profiler::setThreadName(const char *name) {
+    threadData()->name = name;
+}
+
+uint64 Profiler::beginZone() {
+    threadData()->depth++;
+    return fs_utils::microTime();
+}
+
+void Profiler::endZone(const char *name, uint64 startTime) {
+    uint64 duration = fs_utils::microTime() - startTime;
+    ThreadData *pData = threadData();
+    pData->depth--;
+
+    SDL_LockMutex(pData->pMutex);
+    size_t i = 0;
+    while (i < pData->totals.size() && pData->totals[i].name != name) {
+        i++;
+    }
+    if (i == pData->totals.size()) {
+        ProfileTotal total = { name, pData->depth, 0, 0 };
+        pData->totals.push_back(total);
+    }
+    pData->totals[i].time += duration;
+    pData->totals[i].calls++;
+
+    if (capturing_.load(std::memory_order_relaxed)) {
+        if (pData->events.size() < kMaxEvents) {
+            ProfileEvent event = { name, startTime, (uint32) duration };
+            pData->events.push_back(event);
+        } else {
+            pData->nbDroppedEvents++;
+        }
+    }
+    SDL_UnlockMutex(pData->pMutex);
+}
+
+/*!
+ * Adds the time of the frame to the sums and, every kFramesPerUpdate
+ * frames, makes the averages of the sums the shown times.
+ */
+void Profiler::endFrame() {
+    SDL_LockMutex(pThreadsMutex);
+    for (size_t t = 0; t < threads_.size(); t++) {
+        ThreadData *pData = threads_[t];
+        SDL_LockMutex(pData->pMutex);
+        for (size_t i = 0; i < pData->totals.size(); i++) {
+            const ProfileTotal &total = pData->totals[i];
+            size_t z = 0;
+            while (z < sums_.size() && sums_[z].name != total.name) {
+                z++;
+            }
+            if (z == sums_.size()) {
+                ZoneStats zone = { total.name, total.depth, 0.0f, 0.0f, 0.0f };
+                sums_.push_back(zone);
+            }
+            float ms = total.time / 1000.0f;
+            sums_[z].avgMs += ms;
+            sums_[z].calls += total.calls;
+            if (ms > sums_[z].maxMs) {
+                sums_[z].maxMs = ms;
+            }
+        }
+        pData->totals.clear();
+        SDL_UnlockMutex(pData->pMutex);
+    }
+    SDL_UnlockMutex(pThreadsMutex);
+
+    nbFrames_++;
+    if (nbFrames_ < kFramesPerUpdate) {
+        return;
+    }
+
+    zoneStats_.clear();
+    for (size_t z = 0; z < sums_.size(); z++) {
+        ZoneStats &zone = sums_[z];
+        if (zone.calls > 0) {
+            ZoneStats shown = zone;
+            shown.avgMs /= nbFrames_;
+            shown.calls /= nbFrames_;
+            zoneStats_.push_back(shown);
+        }
+        zone.avgMs = zone.maxMs = zone.calls = 0.0f;
+    }
+    nbFrames_ = 0;
+}
+
+/*!
+ * Events kept by a previous capture are dropped. The profiler is
+ * enabled if it was not.
+ */
+void Profiler::startCapture() {
+    SDL_LockMutex(pThreadsMutex);
+    for (size_t t = 0; t < threads_.size(); t++) {
+        SDL_LockMutex(threads_[t]->pMutex);
+        threads_[t]->events.clear();
+        threads_[t]->nbDroppedEvents = 0;
+        SDL_UnlockMutex(threads_[t]->pMutex);
+    }
+    SDL_UnlockMutex(pThreadsMutex);
+
+    captureStart_ = fs_utils::microTime();
+    capturing_ = true;
+    enabled_ = true;
+    LOG(Log::k_FLG_INFO, "Profiler", "startCapture", ("Capture started"))
+}
+
+/*!
+ * Writes all events as complete events ("ph":"X") with one track per
+ * thread. Times are in microseconds since the start of the capture.
+ * Threads that dropped events have a "dropped_events" metadata event.
+ * \param path Path of the trace file
+ * \return False if file could not be written
+ */
+bool Profiler::stopCapture(const std::string &path) {
+    if (!capturing_) {
+        return false;
+    }
+    capturing_ = false;
+
+    FILE *fp = fopen(path.c_str(), "w");
+    if (fp == NULL) {
+        FSERR(Log::k_FLG_IO, "Profiler", "stopCapture", ("Cannot create trace file %s\n", path.c_str()))
+        return false;
+    }
+
+    size_t nbEvents = 0;
+    size_t nbDroppedEvents = 0;
+    fprintf(fp, "{\"traceEvents\":[\n");
+    SDL_LockMutex(pThreadsMutex);
+    for (size_t t = 0; t < threads_.size(); t++) {
+        ThreadData *pData = threads_[t];
+        SDL_LockMutex(pData->pMutex);
+        fprintf(fp, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+            t > 0 ? ",\n" : "", pData->tid, pData->name);
+        for (size_t i = 0; i < pData->events.size(); i++) {
+            const ProfileEvent &event = pData->events[i];
+            fprintf(fp, ",\n{\"name\":\"%s\",\"cat\":\"zone\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%lld,\"dur\":%u}",
+                event.name, pData->tid, (long long) event.startTime - (long long) captureStart_,
+                event.duration);
+        }
+        if (pData->nbDroppedEvents > 0) {
+            // shown in the metadata of the thread
+            fprintf(fp, ",\n{\"name\":\"dropped_events\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"count\":%u}}",
+                pData->tid, (unsigned int) pData->nbDroppedEvents);
+        }
+        nbEvents += pData->events.size();
+        nbDroppedEvents += pData->nbDroppedEvents;
+        pData->events.clear();
+        pData->nbDroppedEvents = 0;
+        SDL_UnlockMutex(pData->pMutex);
+    }
+    SDL_UnlockMutex(pThreadsMutex);
+    fprintf(fp, "\n],\"displayTimeUnit\":\"ms\"}\n");
+    fclose(fp);
+
+    LOG(Log::k_FLG_INFO, "Profiler", "stopCapture", ("%d events written in %s", (int) nbEvents, path.c_str()))
+    if (nbDroppedEvents > 0) {
+        FSERR(Log::k_FLG_INFO, "Profiler", "stopCapture", ("%d events were dropped, a thread had more than %d events\n",
+            (int) nbDroppedEvents, (int) kMaxEvents))
+    }
+    return true;
+}
@@ -0,0 +1,149 @@
+/************************************************************************
+ *                                                                      *
+ *  FreeSynd - a remake of the classic Bullfrog game "Syndicate".       *
+ *                                                                      *
+ *   Copyright (C) 2016  Benoit Blancard <benblan@users.sourceforge.net>*
+ *                                                                      *
+ *    This program is free software;  you can redistribute it and / or  *
+ *  modify it  under the  terms of the  GNU General  Public License as  *
+ *  published by the Free Software Foundation; either version 2 of the  *
+ *  License, or (at your option) any later version.                     *
+ *                                                                      *
+ *    This program is  distributed in the hope that it will be useful,  *
+ *  but WITHOUT  ANY WARRANTY;  without even  the implied  warranty of  *
+ *  MERCHANTABILITY  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU  *
+ *  General Public License for more details.                            *
+ *                                                                      *
+ *    You can view the GNU  General Public License, online, at the GNU  *
+ *  project's  web  site;  see <http://www.gnu.org/licenses/gpl.html>.  *
+ *  The full text of the license is also included in the file COPYING.  *
+ *                                                                      *
+ ************************************************************************/
+
+#ifndef UTILS_PROFILER_H_
+#define UTILS_PROFILER_H_
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+#include "common.h"
+#include "config.h"
+
+/*!
+ * Measures the time spent in named zones of code, on every thread.
+ * A zone is the scope of a PROFILE_ZONE() macro, so zones nest and the
+ * time of a zone includes the time of the zones it contains.
+ * When the profiler is disabled, a zone costs a test. When FS_PROFILER
+ * is 0 in config.h, zones are not compiled at all.
+ *
+ * The main loop calls endFrame() after each frame : the time of each
+ * zone is then averaged over the last frames for the overlay.
+ * During a capture, every zone is also kept as an event and written at
+ * the end in the trace event format of Chrome (chrome://tracing). Only
+ * kMaxEvents events are kept per thread, the others are counted.
+ */
+class Profiler {
+public:
+    //! Time spent in a zone, by all threads
+    struct ZoneStats {
+        const char *name;
+        //! Depth of the zone in its thread, 0 for top zones
+        int depth;
+        //! Average time per frame in milliseconds
+        float avgMs;
+        //! Longest time in one frame in milliseconds
+        float maxMs;
+        //! Average number of times zone was run per frame
+        float calls;
+    };
+
+    //! Maximum number of events kept per thread during a capture
+    static const size_t kMaxEvents;
+    //! Number of frames over which zone times are averaged
+    static const int kFramesPerUpdate;
+
+    //! Registers the calling thread as the main thread
+    static void initialize();
+    //! Frees all data
+    static void destroy();
+
+    static void setEnabled(bool enabled) { enabled_ = enabled; }
+    static bool isEnabled() { return enabled_.load(std::memory_order_relaxed); }
+    //! Gives a name to the calling thread for the trace
+    static void setThreadName(const char *name);
+
+    //! Starts keeping events for the trace
+    static void startCapture();
+    //! Writes the events in a trace file and stops capturing
+    static bool stopCapture(const std::string &path);
+    static bool isCapturing() { return capturing_; }
+
+    //! Updates the zone times, must be called by the main thread after each frame
+    static void endFrame();
+    //! Returns the time of each zone, in the order they were first seen
+    static const std::vector<ZoneStats> & zoneStats() { return zoneStats_; }
+
+    //! Called when a zone is entered, returns the start time
+    static uint64 beginZone();
+    //! Called when a zone is left
+    static void endZone(const char *name, uint64 startTime);
+
+private:
+    struct ThreadData;
+
+    //! Returns the data of the calling thread, creates it on first call
+    static ThreadData * threadData();
+
+    /*! Written by the main thread and read by all threads in zones.*/
+    static std::atomic<bool> enabled_;
+    static std::atomic<bool> capturing_;
+    /*! Time when the capture started.*/
+    static uint64 captureStart_;
+    /*! Number of frames since the zone times were updated.*/
+    static int nbFrames_;
+    static std::vector<ThreadData *> threads_;
+    /*! Times of zones being summed.*/
+    static std::vector<ZoneStats> sums_;
+    /*! Times of zones shown.*/
+    static std::vector<ZoneStats> zoneStats_;
+};
+
+/*!
+ * Measures the time between its creation and its destruction.
+ * Use PROFILE_ZONE() instead so zones can be removed at compile time.
+ */
+class ProfileZone {
+public:
+    //! The name must be a constant string, it identifies the zone
+    explicit ProfileZone(const char *name) {
+        if (Profiler::isEnabled()) {
+            pName_ = name;
+            startTime_ = Profiler::beginZone();
+        } else {
+            pName_ = NULL;
+        }
+    }
+
+    ~ProfileZone() {
+        if (pName_ != NULL) {
+            Profiler::endZone(pName_, startTime_);
+        }
+    }
+
+private:
+    const char *pName_;
+    uint64 startTime_;
+};
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+
+#if FS_PROFILER
+//! Measures the time until the end of the current scope
+#define PROFILE_ZONE(name) ProfileZone PROFILE_CONCAT(profileZone, __LINE__)(name)
+#else
+#define PROFILE_ZONE(name)
+#endif
+
+#endif  // UTILS_PROFILER_H_
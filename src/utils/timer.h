@@ -23,9 +23,21 @@
 #ifndef UTILS_TIMER_H_
 #define UTILS_TIMER_H_
 
+#include <chrono>
+
 #include "common.h"
 namespace fs_utils {
 
+/*!
+ * Returns a time in microseconds from a monotonic clock.
+ * Only the difference between two values is meaningful : it's
+ * used to measure code execution.
+ */
+inline uint64 microTime() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
 /*!
  * A simple timer implementation. Create the timer with
  * max time and call update in each frame animation with the